@@ -60,6 +60,23 @@ set(SRC
   src/vdr_pi_time.cpp
   src/vdr_network.h
   src/vdr_network.cpp
+  src/vdr_filter.h
+  src/vdr_filter.cpp
+  src/vdr_spsc_queue.h
+  src/vdr_keyframes.h
+  src/vdr_keyframes.cpp
+  src/vdr_follow.h
+  src/vdr_follow.cpp
+  src/vdr_ring.h
+  src/vdr_ring.cpp
+  src/vdr_csv.h
+  src/vdr_csv.cpp
+  src/vdr_nmea.h
+  src/vdr_nmea.cpp
+  src/vdr_n2k.h
+  src/vdr_n2k.cpp
+  src/vdr_signalk.h
+  src/vdr_signalk.cpp
 )
 
 
@@ -67,11 +84,20 @@ set(PKG_API_LIB api-18)  #  A directory in libs/ e. g., api-18 or api-19
 
 macro(add_plugin_libraries)
   # Add libraries required by this plugin
+
+  # The network servers run their own thread on the platform sockets.
+  find_package(Threads REQUIRED)
+  target_link_libraries(${PACKAGE_NAME} Threads::Threads)
+  if (WIN32)
+    target_link_libraries(${PACKAGE_NAME} ws2_32)
+  endif ()
+
 #  add_subdirectory("${CMAKE_SOURCE_DIR}/opencpn-libs/tinyxml")
 #  target_link_libraries(${PACKAGE_NAME} ocpn::tinyxml)
 
-#  add_subdirectory("${CMAKE_SOURCE_DIR}/opencpn-libs/wxJSON")
-#  target_link_libraries(${PACKAGE_NAME} ocpn::wxjson)
+  # Signal K deltas are delivered by OpenCPN as wxJSON values.
+  add_subdirectory("${CMAKE_SOURCE_DIR}/opencpn-libs/wxJSON")
+  target_link_libraries(${PACKAGE_NAME} ocpn::wxjson)
 
 #  add_subdirectory("${CMAKE_SOURCE_DIR}/opencpn-libs/plugingl")
 #  target_link_libraries(${PACKAGE_NAME} ocpn::plugingl)
@@ -0,0 +1,29 @@
+#!/usr/bin/env bash
+#
+# Build and run the plugin tests, after ci/circleci-build-debian.sh has
+# installed the build dependencies.
+
+set -xe
+
+if [ -f ~/.config/local-build.rc ]; then source ~/.config/local-build.rc; fi
+if [ -d /ci-source ]; then cd /ci-source; fi
+
+sudo apt-get -qq install libgtest-dev
+
+if [ -n "$TARGET_TUPLE" ]; then
+  TARGET_OPT="-DOCPN_TARGET_TUPLE=$TARGET_TUPLE";
+fi
+
+testdir=build-test-$OCPN_TARGET
+rm -rf $testdir && mkdir $testdir
+cd $testdir
+
+cmake "-DCMAKE_BUILD_TYPE=${CMAKE_BUILD_TYPE:-RelWithDbgInfo}" \
+    -DOCPN_BUILD_TEST=ON $TARGET_OPT ..
+make vdr_tests vdr_timing_tests
+
+ctest --output-on-failure -LE timing
+
+# Playback timing depends on the load of the shared runner, a regression
+# fails all the attempts.
+ctest --output-on-failure -L timing --repeat until-pass:3
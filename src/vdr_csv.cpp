@@ -0,0 +1,98 @@
+/***************************************************************************
+ *   Copyright (C) 2024 by OpenCPN development team                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ **************************************************************************/
+
+#include "vdr_csv.h"
+
+namespace {
+
+/** Make the view of a field, given its raw text and number of quotes. */
+CSVFieldView MakeFieldView(const wxStringCharType* data, size_t length,
+                           size_t quotes) {
+  if (quotes == 0) {
+    return CSVFieldView(data, length, false);
+  }
+  if (quotes == 2 && length >= 2 && data[0] == '"' && data[length - 1] == '"') {
+    // Quoted field without quotes inside.
+    return CSVFieldView(data + 1, length - 2, false);
+  }
+  return CSVFieldView(data, length, true);
+}
+
+}  // namespace
+
+wxString CSVFieldView::ToString() const {
+  if (!m_escaped) {
+    return wxString(m_data, m_length);
+  }
+  wxString content;
+  content.reserve(m_length);
+  bool inQuotes = false;
+  for (size_t i = 0; i < m_length; i++) {
+    wxStringCharType ch = m_data[i];
+    if (ch == '"') {
+      if (inQuotes && i + 1 < m_length && m_data[i + 1] == '"') {
+        // Double quotes inside quoted field = escaped quote
+        content += '"';
+        i++;
+      } else {
+        inQuotes = !inQuotes;
+      }
+    } else {
+      content += ch;
+    }
+  }
+  return content;
+}
+
+size_t ProjectCSVFields(const wxStringCharType* line, size_t length,
+                        const unsigned int* columns, CSVFieldView* fields,
+                        size_t count) {
+  for (size_t k = 0; k < count; k++) {
+    fields[k] = CSVFieldView();
+  }
+  size_t found = 0;
+  unsigned int column = 0;
+  size_t start = 0;
+  size_t quotes = 0;
+  bool inQuotes = false;
+  for (size_t i = 0; found < count; i++) {
+    if (i == length || (line[i] == ',' && !inQuotes)) {
+      for (size_t k = 0; k < count; k++) {
+        if (columns[k] == column) {
+          fields[k] = MakeFieldView(line + start, i - start, quotes);
+          found++;
+        }
+      }
+      if (i == length) break;
+      column++;
+      start = i + 1;
+      quotes = 0;
+    } else if (line[i] == '"') {
+      quotes++;
+      if (inQuotes && i + 1 < length && line[i + 1] == '"') {
+        // Escaped quote, stays inside quotes.
+        quotes++;
+        i++;
+      } else {
+        inQuotes = !inQuotes;
+      }
+    }
+  }
+  return found;
+}
@@ -0,0 +1,84 @@
+/***************************************************************************
+ *   Copyright (C) 2024 by OpenCPN development team                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ **************************************************************************/
+
+#ifndef _VDR_CSV_H_
+#define _VDR_CSV_H_
+
+#include <wx/string.h>
+
+#include <cstddef>
+
+/**
+ * View of a field of a CSV line, valid as long as the line is not modified.
+ *
+ * A field that is entirely enclosed in quotes, the layout written by the
+ * recorder, is viewed without its quotes. A field with escaped ("") or
+ * embedded quotes is viewed raw, and its content is only built by
+ * ToString().
+ */
+class CSVFieldView {
+public:
+  CSVFieldView() : m_data(nullptr), m_length(0), m_escaped(false) {}
+  CSVFieldView(const wxStringCharType* data, size_t length, bool escaped)
+      : m_data(data), m_length(length), m_escaped(escaped) {}
+
+  /** Check whether the field was found in the line. */
+  bool IsFound() const { return m_data != nullptr; }
+
+  /**
+   * Check whether the field contains quotes to remove. The view then covers
+   * the raw field text.
+   */
+  bool IsEscaped() const { return m_escaped; }
+
+  /** Characters of the field, not null-terminated. */
+  const wxStringCharType* GetData() const { return m_data; }
+
+  /** Number of characters of the view. */
+  size_t GetLength() const { return m_length; }
+
+  /** Get the content of the field, with quotes removed. */
+  wxString ToString() const;
+
+private:
+  const wxStringCharType* m_data;
+  size_t m_length;
+  bool m_escaped;
+};
+
+/**
+ * Find some fields of a CSV line without splitting the other fields.
+ *
+ * Fields are separated by commas outside quotes, and two quotes inside quotes
+ * stand for one quote. Scanning stops as soon as all the requested fields are
+ * found.
+ *
+ * @param line Characters of the line.
+ * @param length Number of characters of the line.
+ * @param columns Index of each requested field.
+ * @param fields Output view of each requested field, not found if the line
+ * has fewer fields.
+ * @param count Number of requested fields.
+ * @return Number of requested fields found in the line.
+ */
+size_t ProjectCSVFields(const wxStringCharType* line, size_t length,
+                        const unsigned int* columns, CSVFieldView* fields,
+                        size_t count);
+
+#endif  // _VDR_CSV_H_
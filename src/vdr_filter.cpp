@@ -0,0 +1,134 @@
+/***************************************************************************
+ *   Copyright (C) 2024 by OpenCPN development team                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ **************************************************************************/
+
+#include "vdr_filter.h"
+
+#include "vdr_n2k.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+
+/** Largest NMEA 2000 PGN. */
+static const uint32_t MAX_PGN = 0x3FFFF;
+
+/** Longest address field, e.g. "GPRMC" or "PCDIN". */
+static const size_t MAX_ADDRESS_LENGTH = 8;
+
+/** Whether a pattern matches an address field. */
+static bool MatchAddress(const std::string& pattern, const char* address,
+                         size_t length) {
+  for (size_t i = 0; i < pattern.size(); i++) {
+    if (pattern[i] == '*') return true;
+    if (i >= length || (pattern[i] != '?' && pattern[i] != address[i])) {
+      return false;
+    }
+  }
+  return pattern.size() == length;
+}
+
+VDRMessageFilter::VDRMessageFilter() : m_matchAll(true) {}
+
+bool VDRMessageFilter::Parse(const std::string& patterns, std::string* error) {
+  std::vector<std::string> sentences;
+  std::vector<uint32_t> pgns;
+  bool matchAll = false;
+  size_t start = 0;
+  while (start < patterns.size()) {
+    size_t end = patterns.find_first_of(", \t\r\n", start);
+    if (end == std::string::npos) end = patterns.size();
+    std::string pattern = patterns.substr(start, end - start);
+    start = end + 1;
+    if (pattern.empty()) continue;
+
+    std::transform(pattern.begin(), pattern.end(), pattern.begin(),
+                   [](unsigned char c) { return std::toupper(c); });
+    if (pattern == "*") {
+      matchAll = true;
+      continue;
+    }
+    if (std::all_of(pattern.begin(), pattern.end(),
+                    [](unsigned char c) { return std::isdigit(c); })) {
+      unsigned long pgn = std::strtoul(pattern.c_str(), nullptr, 10);
+      if (pattern.size() > 6 || pgn > MAX_PGN) {
+        if (error) *error = pattern;
+        return false;
+      }
+      pgns.push_back(static_cast<uint32_t>(pgn));
+      continue;
+    }
+    // Letters, digits and '?', with an optional trailing '*'.
+    size_t stars = std::count(pattern.begin(), pattern.end(), '*');
+    bool valid = pattern.size() <= MAX_ADDRESS_LENGTH &&
+                 (stars == 0 || (stars == 1 && pattern.back() == '*'));
+    for (char c : pattern) {
+      valid = valid && (std::isalnum(static_cast<unsigned char>(c)) ||
+                        c == '?' || c == '*');
+    }
+    if (!valid) {
+      if (error) *error = pattern;
+      return false;
+    }
+    sentences.push_back(pattern);
+  }
+
+  std::sort(pgns.begin(), pgns.end());
+  pgns.erase(std::unique(pgns.begin(), pgns.end()), pgns.end());
+  m_sentences.swap(sentences);
+  m_pgns.swap(pgns);
+  m_matchAll = matchAll || (m_sentences.empty() && m_pgns.empty());
+  return true;
+}
+
+bool VDRMessageFilter::Matches(const std::string& message) const {
+  if (m_matchAll) return true;
+
+  if (message.size() >= 2 && (message[0] == '$' || message[0] == '!')) {
+    // The address field runs from the start character to the first comma.
+    const char* address = message.data() + 1;
+    size_t length = 0;
+    while (1 + length < message.size() && length <= MAX_ADDRESS_LENGTH &&
+           address[length] != ',' && address[length] != '*' &&
+           address[length] != '\r' && address[length] != '\n') {
+      length++;
+    }
+    for (const auto& pattern : m_sentences) {
+      if (MatchAddress(pattern, address, length)) return true;
+    }
+  }
+
+  uint32_t pgn;
+  return !m_pgns.empty() &&
+         GetN2KMessagePGN(message.data(), message.size(), &pgn) &&
+         std::binary_search(m_pgns.begin(), m_pgns.end(), pgn);
+}
+
+std::string VDRMessageFilter::ToString() const {
+  if (m_matchAll) return "*";
+  std::string patterns;
+  for (const auto& pattern : m_sentences) {
+    if (!patterns.empty()) patterns += ",";
+    patterns += pattern;
+  }
+  for (uint32_t pgn : m_pgns) {
+    if (!patterns.empty()) patterns += ",";
+    patterns += std::to_string(pgn);
+  }
+  return patterns;
+}
@@ -0,0 +1,73 @@
+/***************************************************************************
+ *   Copyright (C) 2024 by OpenCPN development team                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ **************************************************************************/
+
+#ifndef _VDR_FILTER_H_
+#define _VDR_FILTER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Selects the messages sent to a network client.
+ *
+ * A filter is a list of patterns separated by commas or spaces:
+ * - A sentence pattern is matched against the address field of NMEA 0183
+ *   and AIS sentences, e.g. GPRMC or AIVDM. A '?' matches any character,
+ *   and a trailing '*' matches the rest of the field: ??RMC, AI*.
+ * - A decimal number is an NMEA 2000 PGN, e.g. 129025, matched against the
+ *   NMEA 2000 messages in any format sent by the replay servers.
+ *
+ * An empty filter, or the "*" pattern, matches every message.
+ */
+class VDRMessageFilter {
+public:
+  VDRMessageFilter();
+
+  /**
+   * Replace the patterns of the filter.
+   *
+   * @param patterns Patterns separated by commas or spaces.
+   * @param error Set to the invalid pattern if parsing fails.
+   * @return False if a pattern is invalid, the filter is then unchanged.
+   */
+  bool Parse(const std::string& patterns, std::string* error = nullptr);
+
+  /** Whether every message matches. */
+  bool MatchesAll() const { return m_matchAll; }
+
+  /**
+   * Whether a message matches the filter.
+   *
+   * @param message Sentence starting with $ or !, line ending optional, or
+   * binary NMEA 2000 message.
+   */
+  bool Matches(const std::string& message) const;
+
+  /** Return the patterns, normalized. */
+  std::string ToString() const;
+
+private:
+  std::vector<std::string> m_sentences;  //!< Sentence patterns
+  std::vector<uint32_t> m_pgns;          //!< Sorted PGNs
+  bool m_matchAll;
+};
+
+#endif  // _VDR_FILTER_H_
@@ -0,0 +1,161 @@
+/***************************************************************************
+ *   Copyright (C) 2024 by OpenCPN development team                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ **************************************************************************/
+
+#include "vdr_follow.h"
+
+#include <fstream>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+VDRFileFollower::VDRFileFollower()
+    : m_active(false),
+      m_hadPartialLine(false),
+      m_offset(0),
+      m_notifyFd(-1),
+      m_callsSinceCheck(0) {}
+
+VDRFileFollower::~VDRFileFollower() { Stop(); }
+
+bool VDRFileFollower::Start(const std::string& path) {
+  Stop();
+
+  std::ifstream file(path, std::ios::binary | std::ios::ate);
+  if (!file.is_open()) return false;
+  std::streamoff size = file.tellg();
+  if (size < 0) return false;
+
+  // Find the start of the line being written, if any.
+  std::streamoff lineStart = size;
+  const std::streamoff CHUNK_SIZE = 4096;
+  char buffer[CHUNK_SIZE];
+  bool found = false;
+  while (lineStart > 0 && !found) {
+    std::streamoff chunkStart =
+        lineStart > CHUNK_SIZE ? lineStart - CHUNK_SIZE : 0;
+    std::streamoff chunkSize = lineStart - chunkStart;
+    file.seekg(chunkStart);
+    if (!file.read(buffer, chunkSize)) return false;
+    for (std::streamoff i = chunkSize; i > 0; i--) {
+      if (buffer[i - 1] == '\n') {
+        lineStart = chunkStart + i;
+        found = true;
+        break;
+      }
+    }
+    if (!found) lineStart = chunkStart;
+  }
+  if (lineStart < size) {
+    m_partial.resize(static_cast<size_t>(size - lineStart));
+    file.clear();
+    file.seekg(lineStart);
+    if (!file.read(&m_partial[0], size - lineStart)) return false;
+  }
+
+  m_path = path;
+  m_offset = static_cast<uint64_t>(size);
+  m_hadPartialLine = !m_partial.empty();
+  // Check the file size on the first call, data may have been appended
+  // before the watch was installed.
+  m_callsSinceCheck = FORCED_CHECK_INTERVAL;
+  m_active = true;
+
+#ifdef __linux__
+  m_notifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (m_notifyFd >= 0 &&
+      inotify_add_watch(m_notifyFd, path.c_str(), IN_MODIFY) < 0) {
+    close(m_notifyFd);
+    m_notifyFd = -1;
+  }
+#endif
+  return true;
+}
+
+void VDRFileFollower::Stop() {
+#ifdef __linux__
+  if (m_notifyFd >= 0) {
+    close(m_notifyFd);
+  }
+#endif
+  m_notifyFd = -1;
+  m_active = false;
+  m_hadPartialLine = false;
+  m_offset = 0;
+  m_partial.clear();
+  m_path.clear();
+}
+
+bool VDRFileFollower::HasPendingChanges() {
+  if (m_notifyFd < 0) return true;
+  if (++m_callsSinceCheck >= FORCED_CHECK_INTERVAL) {
+    m_callsSinceCheck = 0;
+    return true;
+  }
+#ifdef __linux__
+  // Drain the pending events, their content does not matter.
+  bool changed = false;
+  char events[4096];
+  while (read(m_notifyFd, events, sizeof(events)) > 0) {
+    changed = true;
+  }
+  return changed;
+#else
+  return true;
+#endif
+}
+
+size_t VDRFileFollower::ReadLines(std::vector<std::string>& lines) {
+  if (!m_active || !HasPendingChanges()) return 0;
+
+  std::ifstream file(m_path, std::ios::binary | std::ios::ate);
+  if (!file.is_open()) return 0;
+  std::streamoff size = file.tellg();
+  if (size < 0) return 0;
+  if (static_cast<uint64_t>(size) < m_offset) {
+    // The file has been truncated or replaced. Continue from its new end
+    // rather than replaying content that has already been read.
+    m_offset = static_cast<uint64_t>(size);
+    m_partial.clear();
+    return 0;
+  }
+  if (static_cast<uint64_t>(size) == m_offset) return 0;
+
+  std::string data(static_cast<size_t>(size - m_offset), '\0');
+  file.seekg(static_cast<std::streamoff>(m_offset));
+  file.read(&data[0], static_cast<std::streamsize>(data.size()));
+  data.resize(static_cast<size_t>(file.gcount()));
+  m_offset += data.size();
+
+  size_t count = 0;
+  size_t start = 0;
+  size_t end;
+  while ((end = data.find('\n', start)) != std::string::npos) {
+    std::string line = m_partial;
+    line.append(data, start, end - start);
+    m_partial.clear();
+    if (!line.empty() && line.back() == '\r') line.pop_back();
+    lines.push_back(std::move(line));
+    count++;
+    start = end + 1;
+  }
+  m_partial.append(data, start, std::string::npos);
+  return count;
+}
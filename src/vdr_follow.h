@@ -0,0 +1,108 @@
+/***************************************************************************
+ *   Copyright (C) 2024 by OpenCPN development team                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ **************************************************************************/
+
+#ifndef _VDR_FOLLOW_H_
+#define _VDR_FOLLOW_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Detect and read data appended to a file that is still being written.
+ *
+ * Used to replay a VDR recording while another OpenCPN instance is still
+ * recording it. Only the bytes appended after Start() are read, the existing
+ * content is never read again.
+ *
+ * On Linux, inotify is used to avoid checking the file size when nothing has
+ * been written. The size is still checked periodically because inotify does
+ * not report changes made through network file systems. Other platforms poll
+ * the file size on each call to ReadLines().
+ */
+class VDRFileFollower {
+public:
+  VDRFileFollower();
+  ~VDRFileFollower();
+
+  VDRFileFollower(const VDRFileFollower&) = delete;
+  VDRFileFollower& operator=(const VDRFileFollower&) = delete;
+
+  /**
+   * Start following a file from its current end.
+   *
+   * If the file does not end with a line terminator, the last line is still
+   * being written. It is kept and completed by the next call to ReadLines().
+   *
+   * @param path Path of the file.
+   * @return False if the file cannot be opened.
+   */
+  bool Start(const std::string& path);
+
+  /** Stop following the file. */
+  void Stop();
+
+  /** Check if a file is being followed. */
+  bool IsActive() const { return m_active; }
+
+  /**
+   * Check if the file ended with an incomplete line when Start() was called.
+   *
+   * The caller should discard that line from the content it already loaded,
+   * as it will be returned by ReadLines() once complete.
+   */
+  bool HasPartialLine() const { return m_hadPartialLine; }
+
+  /** Check if change notifications are used instead of polling. */
+  bool UsesNotifications() const { return m_notifyFd >= 0; }
+
+  /**
+   * Read the complete lines appended to the file since the last call.
+   *
+   * Line terminators are removed. An incomplete last line is kept until its
+   * terminator has been written.
+   *
+   * @param lines [out] Lines appended to the file.
+   * @return Number of lines added to the output vector.
+   */
+  size_t ReadLines(std::vector<std::string>& lines);
+
+  /** Get the offset of the next byte to be read. */
+  uint64_t GetOffset() const { return m_offset; }
+
+private:
+  /** Check whether the file may have changed since the last read. */
+  bool HasPendingChanges();
+
+  /** Number of calls between two size checks when notifications are used. */
+  static const int FORCED_CHECK_INTERVAL = 8;
+
+  std::string m_path;
+  bool m_active;
+  bool m_hadPartialLine;
+  /** Offset of the next byte to be read from the file. */
+  uint64_t m_offset;
+  /** Bytes of the line currently being written. */
+  std::string m_partial;
+  /** inotify file descriptor, -1 if notifications are not available. */
+  int m_notifyFd;
+  int m_callsSinceCheck;
+};
+
+#endif  // _VDR_FOLLOW_H_
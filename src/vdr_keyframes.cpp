@@ -0,0 +1,277 @@
+/***************************************************************************
+ *   Copyright (C) 2024 by OpenCPN development team                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ **************************************************************************/
+
+#include "vdr_keyframes.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace {
+
+/** Return the comma separated field at the given index, or an empty string. */
+std::string GetField(const std::string& message, int index) {
+  size_t start = 0;
+  for (int i = 0; i < index; i++) {
+    start = message.find(',', start);
+    if (start == std::string::npos) return std::string();
+    start++;
+  }
+  size_t end = message.find_first_of(",*", start);
+  if (end == std::string::npos) end = message.size();
+  return message.substr(start, end - start);
+}
+
+/** Return true if the message is an AIS VDM or VDO sentence. */
+bool IsAISSentence(const std::string& message) {
+  if (message.size() < 7 || message[0] != '!' || message[6] != ',') {
+    return false;
+  }
+  return message.compare(3, 3, "VDM") == 0 || message.compare(3, 3, "VDO") == 0;
+}
+
+/** PGNs of NMEA 2000 AIS messages, which carry the MMSI in data bytes 1-4. */
+bool IsAISPGN(const std::string& pgn) {
+  static const char* aisPgns[] = {"129038", "129039", "129040", "129041",
+                                  "129793", "129794", "129798", "129809",
+                                  "129810"};
+  for (const char* p : aisPgns) {
+    if (pgn == p) return true;
+  }
+  return false;
+}
+
+/** Build the snapshot key of an AIS message from its first fragment. */
+bool GetAISKey(const std::string& firstFragment, std::string& key) {
+  int type;
+  uint32_t mmsi;
+  int part;
+  if (!StateSnapshot::DecodeAISHeader(GetField(firstFragment, 5), type, mmsi,
+                                      part)) {
+    return false;
+  }
+  // Position reports of the same class replace each other.
+  if (type == 2 || type == 3) type = 1;
+  if (type == 19) type = 18;
+  key = firstFragment.substr(3, 3) + "," + std::to_string(mmsi) + "," +
+        std::to_string(type);
+  if (type == 24) key += "," + std::to_string(part);
+  return true;
+}
+
+}  // namespace
+
+bool StateSnapshot::DecodeAISHeader(const std::string& payload, int& type,
+                                    uint32_t& mmsi, int& part) {
+  // The first 40 bits (7 characters) hold the type, repeat indicator, MMSI
+  // and, for type 24, the part number.
+  if (payload.size() < 7) return false;
+  uint64_t bits = 0;
+  for (size_t i = 0; i < 7; i++) {
+    int value = static_cast<unsigned char>(payload[i]) - 48;
+    if (value < 0 || value > 71 || (value > 39 && value < 48)) return false;
+    if (value > 40) value -= 8;
+    bits = (bits << 6) | static_cast<uint64_t>(value);
+  }
+  // 42 bits have been read, bit 0 of the message is bit 41 of 'bits'.
+  type = static_cast<int>((bits >> 36) & 0x3F);
+  mmsi = static_cast<uint32_t>((bits >> 4) & 0x3FFFFFFF);
+  part = type == 24 ? static_cast<int>((bits >> 2) & 0x3) : 0;
+  return true;
+}
+
+bool StateSnapshot::GetMessageKey(const std::string& message,
+                                  std::string& key) {
+  if (message.size() < 2 || (message[0] != '$' && message[0] != '!')) {
+    return false;
+  }
+  if (IsAISSentence(message)) {
+    return GetAISKey(message, key);
+  }
+  size_t headerEnd = message.find_first_of(",*");
+  if (headerEnd == std::string::npos) headerEnd = message.size();
+  key = message.substr(0, headerEnd);
+
+  if (key == "$PCDIN") {
+    // NMEA 2000 message: one entry per PGN, and per MMSI for AIS PGNs.
+    std::string pgn = GetField(message, 1);
+    key += "," + pgn;
+    if (IsAISPGN(pgn)) {
+      // The VDR recording format stores the N2K payload with a 13 byte
+      // header, SeaSmart stores the data bytes in field 4.
+      std::string payload = GetField(message, 2);
+      std::string data = GetField(message, 4);
+      size_t offset = 2;  // Skip message ID and repeat indicator byte.
+      if (data.empty()) {
+        data = payload;
+        offset += 26;
+      }
+      if (data.size() >= offset + 8) {
+        key += "," + data.substr(offset, 8);
+      }
+    }
+  } else if (key == "$PVDSK") {
+    // Signal K record: one entry per dictionary id, and per context and
+    // path for the values. The dictionary entries are older than the values
+    // using them, so a snapshot can always be decoded.
+    std::string kind = GetField(message, 1);
+    key += "," + kind + "," + GetField(message, 2);
+    if (kind == "V") key += "," + GetField(message, 3);
+  } else if (key.size() == 6 && key.compare(3, 3, "GSV") == 0) {
+    // Satellites in view are spread over several sentences.
+    key += "," + GetField(message, 2);
+  }
+  return true;
+}
+
+void StateSnapshot::Clear() {
+  m_entries.clear();
+  m_aisFragments.clear();
+  m_aisSequenceId.clear();
+  m_sequence = 0;
+}
+
+void StateSnapshot::Update(const std::string& message) {
+  if (IsAISSentence(message)) {
+    UpdateAIS(message);
+    return;
+  }
+  std::string key;
+  if (!GetMessageKey(message, key)) return;
+  Entry& entry = m_entries[key];
+  entry.sequence = ++m_sequence;
+  entry.lines = std::make_shared<const std::vector<std::string>>(1, message);
+}
+
+void StateSnapshot::UpdateAIS(const std::string& message) {
+  int count = std::atoi(GetField(message, 1).c_str());
+  int number = std::atoi(GetField(message, 2).c_str());
+  std::string key;
+
+  if (count <= 1) {
+    if (!GetAISKey(message, key)) return;
+    Entry& entry = m_entries[key];
+    entry.sequence = ++m_sequence;
+    entry.lines = std::make_shared<const std::vector<std::string>>(1, message);
+    return;
+  }
+
+  std::string sequenceId = GetField(message, 3);
+  if (number == 1) {
+    m_aisFragments.assign(1, message);
+    m_aisSequenceId = sequenceId;
+  } else if (!m_aisFragments.empty() && sequenceId == m_aisSequenceId &&
+             number == static_cast<int>(m_aisFragments.size()) + 1) {
+    m_aisFragments.push_back(message);
+  } else {
+    // Missing fragment, drop the incomplete message.
+    m_aisFragments.clear();
+    return;
+  }
+
+  if (number == count) {
+    if (GetAISKey(m_aisFragments[0], key)) {
+      Entry& entry = m_entries[key];
+      entry.sequence = ++m_sequence;
+      entry.lines =
+          std::make_shared<const std::vector<std::string>>(m_aisFragments);
+    }
+    m_aisFragments.clear();
+  }
+}
+
+std::vector<std::string> StateSnapshot::GetMessages() const {
+  std::vector<const Entry*> entries;
+  entries.reserve(m_entries.size());
+  for (const auto& it : m_entries) {
+    entries.push_back(&it.second);
+  }
+  std::sort(entries.begin(), entries.end(),
+            [](const Entry* a, const Entry* b) {
+              return a->sequence < b->sequence;
+            });
+
+  std::vector<std::string> messages;
+  for (const Entry* entry : entries) {
+    messages.insert(messages.end(), entry->lines->begin(),
+                    entry->lines->end());
+  }
+  return messages;
+}
+
+KeyframeIndex::KeyframeIndex(int intervalLines, size_t maxKeyframes)
+    : m_baseIntervalLines(std::max(1, intervalLines)),
+      m_maxKeyframes(std::max<size_t>(2, maxKeyframes)),
+      m_intervalLines(m_baseIntervalLines),
+      m_linesSinceKeyframe(0) {}
+
+void KeyframeIndex::Clear() {
+  m_intervalLines = m_baseIntervalLines;
+  m_linesSinceKeyframe = 0;
+  m_keyframes.clear();
+  m_sourceTimes.clear();
+  m_state.Clear();
+}
+
+void KeyframeIndex::AddTimestamp(const std::string& sourceKey,
+                                 int64_t timestamp) {
+  m_sourceTimes[sourceKey] = timestamp;
+}
+
+void KeyframeIndex::AddLine(int line, const std::string& message) {
+  if (!message.empty()) {
+    m_state.Update(message);
+  }
+  if (++m_linesSinceKeyframe >= m_intervalLines) {
+    Keyframe keyframe;
+    keyframe.line = line;
+    keyframe.sourceTimes = m_sourceTimes;
+    keyframe.state = m_state;
+    m_keyframes.push_back(std::move(keyframe));
+    m_linesSinceKeyframe = 0;
+  }
+  if (m_keyframes.size() > m_maxKeyframes) {
+    // Keep the keyframes at multiples of the doubled interval. When the
+    // newest keyframe is dropped, the lines since the previous one count.
+    if (m_keyframes.size() % 2 == 1) m_linesSinceKeyframe += m_intervalLines;
+    size_t kept = 0;
+    for (size_t i = 1; i < m_keyframes.size(); i += 2) {
+      m_keyframes[kept++] = std::move(m_keyframes[i]);
+    }
+    m_keyframes.erase(m_keyframes.begin() + kept, m_keyframes.end());
+    m_intervalLines *= 2;
+  }
+}
+
+const Keyframe* KeyframeIndex::FindKeyframe(const std::string& sourceKey,
+                                            int64_t timestamp) const {
+  for (auto it = m_keyframes.rbegin(); it != m_keyframes.rend(); ++it) {
+    auto source = it->sourceTimes.find(sourceKey);
+    if (source != it->sourceTimes.end() && source->second < timestamp) {
+      return &(*it);
+    }
+  }
+  return nullptr;
+}
+
+const Keyframe* KeyframeIndex::FindKeyframeBeforeLine(int line) const {
+  for (auto it = m_keyframes.rbegin(); it != m_keyframes.rend(); ++it) {
+    if (it->line < line) return &(*it);
+  }
+  return nullptr;
+}
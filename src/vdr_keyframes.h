@@ -0,0 +1,197 @@
+/***************************************************************************
+ *   Copyright (C) 2024 by OpenCPN development team                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ **************************************************************************/
+
+#ifndef _VDR_KEYFRAMES_H_
+#define _VDR_KEYFRAMES_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Latest known message for each data item of a VDR recording.
+ *
+ * Messages are keyed by talker and sentence type (e.g. "$GPRMC"), by PGN for
+ * NMEA 2000 messages recorded as $PCDIN, and by MMSI and message type for AIS
+ * targets. Replaying the snapshot restores the state of every instrument and
+ * every AIS target without replaying the recording from the start.
+ *
+ * The messages are immutable and shared by the copies of a snapshot, a copy
+ * only duplicates the keys.
+ */
+class StateSnapshot {
+public:
+  StateSnapshot() : m_sequence(0) {}
+
+  /** Remove all messages from the snapshot. */
+  void Clear();
+
+  /**
+   * Update the snapshot with the next message of the recording.
+   *
+   * Multi-sentence AIS messages are kept together and only become part of the
+   * snapshot once the last fragment has been seen.
+   *
+   * @param message NMEA 0183, AIS or $PCDIN message without line terminator.
+   */
+  void Update(const std::string& message);
+
+  /**
+   * Get the messages of the snapshot, in the order they were last seen in the
+   * recording.
+   */
+  std::vector<std::string> GetMessages() const;
+
+  /** Get the number of distinct data items in the snapshot. */
+  size_t Size() const { return m_entries.size(); }
+
+  /**
+   * Get the key identifying the data item carried by a message.
+   *
+   * @param message Message to classify.
+   * @param key [out] Key of the data item.
+   * @return False if the message cannot be classified.
+   */
+  static bool GetMessageKey(const std::string& message, std::string& key);
+
+  /**
+   * Decode the message type and MMSI from an AIS armored payload.
+   *
+   * @param payload Six-bit armored payload (field 5 of a VDM/VDO sentence).
+   * @param type [out] AIS message type.
+   * @param mmsi [out] Source MMSI.
+   * @param part [out] Part number for type 24 static data reports, 0 otherwise.
+   * @return False if the payload is too short or contains invalid characters.
+   */
+  static bool DecodeAISHeader(const std::string& payload, int& type,
+                              uint32_t& mmsi, int& part);
+
+private:
+  typedef std::shared_ptr<const std::vector<std::string>> Lines;
+
+  struct Entry {
+    uint64_t sequence;  //!< Position of the last update.
+    Lines lines;        //!< All sentences of the message.
+  };
+
+  /** Handle one fragment of an AIS VDM/VDO message. */
+  void UpdateAIS(const std::string& message);
+
+  std::unordered_map<std::string, Entry> m_entries;
+  /** Fragments of the multi-sentence AIS message being assembled. */
+  std::vector<std::string> m_aisFragments;
+  /** Sequential message identifier of m_aisFragments. */
+  std::string m_aisSequenceId;
+  uint64_t m_sequence;
+};
+
+/**
+ * Playback state captured at a given line of a VDR recording.
+ */
+struct Keyframe {
+  /** Index of the last line of the file included in the snapshot. */
+  int line;
+  /** Latest timestamp of each time source, in milliseconds since epoch. */
+  std::unordered_map<std::string, int64_t> sourceTimes;
+  /** Latest message for each data item. */
+  StateSnapshot state;
+};
+
+/**
+ * Index of keyframes built while scanning a VDR recording.
+ *
+ * A keyframe is captured at regular intervals so that seeking can restore the
+ * display state immediately and only needs to read the lines between the
+ * keyframe and the seek position.
+ *
+ * The number of keyframes is bounded: when it is exceeded, every other
+ * keyframe is dropped and the interval is doubled, so long recordings use
+ * a bounded amount of memory at the cost of reading more lines on seek.
+ */
+class KeyframeIndex {
+public:
+  /** Default number of lines between two keyframes. */
+  static const int DEFAULT_INTERVAL_LINES = 1000;
+
+  /** Default largest number of keyframes in the index. */
+  static const size_t DEFAULT_MAX_KEYFRAMES = 512;
+
+  KeyframeIndex(int intervalLines = DEFAULT_INTERVAL_LINES,
+                size_t maxKeyframes = DEFAULT_MAX_KEYFRAMES);
+
+  /** Remove all keyframes and reset the current state. */
+  void Clear();
+
+  /**
+   * Record the timestamp of the line about to be added with AddLine().
+   *
+   * @param sourceKey Identifier of the time source.
+   * @param timestamp Timestamp in milliseconds since epoch.
+   */
+  void AddTimestamp(const std::string& sourceKey, int64_t timestamp);
+
+  /**
+   * Add the next line of the recording and capture a keyframe if the
+   * interval has elapsed.
+   *
+   * @param line Index of the line in the file.
+   * @param message Message carried by the line, or empty if the line does not
+   * contain a valid message.
+   */
+  void AddLine(int line, const std::string& message);
+
+  /**
+   * Find the last keyframe located strictly before a timestamp.
+   *
+   * @param sourceKey Time source used to compare timestamps.
+   * @param timestamp Target timestamp in milliseconds since epoch.
+   * @return Keyframe, or nullptr if no keyframe precedes the timestamp.
+   */
+  const Keyframe* FindKeyframe(const std::string& sourceKey,
+                               int64_t timestamp) const;
+
+  /**
+   * Find the last keyframe located strictly before a line.
+   *
+   * @param line Target line index.
+   * @return Keyframe, or nullptr if no keyframe precedes the line.
+   */
+  const Keyframe* FindKeyframeBeforeLine(int line) const;
+
+  /** Get the number of keyframes in the index. */
+  size_t GetCount() const { return m_keyframes.size(); }
+
+  /** Get the current number of lines between two keyframes. */
+  int GetIntervalLines() const { return m_intervalLines; }
+
+private:
+  int m_baseIntervalLines;  //!< Interval before the index is thinned
+  size_t m_maxKeyframes;
+  int m_intervalLines;
+  int m_linesSinceKeyframe;
+  std::vector<Keyframe> m_keyframes;
+  /** State at the current scan position. */
+  std::unordered_map<std::string, int64_t> m_sourceTimes;
+  StateSnapshot m_state;
+};
+
+#endif  // _VDR_KEYFRAMES_H_
@@ -0,0 +1,422 @@
+/***************************************************************************
+ *   Copyright (C) 2024 by OpenCPN development team                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ **************************************************************************/
+
+#include "vdr_n2k.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+
+const uint8_t DLE = 0x10;
+const uint8_t STX = 0x02;
+const uint8_t ETX = 0x03;
+/** Actisense command of a received NMEA 2000 message. */
+const uint8_t N2K_MSG_RECEIVED = 0x93;
+/** Bytes of the Actisense header before the data, after the length. */
+const size_t ACTISENSE_HEADER_SIZE = 11;
+/** Largest fast packet payload. */
+const size_t MAX_FAST_PACKET_SIZE = 223;
+
+/** Fast packet PGNs, sent in several frames even when they are short. */
+const uint32_t FAST_PACKET_PGNS[] = {
+    126208, 126464, 126720, 126996, 126998, 127233, 127237, 127489, 127496,
+    127497, 127498, 127503, 127504, 127506, 127507, 127509, 127510, 127511,
+    127512, 127513, 127514, 128275, 128520, 129029, 129038, 129039, 129040,
+    129041, 129044, 129045, 129284, 129285, 129301, 129302, 129538, 129540,
+    129541, 129542, 129545, 129547, 129549, 129551, 129556, 129792, 129793,
+    129794, 129795, 129796, 129797, 129798, 129799, 129800, 129801, 129802,
+    129803, 129804, 129805, 129806, 129807, 129808, 129809, 129810, 130060,
+    130061, 130064, 130065, 130066, 130067, 130068, 130069, 130070, 130071,
+    130072, 130073, 130074, 130320, 130321, 130322, 130323, 130324, 130330,
+    130560, 130561, 130562, 130563, 130564, 130565, 130566, 130567, 130569,
+    130570, 130571, 130572, 130573, 130574, 130577, 130578, 130579, 130580,
+    130581, 130582};
+
+bool IsFastPacketPGN(uint32_t pgn) {
+  // Proprietary fast packet range.
+  if (pgn >= 130816 && pgn <= 131071) return true;
+  return std::binary_search(std::begin(FAST_PACKET_PGNS),
+                            std::end(FAST_PACKET_PGNS), pgn);
+}
+
+int HexValue(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  return -1;
+}
+
+/**
+ * Parse a hexadecimal number.
+ *
+ * @return False if the text is empty, too long or not hexadecimal.
+ */
+bool ParseHex(const std::string& text, uint32_t* value) {
+  if (text.empty() || text.size() > 8) return false;
+  *value = 0;
+  for (char c : text) {
+    int digit = HexValue(c);
+    if (digit < 0) return false;
+    *value = *value * 16 + digit;
+  }
+  return true;
+}
+
+/** Parse hexadecimal bytes, two digits each. */
+bool ParseHexBytes(const std::string& text, std::vector<uint8_t>* bytes) {
+  if (text.size() % 2 != 0) return false;
+  bytes->clear();
+  bytes->reserve(text.size() / 2);
+  for (size_t i = 0; i < text.size(); i += 2) {
+    int high = HexValue(text[i]);
+    int low = HexValue(text[i + 1]);
+    if (high < 0 || low < 0) return false;
+    bytes->push_back(static_cast<uint8_t>(high * 16 + low));
+  }
+  return true;
+}
+
+/** Split comma separated fields, up to the checksum or line ending. */
+std::vector<std::string> SplitFields(const std::string& sentence) {
+  size_t end = sentence.find_first_of("*\r\n");
+  if (end == std::string::npos) end = sentence.size();
+  std::vector<std::string> fields;
+  size_t start = 0;
+  while (start <= end) {
+    size_t comma = sentence.find(',', start);
+    if (comma == std::string::npos || comma > end) comma = end;
+    fields.push_back(sentence.substr(start, comma - start));
+    start = comma + 1;
+  }
+  return fields;
+}
+
+/** CAN identifier of a message. */
+uint32_t GetCanId(const N2KMessage& message) {
+  uint32_t pduFormat = (message.pgn >> 8) & 0xFF;
+  // PDU1 messages are addressed, the destination replaces the low byte.
+  uint32_t pduSpecific =
+      pduFormat < 240 ? message.destination : (message.pgn & 0xFF);
+  return (static_cast<uint32_t>(message.priority & 0x7) << 26) |
+         ((message.pgn & 0x3FF00) << 8) | (pduSpecific << 8) | message.source;
+}
+
+/** Set the header fields of a message from a CAN identifier. */
+void SetCanId(uint32_t id, N2KMessage* message) {
+  uint32_t pduFormat = (id >> 16) & 0xFF;
+  uint32_t pduSpecific = (id >> 8) & 0xFF;
+  message->priority = static_cast<uint8_t>((id >> 26) & 0x7);
+  message->source = static_cast<uint8_t>(id & 0xFF);
+  message->pgn = ((id >> 8) & 0x3FF00) | (pduFormat < 240 ? 0 : pduSpecific);
+  message->destination =
+      static_cast<uint8_t>(pduFormat < 240 ? pduSpecific : 255);
+}
+
+/** Fast packet key of a message. */
+uint32_t GetPacketKey(const N2KMessage& message) {
+  return (message.pgn << 8) | message.source;
+}
+
+}  // namespace
+
+bool ParsePCDIN(const std::string& sentence, N2KMessage* message) {
+  if (sentence.compare(0, 7, "$PCDIN,") != 0) return false;
+  std::vector<std::string> fields = SplitFields(sentence);
+  *message = N2KMessage();
+
+  if (fields.size() >= 5) {
+    // SeaSmart: PGN, timestamp, source and data, all hexadecimal.
+    uint32_t pgn, timestamp, source;
+    if (!ParseHex(fields[1], &pgn) || !ParseHex(fields[2], &timestamp) ||
+        !ParseHex(fields[3], &source) || source > 0xFF ||
+        !ParseHexBytes(fields[4], &message->data)) {
+      return false;
+    }
+    message->pgn = pgn;
+    message->timestamp = timestamp;
+    message->source = static_cast<uint8_t>(source);
+    return message->data.size() <= MAX_FAST_PACKET_SIZE;
+  }
+
+  // VDR recording: decimal PGN and the OpenCPN payload.
+  std::vector<uint8_t> payload;
+  if (fields.size() != 3 || !ParseHexBytes(fields[2], &payload) ||
+      payload.size() < 2 + ACTISENSE_HEADER_SIZE) {
+    return false;
+  }
+  size_t length = payload[12];
+  if (payload.size() < 2 + ACTISENSE_HEADER_SIZE + length) return false;
+  message->priority = payload[2] & 0x7;
+  message->pgn = payload[3] | (payload[4] << 8) | ((payload[5] & 0x3) << 16);
+  message->destination = payload[6];
+  message->source = payload[7];
+  message->timestamp = payload[8] | (payload[9] << 8) | (payload[10] << 16) |
+                       (static_cast<uint32_t>(payload[11]) << 24);
+  message->data.assign(payload.begin() + 13, payload.begin() + 13 + length);
+  return true;
+}
+
+std::vector<uint8_t> MakeN2KPayload(const N2KMessage& message) {
+  size_t length = std::min(message.data.size(), MAX_FAST_PACKET_SIZE);
+  std::vector<uint8_t> payload;
+  payload.reserve(2 + ACTISENSE_HEADER_SIZE + length);
+  payload.push_back(N2K_MSG_RECEIVED);
+  payload.push_back(static_cast<uint8_t>(ACTISENSE_HEADER_SIZE + length));
+  payload.push_back(message.priority);
+  payload.push_back(static_cast<uint8_t>(message.pgn));
+  payload.push_back(static_cast<uint8_t>(message.pgn >> 8));
+  payload.push_back(static_cast<uint8_t>(message.pgn >> 16));
+  payload.push_back(message.destination);
+  payload.push_back(message.source);
+  for (int shift = 0; shift < 32; shift += 8) {
+    payload.push_back(static_cast<uint8_t>(message.timestamp >> shift));
+  }
+  payload.push_back(static_cast<uint8_t>(length));
+  payload.insert(payload.end(), message.data.begin(),
+                 message.data.begin() + length);
+  return payload;
+}
+
+bool GetN2KMessagePGN(const char* data, size_t length, uint32_t* pgn) {
+  std::string text(data, std::min<size_t>(length, 64));
+  if (text.compare(0, 7, "$PCDIN,") == 0) {
+    // Only the PGN field is needed, the variant is told by the number of
+    // fields.
+    size_t fields = std::count(data, data + length, ',') + 1;
+    std::string field = text.substr(7, text.find(',', 7) - 7);
+    if (fields >= 5) return ParseHex(field, pgn);
+    char* end;
+    unsigned long value = std::strtoul(field.c_str(), &end, 10);
+    *pgn = static_cast<uint32_t>(value);
+    return !field.empty() && *end == '\0';
+  }
+  if (text.compare(0, 7, "$MXPGN,") == 0) {
+    return ParseHex(text.substr(7, text.find(',', 7) - 7), pgn);
+  }
+  if (length >= 8 && static_cast<uint8_t>(data[0]) == DLE &&
+      data[1] == STX) {
+    // The header of the Actisense message, DLE bytes are escaped.
+    uint8_t header[6];
+    size_t count = 0;
+    for (size_t i = 2; i < length && count < sizeof(header); i++) {
+      if (static_cast<uint8_t>(data[i]) == DLE) i++;
+      if (i < length) header[count++] = static_cast<uint8_t>(data[i]);
+    }
+    if (count < sizeof(header) || header[0] != N2K_MSG_RECEIVED) {
+      return false;
+    }
+    *pgn = header[3] | (header[4] << 8) | ((header[5] & 0x3) << 16);
+    return true;
+  }
+  // YD RAW: "hh:mm:ss.sss R <CAN id> ..."
+  uint32_t id;
+  if (text.size() > 23 && text[2] == ':' && text[12] == ' ' &&
+      text[14] == ' ' && ParseHex(text.substr(15, 8), &id)) {
+    N2KMessage message;
+    SetCanId(id, &message);
+    *pgn = message.pgn;
+    return true;
+  }
+  return false;
+}
+
+std::string EncodeActisenseN2K(const N2KMessage& message) {
+  size_t length = std::min(message.data.size(), MAX_FAST_PACKET_SIZE);
+  uint8_t header[] = {N2K_MSG_RECEIVED,
+                      static_cast<uint8_t>(ACTISENSE_HEADER_SIZE + length),
+                      static_cast<uint8_t>(message.priority & 0x7),
+                      static_cast<uint8_t>(message.pgn & 0xFF),
+                      static_cast<uint8_t>((message.pgn >> 8) & 0xFF),
+                      static_cast<uint8_t>((message.pgn >> 16) & 0x3),
+                      message.destination,
+                      message.source,
+                      static_cast<uint8_t>(message.timestamp & 0xFF),
+                      static_cast<uint8_t>((message.timestamp >> 8) & 0xFF),
+                      static_cast<uint8_t>((message.timestamp >> 16) & 0xFF),
+                      static_cast<uint8_t>((message.timestamp >> 24) & 0xFF),
+                      static_cast<uint8_t>(length)};
+
+  std::string frame;
+  frame.reserve(2 * (sizeof(header) + length) + 5);
+  frame += static_cast<char>(DLE);
+  frame += static_cast<char>(STX);
+  uint8_t sum = 0;
+  auto append = [&frame, &sum](uint8_t byte) {
+    sum += byte;
+    if (byte == DLE) frame += static_cast<char>(DLE);
+    frame += static_cast<char>(byte);
+  };
+  for (uint8_t byte : header) append(byte);
+  for (size_t i = 0; i < length; i++) append(message.data[i]);
+  // The checksum makes the sum of all the bytes zero.
+  append(static_cast<uint8_t>(-sum));
+  frame += static_cast<char>(DLE);
+  frame += static_cast<char>(ETX);
+  return frame;
+}
+
+bool DecodeActisenseN2K(const uint8_t* data, size_t length,
+                        N2KMessage* message, size_t* consumed) {
+  if (length < 2 || data[0] != DLE || data[1] != STX) return false;
+  std::vector<uint8_t> body;
+  size_t i = 2;
+  bool complete = false;
+  while (i < length) {
+    if (data[i] == DLE) {
+      if (i + 1 >= length) return false;
+      if (data[i + 1] == ETX) {
+        i += 2;
+        complete = true;
+        break;
+      }
+      if (data[i + 1] != DLE) return false;
+      i++;
+    }
+    body.push_back(data[i++]);
+  }
+  if (!complete || body.size() < 3 + ACTISENSE_HEADER_SIZE ||
+      body[0] != N2K_MSG_RECEIVED ||
+      body.size() != static_cast<size_t>(body[1]) + 3) {
+    return false;
+  }
+  uint8_t sum = 0;
+  for (uint8_t byte : body) sum += byte;
+  size_t dataLength = body[12];
+  if (sum != 0 || 13 + dataLength + 1 != body.size()) return false;
+
+  *message = N2KMessage();
+  message->priority = body[2] & 0x7;
+  message->pgn = body[3] | (body[4] << 8) | ((body[5] & 0x3) << 16);
+  message->destination = body[6];
+  message->source = body[7];
+  message->timestamp = body[8] | (body[9] << 8) | (body[10] << 16) |
+                       (static_cast<uint32_t>(body[11]) << 24);
+  message->data.assign(body.begin() + 13, body.begin() + 13 + dataLength);
+  *consumed = i;
+  return true;
+}
+
+std::string YDRawEncoder::Encode(const N2KMessage& message, int64_t timeMs) {
+  int64_t msOfDay = ((timeMs % 86400000) + 86400000) % 86400000;
+  char prefix[32];
+  snprintf(prefix, sizeof(prefix), "%02d:%02d:%02d.%03d R %08X",
+           static_cast<int>(msOfDay / 3600000),
+           static_cast<int>(msOfDay / 60000 % 60),
+           static_cast<int>(msOfDay / 1000 % 60),
+           static_cast<int>(msOfDay % 1000),
+           static_cast<unsigned>(GetCanId(message)));
+
+  // Each frame is the prefix followed by up to 8 data bytes.
+  std::string frames;
+  auto addFrame = [&frames, &prefix](const uint8_t* bytes, size_t count) {
+    frames += prefix;
+    char byte[4];
+    for (size_t i = 0; i < count; i++) {
+      snprintf(byte, sizeof(byte), " %02X", bytes[i]);
+      frames += byte;
+    }
+    frames += "\r\n";
+  };
+
+  size_t length = std::min(message.data.size(), MAX_FAST_PACKET_SIZE);
+  if (length <= 8 && !IsFastPacketPGN(message.pgn)) {
+    addFrame(message.data.data(), length);
+    return frames;
+  }
+
+  // Fast packet: the first frame holds the length and 6 bytes, the next
+  // ones 7 bytes each. The last frame is padded with 0xFF.
+  uint8_t sequence = m_sequences[GetPacketKey(message)]++ & 0x7;
+  size_t offset = 0;
+  for (uint8_t frame = 0; offset < length || frame == 0; frame++) {
+    uint8_t bytes[8];
+    size_t count = 0;
+    bytes[count++] = static_cast<uint8_t>((sequence << 5) | (frame & 0x1F));
+    if (frame == 0) bytes[count++] = static_cast<uint8_t>(length);
+    while (count < 8) {
+      bytes[count++] = offset < length ? message.data[offset++] : 0xFF;
+    }
+    addFrame(bytes, count);
+  }
+  return frames;
+}
+
+bool YDRawDecoder::Decode(const std::string& line, N2KMessage* message) {
+  // "hh:mm:ss.sss R 19F51323 01 02 03"
+  uint32_t id;
+  if (line.size() < 23 || line[2] != ':' || line[12] != ' ' ||
+      line[14] != ' ' || !ParseHex(line.substr(15, 8), &id)) {
+    return false;
+  }
+  std::vector<uint8_t> bytes;
+  size_t end = line.find_first_of("\r\n");
+  if (end == std::string::npos) end = line.size();
+  for (size_t i = 23; i < end; i += 3) {
+    uint32_t value;
+    if (line[i] != ' ' || i + 3 > end ||
+        !ParseHex(line.substr(i + 1, 2), &value)) {
+      return false;
+    }
+    bytes.push_back(static_cast<uint8_t>(value));
+  }
+  if (bytes.size() > 8) return false;
+
+  N2KMessage header;
+  SetCanId(id, &header);
+  if (!IsFastPacketPGN(header.pgn)) {
+    *message = header;
+    message->data = bytes;
+    return true;
+  }
+
+  // Fast packet frame.
+  if (bytes.empty()) return false;
+  uint8_t sequence = bytes[0] >> 5;
+  uint8_t frame = bytes[0] & 0x1F;
+  uint32_t key = GetPacketKey(header);
+  if (frame == 0) {
+    if (bytes.size() < 2) return false;
+    FastPacket& packet = m_packets[key];
+    packet.sequence = sequence;
+    packet.nextFrame = 1;
+    packet.length = bytes[1];
+    packet.message = header;
+    packet.message.data.assign(bytes.begin() + 2, bytes.end());
+  } else {
+    auto it = m_packets.find(key);
+    if (it == m_packets.end() || it->second.sequence != sequence ||
+        it->second.nextFrame != frame) {
+      // A frame was lost, the message is dropped.
+      m_packets.erase(key);
+      return false;
+    }
+    it->second.nextFrame++;
+    it->second.message.data.insert(it->second.message.data.end(),
+                                   bytes.begin() + 1, bytes.end());
+  }
+
+  FastPacket& packet = m_packets[key];
+  if (packet.message.data.size() < packet.length) return false;
+  packet.message.data.resize(packet.length);
+  *message = packet.message;
+  m_packets.erase(key);
+  return true;
+}
@@ -0,0 +1,141 @@
+/***************************************************************************
+ *   Copyright (C) 2024 by OpenCPN development team                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ **************************************************************************/
+
+#ifndef _VDR_N2K_H_
+#define _VDR_N2K_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+/** NMEA 2000 message with the fields of its CAN header. */
+struct N2KMessage {
+  uint32_t pgn;          //!< Parameter group number
+  uint8_t priority;      //!< 0 (highest) to 7
+  uint8_t source;        //!< Source address
+  uint8_t destination;   //!< Destination address, 255 for broadcast
+  uint32_t timestamp;    //!< Milliseconds, from the Actisense header
+  std::vector<uint8_t> data;  //!< Message data, up to 223 bytes
+
+  N2KMessage()
+      : pgn(0), priority(2), source(0), destination(255), timestamp(0) {}
+};
+
+/**
+ * Parse an NMEA 2000 message in the $PCDIN format.
+ *
+ * Accepts the VDR recording format "$PCDIN,<pgn>,<payload>", where the PGN
+ * is decimal and the payload is the message as delivered by OpenCPN (an
+ * Actisense N2K message without framing) in hexadecimal, and the SeaSmart
+ * format "$PCDIN,<pgn>,<timestamp>,<source>,<data>*hh", all hexadecimal.
+ *
+ * @param sentence Sentence, line ending optional.
+ * @param message Parsed message.
+ * @return False if the sentence is not a valid $PCDIN message.
+ */
+bool ParsePCDIN(const std::string& sentence, N2KMessage* message);
+
+/**
+ * Build the payload of a message as delivered by OpenCPN, and recorded in
+ * the VDR $PCDIN format: an Actisense N2K message without framing.
+ */
+std::vector<uint8_t> MakeN2KPayload(const N2KMessage& message);
+
+/**
+ * Get the PGN of an NMEA 2000 message in any of the formats sent by the
+ * replay servers: $PCDIN (both variants), $MXPGN, Actisense N2K binary or
+ * YD RAW.
+ *
+ * @return False if the data is not a recognized NMEA 2000 message.
+ */
+bool GetN2KMessagePGN(const char* data, size_t length, uint32_t* pgn);
+
+/**
+ * Encode a message as an Actisense N2K binary message.
+ *
+ * The message is framed by DLE STX and DLE ETX, with DLE bytes escaped and
+ * a trailing checksum, as sent by the Actisense NGT-1.
+ */
+std::string EncodeActisenseN2K(const N2KMessage& message);
+
+/**
+ * Decode an Actisense N2K binary message.
+ *
+ * @param data Bytes starting with DLE STX.
+ * @param length Number of bytes.
+ * @param message Decoded message.
+ * @param consumed Set to the number of bytes of the message.
+ * @return False if the data does not start with a complete, valid message.
+ */
+bool DecodeActisenseN2K(const uint8_t* data, size_t length,
+                        N2KMessage* message, size_t* consumed);
+
+/**
+ * Encoder of NMEA 2000 messages as YD RAW CAN frames.
+ *
+ * Each frame is a line "hh:mm:ss.sss R <CAN id> <data bytes>". The messages
+ * of the known fast packet PGNs, and any message longer than 8 bytes, are
+ * split into fast packet frames numbered with a sequence counter per PGN and
+ * source.
+ */
+class YDRawEncoder {
+public:
+  /**
+   * Encode a message.
+   *
+   * @param message Message to encode.
+   * @param timeMs Time of the frames, in milliseconds since epoch (UTC).
+   * @return The frames, each one ending with CR LF.
+   */
+  std::string Encode(const N2KMessage& message, int64_t timeMs);
+
+private:
+  std::map<uint32_t, uint8_t> m_sequences;  //!< Next fast packet sequence
+};
+
+/**
+ * Decoder of YD RAW CAN frames, reassembling the fast packets of the known
+ * fast packet PGNs.
+ */
+class YDRawDecoder {
+public:
+  /**
+   * Decode a frame.
+   *
+   * @param line Frame, line ending optional.
+   * @param message Set when the frame completes a message.
+   * @return True if a message is complete.
+   */
+  bool Decode(const std::string& line, N2KMessage* message);
+
+private:
+  /** Partially received fast packet. */
+  struct FastPacket {
+    uint8_t sequence;
+    uint8_t nextFrame;
+    size_t length;
+    N2KMessage message;
+  };
+
+  std::map<uint32_t, FastPacket> m_packets;  //!< By PGN and source
+};
+
+#endif  // _VDR_N2K_H_
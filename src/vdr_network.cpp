@@ -16,33 +16,298 @@
  *   Free Software Foundation, Inc.,                                       *
  *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
  **************************************************************************/
+// The socket headers must come first, windows.h would otherwise pull in
+// the obsolete winsock.h.
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
 
 #include "vdr_network.h"
 
+#include <wx/tokenzr.h>
+
 #include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstring>
+
+typedef VDRNetworkServer::Socket Socket;
+
+#ifdef _WIN32
+static const Socket INVALID_SOCKET_HANDLE = INVALID_SOCKET;
+#define VDR_POLL WSAPoll
+
+static void CloseSocket(Socket socket) { closesocket(socket); }
+
+static bool SetNonBlocking(Socket socket) {
+  u_long mode = 1;
+  return ioctlsocket(socket, FIONBIO, &mode) == 0;
+}
+
+static bool WouldBlock() {
+  int error = WSAGetLastError();
+  return error == WSAEWOULDBLOCK || error == WSAEINTR;
+}
+
+static bool ConnectInProgress() {
+  return WSAGetLastError() == WSAEWOULDBLOCK;
+}
+#else
+static const Socket INVALID_SOCKET_HANDLE = -1;
+#define VDR_POLL poll
+
+static void CloseSocket(Socket socket) { close(socket); }
+
+static bool SetNonBlocking(Socket socket) {
+  int flags = fcntl(socket, F_GETFL, 0);
+  return flags >= 0 && fcntl(socket, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+static bool WouldBlock() {
+  return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+}
+
+static bool ConnectInProgress() { return errno == EINPROGRESS; }
+#endif
+
+// Writing to a closed connection must not raise SIGPIPE.
+#ifdef MSG_NOSIGNAL
+static const int SEND_FLAGS = MSG_NOSIGNAL;
+#else
+static const int SEND_FLAGS = 0;
+#endif
+
+#if defined(__linux__) && !defined(__ANDROID__)
+#define VDR_HAVE_SENDMMSG
+/** Largest number of datagrams sent by one sendmmsg() call. */
+static const size_t MAX_SENDMMSG = 1024;
+#endif
+
+/** Longest wait of the I/O thread, to apply the slow client policy. */
+static const int POLL_INTERVAL_MS = 100;
+
+/** Longest wait for a TCP connection to a network source. */
+static const int CONNECT_TIMEOUT_MS = 5000;
+
+/** Monotonic time in milliseconds, to measure how far clients lag. */
+static int64_t NowMs() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+/**
+ * Write buffers with a single system call.
+ *
+ * @param socket Socket to write to.
+ * @param buffers Data and length of each buffer.
+ * @param dest Datagram destination, nullptr on a connected socket.
+ * @return Number of bytes written, -1 on error.
+ */
+static long SendBuffers(
+    Socket socket, const std::vector<std::pair<const char*, size_t>>& buffers,
+    const sockaddr_in* dest) {
+#ifdef _WIN32
+  std::vector<WSABUF> wsaBuffers;
+  for (const auto& buffer : buffers) {
+    WSABUF wsaBuffer;
+    wsaBuffer.buf = const_cast<char*>(buffer.first);
+    wsaBuffer.len = static_cast<ULONG>(buffer.second);
+    wsaBuffers.push_back(wsaBuffer);
+  }
+  DWORD sent = 0;
+  int result = WSASendTo(socket, wsaBuffers.data(),
+                         static_cast<DWORD>(wsaBuffers.size()), &sent, 0,
+                         reinterpret_cast<const sockaddr*>(dest),
+                         dest ? sizeof(*dest) : 0, nullptr, nullptr);
+  return result == SOCKET_ERROR ? -1 : static_cast<long>(sent);
+#else
+  std::vector<iovec> iovecs;
+  for (const auto& buffer : buffers) {
+    iovecs.push_back({const_cast<char*>(buffer.first), buffer.second});
+  }
+  msghdr header = {};
+  header.msg_name = const_cast<sockaddr_in*>(dest);
+  header.msg_namelen = dest ? sizeof(*dest) : 0;
+  header.msg_iov = iovecs.data();
+  header.msg_iovlen = iovecs.size();
+  return static_cast<long>(sendmsg(socket, &header, SEND_FLAGS));
+#endif
+}
+
+/** IPv4 address and port, in host byte order. */
+static sockaddr_in MakeAddress(uint32_t ip, int port) {
+  sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(ip);
+  addr.sin_port = htons(static_cast<uint16_t>(port));
+  return addr;
+}
+
+/** Loopback address and port. */
+static sockaddr_in LoopbackAddress(int port) {
+  return MakeAddress(INADDR_LOOPBACK, port);
+}
+
+/**
+ * Resolve an IPv4 host name or address.
+ *
+ * @param host Host name or dotted address.
+ * @param ip Address in host byte order.
+ * @return False if the host is unknown.
+ */
+static bool ResolveHost(const wxString& host, uint32_t* ip) {
+  addrinfo hints = {};
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_DGRAM;
+  addrinfo* result = nullptr;
+  if (getaddrinfo(host.ToStdString().c_str(), nullptr, &hints, &result) != 0 ||
+      !result) {
+    return false;
+  }
+  *ip = ntohl(reinterpret_cast<sockaddr_in*>(result->ai_addr)->sin_addr.s_addr);
+  freeaddrinfo(result);
+  return true;
+}
+
+VDRMessagePtr MakeVDRMessage(const wxString& text) {
+  std::string data = text.ToStdString();
+  if (!text.EndsWith("\r\n")) {
+    data += "\r\n";
+  }
+  return std::make_shared<const std::string>(std::move(data));
+}
+
+VDRSendQueue::VDRSendQueue(size_t maxBytes)
+    : m_offset(0),
+      m_bytes(0),
+      m_maxBytes(maxBytes),
+      m_bytesSent(0),
+      m_messagesDropped(0),
+      m_bytesDropped(0) {}
+
+void VDRSendQueue::SetMaxBytes(size_t maxBytes) {
+  m_maxBytes = maxBytes;
+  MakeRoom(0);
+}
+
+bool VDRSendQueue::Push(const VDRMessagePtr& message, int64_t nowMs) {
+  size_t length = message ? message->size() : 0;
+  if (length == 0) return true;
+  if (length <= m_maxBytes) MakeRoom(length);
+  if (m_bytes + length > m_maxBytes) {
+    m_messagesDropped++;
+    m_bytesDropped += length;
+    return false;
+  }
+  m_messages.push_back({message, nowMs});
+  m_bytes += length;
+  return true;
+}
+
+bool VDRSendQueue::Push(const void* data, size_t length, int64_t nowMs) {
+  return Push(std::make_shared<const std::string>(
+                  static_cast<const char*>(data), length),
+              nowMs);
+}
+
+void VDRSendQueue::MakeRoom(size_t length) {
+  // The oldest message is kept if it has been partially sent.
+  size_t first = m_offset > 0 ? 1 : 0;
+  while (m_bytes + length > m_maxBytes && m_messages.size() > first) {
+    auto it = m_messages.begin() + first;
+    size_t size = it->data->size() - (first == 0 ? m_offset : 0);
+    m_bytes -= size;
+    m_messagesDropped++;
+    m_bytesDropped += size;
+    m_messages.erase(it);
+  }
+}
+
+const char* VDRSendQueue::GetFrontData() const {
+  return m_messages.empty() ? nullptr
+                            : m_messages.front().data->data() + m_offset;
+}
+
+size_t VDRSendQueue::GetFrontLength() const {
+  return m_messages.empty() ? 0 : m_messages.front().data->size() - m_offset;
+}
+
+void VDRSendQueue::GetPending(
+    std::vector<std::pair<const char*, size_t>>& buffers,
+    size_t maxBuffers) const {
+  buffers.clear();
+  size_t offset = m_offset;
+  for (const auto& message : m_messages) {
+    if (buffers.size() >= maxBuffers) break;
+    buffers.emplace_back(message.data->data() + offset,
+                         message.data->size() - offset);
+    offset = 0;
+  }
+}
+
+void VDRSendQueue::Consume(size_t length) {
+  length = std::min(length, m_bytes);
+  m_bytes -= length;
+  m_bytesSent += length;
+  while (length > 0) {
+    size_t consumed = std::min(length, GetFrontLength());
+    length -= consumed;
+    m_offset += consumed;
+    if (m_offset == m_messages.front().data->size()) {
+      m_messages.pop_front();
+      m_offset = 0;
+    }
+  }
+}
+
+void VDRSendQueue::Drop(size_t messages, size_t bytes) {
+  m_messagesDropped += messages;
+  m_bytesDropped += bytes;
+}
 
-// Socket event IDs
-enum { SOCKET_ID = 5000, SERVER_ID };
+int64_t VDRSendQueue::GetLagMs(int64_t nowMs) const {
+  return m_messages.empty() ? 0 : nowMs - m_messages.front().queuedMs;
+}
 
-BEGIN_EVENT_TABLE(VDRNetworkServer, wxEvtHandler)
-EVT_SOCKET(SERVER_ID, VDRNetworkServer::OnTcpEvent)
-EVT_SOCKET(SOCKET_ID, VDRNetworkServer::OnTcpEvent)
-END_EVENT_TABLE()
 
 VDRNetworkServer::VDRNetworkServer()
-    : m_tcpServer(nullptr),
-      m_udpSocket(nullptr),
+    : m_listenSocket(INVALID_SOCKET_HANDLE),
+      m_udpSocket(INVALID_SOCKET_HANDLE),
+      m_wakeupSocket(INVALID_SOCKET_HANDLE),
       m_running(false),
       m_useTCP(true),
-      m_port(DEFAULT_PORT) {
+      m_port(DEFAULT_PORT),
+      m_stopRequested(false),
+      m_wakeupPending(false),
+      m_outbound(MAX_PENDING_BATCHES),
+      m_batchesDropped(0) {
+#ifdef _WIN32
   // Initialize socket handling
-  wxSocketBase::Initialize();
+  WSADATA data;
+  WSAStartup(MAKEWORD(2, 2), &data);
+#endif
 }
 
 VDRNetworkServer::~VDRNetworkServer() {
   if (m_running) {
     Stop();
   }
+#ifdef _WIN32
+  WSACleanup();
+#endif
 }
 
 bool VDRNetworkServer::Start(bool useTCP, int port, wxString& error) {
@@ -61,31 +326,92 @@ bool VDRNetworkServer::Start(bool useTCP, int port, wxString& error) {
     return false;
   }
 
-  bool success = m_useTCP ? InitTCP(port, error) : InitUDP(port, error);
-
-  if (success) {
-    m_running = true;
-    error = wxEmptyString;
-    wxLogMessage("VDR Network Server started - %s on port %d",
-                 m_useTCP ? "TCP" : "UDP", m_port);
+  bool success = InitWakeup(error) &&
+                 (m_useTCP ? InitTCP(port, error) : InitUDP(port, error));
+  if (!success) {
+    CloseSockets();
+    return false;
   }
-  return success;
+
+  m_stopRequested = false;
+  m_wakeupPending = false;
+  m_thread = std::thread(&VDRNetworkServer::Run, this);
+  m_running = true;
+  error = wxEmptyString;
+  wxLogMessage("VDR Network Server started - %s on port %d",
+               m_useTCP ? "TCP" : "UDP", m_port);
+  return true;
 }
 
 void VDRNetworkServer::Stop() {
-  if (m_tcpServer) {
-    m_tcpServer->Notify(false);
-    delete m_tcpServer;
-    m_tcpServer = nullptr;
+  if (m_thread.joinable()) {
+    m_stopRequested = true;
+    m_wakeupPending = false;
+    Wakeup();
+    m_thread.join();
   }
+  CloseSockets();
 
-  if (m_udpSocket) {
-    delete m_udpSocket;
-    m_udpSocket = nullptr;
+  // The I/O thread is gone, drop what it did not send.
+  Batch batch;
+  while (m_outbound.Pop(batch)) {
   }
+  m_batch = Batch();
+  m_running = false;
+}
 
+void VDRNetworkServer::CloseSockets() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  for (auto& client : m_tcpClients) {
+    CloseSocket(client->socket);
+  }
   m_tcpClients.clear();
-  m_running = false;
+  for (Socket* socket : {&m_listenSocket, &m_udpSocket, &m_wakeupSocket}) {
+    if (*socket != INVALID_SOCKET_HANDLE) {
+      CloseSocket(*socket);
+      *socket = INVALID_SOCKET_HANDLE;
+    }
+  }
+}
+
+bool VDRNetworkServer::SetFilter(const wxString& patterns, wxString& error) {
+  std::string invalid;
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (!m_filter.Parse(patterns.ToStdString(), &invalid)) {
+    error =
+        wxString::Format(_("Invalid filter pattern %s"), wxString(invalid));
+    return false;
+  }
+  error = wxEmptyString;
+  return true;
+}
+
+wxString VDRNetworkServer::GetFilter() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_filter.MatchesAll() ? wxString() : wxString(m_filter.ToString());
+}
+
+void VDRNetworkServer::SetClientQueueSettings(
+    const VDRClientQueueSettings& settings) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_queueSettings = settings;
+}
+
+VDRClientQueueSettings VDRNetworkServer::GetClientQueueSettings() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_queueSettings;
+}
+
+std::vector<VDRClientStats> VDRNetworkServer::GetClientStats() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  std::vector<VDRClientStats> stats;
+  for (const auto& client : m_tcpClients) {
+    stats.push_back({client->address, client->queue.GetBytesSent(),
+                     client->queue.GetBytes(),
+                     client->queue.GetMessagesDropped(),
+                     client->queue.GetBytesDropped()});
+  }
+  return stats;
 }
 
 bool VDRNetworkServer::SendText(const wxString& message) {
@@ -93,12 +419,39 @@ bool VDRNetworkServer::SendText(const wxString& message) {
     return false;
   }
 
-  // Ensure message ends with proper line ending
-  wxString formattedMsg = message;
-  if (!formattedMsg.EndsWith("\r\n")) {
-    formattedMsg += "\r\n";
+  Batch batch;
+  batch.messages.push_back(MakeVDRMessage(message));
+  batch.bytes = batch.messages.back()->size();
+  return Post(std::move(batch));
+}
+
+void VDRNetworkServer::QueueText(const wxString& message) {
+  if (!m_running) {
+    return;
+  }
+  QueueMessage(MakeVDRMessage(message));
+}
+
+void VDRNetworkServer::QueueMessage(const VDRMessagePtr& message) {
+  if (!m_running || !message) {
+    return;
+  }
+
+  m_batch.messages.push_back(message);
+  m_batch.bytes += message->size();
+  if (m_batch.bytes >= MAX_BATCH_SIZE) {
+    Flush();
   }
-  return SendImpl(formattedMsg.c_str(), formattedMsg.Length());
+}
+
+bool VDRNetworkServer::Flush() {
+  if (m_batch.messages.empty()) {
+    return true;
+  }
+
+  Batch batch;
+  std::swap(batch, m_batch);
+  return Post(std::move(batch));
 }
 
 bool VDRNetworkServer::SendBinary(const void* data, size_t length) {
@@ -106,148 +459,742 @@ bool VDRNetworkServer::SendBinary(const void* data, size_t length) {
     return false;
   }
 
-  return SendImpl(data, length);
+  Batch batch;
+  batch.messages.push_back(std::make_shared<const std::string>(
+      static_cast<const char*>(data), length));
+  batch.bytes = length;
+  return Post(std::move(batch));
 }
 
-bool VDRNetworkServer::SendImpl(const void* data, size_t length) {
-  if (m_useTCP) {
-    // Remove any dead connections before sending
-    CleanupDeadConnections();
+void VDRNetworkServer::QueueBinary(const void* data, size_t length) {
+  if (!m_running || !data || length == 0) {
+    return;
+  }
+  QueueMessage(std::make_shared<const std::string>(
+      static_cast<const char*>(data), length));
+}
 
-    // Send to all TCP clients
-    bool success = true;
-    for (auto client : m_tcpClients) {
-      client->Write(data, length);
-      if (client->Error()) {
-        success = false;
-      }
+bool VDRNetworkServer::Post(Batch&& batch) {
+  if (!m_outbound.Push(std::move(batch))) {
+    if (m_batchesDropped++ == 0) {
+      wxLogMessage("Network server on port %d cannot keep up, dropping data",
+                   m_port);
     }
-    return success && !m_tcpClients.empty();
-  } else {
-    // Send UDP broadcast to localhost
-    if (m_udpSocket) {
-      wxIPV4address destAddr;
-      destAddr.Hostname("127.0.0.1");
-      destAddr.Service(m_port);  // Target port (10110 typically)
+    return false;
+  }
+  // One wakeup is enough for all the batches posted until the I/O thread
+  // picks them up.
+  if (!m_wakeupPending.exchange(true)) {
+    Wakeup();
+  }
+  return true;
+}
 
-      m_udpSocket->SendTo(destAddr, data, length);
-      return !m_udpSocket->Error();
-    }
+void VDRNetworkServer::Wakeup() {
+  const char signal = 0;
+  send(m_wakeupSocket, &signal, 1, SEND_FLAGS);
+}
+
+bool VDRNetworkServer::InitWakeup(wxString& error) {
+  // A loopback UDP socket connected to itself, poll() reports it readable
+  // when the playback engine has posted data.
+  m_wakeupSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+  sockaddr_in addr = LoopbackAddress(0);
+  socklen_t length = sizeof(addr);
+  if (m_wakeupSocket == INVALID_SOCKET_HANDLE ||
+      bind(m_wakeupSocket, reinterpret_cast<sockaddr*>(&addr), length) != 0 ||
+      getsockname(m_wakeupSocket, reinterpret_cast<sockaddr*>(&addr),
+                  &length) != 0 ||
+      connect(m_wakeupSocket, reinterpret_cast<sockaddr*>(&addr), length) !=
+          0 ||
+      !SetNonBlocking(m_wakeupSocket)) {
+    error = _("Network thread init failed");
+    wxLogMessage(error);
+    return false;
   }
-  return false;
+  return true;
 }
 
 bool VDRNetworkServer::InitTCP(int port, wxString& error) {
-  wxIPV4address addr;
-  if (!addr.Hostname("127.0.0.1")) {
-    error = "Failed to set TCP socket hostname";
+  m_listenSocket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+  if (m_listenSocket == INVALID_SOCKET_HANDLE) {
+    error = _("TCP server init failed");
     wxLogMessage(error);
     return false;
   }
 
-  if (!addr.Service(port)) {
+  // Allow restarting the server while old connections are closing.
+  int reuse = 1;
+  setsockopt(m_listenSocket, SOL_SOCKET, SO_REUSEADDR,
+             reinterpret_cast<const char*>(&reuse), sizeof(reuse));
+
+  sockaddr_in addr = LoopbackAddress(port);
+  if (bind(m_listenSocket, reinterpret_cast<sockaddr*>(&addr),
+           sizeof(addr)) != 0) {
     error = wxString::Format("Failed to set TCP port %d", port);
     wxLogMessage(error);
     return false;
   }
 
-  // Create new server socket
-  if (m_tcpServer) {
-    delete m_tcpServer;
-    m_tcpServer = nullptr;
-  }
-
-  m_tcpServer = new wxSocketServer(addr);
-
-  // Check socket state
-  if (!m_tcpServer->IsOk()) {
+  if (listen(m_listenSocket, SOMAXCONN) != 0 ||
+      !SetNonBlocking(m_listenSocket)) {
     error = _("TCP server init failed");
     wxLogMessage(error);
-    delete m_tcpServer;
-    m_tcpServer = nullptr;
     return false;
   }
-
-  m_tcpServer->SetEventHandler(*this);
-  // Indicate that we want to be notified on connection events.
-  m_tcpServer->SetNotify(wxSOCKET_CONNECTION_FLAG);
-  // Enable the event notifications.
-  m_tcpServer->Notify(true);
   error = wxEmptyString;
   wxLogMessage("TCP server initialized on port %d", port);
   return true;
 }
 
 bool VDRNetworkServer::InitUDP(int port, wxString& error) {
-  // Create new socket
-  if (m_udpSocket) {
-    delete m_udpSocket;
-    m_udpSocket = nullptr;
+  // Use ephemeral port for sending
+  m_udpSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+  if (m_udpSocket == INVALID_SOCKET_HANDLE || !SetNonBlocking(m_udpSocket)) {
+    error = _("UDP socket init failed");
+    wxLogMessage(error);
+    return false;
+  }
+  if (!InitUDPDestinations(error)) {
+    wxLogMessage(error);
+    return false;
   }
+  error = wxEmptyString;
+  wxLogMessage("UDP server initialized on port %d, %zu destinations", port,
+               m_udpTargets.size());
+  return true;
+}
 
-  wxIPV4address addr;
-  addr.AnyAddress();
-  addr.Service(0);  // Use ephemeral port for sending
+bool VDRNetworkServer::InitUDPDestinations(wxString& error) {
+  m_udpTargets.clear();
+  wxString addresses = m_udpDestinations.addresses;
+  addresses.Trim(true).Trim(false);
 
-  m_udpSocket = new wxDatagramSocket(addr, wxSOCKET_NOWAIT);
-  // Check socket state
-  if (!m_udpSocket->IsOk()) {
-    error = _("UDP socket init failed");
+  switch (m_udpDestinations.mode) {
+    case VDRUdpMode::LOCALHOST:
+      m_udpTargets.push_back({INADDR_LOOPBACK, static_cast<uint16_t>(m_port)});
+      return true;
+
+    case VDRUdpMode::UNICAST: {
+      wxStringTokenizer tokenizer(addresses, ", ;\t", wxTOKEN_STRTOK);
+      while (tokenizer.HasMoreTokens()) {
+        wxString host = tokenizer.GetNextToken();
+        long port = m_port;
+        if (host.Contains(":")) {
+          wxString portText = host.AfterLast(':');
+          host = host.BeforeLast(':');
+          if (!portText.ToLong(&port) || port < 1 || port > 65535) {
+            error = wxString::Format(_("Invalid UDP destination port %s"),
+                                     portText);
+            return false;
+          }
+        }
+        uint32_t ip;
+        if (!ResolveHost(host, &ip)) {
+          error = wxString::Format(_("Unknown UDP destination %s"), host);
+          return false;
+        }
+        m_udpTargets.push_back({ip, static_cast<uint16_t>(port)});
+      }
+      if (m_udpTargets.empty()) {
+        error = _("No UDP destination");
+        return false;
+      }
+      return true;
+    }
+
+    case VDRUdpMode::BROADCAST: {
+      uint32_t ip = INADDR_BROADCAST;
+      if (!addresses.IsEmpty() && !ResolveHost(addresses, &ip)) {
+        error = wxString::Format(_("Invalid broadcast address %s"), addresses);
+        return false;
+      }
+      int broadcast = 1;
+      if (setsockopt(m_udpSocket, SOL_SOCKET, SO_BROADCAST,
+                     reinterpret_cast<const char*>(&broadcast),
+                     sizeof(broadcast)) != 0) {
+        error = _("Failed to enable UDP broadcast");
+        return false;
+      }
+      m_udpTargets.push_back({ip, static_cast<uint16_t>(m_port)});
+      return true;
+    }
+
+    case VDRUdpMode::MULTICAST: {
+      uint32_t ip;
+      if (!ResolveHost(addresses, &ip) || (ip >> 28) != 0xE) {
+        error = wxString::Format(_("Invalid multicast group %s"), addresses);
+        return false;
+      }
+      // The option is a byte on BSD and macOS, a DWORD on Windows.
+#ifdef _WIN32
+      DWORD ttl = m_udpDestinations.multicastTtl;
+#else
+      unsigned char ttl =
+          static_cast<unsigned char>(m_udpDestinations.multicastTtl);
+#endif
+      if (setsockopt(m_udpSocket, IPPROTO_IP, IP_MULTICAST_TTL,
+                     reinterpret_cast<const char*>(&ttl), sizeof(ttl)) != 0) {
+        error = _("Failed to set the multicast TTL");
+        return false;
+      }
+      m_udpTargets.push_back({ip, static_cast<uint16_t>(m_port)});
+      return true;
+    }
+  }
+  return true;
+}
+
+void VDRNetworkServer::Run() {
+  std::vector<pollfd> fds;
+  char buffer[1024];
+  while (!m_stopRequested) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    fds.clear();
+    fds.push_back({m_wakeupSocket, POLLIN, 0});
+    if (m_listenSocket != INVALID_SOCKET_HANDLE) {
+      fds.push_back({m_listenSocket, POLLIN, 0});
+    }
+    size_t firstClient = fds.size();
+    for (const auto& client : m_tcpClients) {
+      short events = POLLIN;
+      if (!client->queue.IsEmpty()) events |= POLLOUT;
+      fds.push_back({client->socket, events, 0});
+    }
+    lock.unlock();
+
+    if (VDR_POLL(fds.data(), static_cast<unsigned>(fds.size()),
+                 POLL_INTERVAL_MS) < 0 &&
+        !WouldBlock()) {
+      wxLogMessage("Network server on port %d: poll failed", m_port);
+      break;
+    }
+    if (m_stopRequested) break;
+
+    lock.lock();
+    int64_t now = NowMs();
+    if (fds[0].revents & POLLIN) {
+      while (recv(m_wakeupSocket, buffer, sizeof(buffer), 0) > 0) {
+      }
+    }
+    // Batches posted from now on need a new wakeup.
+    m_wakeupPending = false;
+
+    if (firstClient > 1 && (fds[1].revents & POLLIN)) {
+      AcceptClients();
+    }
+    for (auto& client : m_tcpClients) {
+      client->queue.SetMaxBytes(m_queueSettings.maxBytes);
+    }
+    Batch batch;
+    while (m_outbound.Pop(batch)) {
+      SendBatch(batch, now);
+    }
+
+    // Write to the clients, and forget the ones that are gone.
+    for (size_t i = 0; i < m_tcpClients.size();) {
+      TcpClient& client = *m_tcpClients[i];
+      short revents = firstClient + i < fds.size() &&
+                              fds[firstClient + i].fd == client.socket
+                          ? fds[firstClient + i].revents
+                          : 0;
+      bool connected = !(revents & (POLLERR | POLLHUP | POLLNVAL));
+      if (connected && (revents & POLLIN)) {
+        int received = recv(client.socket, buffer, sizeof(buffer), 0);
+        connected = received > 0 || (received < 0 && WouldBlock());
+        if (received > 0) HandleClientInput(client, buffer, received);
+      }
+      if (connected && FlushClient(client, now)) {
+        i++;
+        continue;
+      }
+      CloseSocket(client.socket);
+      m_tcpClients.erase(m_tcpClients.begin() + i);
+      wxLogMessage("TCP client disconnected. Remaining clients: %zu",
+                   m_tcpClients.size());
+    }
+  }
+}
+
+void VDRNetworkServer::AcceptClients() {
+  while (true) {
+    sockaddr_in peer = {};
+    socklen_t length = sizeof(peer);
+    Socket socket =
+        accept(m_listenSocket, reinterpret_cast<sockaddr*>(&peer), &length);
+    if (socket == INVALID_SOCKET_HANDLE) break;
+
+    // Writes must never block, and are sent right away.
+    int noDelay = 1;
+    setsockopt(socket, IPPROTO_TCP, TCP_NODELAY,
+               reinterpret_cast<const char*>(&noDelay), sizeof(noDelay));
+#ifdef SO_NOSIGPIPE
+    int noSigPipe = 1;
+    setsockopt(socket, SOL_SOCKET, SO_NOSIGPIPE, &noSigPipe,
+               sizeof(noSigPipe));
+#endif
+    if (!SetNonBlocking(socket)) {
+      CloseSocket(socket);
+      continue;
+    }
+
+    uint32_t ip = ntohl(peer.sin_addr.s_addr);
+    wxString address = wxString::Format(
+        "%u.%u.%u.%u:%u", ip >> 24, (ip >> 16) & 0xFF, (ip >> 8) & 0xFF,
+        ip & 0xFF, static_cast<unsigned>(ntohs(peer.sin_port)));
+    m_tcpClients.push_back(std::unique_ptr<TcpClient>(new TcpClient{
+        socket, address, VDRSendQueue(m_queueSettings.maxBytes), false, false,
+        VDRMessageFilter(), std::string()}));
+    wxLogMessage("New TCP client %s connected. Total clients: %zu", address,
+                 m_tcpClients.size());
+  }
+}
+
+void VDRNetworkServer::HandleClientInput(TcpClient& client, const char* data,
+                                         size_t length) {
+  client.input.append(data, length);
+  size_t end;
+  while ((end = client.input.find('\n')) != std::string::npos) {
+    std::string command = client.input.substr(0, end);
+    client.input.erase(0, end + 1);
+
+    // Anything but a subscription is ignored.
+    static const std::string SUBSCRIBE = "SUBSCRIBE";
+    if (command.size() < SUBSCRIBE.size() ||
+        !std::equal(SUBSCRIBE.begin(), SUBSCRIBE.end(), command.begin(),
+                    [](char a, char b) { return a == toupper(b); }) ||
+        (command.size() > SUBSCRIBE.size() &&
+         !isspace(static_cast<unsigned char>(command[SUBSCRIBE.size()])))) {
+      continue;
+    }
+    std::string patterns = command.substr(SUBSCRIBE.size());
+    std::string invalid;
+    if (patterns.find_first_not_of(" \t\r") == std::string::npos) {
+      client.subscribed = false;
+      wxLogMessage("TCP client %s uses the port filter", client.address);
+    } else if (client.filter.Parse(patterns, &invalid)) {
+      client.subscribed = true;
+      wxLogMessage("TCP client %s subscribed to %s", client.address,
+                   wxString(client.filter.ToString()));
+    } else {
+      wxLogMessage("TCP client %s: invalid filter pattern %s", client.address,
+                   wxString(invalid));
+    }
+  }
+  // Clients are not expected to send anything else.
+  if (client.input.size() > MAX_COMMAND_LENGTH) {
+    client.input.clear();
+  }
+}
+
+void VDRNetworkServer::SendBatch(const Batch& batch, int64_t nowMs) {
+  if (!m_useTCP) {
+    SendDatagrams(batch);
+    return;
+  }
+
+  // Queue the messages for each TCP client, they are written by
+  // FlushClient(). The clients share the messages, and the ones they did
+  // not subscribe to are skipped before being queued.
+  std::vector<const VDRMessagePtr*> selected;
+  for (auto& client : m_tcpClients) {
+    const VDRMessageFilter& filter =
+        client->subscribed ? client->filter : m_filter;
+    selected.clear();
+    size_t bytes = 0;
+    for (const auto& message : batch.messages) {
+      if (filter.Matches(*message)) {
+        selected.push_back(&message);
+        bytes += message->size();
+      }
+    }
+
+    // A batch larger than the client queue loses its oldest messages.
+    size_t first = 0;
+    size_t droppedBytes = 0;
+    while (bytes - droppedBytes > m_queueSettings.maxBytes) {
+      droppedBytes += (*selected[first++])->size();
+    }
+
+    uint64_t dropped = client->queue.GetMessagesDropped();
+    client->queue.Drop(first, droppedBytes);
+    for (size_t i = first; i < selected.size(); i++) {
+      client->queue.Push(*selected[i], nowMs);
+    }
+    if (client->queue.GetMessagesDropped() != dropped && !client->dropping) {
+      // Logged once, the count is in the client statistics.
+      wxLogMessage("TCP client %s is too slow, dropping messages",
+                   client->address);
+      client->dropping = true;
+    }
+  }
+}
+
+void VDRNetworkServer::SendDatagrams(const Batch& batch) {
+  // Messages that do not match the port filter are skipped first.
+  std::vector<const std::string*> messages;
+  for (const auto& message : batch.messages) {
+    if (m_filter.Matches(*message)) {
+      messages.push_back(message.get());
+    }
+  }
+
+  // Pack whole messages in each datagram, a message larger than a
+  // datagram is sent alone.
+  std::vector<std::pair<size_t, size_t>> datagrams;  // First message, count.
+  size_t i = 0;
+  while (i < messages.size()) {
+    size_t first = i;
+    size_t size = messages[i++]->size();
+    while (i < messages.size() &&
+           size + messages[i]->size() <= MAX_DATAGRAM_SIZE) {
+      size += messages[i++]->size();
+    }
+    datagrams.emplace_back(first, i - first);
+  }
+
+  std::vector<sockaddr_in> destinations;
+  for (const auto& target : m_udpTargets) {
+    destinations.push_back(MakeAddress(target.ip, target.port));
+  }
+
+#ifdef VDR_HAVE_SENDMMSG
+  // The datagrams gather the shared messages, and every datagram is sent to
+  // every destination with as few system calls as possible.
+  std::vector<iovec> iovecs;
+  iovecs.reserve(messages.size());
+  for (const std::string* message : messages) {
+    iovecs.push_back({const_cast<char*>(message->data()), message->size()});
+  }
+  std::vector<mmsghdr> headers;
+  headers.reserve(datagrams.size() * destinations.size());
+  for (const auto& datagram : datagrams) {
+    for (auto& destination : destinations) {
+      mmsghdr header = {};
+      header.msg_hdr.msg_name = &destination;
+      header.msg_hdr.msg_namelen = sizeof(destination);
+      header.msg_hdr.msg_iov = &iovecs[datagram.first];
+      header.msg_hdr.msg_iovlen = datagram.second;
+      headers.push_back(header);
+    }
+  }
+  size_t sent = 0;
+  while (sent < headers.size()) {
+    int count =
+        sendmmsg(m_udpSocket, headers.data() + sent,
+                 std::min(headers.size() - sent, MAX_SENDMMSG), SEND_FLAGS);
+    if (count < 0) {
+      // When the socket buffer is full, the rest is lost as any datagram.
+      if (WouldBlock()) break;
+      // A destination that cannot be reached, e.g. without a route, must
+      // not hold up the other ones: its datagram is skipped.
+      sent++;
+      continue;
+    }
+    if (count == 0) break;
+    sent += count;
+  }
+#else
+  std::vector<std::pair<const char*, size_t>> buffers;
+  for (const auto& datagram : datagrams) {
+    buffers.clear();
+    for (size_t j = 0; j < datagram.second; j++) {
+      const std::string* message = messages[datagram.first + j];
+      buffers.emplace_back(message->data(), message->size());
+    }
+    for (const auto& destination : destinations) {
+      SendBuffers(m_udpSocket, buffers, &destination);
+    }
+  }
+#endif
+}
+
+bool VDRNetworkServer::FlushClient(TcpClient& client, int64_t nowMs) {
+  std::vector<std::pair<const char*, size_t>> buffers;
+  while (!client.queue.IsEmpty()) {
+    // The queued messages are written together, without copying them.
+    client.queue.GetPending(buffers, MAX_GATHERED_MESSAGES);
+    long sent = SendBuffers(client.socket, buffers, nullptr);
+    if (sent < 0) {
+      // The socket is full, the rest is written when it becomes writable.
+      if (WouldBlock()) break;
+      return false;
+    }
+    client.queue.Consume(static_cast<size_t>(sent));
+  }
+  if (!client.queue.IsEmpty() &&
+      m_queueSettings.policy == VDRSlowClientPolicy::DISCONNECT &&
+      client.queue.GetLagMs(nowMs) > m_queueSettings.maxLagMs) {
+    wxLogMessage("Disconnecting TCP client %s, %lld ms behind",
+                 client.address,
+                 static_cast<long long>(client.queue.GetLagMs(nowMs)));
+    return false;
+  }
+  return true;
+}
+
+VDRLineReader::VDRLineReader(size_t capacity)
+    : m_buffer(capacity),
+      m_start(0),
+      m_end(0),
+      m_discarding(false),
+      m_linesDiscarded(0) {}
+
+char* VDRLineReader::GetWriteBuffer(size_t* length) {
+  if (m_start > 0) {
+    // Move the incomplete line to the front.
+    std::memmove(m_buffer.data(), m_buffer.data() + m_start, m_end - m_start);
+    m_end -= m_start;
+    m_start = 0;
+  }
+  if (m_end == m_buffer.size()) {
+    // No line ending in the whole buffer, skip the rest of the line.
+    if (!m_discarding) m_linesDiscarded++;
+    m_discarding = true;
+    m_end = 0;
+  }
+  *length = m_buffer.size() - m_end;
+  return m_buffer.data() + m_end;
+}
+
+void VDRLineReader::Commit(size_t length) {
+  m_end = std::min(m_end + length, m_buffer.size());
+}
+
+bool VDRLineReader::NextLine(const char** line, size_t* length) {
+  while (m_start < m_end) {
+    const char* begin = m_buffer.data() + m_start;
+    const char* end = m_buffer.data() + m_end;
+    const char* eol = begin;
+    while (eol < end && *eol != '\n' && *eol != '\r') eol++;
+    if (eol == end) return false;
+
+    size_t size = eol - begin;
+    m_start += size + 1;
+    if (m_discarding) {
+      // End of a line too long for the buffer.
+      m_discarding = false;
+      continue;
+    }
+    if (size == 0) continue;  // Second byte of CR LF, or an empty line
+    *line = begin;
+    *length = size;
+    return true;
+  }
+  return false;
+}
+
+bool VDRLineReader::TakeRest(const char** line, size_t* length) {
+  bool discarding = m_discarding;
+  m_discarding = false;
+  if (m_start == m_end || discarding) {
+    m_start = m_end;
+    return false;
+  }
+  *line = m_buffer.data() + m_start;
+  *length = m_end - m_start;
+  m_start = m_end;
+  return true;
+}
+
+void VDRLineReader::Clear() {
+  m_start = 0;
+  m_end = 0;
+  m_discarding = false;
+}
+
+VDRNetworkClient::VDRNetworkClient()
+    : m_socket(INVALID_SOCKET_HANDLE),
+      m_ip(0),
+      m_running(false),
+      m_useTCP(true),
+      m_port(0),
+      m_stopRequested(false),
+      m_connected(false),
+      m_linesReceived(0),
+      m_reportFailure(true) {
+#ifdef _WIN32
+  WSADATA data;
+  WSAStartup(MAKEWORD(2, 2), &data);
+#endif
+}
+
+VDRNetworkClient::~VDRNetworkClient() {
+  Stop();
+#ifdef _WIN32
+  WSACleanup();
+#endif
+}
+
+bool VDRNetworkClient::Start(bool useTCP, const wxString& host, int port,
+                             const LineHandler& handler, wxString& error) {
+  Stop();
+  m_useTCP = useTCP;
+  m_host = host;
+  m_port = port;
+  m_handler = handler;
+
+  if (port < 1 || port > 65535) {
+    error = wxString::Format("Invalid port %d (must be 1-65535)", port);
     wxLogMessage(error);
-    delete m_udpSocket;
-    m_udpSocket = nullptr;
     return false;
   }
+  if (m_useTCP && !ResolveHost(host, &m_ip)) {
+    error = wxString::Format("Unknown host %s", host);
+    wxLogMessage(error);
+    return false;
+  }
+  // UDP errors, such as a port in use, are reported now. TCP connections
+  // are retried by the I/O thread.
+  m_stopRequested = false;
+  m_reportFailure = true;
+  if (!m_useTCP && !Open()) {
+    error = wxString::Format("Failed to receive on UDP port %d", port);
+    return false;
+  }
+
+  m_linesReceived = 0;
+  m_thread = std::thread(&VDRNetworkClient::Run, this);
+  m_running = true;
   error = wxEmptyString;
-  wxLogMessage("UDP server initialized on port %d", port);
+  wxLogMessage("VDR network input started - %s %s:%d",
+               m_useTCP ? "TCP" : "UDP", m_useTCP ? m_host : "*", m_port);
   return true;
 }
 
-void VDRNetworkServer::OnTcpEvent(wxSocketEvent& event) {
-  switch (event.GetSocketEvent()) {
-    case wxSOCKET_CONNECTION: {
-      // Accept new client connection
-      wxSocketBase* client = m_tcpServer->Accept(false);
-      if (client) {
-        client->SetEventHandler(*this, SOCKET_ID);
-        client->SetNotify(wxSOCKET_LOST_FLAG);
-        client->Notify(true);
-        m_tcpClients.push_back(client);
-        wxLogMessage("New TCP client connected. Total clients: %zu",
-                     m_tcpClients.size());
+void VDRNetworkClient::Stop() {
+  if (m_thread.joinable()) {
+    m_stopRequested = true;
+    m_thread.join();
+  }
+  Close();
+  m_running = false;
+}
+
+bool VDRNetworkClient::Open() {
+  m_socket = socket(AF_INET, m_useTCP ? SOCK_STREAM : SOCK_DGRAM,
+                    m_useTCP ? IPPROTO_TCP : IPPROTO_UDP);
+  if (m_socket == INVALID_SOCKET_HANDLE || !SetNonBlocking(m_socket)) {
+    Close();
+    return false;
+  }
+
+  if (!m_useTCP) {
+    // Gateways broadcast to every listener on the port.
+    int reuse = 1;
+    setsockopt(m_socket, SOL_SOCKET, SO_REUSEADDR,
+               reinterpret_cast<const char*>(&reuse), sizeof(reuse));
+    sockaddr_in addr = MakeAddress(INADDR_ANY, m_port);
+    if (bind(m_socket, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) !=
+        0) {
+      wxLogMessage("Network input: failed to set UDP port %d", m_port);
+      Close();
+      return false;
+    }
+    m_connected = true;
+    return true;
+  }
+
+  sockaddr_in addr = MakeAddress(m_ip, m_port);
+  if (connect(m_socket, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) !=
+      0) {
+    // Wait for the connection, in steps to notice stop requests.
+    int ready = -1;
+    if (ConnectInProgress()) {
+      pollfd fd = {m_socket, POLLOUT, 0};
+      for (int waited = 0; waited < CONNECT_TIMEOUT_MS && !m_stopRequested;
+           waited += POLL_INTERVAL_MS) {
+        ready = VDR_POLL(&fd, 1, POLL_INTERVAL_MS);
+        if (ready != 0) break;
       }
-      break;
     }
+    int socketError = -1;
+    socklen_t length = sizeof(socketError);
+    if (ready <= 0 ||
+        getsockopt(m_socket, SOL_SOCKET, SO_ERROR,
+                   reinterpret_cast<char*>(&socketError), &length) != 0 ||
+        socketError != 0) {
+      if (m_reportFailure && !m_stopRequested) {
+        wxLogMessage("Network input: cannot connect to %s:%d", m_host,
+                     m_port);
+        m_reportFailure = false;
+      }
+      Close();
+      return false;
+    }
+  }
+  wxLogMessage("Network input: connected to %s:%d", m_host, m_port);
+  m_reportFailure = true;
+  m_connected = true;
+  return true;
+}
 
-    case wxSOCKET_LOST: {
-      // Handle client disconnection
-      wxSocketBase* client = event.GetSocket();
-      if (client) {
-        auto it = std::find(m_tcpClients.begin(), m_tcpClients.end(), client);
-        if (it != m_tcpClients.end()) {
-          m_tcpClients.erase(it);
-          client->Destroy();
-          wxLogMessage("TCP client disconnected. Remaining clients: %zu",
-                       m_tcpClients.size());
-        }
+void VDRNetworkClient::Close() {
+  if (m_socket != INVALID_SOCKET_HANDLE) {
+    CloseSocket(m_socket);
+    m_socket = INVALID_SOCKET_HANDLE;
+  }
+  m_reader.Clear();
+  m_connected = false;
+}
+
+void VDRNetworkClient::Run() {
+  while (!m_stopRequested) {
+    if (m_socket == INVALID_SOCKET_HANDLE && !Open()) {
+      // Wait before trying again, in steps to notice stop requests.
+      for (int waited = 0; waited < RECONNECT_INTERVAL_MS && !m_stopRequested;
+           waited += POLL_INTERVAL_MS) {
+        std::this_thread::sleep_for(
+            std::chrono::milliseconds(POLL_INTERVAL_MS));
       }
-      break;
+      continue;
     }
 
-    default:
+    pollfd fd = {m_socket, POLLIN, 0};
+    int ready = VDR_POLL(&fd, 1, POLL_INTERVAL_MS);
+    if (ready < 0 && !WouldBlock()) {
+      wxLogMessage("Network input on port %d: poll failed", m_port);
       break;
+    }
+    if (ready <= 0 || m_stopRequested) continue;
+    if (!Receive()) {
+      wxLogMessage("Network input: connection to %s:%d lost", m_host, m_port);
+      Close();
+    }
   }
 }
 
-void VDRNetworkServer::CleanupDeadConnections() {
-  auto it = m_tcpClients.begin();
-  while (it != m_tcpClients.end()) {
-    wxSocketBase* client = *it;
-    if (!client || !client->IsConnected()) {
-      delete client;
-      it = m_tcpClients.erase(it);
-    } else {
-      ++it;
+bool VDRNetworkClient::Receive() {
+  while (!m_stopRequested) {
+    size_t space;
+    char* buffer = m_reader.GetWriteBuffer(&space);
+    long received = recv(m_socket, buffer, static_cast<int>(space), 0);
+    if (received < 0 && WouldBlock()) return true;
+    if (received < 0 || (received == 0 && m_useTCP)) {
+      // Connection closed or reset. UDP errors, such as ICMP port
+      // unreachable reports, are ignored.
+      return !m_useTCP;
+    }
+    m_reader.Commit(received);
+    HandleLines();
+    if (!m_useTCP) {
+      // A datagram ends with its last line, with or without line ending.
+      const char* line;
+      size_t length;
+      if (m_reader.TakeRest(&line, &length)) {
+        m_handler(line, length);
+        m_linesReceived++;
+      }
     }
   }
+  return true;
+}
+
+void VDRNetworkClient::HandleLines() {
+  const char* line;
+  size_t length;
+  while (m_reader.NextLine(&line, &length)) {
+    m_handler(line, length);
+    m_linesReceived++;
+  }
 }
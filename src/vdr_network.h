@@ -21,25 +21,209 @@
 #define _VDR_NETWORK_H_
 
 #include <wx/wx.h>
-#include <wx/socket.h>
 
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
 #include <vector>
 #include <memory>
 
-// Forward declarations
-class wxSocketServer;
-class wxDatagramSocket;
-class wxSocketEvent;
+#include "vdr_filter.h"
+#include "vdr_spsc_queue.h"
+
+/**
+ * Immutable message, line ending included.
+ *
+ * A replayed record is stored once and shared by the internal API buffer,
+ * the TCP client queues and the UDP datagrams, it is never copied per
+ * output.
+ */
+typedef std::shared_ptr<const std::string> VDRMessagePtr;
+
+/**
+ * Create a shared message.
+ *
+ * @param text Message text, the line ending is added if needed.
+ */
+VDRMessagePtr MakeVDRMessage(const wxString& text);
+
+/** What to do with TCP clients that cannot keep up with the data rate. */
+enum class VDRSlowClientPolicy {
+  DROP_OLDEST,  //!< Discard the oldest queued messages when the queue is full
+  DISCONNECT    //!< Also disconnect clients lagging for too long
+};
+
+/** Outbound queue settings, applied to each TCP client. */
+struct VDRClientQueueSettings {
+  size_t maxBytes;             //!< Maximum number of bytes queued per client
+  VDRSlowClientPolicy policy;  //!< Policy for clients that fall behind
+  int maxLagMs;  //!< Lag after which slow clients are disconnected
+
+  VDRClientQueueSettings()
+      : maxBytes(256 * 1024),
+        policy(VDRSlowClientPolicy::DROP_OLDEST),
+        maxLagMs(5000) {}
+};
+
+/** Where UDP datagrams are sent. */
+enum class VDRUdpMode {
+  LOCALHOST,  //!< 127.0.0.1, on the server port
+  UNICAST,    //!< A list of hosts
+  BROADCAST,  //!< A broadcast address
+  MULTICAST   //!< A multicast group
+};
+
+/** UDP destination settings. */
+struct VDRUdpDestinations {
+  VDRUdpMode mode;  //!< Kind of destination
+  /**
+   * Hosts separated by commas for UNICAST, each one with an optional
+   * ":port" suffix. The broadcast address for BROADCAST, 255.255.255.255
+   * when empty. The group address for MULTICAST.
+   */
+  wxString addresses;
+  int multicastTtl;  //!< Time to live of multicast datagrams, in hops
+
+  VDRUdpDestinations() : mode(VDRUdpMode::LOCALHOST), multicastTtl(1) {}
+
+  bool operator==(const VDRUdpDestinations& other) const {
+    return mode == other.mode && addresses == other.addresses &&
+           multicastTtl == other.multicastTtl;
+  }
+  bool operator!=(const VDRUdpDestinations& other) const {
+    return !(*this == other);
+  }
+};
+
+/** Send statistics of a TCP client. */
+struct VDRClientStats {
+  wxString address;          //!< Peer address and port
+  uint64_t bytesSent;        //!< Bytes written to the socket
+  size_t bytesQueued;        //!< Bytes waiting to be written
+  uint64_t messagesDropped;  //!< Messages discarded because the queue was full
+  uint64_t bytesDropped;     //!< Bytes discarded because the queue was full
+};
+
+/**
+ * Bounded queue of the messages waiting to be sent to a client.
+ *
+ * When a new message does not fit, the oldest messages are discarded. The
+ * message being written is never discarded, the client would otherwise
+ * receive a truncated message. The queue only holds references to the
+ * shared messages.
+ */
+class VDRSendQueue {
+public:
+  explicit VDRSendQueue(size_t maxBytes = VDRClientQueueSettings().maxBytes);
+
+  /** Set the maximum number of queued bytes, dropping messages if needed. */
+  void SetMaxBytes(size_t maxBytes);
+
+  /**
+   * Queue a shared message.
+   *
+   * @param message Message, not copied.
+   * @param nowMs Current time in milliseconds, to measure the lag.
+   * @return False if the message was dropped because it is larger than the
+   * queue.
+   */
+  bool Push(const VDRMessagePtr& message, int64_t nowMs);
+
+  /**
+   * Queue a copy of a message.
+   *
+   * @param data Message bytes.
+   * @param length Number of bytes.
+   * @param nowMs Current time in milliseconds, to measure the lag.
+   * @return False if the message was dropped because it is larger than the
+   * queue.
+   */
+  bool Push(const void* data, size_t length, int64_t nowMs);
+
+  /** Count messages dropped before they could be queued. */
+  void Drop(size_t messages, size_t bytes);
+
+  /** Return the unsent bytes of the oldest message. */
+  const char* GetFrontData() const;
+  /** Return the number of unsent bytes of the oldest message. */
+  size_t GetFrontLength() const;
+  /**
+   * Return the unsent bytes of the oldest messages, to send them with a
+   * single gathered write.
+   *
+   * @param buffers Receives the data and length of each message.
+   * @param maxBuffers Maximum number of messages returned.
+   */
+  void GetPending(std::vector<std::pair<const char*, size_t>>& buffers,
+                  size_t maxBuffers) const;
+  /** Mark bytes as sent, starting with the oldest message. */
+  void Consume(size_t length);
+
+  bool IsEmpty() const { return m_messages.empty(); }
+  /**
+   * Return for how long the oldest message has been waiting.
+   *
+   * @return Lag in milliseconds, 0 if the queue is empty.
+   */
+  int64_t GetLagMs(int64_t nowMs) const;
+  /** Return the number of bytes waiting to be sent. */
+  size_t GetBytes() const { return m_bytes; }
+  uint64_t GetBytesSent() const { return m_bytesSent; }
+  uint64_t GetMessagesDropped() const { return m_messagesDropped; }
+  uint64_t GetBytesDropped() const { return m_bytesDropped; }
+
+private:
+  struct QueuedMessage {
+    VDRMessagePtr data;
+    int64_t queuedMs;
+  };
+
+  /** Drop the oldest messages until length more bytes fit in the queue. */
+  void MakeRoom(size_t length);
+
+  std::deque<QueuedMessage> m_messages;
+  size_t m_offset;    //!< Bytes of the oldest message already sent
+  size_t m_bytes;     //!< Bytes waiting to be sent
+  size_t m_maxBytes;  //!< Maximum number of bytes waiting to be sent
+  uint64_t m_bytesSent;
+  uint64_t m_messagesDropped;
+  uint64_t m_bytesDropped;
+};
 
 /**
  * Network server for replaying NMEA messages over TCP or UDP.
  *
  * Provides a server that can listen on a specified port and protocol (TCP/UDP)
  * and broadcast messages to connected clients. For TCP, maintains a list of
- * connected clients. For UDP, broadcasts to localhost on the specified port.
+ * connected clients. For UDP, sends to localhost on the specified port, or to
+ * the configured unicast, broadcast or multicast destinations.
+ *
+ * The port filter selects the messages sent over UDP and to the TCP clients.
+ * A TCP client can replace it with its own subscription by sending a line
+ * "SUBSCRIBE <patterns>", see VDRMessageFilter for the patterns.
+ * "SUBSCRIBE" alone reverts to the port filter.
+ *
+ * The sockets are handled by a dedicated I/O thread running a poll()
+ * reactor, so network fan-out never competes with the GUI. The playback
+ * engine hands the messages over through a lock-free queue.
+ *
+ * TCP clients are written to without blocking. Each client has its own
+ * bounded queue, drained when its socket becomes writable, so a slow client
+ * does not hold back playback or the other clients.
  */
-class VDRNetworkServer : public wxEvtHandler {
+class VDRNetworkServer {
 public:
+  /** Native socket handle. */
+#ifdef _WIN32
+  typedef uintptr_t Socket;
+#else
+  typedef int Socket;
+#endif
+
   /** Constructor initializes server state. */
   VDRNetworkServer();
 
@@ -66,10 +250,40 @@ public:
    * Automatically adds line endings if needed.
    *
    * @param message Text message to send
-   * @return True if message was sent successfully
+   * @return True if message was handed over to the I/O thread
    */
   bool SendText(const wxString& message);
 
+  /**
+   * Queue a text message, to be sent with the other queued messages.
+   *
+   * The queued messages are sent when Flush() is called, or when they
+   * exceed MAX_BATCH_SIZE.
+   *
+   * @param message Text message, line endings are added if needed.
+   */
+  void QueueText(const wxString& message);
+
+  /**
+   * Queue a shared message, to be sent with the other queued messages.
+   *
+   * Same as QueueText(), the message is sent to every client without being
+   * copied.
+   *
+   * @param message Message, line ending included.
+   */
+  void QueueMessage(const VDRMessagePtr& message);
+
+  /**
+   * Send the queued text messages.
+   *
+   * TCP clients receive all the messages in a single write. UDP packs as
+   * many whole messages as fit in each datagram.
+   *
+   * @return True if the messages were handed over to the I/O thread
+   */
+  bool Flush();
+
   /**
    * Send binary data to all connected clients
    *
@@ -78,10 +292,21 @@ public:
    *
    * @param data Pointer to binary data
    * @param length Length of data in bytes
-   * @return True if data was sent successfully
+   * @return True if data was handed over to the I/O thread
    */
   bool SendBinary(const void* data, size_t length);
 
+  /**
+   * Queue binary data, to be sent with the queued text messages.
+   *
+   * Same as SendBinary(), but sent by Flush() with the rest of the playback
+   * notification.
+   *
+   * @param data Pointer to binary data, a whole message
+   * @param length Length of data in bytes
+   */
+  void QueueBinary(const void* data, size_t length);
+
   /** Check if server is currently running. */
   bool IsRunning() const { return m_running; }
 
@@ -91,12 +316,71 @@ public:
   /** Get current port number. */
   int GetPort() const { return m_port; }
 
+  /**
+   * Set where UDP datagrams are sent.
+   *
+   * The destinations are resolved when the server starts.
+   */
+  void SetUDPDestinations(const VDRUdpDestinations& destinations) {
+    m_udpDestinations = destinations;
+  }
+
+  /** Get where UDP datagrams are sent. */
+  const VDRUdpDestinations& GetUDPDestinations() const {
+    return m_udpDestinations;
+  }
+
+  /**
+   * Set the port filter, applied to UDP and to the TCP clients without a
+   * subscription of their own.
+   *
+   * @param patterns Patterns, see VDRMessageFilter. Empty for all messages.
+   * @param error Will contain error message if a pattern is invalid
+   * @return False if a pattern is invalid, the filter is then unchanged.
+   */
+  bool SetFilter(const wxString& patterns, wxString& error);
+
+  /** Get the patterns of the port filter. */
+  wxString GetFilter() const;
+
+  /** Set the outbound queue settings of the TCP clients. */
+  void SetClientQueueSettings(const VDRClientQueueSettings& settings);
+
+  /** Get the outbound queue settings of the TCP clients. */
+  VDRClientQueueSettings GetClientQueueSettings() const;
+
+  /** Get the send statistics of the connected TCP clients. */
+  std::vector<VDRClientStats> GetClientStats() const;
+
+  /**
+   * Get the number of batches dropped because the I/O thread could not keep
+   * up with the playback.
+   */
+  uint64_t GetBatchesDropped() const { return m_batchesDropped; }
+
 private:
-  /** Handle incoming TCP socket events. */
-  void OnTcpEvent(wxSocketEvent& event);
+  /** Messages handed over to the I/O thread. */
+  struct Batch {
+    std::vector<VDRMessagePtr> messages;
+    size_t bytes = 0;  //!< Total size of the messages
+  };
+
+  /** Resolved UDP destination, in host byte order. */
+  struct UDPTarget {
+    uint32_t ip;
+    uint16_t port;
+  };
 
-  /** Remove any dead or disconnected TCP clients. */
-  void CleanupDeadConnections();
+  /** A connected TCP client and its outbound queue. */
+  struct TcpClient {
+    Socket socket;
+    wxString address;
+    VDRSendQueue queue;
+    bool dropping;            //!< Whether dropped messages have been logged
+    bool subscribed;          //!< Whether the client has its own filter
+    VDRMessageFilter filter;  //!< Messages requested by the client
+    std::string input;        //!< Received bytes of an incomplete command
+  };
 
   /** Initialize TCP server. */
   bool InitTCP(int port, wxString& error);
@@ -104,23 +388,225 @@ private:
   /** Initialize UDP server. */
   bool InitUDP(int port, wxString& error);
 
+  /** Resolve the UDP destinations and configure the UDP socket for them. */
+  bool InitUDPDestinations(wxString& error);
+
+  /** Create the socket used to wake up the I/O thread. */
+  bool InitWakeup(wxString& error);
+
+  /** Hand a batch over to the I/O thread. */
+  bool Post(Batch&& batch);
+
+  /** Wake up the I/O thread. */
+  void Wakeup();
+
+  /** Main loop of the I/O thread. */
+  void Run();
+
+  /** Accept the pending TCP connections. */
+  void AcceptClients();
+
+  /** Handle the commands sent by a TCP client. */
+  void HandleClientInput(TcpClient& client, const char* data, size_t length);
+
+  /** Send a batch to the TCP clients or as UDP datagrams. */
+  void SendBatch(const Batch& batch, int64_t nowMs);
+
+  /** Send a batch as UDP datagrams to every destination. */
+  void SendDatagrams(const Batch& batch);
+
   /**
-   * Internal send implementation.
-   * Handles the actual sending of data for both TCP and UDP.
+   * Write queued messages until the socket would block.
+   *
+   * Applies the slow client policy once the socket is full.
+   *
+   * @return False if the client must be disconnected.
    */
-  bool SendImpl(const void* data, size_t length);
+  bool FlushClient(TcpClient& client, int64_t nowMs);
+
+  /** Close the sockets and forget the TCP clients. */
+  void CloseSockets();
 
 private:
-  wxSocketServer* m_tcpServer;              //!< TCP server socket
-  wxDatagramSocket* m_udpSocket;            //!< UDP socket
-  std::vector<wxSocketBase*> m_tcpClients;  //!< Connected TCP clients
-  bool m_running;                           //!< Server running state
-  bool m_useTCP;                            //!< Current protocol
-  int m_port;                               //!< Current port
+  Socket m_listenSocket;  //!< TCP server socket
+  Socket m_udpSocket;     //!< UDP socket
+  Socket m_wakeupSocket;  //!< Loopback UDP socket waking up the I/O thread
+  VDRUdpDestinations m_udpDestinations;  //!< UDP destination settings
+  std::vector<UDPTarget> m_udpTargets;   //!< Resolved UDP destinations
+  /** Connected TCP clients, owned by the I/O thread. */
+  std::vector<std::unique_ptr<TcpClient>> m_tcpClients;
+  /** Protects the client list, the filter and the queue settings. */
+  mutable std::mutex m_mutex;
+  VDRMessageFilter m_filter;               //!< Port filter
+  VDRClientQueueSettings m_queueSettings;  //!< TCP client queue settings
+  bool m_running;                          //!< Server running state
+  bool m_useTCP;                           //!< Current protocol
+  int m_port;                              //!< Current port
+
+  std::thread m_thread;               //!< Network I/O thread
+  std::atomic<bool> m_stopRequested;  //!< Asks the I/O thread to exit
+  std::atomic<bool> m_wakeupPending;  //!< A wakeup has been sent
+  VDRSpscQueue<Batch> m_outbound;     //!< Batches for the I/O thread
+  std::atomic<uint64_t> m_batchesDropped;
+
+  Batch m_batch;  //!< Queued text messages
 
   static const int DEFAULT_PORT = 10111;  //!< Default NMEA port
+  /** Largest UDP payload sent without fragmentation on Ethernet. */
+  static const size_t MAX_DATAGRAM_SIZE = 1472;
+  /** Queued bytes after which messages are sent without waiting. */
+  static const size_t MAX_BATCH_SIZE = 64 * 1024;
+  /** Batches waiting for the I/O thread, beyond which they are dropped. */
+  static const size_t MAX_PENDING_BATCHES = 1024;
+  /** Longest command accepted from a TCP client. */
+  static const size_t MAX_COMMAND_LENGTH = 1024;
+  /** Most messages written to a TCP client by one system call. */
+  static const size_t MAX_GATHERED_MESSAGES = 64;
+};
+
+/**
+ * Receive buffer splitting a byte stream into lines.
+ *
+ * Data is received directly into the buffer and the lines are returned as
+ * pointers into it. Only the incomplete line at the end of the buffer is
+ * moved, to the front, to make room for more data.
+ */
+class VDRLineReader {
+public:
+  /** @param capacity Buffer size, the longest line accepted. */
+  explicit VDRLineReader(size_t capacity = DEFAULT_CAPACITY);
+
+  /**
+   * Get the free space after the received data.
+   *
+   * A line filling the whole buffer is discarded, up to its line ending.
+   *
+   * @param length Set to the number of bytes that can be received.
+   * @return Where to receive the data.
+   */
+  char* GetWriteBuffer(size_t* length);
+
+  /** Mark bytes written to the write buffer as received. */
+  void Commit(size_t length);
+
+  /**
+   * Get the next complete line, without its line ending. Empty lines are
+   * skipped.
+   *
+   * @param line Set to the line, valid until GetWriteBuffer() is called.
+   * @param length Set to the length of the line.
+   * @return False if there is no complete line.
+   */
+  bool NextLine(const char** line, size_t* length);
+
+  /**
+   * Get the incomplete line, as when a datagram has no final line ending.
+   *
+   * @return False if there is no incomplete line.
+   */
+  bool TakeRest(const char** line, size_t* length);
+
+  /** Forget the received data, as when a connection is lost. */
+  void Clear();
+
+  /** Get the number of lines discarded because they were too long. */
+  uint64_t GetLinesDiscarded() const { return m_linesDiscarded; }
+
+  static const size_t DEFAULT_CAPACITY = 64 * 1024;
+
+private:
+  std::vector<char> m_buffer;
+  size_t m_start;     //!< Start of the first unread line
+  size_t m_end;       //!< End of the received data
+  bool m_discarding;  //!< Skipping a line too long for the buffer
+  uint64_t m_linesDiscarded;
+};
+
+/**
+ * Network client receiving NMEA messages over TCP or UDP.
+ *
+ * Connects to a TCP server, reconnecting when the connection is lost, or
+ * receives UDP datagrams on a port. The messages are split into lines on a
+ * dedicated I/O thread and handed over to a handler, one line at a time.
+ * Lines are NMEA 0183 sentences or NMEA 2000 messages in a text format
+ * such as YD RAW.
+ */
+class VDRNetworkClient {
+public:
+  typedef VDRNetworkServer::Socket Socket;
+
+  /**
+   * Called on the I/O thread for each received line.
+   *
+   * The line has no line ending and is only valid during the call.
+   */
+  typedef std::function<void(const char* line, size_t length)> LineHandler;
+
+  VDRNetworkClient();
+  ~VDRNetworkClient();
+
+  /**
+   * Start receiving.
+   *
+   * @param useTCP True to connect to a TCP server, false to receive UDP.
+   * @param host TCP server host, unused for UDP.
+   * @param port TCP server port, or UDP port to receive on.
+   * @param handler Called for each received line.
+   * @param error Will contain error message if start fails
+   * @return True if the client started. A TCP client keeps trying to connect
+   * until it is stopped.
+   */
+  bool Start(bool useTCP, const wxString& host, int port,
+             const LineHandler& handler, wxString& error);
+
+  /** Stop receiving and close the connection. */
+  void Stop();
+
+  bool IsRunning() const { return m_running; }
+  /** Check if the TCP connection is up, or the UDP port is open. */
+  bool IsConnected() const { return m_connected; }
+  bool IsTCP() const { return m_useTCP; }
+  const wxString& GetHost() const { return m_host; }
+  int GetPort() const { return m_port; }
+  /** Get the number of lines handed over to the handler. */
+  uint64_t GetLinesReceived() const { return m_linesReceived; }
+
+private:
+  /** Open the UDP socket, or connect to the TCP server. */
+  bool Open();
+
+  /** Close the socket and forget the incomplete line. */
+  void Close();
+
+  /** Main loop of the I/O thread. */
+  void Run();
+
+  /**
+   * Receive the pending data.
+   *
+   * @return False if the TCP connection is lost.
+   */
+  bool Receive();
+
+  /** Hand the complete lines over to the handler. */
+  void HandleLines();
+
+  Socket m_socket;
+  uint32_t m_ip;  //!< Resolved TCP server address, in host byte order
+  LineHandler m_handler;
+  VDRLineReader m_reader;
+  bool m_running;
+  bool m_useTCP;
+  wxString m_host;
+  int m_port;
+  std::thread m_thread;               //!< Network I/O thread
+  std::atomic<bool> m_stopRequested;  //!< Asks the I/O thread to exit
+  std::atomic<bool> m_connected;
+  std::atomic<uint64_t> m_linesReceived;
+  bool m_reportFailure;  //!< Log the next connection failure
 
-  DECLARE_EVENT_TABLE()
+  /** Delay before connecting again to the TCP server. */
+  static const int RECONNECT_INTERVAL_MS = 5000;
 };
 
-#endif  // _VDR_NETWORK_H_
\ No newline at end of file
+#endif  // _VDR_NETWORK_H_
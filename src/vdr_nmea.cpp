@@ -0,0 +1,157 @@
+/***************************************************************************
+ *   Copyright (C) 2024 by OpenCPN development team                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ **************************************************************************/
+
+#include "vdr_nmea.h"
+
+#include <type_traits>
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define VDR_NMEA_SSE2
+#endif
+
+namespace {
+
+/**
+ * XOR and OR all characters, 16 bytes at a time with SSE2.
+ *
+ * @param bits Set to the OR of all characters.
+ * @return XOR of all characters.
+ */
+template <typename CharT>
+uint32_t XorChars(const CharT* data, size_t length, uint32_t& bits) {
+  uint32_t sum = 0;
+  bits = 0;
+  size_t i = 0;
+#ifdef VDR_NMEA_SSE2
+  const size_t step = sizeof(__m128i) / sizeof(CharT);
+  if (length >= step) {
+    __m128i x = _mm_setzero_si128();
+    __m128i o = _mm_setzero_si128();
+    for (; i + step <= length; i += step) {
+      __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+      x = _mm_xor_si128(x, v);
+      o = _mm_or_si128(o, v);
+    }
+    // Fold the four 32-bit lanes, then the characters packed in a lane.
+    x = _mm_xor_si128(x, _mm_srli_si128(x, 8));
+    x = _mm_xor_si128(x, _mm_srli_si128(x, 4));
+    o = _mm_or_si128(o, _mm_srli_si128(o, 8));
+    o = _mm_or_si128(o, _mm_srli_si128(o, 4));
+    sum = static_cast<uint32_t>(_mm_cvtsi128_si32(x));
+    bits = static_cast<uint32_t>(_mm_cvtsi128_si32(o));
+    if (sizeof(CharT) < 4) {
+      sum = (sum ^ (sum >> 16)) & 0xFFFF;
+      bits = (bits | (bits >> 16)) & 0xFFFF;
+    }
+    if (sizeof(CharT) < 2) {
+      sum = (sum ^ (sum >> 8)) & 0xFF;
+      bits = (bits | (bits >> 8)) & 0xFF;
+    }
+  }
+#endif
+  for (; i < length; i++) {
+    // Characters are compared unsigned, negative chars are not ASCII.
+    uint32_t c = static_cast<uint32_t>(
+        static_cast<typename std::make_unsigned<CharT>::type>(data[i]));
+    sum ^= c;
+    bits |= c;
+  }
+  return sum;
+}
+
+bool IsUpper(wxStringCharType c) { return c >= 'A' && c <= 'Z'; }
+
+int HexValue(wxStringCharType c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  return -1;
+}
+
+}  // namespace
+
+uint8_t ComputeNMEAChecksum(const wxStringCharType* data, size_t length,
+                            bool* isAscii) {
+  uint32_t bits;
+  uint32_t sum = XorChars(data, length, bits);
+  if (isAscii) *isAscii = bits < 0x80;
+  return static_cast<uint8_t>(sum & 0xFF);
+}
+
+NMEASentenceStatus ValidateNMEASentence(const wxStringCharType* sentence,
+                                        size_t length,
+                                        NMEASentenceHeader* header) {
+  // Shortest sentence: $GPXXX,*hh
+  if (length < 7 || (sentence[0] != '$' && sentence[0] != '!')) {
+    return NMEASentenceStatus::MALFORMED;
+  }
+  for (size_t i = 1; i < 6; i++) {
+    if (!IsUpper(sentence[i])) return NMEASentenceStatus::MALFORMED;
+  }
+  if (sentence[6] != ',') return NMEASentenceStatus::MALFORMED;
+
+  bool isAIS = sentence[0] == '!';
+  if (isAIS) {
+    // Only accept the AIS talker IDs.
+    wxStringCharType first = sentence[1];
+    wxStringCharType second = sentence[2];
+    if (!(first == 'A' && (second == 'I' || second == 'B')) &&
+        !(first == 'B' && second == 'S')) {
+      return NMEASentenceStatus::MALFORMED;
+    }
+  }
+
+  // The checksum is the last field, skip the line ending.
+  size_t end = length;
+  while (end > 7 && (sentence[end - 1] == '\r' || sentence[end - 1] == '\n' ||
+                     sentence[end - 1] == ' ' || sentence[end - 1] == '\t')) {
+    end--;
+  }
+  NMEASentenceStatus status = NMEASentenceStatus::BAD_CHECKSUM;
+  if (end >= 10 && sentence[end - 3] == '*') {
+    int high = HexValue(sentence[end - 2]);
+    int low = HexValue(sentence[end - 1]);
+    bool isAscii;
+    if (high >= 0 && low >= 0 &&
+        ComputeNMEAChecksum(sentence + 1, end - 4, &isAscii) ==
+            (high << 4 | low) &&
+        isAscii) {
+      status = NMEASentenceStatus::VALID;
+    }
+  } else {
+    // Without a * the data cannot be delimited.
+    bool hasChecksum = false;
+    for (size_t i = 7; i < end && !hasChecksum; i++) {
+      hasChecksum = sentence[i] == '*';
+    }
+    if (!hasChecksum) return NMEASentenceStatus::MALFORMED;
+  }
+
+  if (header) {
+    header->talkerId[0] = sentence[1];
+    header->talkerId[1] = sentence[2];
+    header->sentenceId[0] = sentence[3];
+    header->sentenceId[1] = sentence[4];
+    header->sentenceId[2] = sentence[5];
+    header->isAIS = isAIS;
+  }
+  return status;
+}
@@ -0,0 +1,69 @@
+/***************************************************************************
+ *   Copyright (C) 2024 by OpenCPN development team                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ **************************************************************************/
+
+#ifndef _VDR_NMEA_H_
+#define _VDR_NMEA_H_
+
+#include <wx/string.h>
+
+#include <cstddef>
+#include <cstdint>
+
+/** Result of the validation of an NMEA 0183 sentence. */
+enum class NMEASentenceStatus {
+  VALID,        //!< Well formed, with a matching checksum.
+  MALFORMED,    //!< Not an NMEA 0183 or AIS sentence.
+  BAD_CHECKSUM  //!< Well formed header, invalid or mismatched checksum.
+};
+
+/** Talker and sentence identifiers of an NMEA 0183 sentence. */
+struct NMEASentenceHeader {
+  wxStringCharType talkerId[2];    //!< e.g. GP, not null-terminated.
+  wxStringCharType sentenceId[3];  //!< e.g. RMC, not null-terminated.
+  bool isAIS;                      //!< Encapsulated sentence starting with !
+};
+
+/**
+ * Compute the checksum of NMEA 0183 sentence data, the XOR of all characters.
+ *
+ * @param data Characters between the leading $ or ! and the *.
+ * @param length Number of characters.
+ * @param isAscii Set to false if a character is not 7-bit ASCII, the
+ * checksum is then meaningless.
+ */
+uint8_t ComputeNMEAChecksum(const wxStringCharType* data, size_t length,
+                            bool* isAscii = nullptr);
+
+/**
+ * Validate an NMEA 0183 or AIS sentence and extract its identifiers.
+ *
+ * The header must be $ or ! followed by 5 uppercase letters and a comma, AIS
+ * sentences only come from the AI, AB and BS talkers. The sentence must end
+ * with *hh, optionally followed by white space.
+ *
+ * @param sentence Characters of the sentence.
+ * @param length Number of characters.
+ * @param header Optional output identifiers, set unless the sentence is
+ * malformed.
+ */
+NMEASentenceStatus ValidateNMEASentence(const wxStringCharType* sentence,
+                                        size_t length,
+                                        NMEASentenceHeader* header);
+
+#endif  // _VDR_NMEA_H_
@@ -26,12 +26,16 @@
 #include "wx/tokenzr.h"
 #include "wx/statline.h"
 #include "wx/display.h"
+#include "wx/jsonval.h"
+#include "wx/jsonwriter.h"
 
 #include <map>
 #include <typeinfo>
 #include <algorithm>
 #include <cstring>
 #include <cstdint>
+#include <cctype>
+#include <cmath>
 
 #include "ocpn_plugin.h"
 
@@ -84,13 +88,29 @@ vdr_pi::vdr_pi(void* ppimgr) : opencpn_plugin_118(ppimgr) {
     wxLogWarning("VDR panel icon has NOT been loaded");
 
   m_pvdrcontrol = nullptr;
+  m_speed_multiplier = 1.0;
 
   // Runtime variables
   m_recording = false;
   m_recording_paused = false;
   m_playing = false;
   m_is_csv_file = false;
+  m_follow_mode = false;
+  m_skip_corrupt_sentences = false;
+  m_corrupt_sentences = 0;
+  m_instant_replay = false;
+  m_replay_start_ms = 0;
+  m_replay_first_ms = 0;
+  m_replay_timer = nullptr;
+  m_input_timer = nullptr;
+  m_input_dropped = 0;
+  m_blackbox_written_sequence = 0;
+  m_blackbox_above_threshold = false;
   m_last_speed = 0.0;
+  m_playback_base_time = INVALID_TIME_MS;
+  m_firstTimestamp = INVALID_TIME_MS;
+  m_lastTimestamp = INVALID_TIME_MS;
+  m_currentTimestamp = INVALID_TIME_MS;
   m_sentence_buffer.clear();
   m_messages_dropped = false;
 }
@@ -98,6 +118,8 @@ vdr_pi::vdr_pi(void* ppimgr) : opencpn_plugin_118(ppimgr) {
 int vdr_pi::Init(void) {
   m_eventHandler = new wxEvtHandler();
   m_timer = new TimerHandler(this);
+  m_replay_timer = new InstantReplayTimer(this);
+  m_input_timer = new NetworkInputTimer(this);
 
   AddLocaleCatalog(_T("opencpn-vdr_pi"));
 
@@ -111,10 +133,14 @@ int vdr_pi::Init(void) {
   // Set up NMEA 2000 listeners based on preferences
   UpdateNMEA2000Listeners();
 
+  // Start receiving from the network source, if any.
+  UpdateNetworkInput();
+
   // If auto-start is enabled and we're not playing back and not using speed
   // threshold, start recording after initialization.
   m_recording_manually_disabled = false;
-  if (m_auto_start_recording && !m_use_speed_threshold && !IsPlaying()) {
+  if (m_auto_start_recording && !m_use_speed_threshold &&
+      !m_blackbox_settings.enabled && !IsPlaying()) {
     wxLogMessage("Auto-starting recording on plugin initialization");
     StartRecording();
     SetToolbarToolStatus(m_tb_item_id_record, true);
@@ -130,7 +156,8 @@ int vdr_pi::Init(void) {
   m_recording = false;
 
   return (WANTS_TOOLBAR_CALLBACK | INSTALLS_TOOLBAR_TOOL | WANTS_CONFIG |
-          WANTS_NMEA_SENTENCES | WANTS_AIS_SENTENCES | WANTS_PREFERENCES);
+          WANTS_NMEA_SENTENCES | WANTS_AIS_SENTENCES | WANTS_PREFERENCES |
+          WANTS_PLUGIN_MESSAGING);
 }
 
 bool vdr_pi::DeInit(void) {
@@ -143,6 +170,17 @@ bool vdr_pi::DeInit(void) {
     delete m_timer;
     m_timer = nullptr;
   }
+  if (m_replay_timer) {
+    StopInstantReplay();
+    delete m_replay_timer;
+    m_replay_timer = nullptr;
+  }
+  if (m_input_timer) {
+    m_protocols.input.enabled = false;
+    UpdateNetworkInput();
+    delete m_input_timer;
+    m_input_timer = nullptr;
+  }
 
   if (m_pvdrcontrol) {
     m_pauimgr->DetachPane(m_pvdrcontrol);
@@ -219,7 +257,31 @@ void vdr_pi::UpdateSignalKListeners() {
   wxLogMessage("Configuring SignalK listeners. SignalK enabled: %d",
                m_protocols.signalK);
   if (m_protocols.signalK) {
-    // TODO: Implement SignalK configuration.
+    // Deltas of the own vessel.
+    m_signalk_listeners.push_back(
+        GetListener(SignalkId("self"), EVT_SIGNALK, m_eventHandler));
+    m_eventHandler->Bind(EVT_SIGNALK, &vdr_pi::OnSignalKEvent, this);
+  }
+}
+
+void vdr_pi::SetProtocolSettings(const VDRProtocolSettings& settings) {
+  bool previousNMEA2000State = m_protocols.nmea2000;
+  bool previousSignalKState = m_protocols.signalK;
+  VDRNetworkInputSettings previousInput = m_protocols.input;
+  m_protocols = settings;
+  m_signalk_encoder.SetHeartbeat(m_protocols.signalKHeartbeatSec * 1000LL);
+  m_signalk_ring_encoder.SetHeartbeat(m_protocols.signalKHeartbeatSec *
+                                      1000LL);
+
+  // Update listeners if the setting changed
+  if (previousNMEA2000State != m_protocols.nmea2000) {
+    UpdateNMEA2000Listeners();
+  }
+  if (previousSignalKState != m_protocols.signalK) {
+    UpdateSignalKListeners();
+  }
+  if (previousInput != m_protocols.input) {
+    UpdateNetworkInput();
   }
 }
 
@@ -310,7 +372,58 @@ void vdr_pi::OnSignalKEvent(wxCommandEvent& event) {
     // SignalK recording is disabled.
     return;
   }
-  // TODO: Implement SignalK recording.
+  ObservedEvt& ev = dynamic_cast<ObservedEvt&>(event);
+  std::shared_ptr<const wxJSONValue> payload =
+      std::static_pointer_cast<const wxJSONValue>(GetSignalkPayload(ev));
+  if (!payload || !payload->HasMember("Data")) {
+    return;
+  }
+  wxString json;
+  wxJSONWriter writer(wxJSONWRITER_NONE);
+  writer.Write(payload->ItemAt("Data"), json);
+  wxString self = payload->HasMember("ContextSelf")
+                      ? payload->ItemAt("ContextSelf").AsString()
+                      : wxString("vessels.self");
+  RecordSignalKDelta(json.ToStdString(), self.ToStdString());
+}
+
+void vdr_pi::RecordSignalKDelta(const std::string& json,
+                                const std::string& selfContext) {
+  if (!m_protocols.signalK ||
+      ((!m_recording || m_recording_paused) && !IsBuffering())) {
+    return;
+  }
+  std::vector<SignalKValue> values;
+  if (!ParseSignalKDelta(json, selfContext, &values)) {
+    return;
+  }
+
+  int64_t now = wxGetUTCTimeMillis().GetValue();
+  std::vector<std::string> records;
+  if (IsBuffering()) {
+    for (const SignalKValue& value : values) {
+      m_signalk_ring_encoder.Encode(value, now, &records);
+    }
+    SignalKValue decoded;
+    for (const std::string& record : records) {
+      m_signalk_ring_decoder.Decode(record, &decoded);
+      m_ring.Add(now, record);
+    }
+    records.clear();
+  }
+  CheckBlackBoxWindow();
+  if (!m_recording || m_recording_paused) return;
+
+  // A new file starts a new dictionary, rotate before encoding.
+  CheckLogRotation();
+
+  for (const SignalKValue& value : values) {
+    m_signalk_encoder.Encode(value, now, &records);
+  }
+  wxDateTime timestamp = wxDateTime::UNow();
+  for (const std::string& record : records) {
+    WriteNMEA0183(wxString(record), timestamp);
+  }
 }
 
 /**
@@ -356,14 +469,16 @@ inline uint16_t N2KToInt16(const uint8_t* data) {
 }
 
 void vdr_pi::OnN2KEvent(wxCommandEvent& event) {
+  ObservedEvt& ev = dynamic_cast<ObservedEvt&>(event);
+  // Get payload and source
+  ProcessN2KPayload(GetN2000Payload(0, ev));  // ID does not matter.
+}
+
+void vdr_pi::ProcessN2KPayload(const std::vector<uint8_t>& payload) {
   if (!m_protocols.nmea2000) {
     // NMEA 2000 recording is disabled.
     return;
   }
-
-  ObservedEvt& ev = dynamic_cast<ObservedEvt&>(event);
-  // Get payload and source
-  std::vector<uint8_t> payload = GetN2000Payload(0, ev);  // ID does not matter.
   // Extract PGN from payload (bytes 3-5, little endian)
   if (payload.size() < 6) {
     return;  // Not enough bytes for valid message
@@ -392,47 +507,117 @@ void vdr_pi::OnN2KEvent(wxCommandEvent& event) {
     }
   }
 
-  if (!m_recording) {
+  // Man overboard (PGN 127233) fires a black box trigger. This is done before
+  // buffering the message so it is written once, when recording.
+  if (pgn == 127233 && m_blackbox_settings.enabled) {
+    TriggerBlackBox("MOB (Man Overboard) PGN 127233");
+  }
+
+  if (!m_recording && !IsBuffering()) {
     return;
   }
 
   // Convert payload for logging
-  wxString log_payload;
+  wxString log_payload = FormatN2KPayload(payload);
+
+  if (IsBuffering()) {
+    m_ring.Add(wxGetUTCTimeMillis().GetValue(),
+               wxString::Format("$PCDIN,%d,%s", pgn, log_payload)
+                   .ToStdString());
+  }
+  CheckBlackBoxWindow();
+  if (!m_recording) {
+    return;
+  }
+
+  // Check if we need to rotate the VDR file.
+  CheckLogRotation();
+
+  WriteNMEA2000(pgn, log_payload, wxDateTime::UNow());
+}
+
+wxString vdr_pi::FormatN2KPayload(const std::vector<uint8_t>& payload) {
+  wxString hex;
   for (size_t i = 0; i < payload.size(); i++) {
-    log_payload += wxString::Format("%02X", payload[i]);
+    hex += wxString::Format("%02X", payload[i]);
   }
+  return hex;
+}
 
+void vdr_pi::WriteNMEA2000(unsigned int pgn, const wxString& payload,
+                           const wxDateTime& timestamp) {
   // Format N2K message for recording.
   wxString formatted_message;
   switch (m_data_format) {
-    case VDRDataFormat::CSV: {
+    case VDRDataFormat::CSV:
       // CSV format: timestamp,type,id,payload
       // where "id" is the PGN number.
-      wxString timestamp = FormatIsoDateTime(wxDateTime::UNow());
       formatted_message =
-          wxString::Format("%s,NMEA2000,%d,%s\n", timestamp, pgn, log_payload);
+          wxString::Format("%s,NMEA2000,%u,%s\n", FormatIsoDateTime(timestamp),
+                           pgn, payload);
       break;
-    }
     case VDRDataFormat::RawNMEA:
       // PCDIN format: $PCDIN,<pgn>,<payload>
-      formatted_message =
-          wxString::Format("$PCDIN,%d,%s\r\n", pgn, log_payload);
+      formatted_message = wxString::Format("$PCDIN,%u,%s\r\n", pgn, payload);
       break;
   }
+  m_ostream.Write(formatted_message.ToStdString());
+}
 
-  // Check if we need to rotate the VDR file.
-  CheckLogRotation();
+void vdr_pi::WriteNMEA0183(const wxString& sentence,
+                           const wxDateTime& timestamp) {
+  wxString normalizedSentence = sentence;
+  normalizedSentence.Trim(true);
 
-  m_ostream.Write(formatted_message.ToStdString());
+  switch (m_data_format) {
+    case VDRDataFormat::CSV:
+      m_ostream.Write(FormatNMEA0183AsCSV(normalizedSentence, timestamp));
+      break;
+    case VDRDataFormat::RawNMEA:
+    default:
+      if (!normalizedSentence.EndsWith("\r\n")) {
+        normalizedSentence += "\r\n";
+      }
+      m_ostream.Write(normalizedSentence);
+      break;
+  }
 }
 
-wxString vdr_pi::FormatNMEA0183AsCSV(const wxString& nmea) {
-  // Get current time with millisecond precision
-  wxString timestamp = FormatIsoDateTime(wxDateTime::UNow());
+void vdr_pi::WriteBufferedMessage(const RingMessage& message) {
+  wxDateTime timestamp(wxLongLong(message.timeMs));
+  if (IsSignalKRecord(message.message)) {
+    // Buffered with the dictionary of the buffer, write it with the
+    // dictionary of the VDR file.
+    SignalKValue value;
+    if (!m_signalk_ring_decoder.Decode(message.message, &value)) return;
+    std::vector<std::string> records;
+    m_signalk_encoder.Encode(value, message.timeMs, &records);
+    for (const std::string& record : records) {
+      WriteNMEA0183(wxString(record), timestamp);
+    }
+    return;
+  }
+  wxString text(message.message);
+  // NMEA 2000 messages are buffered in the "$PCDIN,<pgn>,<payload>" format.
+  unsigned long pgn;
+  if (text.StartsWith("$PCDIN,") &&
+      text.AfterFirst(',').BeforeFirst(',').ToULong(&pgn)) {
+    WriteNMEA2000(pgn, text.AfterFirst(',').AfterFirst(','), timestamp);
+    return;
+  }
+  WriteNMEA0183(text, timestamp);
+}
+
+wxString vdr_pi::FormatNMEA0183AsCSV(const wxString& nmea,
+                                     const wxDateTime& ts) {
+  // Timestamp with millisecond precision
+  wxString timestamp = FormatIsoDateTime(ts);
 
   wxString type = "NMEA0183";
   if (nmea.StartsWith("!")) {
     type = "AIS";
+  } else if (nmea.StartsWith(SIGNALK_RECORD_PREFIX)) {
+    type = "SignalK";
   }
 
   // Escape any commas in the NMEA message
@@ -449,6 +634,14 @@ void vdr_pi::SetNMEASentence(wxString& sentence) {
     // Recording of NMEA 0183 is disabled.
     return;
   }
+  wxLongLong now = wxGetUTCTimeMillis();
+  if (!m_echo_filter.IsEmpty() &&
+      m_echo_filter.Consume(
+          now.GetValue(),
+          wxString(sentence).Trim(true).Trim(false).ToStdString())) {
+    // Sentence sent by instant replay, it has already been recorded.
+    return;
+  }
   // Check for RMC sentence to get speed and check for auto-recording.
   // There can be different talkers on the stream so look at the message type
   // irrespective of the talker.
@@ -473,33 +666,32 @@ void vdr_pi::SetNMEASentence(wxString& sentence) {
     }
   }
 
+  if (IsBuffering()) {
+    m_ring.Add(now.GetValue(),
+               wxString(sentence).Trim(true).Trim(false).ToStdString());
+  }
+  CheckBlackBoxWindow();
+
   // Only record if recording is active (whether manual or automatic)
   if (!m_recording || m_recording_paused) return;
 
   // Check if we need to rotate the VDR file.
   CheckLogRotation();
 
-  wxString normalizedSentence = sentence;
-  normalizedSentence.Trim(true);
-
-  switch (m_data_format) {
-    case VDRDataFormat::CSV:
-      m_ostream.Write(FormatNMEA0183AsCSV(normalizedSentence));
-      break;
-    case VDRDataFormat::RawNMEA:
-    default:
-      if (!normalizedSentence.EndsWith("\r\n")) {
-        normalizedSentence += "\r\n";
-      }
-      m_ostream.Write(normalizedSentence);
-      break;
-  }
+  WriteNMEA0183(sentence, wxDateTime::UNow());
 }
 
 void vdr_pi::SetAISSentence(wxString& sentence) {
   SetNMEASentence(sentence);  // Handle the same way as NMEA
 }
 
+void vdr_pi::SetPluginMessage(wxString& message_id, wxString& message_body) {
+  if (message_id == "VDR_BLACKBOX_TRIGGER") {
+    TriggerBlackBox(message_body.IsEmpty() ? wxString("Plugin message")
+                                           : message_body);
+  }
+}
+
 const ConnectionSettings& vdr_pi::GetNetworkSettings(
     const wxString& protocol) const {
   if (protocol == "N2K")
@@ -529,6 +721,22 @@ void vdr_pi::CheckAutoRecording(double speed) {
     return;
   }
 
+  // Add hysteresis to prevent rapid starting/stopping
+  static const double HYSTERESIS = 0.2;  // 0.2 knots below threshold
+
+  if (m_blackbox_settings.enabled) {
+    // In black box mode, crossing the threshold fires a trigger. Recording
+    // stops at the end of the post-trigger window.
+    if (speed >= m_speed_threshold && !m_blackbox_above_threshold) {
+      m_blackbox_above_threshold = true;
+      TriggerBlackBox(wxString::Format("Speed %.2f exceeds threshold %.2f",
+                                       speed, m_speed_threshold));
+    } else if (speed < m_speed_threshold - HYSTERESIS) {
+      m_blackbox_above_threshold = false;
+    }
+    return;
+  }
+
   // If speed drops below threshold, clear the manual disable flag.
   if (speed < m_speed_threshold) {
     if (m_recording_manually_disabled) {
@@ -556,8 +764,6 @@ void vdr_pi::CheckAutoRecording(double speed) {
       ResumeRecording();
     }
   } else if (m_recording) {
-    // Add hysteresis to prevent rapid starting/stopping
-    static const double HYSTERESIS = 0.2;  // 0.2 knots below threshold
     if (speed < (m_speed_threshold - HYSTERESIS)) {
       // If we're recording and it was auto-started, handle stop delay
       if (!m_below_threshold_since.IsValid()) {
@@ -625,20 +831,56 @@ bool vdr_pi::ParseCSVLineTimestamp(const wxString& line, wxString* message,
 
 void vdr_pi::FlushSentenceBuffer() {
   for (const auto& sentence : m_sentence_buffer) {
-    PushNMEABuffer(sentence + "\r\n");
+    PushNMEABuffer(wxString(*sentence));
   }
   m_sentence_buffer.clear();
+  QueueSignalKDelta();
+
+  // Send the sentences queued by HandleNetworkPlayback().
+  for (auto& server : m_networkServers) {
+    if (server.second->IsRunning()) {
+      server.second->Flush();
+    }
+  }
+}
+
+void vdr_pi::EmitStateSnapshot(const StateSnapshot& state) {
+  for (const auto& message : state.GetMessages()) {
+    if (IsSignalKRecord(message)) {
+      HandleSignalKPlayback(message);
+      continue;
+    }
+    VDRMessagePtr nmea = MakeVDRMessage(message);
+    if (m_protocols.nmea0183ReplayMode == NMEA0183ReplayMode::INTERNAL_API) {
+      m_sentence_buffer.push_back(nmea);
+    }
+    HandleNetworkPlayback(nmea);
+  }
+  FlushSentenceBuffer();
 }
 
 double vdr_pi::GetSpeedMultiplier() const {
-  return m_pvdrcontrol ? m_pvdrcontrol->GetSpeedMultiplier() : 1.0;
+  return m_pvdrcontrol ? m_pvdrcontrol->GetSpeedMultiplier()
+                       : m_speed_multiplier;
+}
+
+void vdr_pi::SetSpeedMultiplier(double multiplier) {
+  if (multiplier <= 0) return;
+  m_speed_multiplier = multiplier;
+  if (m_playing) AdjustPlaybackBaseTime();
 }
 
 void vdr_pi::Notify() {
   if (!m_istream.IsOpened()) return;
 
-  wxDateTime now = wxDateTime::UNow();
-  wxDateTime targetTime;
+  if (m_follower.IsActive() && m_istream.Eof() && ReadAppendedLines() == 0) {
+    // Nothing new has been written to the followed file, check again later.
+    m_timer->Start(FOLLOW_POLL_INTERVAL_MS, wxTIMER_ONE_SHOT);
+    return;
+  }
+
+  VDRTimeMs now = wxGetUTCTimeMillis().GetValue();
+  VDRTimeMs targetTime;
   bool behindSchedule = true;
   int precision;
 
@@ -668,6 +910,14 @@ void vdr_pi::Notify() {
     }
 
     if (m_istream.Eof() && line.IsEmpty()) {
+      if (m_follower.IsActive()) {
+        if (ReadAppendedLines() > 0) continue;
+        // Wait for the recorder to append more data.
+        FlushSentenceBuffer();
+        m_timer->Start(FOLLOW_POLL_INTERVAL_MS, wxTIMER_ONE_SHOT);
+        break;
+      }
+      FlushSentenceBuffer();
       m_atFileEnd = true;
       PausePlayback();
       if (m_pvdrcontrol) {
@@ -687,37 +937,50 @@ void vdr_pi::Notify() {
         nmea += "\r\n";
         msgHasTimestamp = true;
       }
-    } else {
+      if (m_skip_corrupt_sentences && IsCorruptSentence(nmea)) {
+        nmea.Clear();
+      }
+    } else if (!m_skip_corrupt_sentences || !IsCorruptSentence(line)) {
       nmea = line + "\r\n";
       msgHasTimestamp =
           m_timestampParser.ParseTimestamp(line, timestamp, precision);
     }
     if (!nmea.IsEmpty()) {
-      if (m_protocols.nmea0183ReplayMode == NMEA0183ReplayMode::INTERNAL_API) {
-        // Add sentence to buffer, maintaining max size.
-        m_sentence_buffer.push_back(nmea);
-      }
-
-      // Send through network if enabled.
-      HandleNetworkPlayback(nmea);
-
       if (msgHasTimestamp) {
         // The current sentence has a timestamp from the primary time source.
-        m_currentTimestamp = timestamp;
+        m_currentTimestamp = ToTimeMs(timestamp);
         targetTime = GetNextPlaybackTime();
         // Check if we've caught up to schedule.
-        if (targetTime.IsValid() && targetTime > now) {
-          behindSchedule = false;  // This will break the loop.
+        if (targetTime != INVALID_TIME_MS && targetTime > now) {
+          // The sentence is not due yet, read it again at the next
+          // notification so it is sent on time.
+          m_istream.GoToLine(pos);
           // Before scheduling next update, flush our sentence buffer.
           FlushSentenceBuffer();
           // Schedule next notification.
-          wxTimeSpan waitTime = targetTime - now;
-          m_timer->Start(
-              static_cast<int>(waitTime.GetMilliseconds().ToDouble()),
-              wxTIMER_ONE_SHOT);
+          m_timer->Start(static_cast<int>(targetTime - now), wxTIMER_ONE_SHOT);
+          break;
         }
-      } else if (!HasValidTimestamps() &&
-                 m_sentence_buffer.size() >= BASE_MESSAGES_PER_BATCH) {
+      }
+
+      if (nmea.StartsWith(SIGNALK_RECORD_PREFIX)) {
+        // Signal K records are not NMEA 0183 sentences.
+        HandleSignalKPlayback(nmea.ToStdString());
+        continue;
+      }
+
+      // A single copy of the sentence is shared by all the outputs.
+      VDRMessagePtr message = MakeVDRMessage(nmea);
+      if (m_protocols.nmea0183ReplayMode == NMEA0183ReplayMode::INTERNAL_API) {
+        // Add sentence to buffer, maintaining max size.
+        m_sentence_buffer.push_back(message);
+      }
+
+      // Send through network if enabled.
+      HandleNetworkPlayback(message);
+
+      if (!msgHasTimestamp && !HasValidTimestamps() &&
+          m_sentence_buffer.size() >= BASE_MESSAGES_PER_BATCH) {
         // For files that do not have timestamped records (or timestamps are not
         // in chronological order), use batch processing.
         behindSchedule = false;  // This will break the loop.
@@ -749,26 +1012,206 @@ void vdr_pi::Notify() {
   }
 }
 
-wxDateTime vdr_pi::GetNextPlaybackTime() const {
-  if (!m_currentTimestamp.IsValid() || !m_firstTimestamp.IsValid() ||
-      !m_playback_base_time.IsValid()) {
-    return wxDateTime();  // Return invalid time if we don't have valid
-                          // timestamps
+VDRTimeMs vdr_pi::GetNextPlaybackTime() const {
+  if (m_currentTimestamp == INVALID_TIME_MS ||
+      m_firstTimestamp == INVALID_TIME_MS ||
+      m_playback_base_time == INVALID_TIME_MS) {
+    return INVALID_TIME_MS;  // We don't have valid timestamps.
   }
   // Calculate when this message should be played relative to playback start.
-  wxTimeSpan elapsedTime = m_currentTimestamp - m_firstTimestamp;
-  wxLongLong ms = elapsedTime.GetMilliseconds();
-  double scaledMs = ms.ToDouble() / GetSpeedMultiplier();
-  wxTimeSpan scaledElapsed =
-      wxTimeSpan::Milliseconds(static_cast<long>(scaledMs));
-  return m_playback_base_time + scaledElapsed;
+  VDRTimeMs elapsedMs = m_currentTimestamp - m_firstTimestamp;
+  return m_playback_base_time +
+         static_cast<VDRTimeMs>(elapsedMs / GetSpeedMultiplier());
+}
+
+void vdr_pi::SetTimeShiftSettings(const VDRTimeShiftSettings& settings) {
+  m_timeshift_settings = settings;
+  UpdateRingLimits();
+}
+
+void vdr_pi::SetBlackBoxSettings(const VDRBlackBoxSettings& settings) {
+  if (settings.enabled != m_blackbox_settings.enabled) {
+    m_blackbox_until = wxDateTime();
+    m_blackbox_above_threshold = false;
+  }
+  m_blackbox_settings = settings;
+  UpdateRingLimits();
+}
+
+void vdr_pi::UpdateRingLimits() {
+  if (!IsBuffering()) {
+    m_ring.Clear();
+    m_signalk_ring_encoder.Reset();
+    m_signalk_ring_decoder.Reset();
+    return;
+  }
+  // The buffer is shared, keep messages for the longest of both horizons.
+  int minutes = 0;
+  if (m_timeshift_settings.enabled) {
+    minutes = m_timeshift_settings.minutes;
+  }
+  if (m_blackbox_settings.enabled) {
+    minutes = std::max(minutes, m_blackbox_settings.preTriggerMinutes);
+  }
+  m_ring.SetLimits(
+      static_cast<size_t>(m_timeshift_settings.maxMegabytes) * 1024 * 1024,
+      static_cast<int64_t>(minutes) * 60 * 1000);
+}
+
+bool vdr_pi::TriggerBlackBox(const wxString& reason) {
+  if (!m_blackbox_settings.enabled) return false;
+  if (IsPlaying()) {
+    wxLogMessage("Ignore black box trigger while playback is active: %s",
+                 reason);
+    return false;
+  }
+
+  m_blackbox_until =
+      wxDateTime::UNow() +
+      wxTimeSpan::Minutes(m_blackbox_settings.postTriggerMinutes);
+  if (m_recording) {
+    wxLogMessage("Black box trigger: %s. Extend recording for %d minutes",
+                 reason, m_blackbox_settings.postTriggerMinutes);
+    ResumeRecording();
+    return true;
+  }
+
+  wxLogMessage("Black box trigger: %s", reason);
+  StartRecording();
+  if (!m_recording) {
+    m_blackbox_until = wxDateTime();
+    return false;
+  }
+  SetToolbarToolStatus(m_tb_item_id_record, true);
+
+  // Write the messages of the pre-trigger window that are not in a previous
+  // VDR file, with their reception time. The Signal K values are encoded
+  // with the dictionary of the new file, reset by StartRecording().
+  int64_t since =
+      wxGetUTCTimeMillis().GetValue() -
+      static_cast<int64_t>(m_blackbox_settings.preTriggerMinutes) * 60 * 1000;
+  int written = 0;
+  for (const RingMessage& message : m_ring.GetMessagesSince(since)) {
+    if (message.sequence > m_blackbox_written_sequence) {
+      WriteBufferedMessage(message);
+      written++;
+    }
+  }
+  m_blackbox_written_sequence = m_ring.GetLastSequence();
+  wxLogMessage("Wrote %d buffered messages", written);
+  return true;
+}
+
+void vdr_pi::CheckBlackBoxWindow() {
+  if (!m_recording || !m_blackbox_until.IsValid()) return;
+  if (wxDateTime::UNow() < m_blackbox_until) return;
+  m_blackbox_until = wxDateTime();
+  StopRecording("Black box post-trigger window elapsed");
+  SetToolbarToolStatus(m_tb_item_id_record, false);
+}
+
+bool vdr_pi::StartInstantReplay(int minutes) {
+  if (!m_timeshift_settings.enabled || !m_replay_timer) return false;
+  if (m_playing) {
+    wxLogMessage("Cannot start instant replay while playing a file");
+    return false;
+  }
+  StopInstantReplay();
+
+  int64_t now = wxGetUTCTimeMillis().GetValue();
+  std::vector<RingMessage> messages =
+      m_ring.GetMessagesSince(now - static_cast<int64_t>(minutes) * 60 * 1000);
+  if (messages.empty()) {
+    wxLogMessage("No buffered messages for instant replay");
+    return false;
+  }
+  m_replay_queue.assign(messages.begin(), messages.end());
+  m_replay_first_ms = m_replay_queue.front().timeMs;
+  m_replay_start_ms = now;
+  m_instant_replay = true;
+
+  if (!InitializeNetworkServers()) {
+    wxLogWarning("Continuing instant replay with failed network servers");
+  }
+  wxLogMessage(
+      "Start instant replay of %d messages received in the last %d minutes",
+      static_cast<int>(m_replay_queue.size()), minutes);
+  OnInstantReplayTimer();
+  return true;
+}
+
+void vdr_pi::StopInstantReplay() {
+  if (!m_instant_replay) return;
+  m_replay_timer->Stop();
+  m_replay_queue.clear();
+  m_instant_replay = false;
+  FlushSentenceBuffer();
+  if (!m_pvdrcontrol) {
+    SetToolbarItemState(m_tb_item_id_play, false);
+  }
+  wxLogMessage("Instant replay stopped");
+}
+
+void vdr_pi::OnInstantReplayTimer() {
+  if (!m_instant_replay) return;
+
+  int64_t now = wxGetUTCTimeMillis().GetValue();
+  double speed = GetSpeedMultiplier();
+  int64_t due = now;
+  while (!m_replay_queue.empty()) {
+    const RingMessage& message = m_replay_queue.front();
+    due = m_replay_start_ms +
+          static_cast<int64_t>((message.timeMs - m_replay_first_ms) / speed);
+    if (due > now) break;
+
+    if (IsSignalKRecord(message.message)) {
+      SignalKValue value;
+      if (m_signalk_ring_decoder.Decode(message.message, &value) &&
+          m_protocols.signalKNet.enabled) {
+        AddSignalKPlaybackValue(value, message.timeMs);
+      }
+      m_replay_queue.pop_front();
+      continue;
+    }
+    VDRMessagePtr nmea = MakeVDRMessage(message.message);
+    if (m_protocols.nmea0183ReplayMode == NMEA0183ReplayMode::INTERNAL_API &&
+        nmea->compare(0, 6, "$PCDIN") != 0) {
+      m_sentence_buffer.push_back(nmea);
+      m_echo_filter.Add(now, message.message);
+    }
+    HandleNetworkPlayback(nmea);
+    m_replay_queue.pop_front();
+  }
+  FlushSentenceBuffer();
+
+  if (m_replay_queue.empty()) {
+    StopInstantReplay();
+    return;
+  }
+  m_replay_timer->Start(static_cast<int>(due - now), wxTIMER_ONE_SHOT);
 }
 
 int vdr_pi::GetToolbarToolCount(void) { return 2; }
 
 void vdr_pi::OnToolbarToolCallback(int id) {
   if (id == m_tb_item_id_play) {
-    // Don't allow playback while recording
+    if (m_instant_replay) {
+      StopInstantReplay();
+      return;
+    }
+    // Don't allow file playback while recording, offer to replay recent data
+    // from memory instead.
+    if (m_recording && m_timeshift_settings.enabled) {
+      int answer = wxMessageBox(
+          wxString::Format(_("Recording is active. Replay the last %d minutes "
+                             "from memory?"),
+                           m_timeshift_settings.minutes),
+          _("VDR Plugin"), wxYES_NO | wxICON_QUESTION);
+      bool started = answer == wxYES &&
+                     StartInstantReplay(m_timeshift_settings.minutes);
+      SetToolbarItemState(id, started);
+      return;
+    }
     if (m_recording) {
       wxMessageBox(_("Stop recording before starting playback."),
                    _("VDR Plugin"), wxOK | wxICON_INFORMATION);
@@ -835,6 +1278,9 @@ void vdr_pi::OnToolbarToolCallback(int id) {
       SetToolbarItemState(id, false);
       // Recording was stopped manually, so disable auto-recording
       m_recording_manually_disabled = true;
+    } else if (m_blackbox_settings.enabled) {
+      // In black box mode, the record button fires a trigger.
+      SetToolbarItemState(id, TriggerBlackBox("Manual trigger"));
     } else {
       StartRecording();
       if (m_recording) {
@@ -860,6 +1306,25 @@ wxString vdr_pi::GenerateFilename() const {
   return "vdr_" + timestamp + extension;
 }
 
+/** Read the UDP destination settings stored with the given key prefix. */
+static void ReadUDPDestinations(wxFileConfig* pConf, const wxString& prefix,
+                                VDRUdpDestinations& udp) {
+  int mode;
+  pConf->Read(prefix + "UDPMode", &mode,
+              static_cast<int>(VDRUdpMode::LOCALHOST));
+  udp.mode = static_cast<VDRUdpMode>(mode);
+  pConf->Read(prefix + "UDPAddresses", &udp.addresses, wxEmptyString);
+  pConf->Read(prefix + "MulticastTTL", &udp.multicastTtl, 1);
+}
+
+/** Write the UDP destination settings with the given key prefix. */
+static void WriteUDPDestinations(wxFileConfig* pConf, const wxString& prefix,
+                                 const VDRUdpDestinations& udp) {
+  pConf->Write(prefix + "UDPMode", static_cast<int>(udp.mode));
+  pConf->Write(prefix + "UDPAddresses", udp.addresses);
+  pConf->Write(prefix + "MulticastTTL", udp.multicastTtl);
+}
+
 bool vdr_pi::LoadConfig(void) {
   wxFileConfig* pConf = (wxFileConfig*)m_pconfig;
 
@@ -887,6 +1352,20 @@ bool vdr_pi::LoadConfig(void) {
   pConf->Read(_T("SpeedThreshold"), &m_speed_threshold, 0.5);
   pConf->Read(_T("StopDelay"), &m_stop_delay, 10);  // Default 10 minutes
 
+  VDRTimeShiftSettings timeShift;
+  pConf->Read(_T("TimeShiftEnabled"), &timeShift.enabled, false);
+  pConf->Read(_T("TimeShiftMinutes"), &timeShift.minutes, 10);
+  pConf->Read(_T("TimeShiftMaxMB"), &timeShift.maxMegabytes, 32);
+  SetTimeShiftSettings(timeShift);
+
+  VDRBlackBoxSettings blackBox;
+  pConf->Read(_T("BlackBoxEnabled"), &blackBox.enabled, false);
+  pConf->Read(_T("BlackBoxPreTriggerMinutes"), &blackBox.preTriggerMinutes,
+              30);
+  pConf->Read(_T("BlackBoxPostTriggerMinutes"), &blackBox.postTriggerMinutes,
+              5);
+  SetBlackBoxSettings(blackBox);
+
   pConf->Read(_T("EnableNMEA0183"), &m_protocols.nmea0183, true);
   pConf->Read(_T("EnableNMEA2000"), &m_protocols.nmea2000, false);
   pConf->Read(_T("EnableSignalK"), &m_protocols.signalK, false);
@@ -901,23 +1380,59 @@ bool vdr_pi::LoadConfig(void) {
   pConf->Read(_T("NMEA0183ReplayMode"), &replayMode,
               static_cast<int>(NMEA0183ReplayMode::INTERNAL_API));
   m_protocols.nmea0183ReplayMode = static_cast<NMEA0183ReplayMode>(replayMode);
+  pConf->Read(_T("FollowMode"), &m_follow_mode, false);
+  pConf->Read(_T("SkipCorruptSentences"), &m_skip_corrupt_sentences, false);
 
   // NMEA 0183 network settings
   pConf->Read(_T("NMEA0183_UseTCP"), &m_protocols.nmea0183Net.useTCP, false);
   pConf->Read(_T("NMEA0183_Port"), &m_protocols.nmea0183Net.port, 10111);
   pConf->Read(_T("NMEA0183_Enabled"), &m_protocols.nmea0183Net.enabled, false);
+  ReadUDPDestinations(pConf, _T("NMEA0183_"), m_protocols.nmea0183Net.udp);
+  pConf->Read(_T("NMEA0183_Filter"), &m_protocols.nmea0183Net.filter,
+              wxEmptyString);
 
   // NMEA 2000 network settings
   pConf->Read(_T("NMEA2000_UseTCP"), &m_protocols.n2kNet.useTCP, false);
   pConf->Read(_T("NMEA2000_Port"), &m_protocols.n2kNet.port, 10112);
   pConf->Read(_T("NMEA2000_Enabled"), &m_protocols.n2kNet.enabled, false);
+  ReadUDPDestinations(pConf, _T("NMEA2000_"), m_protocols.n2kNet.udp);
+  pConf->Read(_T("NMEA2000_Filter"), &m_protocols.n2kNet.filter,
+              wxEmptyString);
+  int n2kNetFormat;
+  pConf->Read(_T("NMEA2000_NetFormat"), &n2kNetFormat,
+              static_cast<int>(N2KNetworkFormat::PCDIN));
+  m_protocols.n2kNetFormat = static_cast<N2KNetworkFormat>(n2kNetFormat);
+
+  // Network input
+  pConf->Read(_T("NetworkInput_Enabled"), &m_protocols.input.enabled, false);
+  pConf->Read(_T("NetworkInput_UseTCP"), &m_protocols.input.useTCP, true);
+  pConf->Read(_T("NetworkInput_Host"), &m_protocols.input.host,
+              _T("127.0.0.1"));
+  pConf->Read(_T("NetworkInput_Port"), &m_protocols.input.port, 10110);
+
+  // Outbound queues of the TCP clients.
+  int queueKB;
+  int slowClientPolicy;
+  pConf->Read(_T("TCPClientQueueKB"), &queueKB, 256);
+  pConf->Read(_T("TCPSlowClientPolicy"), &slowClientPolicy,
+              static_cast<int>(VDRSlowClientPolicy::DROP_OLDEST));
+  pConf->Read(_T("TCPClientMaxLagMs"), &m_client_queue_settings.maxLagMs,
+              5000);
+  m_client_queue_settings.maxBytes = std::max(queueKB, 1) * 1024;
+  m_client_queue_settings.policy =
+      static_cast<VDRSlowClientPolicy>(slowClientPolicy);
 
-#if 0
   // Signal K network settings
   pConf->Read(_T("SignalK_UseTCP"), &m_protocols.signalKNet.useTCP, true);
   pConf->Read(_T("SignalK_Port"), &m_protocols.signalKNet.port, 8375);
   pConf->Read(_T("SignalK_Enabled"), &m_protocols.signalKNet.enabled, false);
-#endif
+  ReadUDPDestinations(pConf, _T("SignalK_"), m_protocols.signalKNet.udp);
+  // Signal K recording
+  pConf->Read(_T("SignalK_HeartbeatSec"), &m_protocols.signalKHeartbeatSec,
+              60);
+  m_signalk_encoder.SetHeartbeat(m_protocols.signalKHeartbeatSec * 1000LL);
+  m_signalk_ring_encoder.SetHeartbeat(m_protocols.signalKHeartbeatSec *
+                                      1000LL);
 
   return true;
 }
@@ -940,6 +1455,14 @@ bool vdr_pi::SaveConfig(void) {
   pConf->Write(_T("UseSpeedThreshold"), m_use_speed_threshold);
   pConf->Write(_T("SpeedThreshold"), m_speed_threshold);
   pConf->Write(_T("StopDelay"), m_stop_delay);
+  pConf->Write(_T("TimeShiftEnabled"), m_timeshift_settings.enabled);
+  pConf->Write(_T("TimeShiftMinutes"), m_timeshift_settings.minutes);
+  pConf->Write(_T("TimeShiftMaxMB"), m_timeshift_settings.maxMegabytes);
+  pConf->Write(_T("BlackBoxEnabled"), m_blackbox_settings.enabled);
+  pConf->Write(_T("BlackBoxPreTriggerMinutes"),
+               m_blackbox_settings.preTriggerMinutes);
+  pConf->Write(_T("BlackBoxPostTriggerMinutes"),
+               m_blackbox_settings.postTriggerMinutes);
   pConf->Write(_T("DataFormat"), static_cast<int>(m_data_format));
 
   pConf->Write(_T("EnableNMEA0183"), m_protocols.nmea0183);
@@ -949,23 +1472,45 @@ bool vdr_pi::SaveConfig(void) {
   // Replay preferences.
   pConf->Write(_T("NMEA0183ReplayMode"),
                static_cast<int>(m_protocols.nmea0183ReplayMode));
+  pConf->Write(_T("FollowMode"), m_follow_mode);
+  pConf->Write(_T("SkipCorruptSentences"), m_skip_corrupt_sentences);
 
   // NMEA 0183 network settings
   pConf->Write(_T("NMEA0183_UseTCP"), m_protocols.nmea0183Net.useTCP);
   pConf->Write(_T("NMEA0183_Port"), m_protocols.nmea0183Net.port);
   pConf->Write(_T("NMEA0183_Enabled"), m_protocols.nmea0183Net.enabled);
+  WriteUDPDestinations(pConf, _T("NMEA0183_"), m_protocols.nmea0183Net.udp);
+  pConf->Write(_T("NMEA0183_Filter"), m_protocols.nmea0183Net.filter);
 
   // NMEA 2000 network settings
   pConf->Write(_T("NMEA2000_UseTCP"), m_protocols.n2kNet.useTCP);
   pConf->Write(_T("NMEA2000_Port"), m_protocols.n2kNet.port);
   pConf->Write(_T("NMEA2000_Enabled"), m_protocols.n2kNet.enabled);
+  WriteUDPDestinations(pConf, _T("NMEA2000_"), m_protocols.n2kNet.udp);
+  pConf->Write(_T("NMEA2000_Filter"), m_protocols.n2kNet.filter);
+  pConf->Write(_T("NMEA2000_NetFormat"),
+               static_cast<int>(m_protocols.n2kNetFormat));
+
+  // Network input
+  pConf->Write(_T("NetworkInput_Enabled"), m_protocols.input.enabled);
+  pConf->Write(_T("NetworkInput_UseTCP"), m_protocols.input.useTCP);
+  pConf->Write(_T("NetworkInput_Host"), m_protocols.input.host);
+  pConf->Write(_T("NetworkInput_Port"), m_protocols.input.port);
+
+  // Outbound queues of the TCP clients.
+  pConf->Write(_T("TCPClientQueueKB"),
+               static_cast<int>(m_client_queue_settings.maxBytes / 1024));
+  pConf->Write(_T("TCPSlowClientPolicy"),
+               static_cast<int>(m_client_queue_settings.policy));
+  pConf->Write(_T("TCPClientMaxLagMs"), m_client_queue_settings.maxLagMs);
 
-#if 0
   // Signal K network settings
   pConf->Write(_T("SignalK_UseTCP"), m_protocols.signalKNet.useTCP);
   pConf->Write(_T("SignalK_Port"), m_protocols.signalKNet.port);
   pConf->Write(_T("SignalK_Enabled"), m_protocols.signalKNet.enabled);
-#endif
+  WriteUDPDestinations(pConf, _T("SignalK_"), m_protocols.signalKNet.udp);
+  // Signal K recording
+  pConf->Write(_T("SignalK_HeartbeatSec"), m_protocols.signalKHeartbeatSec);
 
   return true;
 }
@@ -1020,6 +1565,8 @@ void vdr_pi::StartRecording() {
   if (m_data_format == VDRDataFormat::CSV) {
     m_ostream.Write("timestamp,type,id,message\n");
   }
+  // Signal K ids are only valid in the file that defines them.
+  m_signalk_encoder.Reset();
 
   m_recording = true;
   m_recording_paused = false;
@@ -1045,6 +1592,8 @@ void vdr_pi::StopRecording(const wxString& reason) {
   wxLogMessage("Stop recording. Reason: %s", reason);
   m_ostream.Close();
   m_recording = false;
+  // Buffered messages received so far are in the file.
+  m_blackbox_written_sequence = m_ring.GetLastSequence();
 
 #ifdef __ANDROID__
   bool AndroidSecureCopyFile(wxString in, wxString out);
@@ -1054,20 +1603,20 @@ void vdr_pi::StopRecording(const wxString& reason) {
 }
 
 void vdr_pi::AdjustPlaybackBaseTime() {
-  if (!m_firstTimestamp.IsValid() || !m_currentTimestamp.IsValid()) {
+  if (m_firstTimestamp == INVALID_TIME_MS ||
+      m_currentTimestamp == INVALID_TIME_MS) {
     return;
   }
 
   // Calculate how much time has "elapsed" in the recording up to our current
   // position.
-  wxTimeSpan elapsed = m_currentTimestamp - m_firstTimestamp;
+  VDRTimeMs elapsedMs = m_currentTimestamp - m_firstTimestamp;
 
   // Set base time so that current playback position corresponds to current wall
   // clock.
   m_playback_base_time =
-      wxDateTime::UNow() -
-      wxTimeSpan::Milliseconds(static_cast<long>(
-          (elapsed.GetMilliseconds().ToDouble() / GetSpeedMultiplier())));
+      wxGetUTCTimeMillis().GetValue() -
+      static_cast<VDRTimeMs>(elapsedMs / GetSpeedMultiplier());
 }
 
 void vdr_pi::StartPlayback() {
@@ -1084,6 +1633,9 @@ void vdr_pi::StartPlayback() {
     return;
   }
 
+  // File playback replaces instant replay.
+  StopInstantReplay();
+
   // Reset end-of-file state when starting playback
   m_atFileEnd = false;
 
@@ -1097,6 +1649,15 @@ void vdr_pi::StartPlayback() {
       }
       return;
     }
+    if (m_follow_mode) {
+      // The file may have grown while it was closed, restart following from
+      // its current end and refresh the timeline.
+      StartFollowing();
+      bool hasValidTimestamps;
+      wxString error;
+      ScanFileTimestamps(hasValidTimestamps, error);
+      AdjustPlaybackBaseTime();
+    }
   }
   m_messages_dropped = false;
   m_playing = true;
@@ -1152,6 +1713,7 @@ VDRNetworkServer* vdr_pi::GetServer(const wxString& protocol) {
   if (it == m_networkServers.end()) {
     // Create new server instance if it doesn't exist.
     auto server = std::make_unique<VDRNetworkServer>();
+    server->SetClientQueueSettings(m_client_queue_settings);
     VDRNetworkServer* serverPtr = server.get();
     m_networkServers[protocol] = std::move(server);
     return serverPtr;
@@ -1166,10 +1728,18 @@ bool vdr_pi::InitializeNetworkServers() {
   // Initialize NMEA0183 network server if needed
   if (m_protocols.nmea0183Net.enabled) {
     VDRNetworkServer* server = GetServer("NMEA0183");
+    // The filter is applied without restarting the server.
+    wxString filterError;
+    if (!server->SetFilter(m_protocols.nmea0183Net.filter, filterError)) {
+      success = false;
+      errors += filterError;
+    }
     if (!server->IsRunning() ||
         server->IsTCP() != m_protocols.nmea0183Net.useTCP ||
-        server->GetPort() != m_protocols.nmea0183Net.port) {
+        server->GetPort() != m_protocols.nmea0183Net.port ||
+        server->GetUDPDestinations() != m_protocols.nmea0183Net.udp) {
       server->Stop();  // Stop existing server if running
+      server->SetUDPDestinations(m_protocols.nmea0183Net.udp);
       wxString error;
       if (!server->Start(m_protocols.nmea0183Net.useTCP,
                          m_protocols.nmea0183Net.port, error)) {
@@ -1192,9 +1762,17 @@ bool vdr_pi::InitializeNetworkServers() {
   // Initialize NMEA2000 network server if needed
   if (m_protocols.n2kNet.enabled) {
     VDRNetworkServer* server = GetServer("N2K");
+    // The filter is applied without restarting the server.
+    wxString filterError;
+    if (!server->SetFilter(m_protocols.n2kNet.filter, filterError)) {
+      success = false;
+      errors += filterError;
+    }
     if (!server->IsRunning() || server->IsTCP() != m_protocols.n2kNet.useTCP ||
-        server->GetPort() != m_protocols.n2kNet.port) {
+        server->GetPort() != m_protocols.n2kNet.port ||
+        server->GetUDPDestinations() != m_protocols.n2kNet.udp) {
       server->Stop();  // Stop existing server if running
+      server->SetUDPDestinations(m_protocols.n2kNet.udp);
       wxString error;
       if (!server->Start(m_protocols.n2kNet.useTCP, m_protocols.n2kNet.port,
                          error)) {
@@ -1214,6 +1792,35 @@ bool vdr_pi::InitializeNetworkServers() {
     }
   }
 
+  // Initialize Signal K network server if needed. The deltas are not
+  // filtered, the patterns only apply to NMEA messages.
+  if (m_protocols.signalKNet.enabled) {
+    VDRNetworkServer* server = GetServer("SignalK");
+    if (!server->IsRunning() ||
+        server->IsTCP() != m_protocols.signalKNet.useTCP ||
+        server->GetPort() != m_protocols.signalKNet.port ||
+        server->GetUDPDestinations() != m_protocols.signalKNet.udp) {
+      server->Stop();  // Stop existing server if running
+      server->SetUDPDestinations(m_protocols.signalKNet.udp);
+      wxString error;
+      if (!server->Start(m_protocols.signalKNet.useTCP,
+                         m_protocols.signalKNet.port, error)) {
+        success = false;
+        errors += error;
+      } else {
+        wxLogMessage("Started Signal K server: %s on port %d",
+                     m_protocols.signalKNet.useTCP ? "TCP" : "UDP",
+                     m_protocols.signalKNet.port);
+      }
+    }
+  } else {
+    VDRNetworkServer* server = GetServer("SignalK");
+    if (server->IsRunning()) {
+      server->Stop();
+      wxLogMessage("Stopped Signal K network server (disabled in preferences)");
+    }
+  }
+
   if (m_pvdrcontrol) {
     if (!success) {
       m_pvdrcontrol->UpdateNetworkStatus(errors);
@@ -1225,6 +1832,72 @@ bool vdr_pi::InitializeNetworkServers() {
   return success;
 }
 
+void vdr_pi::SetClientQueueSettings(const VDRClientQueueSettings& settings) {
+  m_client_queue_settings = settings;
+  for (auto& server : m_networkServers) {
+    server.second->SetClientQueueSettings(settings);
+  }
+}
+
+void vdr_pi::UpdateNetworkInput() {
+  m_input_timer->Stop();
+  m_network_input.Stop();
+  // Lines of the previous source are not recorded.
+  std::string line;
+  while (m_input_queue.Pop(line)) {
+  }
+  if (!m_protocols.input.enabled) {
+    return;
+  }
+
+  const VDRNetworkInputSettings& input = m_protocols.input;
+  wxString error;
+  bool started = m_network_input.Start(
+      input.useTCP, input.host, input.port,
+      [this](const char* data, size_t length) {
+        // Called on the I/O thread, recorded by OnNetworkInputTimer().
+        if (!m_input_queue.Push(std::string(data, length))) {
+          m_input_dropped++;
+        }
+      },
+      error);
+  if (!started) {
+    wxLogWarning("Network input not started: %s", error);
+    return;
+  }
+  m_input_timer->Start(NETWORK_INPUT_INTERVAL_MS);
+}
+
+void vdr_pi::OnNetworkInputTimer() {
+  std::string line;
+  while (m_input_queue.Pop(line)) {
+    ProcessNetworkInput(line);
+  }
+  uint64_t dropped = m_input_dropped.exchange(0);
+  if (dropped > 0) {
+    wxLogMessage("Network input: %llu lines dropped",
+                 static_cast<unsigned long long>(dropped));
+  }
+}
+
+void vdr_pi::ProcessNetworkInput(const std::string& line) {
+  if (line.empty()) {
+    return;
+  }
+  N2KMessage n2k;
+  if (isdigit(static_cast<unsigned char>(line[0]))) {
+    // YD RAW frame "hh:mm:ss.sss R <CAN id> <data>".
+    if (m_ydraw_decoder.Decode(line, &n2k)) {
+      ProcessN2KPayload(MakeN2KPayload(n2k));
+    }
+  } else if (ParsePCDIN(line, &n2k)) {
+    ProcessN2KPayload(MakeN2KPayload(n2k));
+  } else if (line[0] == '$' || line[0] == '!') {
+    wxString sentence(line);
+    SetNMEASentence(sentence);
+  }
+}
+
 void vdr_pi::StopNetworkServers() {
   // Stop NMEA0183 server if running
   if (VDRNetworkServer* server = GetServer("NMEA0183")) {
@@ -1241,30 +1914,109 @@ void vdr_pi::StopNetworkServers() {
       wxLogMessage("Stopped NMEA2000 network server");
     }
   }
+
+  // Stop Signal K server if running
+  if (VDRNetworkServer* server = GetServer("SignalK")) {
+    if (server->IsRunning()) {
+      server->Stop();
+      wxLogMessage("Stopped Signal K network server");
+    }
+  }
 }
 
-void vdr_pi::HandleNetworkPlayback(const wxString& data) {
+/** Whether a message starts with the given prefix. */
+static bool StartsWith(const std::string& message, const char* prefix) {
+  return message.compare(0, strlen(prefix), prefix) == 0;
+}
+
+void vdr_pi::HandleNetworkPlayback(const VDRMessagePtr& message) {
+  const std::string& data = *message;
+  // NMEA 2000 data in various text formats, $PCDIN messages must not be
+  // taken for NMEA 0183 sentences.
+  bool isN2K = StartsWith(data, "$PCDIN") ||  // SeaSmart
+               StartsWith(data, "$MXPGN") ||  // MiniPlex
+               StartsWith(data, "$YDRAW");    // YD RAW
   // For NMEA 0183 data
-  if (m_protocols.nmea0183Net.enabled &&
-      (data.StartsWith("$") || data.StartsWith("!"))) {
+  if (m_protocols.nmea0183Net.enabled && !isN2K &&
+      (StartsWith(data, "$") || StartsWith(data, "!"))) {
     VDRNetworkServer* server = GetServer("NMEA0183");
     if (server && server->IsRunning()) {
-      server->SendText(data);  // Use SendText() for NMEA messages
+      server->QueueMessage(message);  // Sent by FlushSentenceBuffer()
     }
   }
   // For NMEA 2000 data in various text formats
   else if (m_protocols.n2kNet.enabled &&
-           (data.StartsWith("$PCDIN") ||   // SeaSmart
-            data.StartsWith("!AIVDM") ||   // Actisense ASCII
-            data.StartsWith("$MXPGN") ||   // MiniPlex
-            data.StartsWith("$YDRAW"))) {  // YD RAW
+           (isN2K || StartsWith(data, "!AIVDM"))) {  // Actisense ASCII
     VDRNetworkServer* server = GetServer("N2K");
-    if (server && server->IsRunning()) {
-      server->SendText(data);  // Use SendText() for text-based formats
+    if (!server || !server->IsRunning()) {
+      return;
+    }
+    N2KMessage n2k;
+    if (m_protocols.n2kNetFormat == N2KNetworkFormat::PCDIN ||
+        !ParsePCDIN(data, &n2k)) {
+      server->QueueMessage(message);  // Sent by FlushSentenceBuffer()
+      return;
     }
+    // Recorded messages are encoded as binary frames.
+    std::string frames =
+        m_protocols.n2kNetFormat == N2KNetworkFormat::ACTISENSE
+            ? EncodeActisenseN2K(n2k)
+            : m_ydraw_encoder.Encode(n2k, wxGetUTCTimeMillis().GetValue());
+    server->QueueBinary(frames.data(), frames.size());
+  }
+}
+
+void vdr_pi::HandleSignalKPlayback(const std::string& record) {
+  // The dictionary entries are needed even when the server is disabled,
+  // it may be enabled later in the file.
+  SignalKValue value;
+  if (!m_signalk_decoder.Decode(record, &value) ||
+      !m_protocols.signalKNet.enabled) {
+    return;
+  }
+  AddSignalKPlaybackValue(
+      value, m_currentTimestamp != INVALID_TIME_MS ? m_currentTimestamp : -1);
+}
+
+void vdr_pi::AddSignalKPlaybackValue(const SignalKValue& value,
+                                     int64_t timeMs) {
+  if (!m_signalk_writer.Add(value, timeMs)) {
+    QueueSignalKDelta();
+    m_signalk_writer.Add(value, timeMs);
+  }
+}
+
+void vdr_pi::QueueSignalKDelta() {
+  if (m_signalk_writer.IsEmpty()) return;
+  // A single copy of the delta is shared by the clients.
+  VDRMessagePtr delta =
+      std::make_shared<const std::string>(m_signalk_writer.Finish());
+  VDRNetworkServer* server = GetServer("SignalK");
+  if (server->IsRunning()) {
+    server->QueueMessage(delta);  // Sent by FlushSentenceBuffer()
   }
 }
 
+bool vdr_pi::ParsePCDINMessage(const wxString& message, int& pgn,
+                               wxString& source, wxString& payload) {
+  N2KMessage n2k;
+  if (!ParsePCDIN(message.ToStdString(), &n2k)) {
+    return false;
+  }
+  pgn = static_cast<int>(n2k.pgn);
+  source = wxString::Format("%u", n2k.source);
+  payload = FormatN2KPayload(n2k.data);
+  return true;
+}
+
+int vdr_pi::ExtractPGN(const wxString& message) {
+  std::string data = message.ToStdString();
+  uint32_t pgn;
+  return GetN2KMessagePGN(data.data(), data.size(), &pgn)
+             ? static_cast<int>(pgn)
+             : 0;
+}
+
 void vdr_pi::SetDataFormat(VDRDataFormat format) {
   // If format hasn't changed, do nothing.
   if (format == m_data_format) {
@@ -1292,7 +2044,9 @@ void vdr_pi::ShowPreferencesDialog(wxWindow* parent) {
   VDRPrefsDialog dlg(parent, wxID_ANY, m_data_format, m_recording_dir,
                      m_log_rotate, m_log_rotate_interval,
                      m_auto_start_recording, m_use_speed_threshold,
-                     m_speed_threshold, m_stop_delay, m_protocols);
+                     m_speed_threshold, m_stop_delay, m_timeshift_settings,
+                     m_blackbox_settings, m_follow_mode,
+                     m_skip_corrupt_sentences, m_protocols);
 #ifdef __WXQT__  // Android
   if (parent) {
     int xmax = parent->GetSize().GetWidth();
@@ -1306,8 +2060,6 @@ void vdr_pi::ShowPreferencesDialog(wxWindow* parent) {
 #endif
 
   if (dlg.ShowModal() == wxID_OK) {
-    bool previousNMEA2000State = m_protocols.nmea2000;
-    bool previousSignalKState = m_protocols.signalK;
     SetDataFormat(dlg.GetDataFormat());
     SetRecordingDir(dlg.GetRecordingDir());
     SetLogRotate(dlg.GetLogRotate());
@@ -1316,17 +2068,13 @@ void vdr_pi::ShowPreferencesDialog(wxWindow* parent) {
     SetUseSpeedThreshold(dlg.GetUseSpeedThreshold());
     SetSpeedThreshold(dlg.GetSpeedThreshold());
     SetStopDelay(dlg.GetStopDelay());
-    m_protocols = dlg.GetProtocolSettings();
+    SetTimeShiftSettings(dlg.GetTimeShiftSettings());
+    SetBlackBoxSettings(dlg.GetBlackBoxSettings());
+    SetFollowMode(dlg.GetFollowMode());
+    SetSkipCorruptSentences(dlg.GetSkipCorruptSentences());
+    SetProtocolSettings(dlg.GetProtocolSettings());
     SaveConfig();
 
-    // Update NMEA 2000 listeners if the setting changed
-    if (previousNMEA2000State != m_protocols.nmea2000) {
-      UpdateNMEA2000Listeners();
-    }
-    if (previousSignalKState != m_protocols.signalK) {
-      UpdateSignalKListeners();
-    }
-
     // Update UI if needed
     if (m_pvdrcontrol) {
       m_pvdrcontrol->UpdateControls();
@@ -1338,11 +2086,11 @@ void vdr_pi::ShowPreferencesDialogNative(wxWindow* parent) {
   VDRPrefsDialog dlg(parent, wxID_ANY, m_data_format, m_recording_dir,
                      m_log_rotate, m_log_rotate_interval,
                      m_auto_start_recording, m_use_speed_threshold,
-                     m_speed_threshold, m_stop_delay, m_protocols);
+                     m_speed_threshold, m_stop_delay, m_timeshift_settings,
+                     m_blackbox_settings, m_follow_mode,
+                     m_skip_corrupt_sentences, m_protocols);
 
   if (dlg.ShowModal() == wxID_OK) {
-    bool previousNMEA2000State = m_protocols.nmea2000;
-    bool previousSignalKState = m_protocols.signalK;
     SetDataFormat(dlg.GetDataFormat());
     SetRecordingDir(dlg.GetRecordingDir());
     SetLogRotate(dlg.GetLogRotate());
@@ -1351,17 +2099,13 @@ void vdr_pi::ShowPreferencesDialogNative(wxWindow* parent) {
     SetUseSpeedThreshold(dlg.GetUseSpeedThreshold());
     SetSpeedThreshold(dlg.GetSpeedThreshold());
     SetStopDelay(dlg.GetStopDelay());
-    m_protocols = dlg.GetProtocolSettings();
+    SetTimeShiftSettings(dlg.GetTimeShiftSettings());
+    SetBlackBoxSettings(dlg.GetBlackBoxSettings());
+    SetFollowMode(dlg.GetFollowMode());
+    SetSkipCorruptSentences(dlg.GetSkipCorruptSentences());
+    SetProtocolSettings(dlg.GetProtocolSettings());
     SaveConfig();
 
-    // Update NMEA 2000 listeners if the setting changed
-    if (previousNMEA2000State != m_protocols.nmea2000) {
-      UpdateNMEA2000Listeners();
-    }
-    if (previousSignalKState != m_protocols.signalK) {
-      UpdateSignalKListeners();
-    }
-
     // Update UI if needed
     if (m_pvdrcontrol) {
       m_pvdrcontrol->UpdateControls();
@@ -1386,86 +2130,46 @@ void vdr_pi::CheckLogRotation() {
 }
 
 bool vdr_pi::ParseNMEAComponents(wxString nmea, wxString& talkerId,
-                                 wxString& sentenceId,
-                                 bool& hasTimestamp) const {
-  // Basic length check - minimum NMEA sentence should be at least 10 chars
-  // $GPGGA,*hh
-  if (nmea.IsEmpty() || (nmea[0] != '$' && nmea[0] != '!')) {
-    return false;
-  }
-
-  // Split the sentence into fields
-  wxStringTokenizer tok(nmea, wxT(",*"));
-  if (!tok.HasMoreTokens()) return false;
-
-  wxString header = tok.GetNextToken();
-  // Need exactly $GPXXX or !AIVDM format
-  if (header.length() != 6) return false;
-
-  // Extract talker ID (GP, GN, etc.) and sentence ID (RMC, ZDA, etc.)
-  talkerId = header.Mid(1, 2);
-  sentenceId = header.Mid(3);
-
-  // Special handling for AIS messages starting with !
-  bool isAIS = (nmea[0] == '!');
-
-  // Validate talker ID:
-  // - Must be exactly 2 chars
-  // - Must be ASCII
-  // - Must be alphabetic
-  // - Must be uppercase
-  if (talkerId.length() != 2 || !talkerId.IsAscii() || !talkerId.IsWord()) {
-    return false;
-  }
-
-  if (isAIS) {
-    // For AIS messages, only accept specific talker IDs.
-    if (talkerId != "AI" && talkerId != "AB" && talkerId != "BS") {
-      return false;
-    }
-  } else {
-    // Standard NMEA.
-    if (!talkerId.IsWord() || talkerId != talkerId.Upper()) {
-      return false;
-    }
-  }
-
-  // Validate sentence ID:
-  // - Must be exactly 3 chars
-  // - Must be ASCII
-  // - Must be alphabetic
-  // - Must be uppercase
-  if (sentenceId.length() != 3 || !sentenceId.IsAscii() ||
-      !sentenceId.IsWord()) {
-    return false;
-  }
-
-  // Check if sentenceId is uppercase by comparing with its uppercase version
-  if (sentenceId != sentenceId.Upper()) {
-    return false;
-  }
-
-  // Additional validation: must contain comma after header and checksum after
-  // data
-  size_t lastComma = nmea.Find(',');
-  size_t checksumPos = nmea.Find('*');
-
-  if (lastComma == wxString::npos || checksumPos == wxString::npos ||
-      checksumPos < lastComma) {
+                                 wxString& sentenceId, bool& hasTimestamp,
+                                 NMEASentenceStatus* status) const {
+  // Header, talker and sentence ID are checked by the validator along with
+  // the checksum, in one pass over the sentence.
+  const wxStringCharType* text = nmea.wx_str();
+  size_t length = std::char_traits<wxStringCharType>::length(text);
+  NMEASentenceHeader header;
+  NMEASentenceStatus result = ValidateNMEASentence(text, length, &header);
+  if (status) *status = result;
+  if (result == NMEASentenceStatus::MALFORMED) {
     return false;
   }
+  talkerId = wxString(header.talkerId, 2);
+  sentenceId = wxString(header.sentenceId, 3);
 
   // Check for known sentence types containing timestamps.
-  if (sentenceId == "RMC" || sentenceId == "ZDA" || sentenceId == "GGA" ||
-      sentenceId == "GBS" || sentenceId == "GLL") {
-    hasTimestamp = true;
+  if (header.isAIS) {
+    // Base station reports (message 4) are single fragment messages, the
+    // type is the first payload character.
+    size_t fieldStart[6] = {};
+    int field = 0;
+    for (size_t i = 6; i < length && field < 5; i++) {
+      if (text[i] == ',') fieldStart[++field] = i + 1;
+    }
+    hasTimestamp = field == 5 && text[fieldStart[1]] == '1' &&
+                   text[fieldStart[1] + 1] == ',' && text[fieldStart[5]] == '4';
     return true;
   }
-  // Unknown sentence type but valid NMEA format.
-  hasTimestamp = false;
+  hasTimestamp =
+      FindSentenceTimeFields(PackSentenceId(header.sentenceId, 3)) != nullptr;
   return true;
 }
 
+bool vdr_pi::IsCorruptSentence(const wxString& message) {
+  const wxStringCharType* text = message.wx_str();
+  return ValidateNMEASentence(
+             text, std::char_traits<wxStringCharType>::length(text),
+             nullptr) == NMEASentenceStatus::BAD_CHECKSUM;
+}
+
 void vdr_pi::SelectPrimaryTimeSource() {
   m_hasPrimaryTimeSource = false;
   if (m_timeSources.empty()) return;
@@ -1485,13 +2189,13 @@ void vdr_pi::SelectPrimaryTimeSource() {
     }
     SourceScore score = {source.first, 0};
     // Prefer sources with complete date+time
-    if (source.first.sentenceId.Contains("RMC") ||
-        source.first.sentenceId.Contains("ZDA")) {
+    wxString sentenceId = source.first.GetSentenceId();
+    if (sentenceId.Contains("RMC") || sentenceId.Contains("ZDA")) {
       score.score += 10;
     }
 
     // Prefer higher precision
-    score.score += source.first.precision * 2;
+    score.score += source.first.GetPrecision() * 2;
     scores.push_back(score);
   }
 
@@ -1508,6 +2212,16 @@ void vdr_pi::SelectPrimaryTimeSource() {
   }
 }
 
+/** Key identifying a time source in the keyframe index. */
+static std::string GetKeyframeSourceKey(const TimeSource& source) {
+  return (source.GetTalkerId() + source.GetSentenceId() +
+          wxString::Format("/%d", source.GetPrecision()))
+      .ToStdString();
+}
+
+/** Key identifying the timestamp column of CSV files in the keyframe index. */
+static const char* const CSV_KEYFRAME_SOURCE = "CSV";
+
 bool vdr_pi::ScanFileTimestamps(bool& hasValidTimestamps, wxString& error) {
   if (!m_istream.IsOpened()) {
     error = _("File not open");
@@ -1518,11 +2232,14 @@ bool vdr_pi::ScanFileTimestamps(bool& hasValidTimestamps, wxString& error) {
   wxLogMessage("Scanning timestamps in %s", m_ifilename);
   // Reset all state
   m_has_timestamps = false;
-  m_firstTimestamp = wxDateTime();
-  m_lastTimestamp = wxDateTime();
-  m_currentTimestamp = wxDateTime();
+  m_firstTimestamp = INVALID_TIME_MS;
+  m_lastTimestamp = INVALID_TIME_MS;
+  m_currentTimestamp = INVALID_TIME_MS;
   m_timeSources.clear();
   m_hasPrimaryTimeSource = false;
+  m_keyframes.Clear();
+  m_signalk_decoder.Reset();
+  m_corrupt_sentences = 0;
   bool foundFirst = false;
   wxDateTime previousTimestamp;
 
@@ -1548,14 +2265,19 @@ bool vdr_pi::ScanFileTimestamps(bool& hasValidTimestamps, wxString& error) {
         wxDateTime timestamp;
         wxString nmea;
         bool success = ParseCSVLineTimestamp(line, &nmea, &timestamp);
+        if (success && IsCorruptSentence(nmea)) {
+          m_corrupt_sentences++;
+          if (m_skip_corrupt_sentences) nmea.Clear();
+        }
         if (success && timestamp.IsValid()) {
           // For CSV files, we require chronological order
           if (previousTimestamp.IsValid() && timestamp < previousTimestamp) {
             m_has_timestamps = false;
-            m_firstTimestamp = wxDateTime();
-            m_lastTimestamp = wxDateTime();
-            m_currentTimestamp = wxDateTime();
+            m_firstTimestamp = INVALID_TIME_MS;
+            m_lastTimestamp = INVALID_TIME_MS;
+            m_currentTimestamp = INVALID_TIME_MS;
             m_istream.GoToLine(0);
+            m_keyframes.Clear();
             hasValidTimestamps = false;
             error = _("Timestamps not in chronological order");
             wxLogMessage(
@@ -1566,73 +2288,133 @@ bool vdr_pi::ScanFileTimestamps(bool& hasValidTimestamps, wxString& error) {
             return false;
           }
           previousTimestamp = timestamp;
-          m_lastTimestamp = timestamp;
+          m_lastTimestamp = ToTimeMs(timestamp);
 
           if (!foundFirst) {
-            m_firstTimestamp = timestamp;
-            m_currentTimestamp = timestamp;
+            m_firstTimestamp = m_lastTimestamp;
+            m_currentTimestamp = m_lastTimestamp;
             foundFirst = true;
           }
           m_has_timestamps = true;  // Found at least one valid timestamp.
+          m_keyframes.AddTimestamp(CSV_KEYFRAME_SOURCE,
+                                   timestamp.GetValue().GetValue());
         }
+        m_keyframes.AddLine(m_istream.GetCurrentLine(),
+                            success ? nmea.ToStdString() : std::string());
       }
       line = GetNextNonEmptyLine();
     }
+    if (m_corrupt_sentences > 0) {
+      wxLogMessage("Found %d corrupt sentences in %s", m_corrupt_sentences,
+                   m_ifilename);
+    }
   } else {
     // Raw NMEA/AIS - scan for time sources and assess quality
-    int precision = 0;
     int validSentences = 0;
     int invalidSentences = 0;
     wxString lastInvalidLine;  // Store for error reporting
-    while (!m_istream.Eof()) {
-      if (!line.IsEmpty()) {
-        wxString talkerId, sentenceId;
+
+    // The lines are validated in chunks, then the timestamps of the valid
+    // sentences of a chunk are parsed in one batch.
+    struct ScanLine {
+      wxString text;
+      int index;      //!< Line number in the input stream
+      bool keep;      //!< Whether the line is stored in the keyframes
+      int batchLine;  //!< Line in the timestamp batch, -1 if none
+      wxString talkerId;
+      wxString sentenceId;
+    };
+    std::vector<ScanLine> pending;
+    pending.reserve(SCAN_BATCH_LINES);
+    wxString buffer;
+    TimestampBatch batch;
+    auto scanPending = [&]() {
+      buffer.Clear();
+      int batchLines = 0;
+      for (ScanLine& scan : pending) {
+        scan.keep = true;
+        scan.batchLine = -1;
+        if (scan.text.StartsWith(SIGNALK_RECORD_PREFIX)) {
+          // Signal K records are not NMEA 0183 sentences, and have no
+          // timestamp.
+          validSentences++;
+          continue;
+        }
         bool hasTimestamp;
-        if (!ParseNMEAComponents(line, talkerId, sentenceId, hasTimestamp)) {
+        NMEASentenceStatus status;
+        if (!ParseNMEAComponents(scan.text, scan.talkerId, scan.sentenceId,
+                                 hasTimestamp, &status)) {
           invalidSentences++;
-          lastInvalidLine = line;
-          line = GetNextNonEmptyLine();
+          lastInvalidLine = scan.text;
+          scan.keep = false;
           continue;
         }
+        if (status == NMEASentenceStatus::BAD_CHECKSUM) {
+          m_corrupt_sentences++;
+          if (m_skip_corrupt_sentences) {
+            scan.keep = false;
+            continue;
+          }
+        }
         // Valid sentence found
         validSentences++;
-
         if (hasTimestamp) {
+          scan.batchLine = batchLines++;
+          buffer += scan.text;
+          buffer += '\n';
+        }
+      }
+      const wxStringCharType* text = buffer.wx_str();
+      m_timestampParser.ParseTimestamps(
+          text, std::char_traits<wxStringCharType>::length(text), batch);
+
+      for (const ScanLine& scan : pending) {
+        if (scan.batchLine >= 0 && batch.valid[scan.batchLine]) {
           // Create time source entry
-          TimeSource source;
-          source.talkerId = talkerId;
-          source.sentenceId = sentenceId;
-
-          wxDateTime timestamp;
-          if (m_timestampParser.ParseTimestamp(line, timestamp, precision)) {
-            source.precision = precision;
-            if (m_timeSources.find(source) == m_timeSources.end()) {
-              TimeSourceDetails details;
-              details.startTime = timestamp;
-              details.currentTime = timestamp;
-              details.endTime = timestamp;
-              details.isChronological = true;
-              m_timeSources[source] = details;
-            } else {
-              // Update existing source
-              TimeSourceDetails& details = m_timeSources[source];
-              // Check if timestamps are still chronological
-              if (timestamp < details.currentTime) {
-                details.isChronological = false;
-              }
-              details.currentTime = timestamp;
-              details.endTime = timestamp;
+          TimeSource source(scan.talkerId, scan.sentenceId,
+                            batch.precision[scan.batchLine]);
+          VDRTimeMs timeMs = batch.epochMs[scan.batchLine];
+          if (m_timeSources.find(source) == m_timeSources.end()) {
+            TimeSourceDetails details;
+            details.startTime = timeMs;
+            details.currentTime = timeMs;
+            details.endTime = timeMs;
+            details.isChronological = true;
+            m_timeSources[source] = details;
+          } else {
+            // Update existing source
+            TimeSourceDetails& details = m_timeSources[source];
+            // Check if timestamps are still chronological
+            if (timeMs < details.currentTime) {
+              details.isChronological = false;
             }
-            m_has_timestamps = true;
+            details.currentTime = timeMs;
+            details.endTime = timeMs;
           }
+          m_has_timestamps = true;
+          m_keyframes.AddTimestamp(GetKeyframeSourceKey(source), timeMs);
         }
+        m_keyframes.AddLine(scan.index, scan.keep ? scan.text.ToStdString()
+                                                  : std::string());
+      }
+      pending.clear();
+    };
+
+    while (!m_istream.Eof()) {
+      if (!line.IsEmpty()) {
+        pending.push_back(ScanLine());
+        pending.back().text = line;
+        pending.back().index = static_cast<int>(m_istream.GetCurrentLine());
+        if (pending.size() == SCAN_BATCH_LINES) scanPending();
       }
       line = GetNextNonEmptyLine();
     }
+    scanPending();
 
     // Log statistics about file quality
-    wxLogMessage("Found %d valid and %d invalid sentences in %s",
-                 validSentences, invalidSentences, m_ifilename);
+    wxLogMessage(
+        "Found %d valid, %d invalid and %d corrupt sentences in %s",
+        validSentences, invalidSentences, m_corrupt_sentences, m_ifilename);
 
     // Only fail if we found no valid sentences at all
     if (validSentences == 0) {
@@ -1648,25 +2430,25 @@ bool vdr_pi::ScanFileTimestamps(bool& hasValidTimestamps, wxString& error) {
       for (const auto& source : m_timeSources) {
         wxLogMessage(
             "  %s%s: precision=%d. isChronological=%d. Start=%s. End=%s",
-            source.first.talkerId, source.first.sentenceId,
-            source.first.precision, source.second.isChronological,
-            FormatIsoDateTime(source.second.startTime),
-            FormatIsoDateTime(source.second.endTime));
+            source.first.GetTalkerId(), source.first.GetSentenceId(),
+            source.first.GetPrecision(), source.second.isChronological,
+            FormatIsoDateTime(FromTimeMs(source.second.startTime)),
+            FormatIsoDateTime(FromTimeMs(source.second.endTime)));
       }
       if (m_hasPrimaryTimeSource) {
         m_firstTimestamp = m_timeSources[m_primaryTimeSource].startTime;
         m_currentTimestamp = m_firstTimestamp;
         m_lastTimestamp = m_timeSources[m_primaryTimeSource].endTime;
-        m_timestampParser.SetPrimaryTimeSource(m_primaryTimeSource.talkerId,
-                                               m_primaryTimeSource.sentenceId,
-                                               m_primaryTimeSource.precision);
+        m_timestampParser.SetPrimaryTimeSource(m_primaryTimeSource);
 
         wxLogMessage(
             "Using %s%s (precision=%d) as primary time source. Start=%s. "
             "End=%s",
-            m_primaryTimeSource.talkerId, m_primaryTimeSource.sentenceId,
-            m_primaryTimeSource.precision, FormatIsoDateTime(m_firstTimestamp),
-            FormatIsoDateTime(m_lastTimestamp));
+            m_primaryTimeSource.GetTalkerId(),
+            m_primaryTimeSource.GetSentenceId(),
+            m_primaryTimeSource.GetPrecision(),
+            FormatIsoDateTime(FromTimeMs(m_firstTimestamp)),
+            FormatIsoDateTime(FromTimeMs(m_lastTimestamp)));
       }
     } else {
       wxLogMessage("No timestamps found in NMEA file %s", m_ifilename);
@@ -1708,6 +2490,112 @@ wxString vdr_pi::GetNextNonEmptyLine(bool fromStart) {
   return line;
 }
 
+void vdr_pi::StartFollowing() {
+  if (!m_follower.Start(m_ifilename.ToStdString())) {
+    wxLogWarning("Cannot follow file %s", m_ifilename);
+    return;
+  }
+  if (m_follower.HasPartialLine() && m_istream.GetLineCount() > 0) {
+    // The recorder is still writing the last line.
+    m_istream.RemoveLine(m_istream.GetLineCount() - 1);
+  }
+  wxLogMessage("Following file %s using %s", m_ifilename,
+               m_follower.UsesNotifications() ? "notifications" : "polling");
+}
+
+size_t vdr_pi::ReadAppendedLines() {
+  std::vector<std::string> lines;
+  if (m_follower.ReadLines(lines) == 0) return 0;
+
+  size_t firstNewLine = m_istream.GetLineCount();
+  for (const auto& appended : lines) {
+    wxString line(appended);
+    m_istream.AddLine(line);
+    ExtendTimeline(line, static_cast<int>(m_istream.GetLineCount() - 1));
+  }
+  // GetNextLine() pre-increments the line index, position the stream on the
+  // last line that was already read.
+  m_istream.GoToLine(firstNewLine - 1);
+  return lines.size();
+}
+
+void vdr_pi::ExtendTimeline(const wxString& appended, int index) {
+  wxString line = appended;
+  line.Trim(true).Trim(false);
+  if (line.IsEmpty() || line.StartsWith("#")) {
+    m_keyframes.AddLine(index, std::string());
+    return;
+  }
+  if (index == 0 && ParseCSVHeader(line)) {
+    // The file was empty when it was loaded.
+    m_is_csv_file = true;
+    m_keyframes.AddLine(index, std::string());
+    return;
+  }
+
+  wxDateTime timestamp;
+  wxString nmea;
+  bool hasTimestamp;
+  std::string sourceKey;
+  if (m_is_csv_file) {
+    hasTimestamp = ParseCSVLineTimestamp(line, &nmea, &timestamp);
+    sourceKey = CSV_KEYFRAME_SOURCE;
+    if (hasTimestamp && IsCorruptSentence(nmea)) {
+      m_corrupt_sentences++;
+      if (m_skip_corrupt_sentences) nmea.Clear();
+    }
+  } else if (line.StartsWith(SIGNALK_RECORD_PREFIX)) {
+    // Signal K records have no timestamp.
+    m_keyframes.AddLine(index, line.ToStdString());
+    return;
+  } else {
+    int precision;
+    if (IsCorruptSentence(line)) {
+      m_corrupt_sentences++;
+      if (m_skip_corrupt_sentences) {
+        m_keyframes.AddLine(index, std::string());
+        return;
+      }
+    }
+    nmea = line;
+    hasTimestamp = m_timestampParser.ParseTimestamp(line, timestamp, precision);
+    if (hasTimestamp && !m_hasPrimaryTimeSource) {
+      // No usable time source when the file was loaded, use the first one
+      // that appears.
+      wxString talkerId, sentenceId;
+      bool isTimeSentence;
+      hasTimestamp =
+          ParseNMEAComponents(line, talkerId, sentenceId, isTimeSentence);
+      if (hasTimestamp) {
+        m_primaryTimeSource = TimeSource(talkerId, sentenceId, precision);
+        m_hasPrimaryTimeSource = true;
+        m_timestampParser.SetPrimaryTimeSource(m_primaryTimeSource);
+        wxLogMessage("Using %s%s (precision=%d) as primary time source",
+                     talkerId, sentenceId, precision);
+      }
+    }
+    sourceKey = GetKeyframeSourceKey(m_primaryTimeSource);
+  }
+
+  if (hasTimestamp && timestamp.IsValid()) {
+    VDRTimeMs timeMs = ToTimeMs(timestamp);
+    if (m_firstTimestamp == INVALID_TIME_MS) {
+      m_firstTimestamp = timeMs;
+      m_currentTimestamp = timeMs;
+      if (m_playing) {
+        AdjustPlaybackBaseTime();
+      }
+    }
+    // INVALID_TIME_MS is the smallest value, no need to check it.
+    if (timeMs > m_lastTimestamp) {
+      m_lastTimestamp = timeMs;
+    }
+    m_has_timestamps = true;
+    m_keyframes.AddTimestamp(sourceKey, timeMs);
+  }
+  m_keyframes.AddLine(index, nmea.ToStdString());
+}
+
 bool vdr_pi::SeekToFraction(double fraction) {
   // Validate input
   if (fraction < 0.0 || fraction > 1.0) {
@@ -1719,109 +2607,109 @@ bool vdr_pi::SeekToFraction(double fraction) {
     return false;
   }
 
+  // State at the seek position, restored from the closest keyframe and
+  // updated with each line read until the target is reached.
+  StateSnapshot state;
+
   // For files without timestamps, use line-based position.
   if (!HasValidTimestamps()) {
     int totalLines = m_istream.GetLineCount();
     if (totalLines > 0) {
       int targetLine = static_cast<int>(fraction * totalLines);
-      m_istream.GoToLine(targetLine);
+      const Keyframe* keyframe = m_keyframes.FindKeyframeBeforeLine(targetLine);
+      if (keyframe) {
+        state = keyframe->state;
+        m_istream.GoToLine(keyframe->line);
+      } else {
+        m_istream.GoToLine(-1);
+      }
+      while (static_cast<int>(m_istream.GetCurrentLine()) < targetLine &&
+             !m_istream.Eof()) {
+        wxString line = m_istream.GetNextLine();
+        line.Trim(true).Trim(false);
+        if (!line.IsEmpty() && !line.StartsWith("#") &&
+            (!m_skip_corrupt_sentences || !IsCorruptSentence(line))) {
+          state.Update(line.ToStdString());
+        }
+      }
+      EmitStateSnapshot(state);
       return true;
     }
     return false;
   }
 
-  // Handle seeking in CSV files
-  if (m_is_csv_file) {
-    if (!HasValidTimestamps()) {
-      return false;
-    }
-
-    // Calculate target timestamp
-    wxTimeSpan totalSpan = m_lastTimestamp - m_firstTimestamp;
-    wxTimeSpan targetSpan =
-        wxTimeSpan::Seconds((totalSpan.GetSeconds().ToDouble() * fraction));
-    wxDateTime targetTime = m_firstTimestamp + targetSpan;
-
-    // Scan file until we find first message after target time
-    wxString line = GetNextNonEmptyLine(true);  // Skip header
-    line = GetNextNonEmptyLine();               // Get first data line
-
-    while (!m_istream.Eof()) {
-      wxDateTime timestamp;
-      wxString nmea;
-      bool success = ParseCSVLineTimestamp(line, &nmea, &timestamp);
-      if (success && timestamp.IsValid() && timestamp >= targetTime) {
-        // Found our position, prepare to play from here
-        m_currentTimestamp = timestamp;
-        if (m_playing) {
-          AdjustPlaybackBaseTime();
-        }
-        return true;
-      }
-      line = GetNextNonEmptyLine();
-    }
-    return false;
+  VDRTimeMs totalMs = m_lastTimestamp - m_firstTimestamp;
+  VDRTimeMs targetTime = m_firstTimestamp + std::llround(totalMs * fraction);
+
+  // Start from the last keyframe before the target time.
+  std::string sourceKey = m_is_csv_file
+                              ? std::string(CSV_KEYFRAME_SOURCE)
+                              : GetKeyframeSourceKey(m_primaryTimeSource);
+  const Keyframe* keyframe =
+      m_keyframes.FindKeyframe(sourceKey, targetTime);
+  if (keyframe) {
+    state = keyframe->state;
+    m_istream.GoToLine(keyframe->line);
+  } else if (m_is_csv_file) {
+    GetNextNonEmptyLine(true);  // Skip header
+  } else {
+    m_istream.GoToLine(-1);
   }
 
-  // Handle seeking in NMEA files
-  else {
-    // If we have valid timestamps in the NMEA file, use them.
-    if (!HasValidTimestamps()) {
-      return false;
+  // Scan file until we find first message at or after target time.
+  bool foundPosition = false;
+  while (!m_istream.Eof()) {
+    wxString line = GetNextNonEmptyLine();
+    if (line.IsEmpty()) continue;
+    wxDateTime timestamp;
+    wxString nmea;
+    bool success;
+    if (m_is_csv_file) {
+      success = ParseCSVLineTimestamp(line, &nmea, &timestamp);
+    } else {
+      int precision;
+      nmea = line;
+      success = m_timestampParser.ParseTimestamp(line, timestamp, precision);
     }
-    wxTimeSpan totalSpan = m_lastTimestamp - m_firstTimestamp;
-    wxTimeSpan targetSpan =
-        wxTimeSpan::Seconds((totalSpan.GetSeconds().ToDouble() * fraction));
-    wxDateTime targetTime = m_firstTimestamp + targetSpan;
-
-    // Scan file for closest timestamp
-    m_istream.GoToLine(0);
-    wxString line;
-    wxDateTime lastTimestamp;
-    bool foundPosition = false;
-    int precision;
-
-    while (!m_istream.Eof()) {
-      line = GetNextNonEmptyLine();
-      wxDateTime timestamp;
-      if (m_timestampParser.ParseTimestamp(line, timestamp, precision)) {
-        if (timestamp >= targetTime) {
-          m_currentTimestamp = timestamp;
-          foundPosition = true;
-          break;
-        }
-        lastTimestamp = timestamp;
-      }
+    if (!nmea.IsEmpty() &&
+        (!m_skip_corrupt_sentences || !IsCorruptSentence(nmea))) {
+      state.Update(nmea.ToStdString());
     }
-
-    if (foundPosition) {
-      if (m_playing) {
-        AdjustPlaybackBaseTime();
-      }
-      return true;
+    if (success && timestamp.IsValid() && ToTimeMs(timestamp) >= targetTime) {
+      // Found our position, prepare to play from here
+      m_currentTimestamp = ToTimeMs(timestamp);
+      foundPosition = true;
+      break;
     }
   }
 
+  if (foundPosition) {
+    if (m_playing) {
+      AdjustPlaybackBaseTime();
+    }
+    EmitStateSnapshot(state);
+    return true;
+  }
   return false;
 }
 
 bool vdr_pi::HasValidTimestamps() const {
-  return m_has_timestamps && m_firstTimestamp.IsValid() &&
-         m_lastTimestamp.IsValid() && m_currentTimestamp.IsValid();
+  return m_has_timestamps && m_firstTimestamp != INVALID_TIME_MS &&
+         m_lastTimestamp != INVALID_TIME_MS &&
+         m_currentTimestamp != INVALID_TIME_MS;
 }
 
 double vdr_pi::GetProgressFraction() const {
   // For files with timestamps
   if (HasValidTimestamps()) {
-    wxTimeSpan totalSpan = m_lastTimestamp - m_firstTimestamp;
-    wxTimeSpan currentSpan = m_currentTimestamp - m_firstTimestamp;
+    VDRTimeMs totalMs = m_lastTimestamp - m_firstTimestamp;
+    VDRTimeMs currentMs = m_currentTimestamp - m_firstTimestamp;
 
-    if (totalSpan.GetSeconds().ToLong() == 0) {
+    if (totalMs == 0) {
       return 0.0;
     }
 
-    return currentSpan.GetSeconds().ToDouble() /
-           totalSpan.GetSeconds().ToDouble();
+    return static_cast<double>(currentMs) / static_cast<double>(totalMs);
   }
 
   // For files without timestamps, use line position.
@@ -1841,6 +2729,7 @@ double vdr_pi::GetProgressFraction() const {
 
 void vdr_pi::ClearInputFile() {
   m_ifilename.Clear();
+  m_follower.Stop();
   if (m_istream.IsOpened()) {
     m_istream.Close();
   }
@@ -1869,6 +2758,7 @@ bool vdr_pi::LoadFile(const wxString& filename, wxString* error) {
   m_atFileEnd = false;
 
   // Close existing file if open
+  m_follower.Stop();
   if (m_istream.IsOpened()) {
     m_istream.Close();
   }
@@ -1878,6 +2768,9 @@ bool vdr_pi::LoadFile(const wxString& filename, wxString* error) {
     }
     return false;
   }
+  if (m_follow_mode) {
+    StartFollowing();
+  }
   return true;
 }
 
@@ -47,6 +47,12 @@
 #include "ocpn_plugin.h"
 #include "vdr_pi_time.h"
 #include "vdr_network.h"
+#include "vdr_keyframes.h"
+#include "vdr_follow.h"
+#include "vdr_ring.h"
+#include "vdr_nmea.h"
+#include "vdr_n2k.h"
+#include "vdr_signalk.h"
 #include "config.h"
 
 #define VDR_TOOL_POSITION -1  // Request default positioning of toolbar tool
@@ -74,17 +80,50 @@ enum class NMEA0183ReplayMode {
   INTERNAL_API  // Use PushNMEABuffer()
 };
 
+/** Format of the NMEA 2000 messages replayed over the network. */
+enum class N2KNetworkFormat {
+  PCDIN,      //!< Text, as recorded: $PCDIN,<pgn>,<payload>
+  ACTISENSE,  //!< Actisense N2K binary messages
+  YDRAW       //!< YD RAW CAN frames
+};
+
 /**
  * Network settings for protocol output.
  */
 struct ConnectionSettings {
-  bool enabled;  //!< Enable network output
-  bool useTCP;   //!< Use TCP (true) or UDP (false)
-  int port;      //!< Network port number
+  bool enabled;            //!< Enable network output
+  bool useTCP;             //!< Use TCP (true) or UDP (false)
+  int port;                //!< Network port number
+  VDRUdpDestinations udp;  //!< Where UDP datagrams are sent
+  wxString filter;         //!< Messages sent, see VDRMessageFilter
 
   ConnectionSettings() : enabled(false), useTCP(true), port(10111) {}
 };
 
+/**
+ * Network input settings.
+ *
+ * Messages received from a network source, such as a multiplexer or a
+ * NMEA 2000 gateway, are recorded like the ones received from OpenCPN.
+ */
+struct VDRNetworkInputSettings {
+  bool enabled;   //!< Record the messages of the network source
+  bool useTCP;    //!< Connect to a TCP server (true) or receive UDP (false)
+  wxString host;  //!< TCP server host
+  int port;       //!< TCP server port, or UDP port to receive on
+
+  VDRNetworkInputSettings()
+      : enabled(false), useTCP(true), host("127.0.0.1"), port(10110) {}
+
+  bool operator==(const VDRNetworkInputSettings& other) const {
+    return enabled == other.enabled && useTCP == other.useTCP &&
+           host == other.host && port == other.port;
+  }
+  bool operator!=(const VDRNetworkInputSettings& other) const {
+    return !(*this == other);
+  }
+};
+
 /**
  * Protocol recording configuration settings.
  *
@@ -98,13 +137,48 @@ struct VDRProtocolSettings {
   ConnectionSettings nmea0183Net;  //!< NMEA 0183 connection settings
   ConnectionSettings n2kNet;       //!< NMEA 2000 connection settings
   ConnectionSettings signalKNet;   //!< Signal K connection settings
+  VDRNetworkInputSettings input;   //!< Network source to record
 
   NMEA0183ReplayMode nmea0183ReplayMode =
       NMEA0183ReplayMode::INTERNAL_API;  //!< NMEA 0183 replay method
+  N2KNetworkFormat n2kNetFormat =
+      N2KNetworkFormat::PCDIN;  //!< NMEA 2000 network output format
+  /** Seconds after which unchanged Signal K values are recorded again. */
+  int signalKHeartbeatSec = 60;
 
   VDRProtocolSettings() : nmea0183(true), nmea2000(false), signalK(false) {}
 };
 
+/**
+ * In-memory buffer settings.
+ *
+ * Recently received messages are kept in memory so they can be replayed
+ * immediately, without stopping recording or opening a file.
+ */
+struct VDRTimeShiftSettings {
+  bool enabled;      //!< Keep recent messages in memory
+  int minutes;       //!< Time horizon of the buffer in minutes
+  int maxMegabytes;  //!< Maximum memory used by the buffer in MB
+
+  VDRTimeShiftSettings() : enabled(false), minutes(10), maxMegabytes(32) {}
+};
+
+/**
+ * Black box recording settings.
+ *
+ * Received messages are only kept in memory until a trigger fires. The
+ * messages received before the trigger are then written to a new VDR file
+ * and recording continues for a limited time after the trigger.
+ */
+struct VDRBlackBoxSettings {
+  bool enabled;            //!< Only write to disk when a trigger fires
+  int preTriggerMinutes;   //!< Minutes of data written before the trigger
+  int postTriggerMinutes;  //!< Minutes of recording after the last trigger
+
+  VDRBlackBoxSettings()
+      : enabled(false), preTriggerMinutes(30), postTriggerMinutes(5) {}
+};
+
 /**
  * Column definition for CSV format files.
  *
@@ -157,6 +231,43 @@ public:
    * and maintaining playback state.
    */
   void Notify();
+  /**
+   * Process timer notification for instant replay.
+   *
+   * Sends the buffered messages that are due and schedules the next
+   * notification.
+   */
+  void OnInstantReplayTimer();
+  /**
+   * Process timer notification for the network input.
+   *
+   * Records the lines received from the network source since the last
+   * notification.
+   */
+  void OnNetworkInputTimer();
+  /**
+   * Record a line received from the network source.
+   *
+   * NMEA 0183 and AIS sentences are handled like SetNMEASentence(). YD RAW
+   * frames and $PCDIN messages are handled like the NMEA 2000 messages
+   * received from OpenCPN, once their fast packets are reassembled.
+   * @param line Line, without line ending
+   */
+  void ProcessNetworkInput(const std::string& line);
+  /**
+   * Record a Signal K delta.
+   *
+   * The values are written as $PVDSK records, see SignalKDeltaEncoder. The
+   * context and path strings are written once per VDR file, and a value is
+   * only written when it changes or when the heartbeat interval has elapsed.
+   * The records are also kept in the in-memory buffer, with a dictionary of
+   * their own, and written with the dictionary of the VDR file once a black
+   * box trigger starts it.
+   * @param json Delta message
+   * @param selfContext Context of a delta without context
+   */
+  void RecordSignalKDelta(const std::string& json,
+                          const std::string& selfContext);
   /**
    * Set the interval for timer notifications.
    * @param interval Timer interval in milliseconds
@@ -178,6 +289,13 @@ public:
    * @param sentence AIS message to process
    */
   void SetAISSentence(wxString& sentence);
+  /**
+   * Process a message sent by OpenCPN or another plugin.
+   *
+   * The VDR_BLACKBOX_TRIGGER message fires a black box trigger, the message
+   * body is logged as the reason.
+   */
+  void SetPluginMessage(wxString& message_id, wxString& message_body);
   /**
    * Get number of toolbar items added by plugin.
    * @return Number of toolbar items
@@ -212,6 +330,32 @@ public:
   bool IsPlaying() { return m_playing; }
   /** Return whether the end of the playback file has been reached. */
   bool IsAtFileEnd() const { return m_atFileEnd; }
+  /**
+   * Replay recently received messages from the in-memory buffer.
+   *
+   * Messages are sent through the playback outputs with their original
+   * timing while recording continues. Replayed sentences that OpenCPN sends
+   * back to the plugin are not recorded again.
+   *
+   * @param minutes Replay the messages received during the last minutes.
+   * @return False if the buffer is disabled or empty, or a file is playing.
+   */
+  bool StartInstantReplay(int minutes);
+  /** Stop replaying messages from the in-memory buffer. */
+  void StopInstantReplay();
+  /** Return whether instant replay is active. */
+  bool IsInstantReplayActive() const { return m_instant_replay; }
+  /**
+   * Fire a black box trigger.
+   *
+   * Starts recording if needed, writing the messages received during the
+   * pre-trigger window first, and extends recording until the end of the
+   * post-trigger window.
+   *
+   * @param reason Reason of the trigger, for logging.
+   * @return False if black box mode is disabled or recording failed to start.
+   */
+  bool TriggerBlackBox(const wxString& reason);
   void ResetEndOfFile() { m_atFileEnd = false; }
   /**
    * Calculate when the current NMEA/SignalK message should be played during
@@ -228,12 +372,13 @@ public:
    * 2x speed)
    * 3. Adding the scaled time to when playback started
    *
-   * @return wxDateTime When to play the current message, relative to system
-   * time. Returns invalid wxDateTime if any required timestamps are invalid.
+   * @return When to play the current message, system time in milliseconds
+   * since the epoch. Returns INVALID_TIME_MS if any required timestamps are
+   * invalid.
    *
    * @see GetSpeedMultiplier() - Controls how fast messages are replayed
    */
-  wxDateTime GetNextPlaybackTime() const;
+  VDRTimeMs GetNextPlaybackTime() const;
 
   /** Invoked during playback. */
   void OnTimer(wxTimerEvent& event);
@@ -320,18 +465,24 @@ public:
    */
   double GetProgressFraction() const;
   /** Get timestamp of first message in file. */
-  wxDateTime GetFirstTimestamp() const { return m_firstTimestamp; }
+  wxDateTime GetFirstTimestamp() const { return FromTimeMs(m_firstTimestamp); }
   /** Get timestamp of last message in file. */
-  wxDateTime GetLastTimestamp() const { return m_lastTimestamp; }
+  wxDateTime GetLastTimestamp() const { return FromTimeMs(m_lastTimestamp); }
   /** Get timestamp at current playback position. */
-  wxDateTime GetCurrentTimestamp() const { return m_currentTimestamp; }
+  wxDateTime GetCurrentTimestamp() const {
+    return FromTimeMs(m_currentTimestamp);
+  }
+  /** Get timeline position of first message in file. */
+  VDRTimeMs GetFirstTimeMs() const { return m_firstTimestamp; }
+  /** Get timeline position of last message in file. */
+  VDRTimeMs GetLastTimeMs() const { return m_lastTimestamp; }
+  /** Get timeline position of current playback position. */
+  VDRTimeMs GetCurrentTimeMs() const { return m_currentTimestamp; }
   /**
-   * Set timestamp for current playback position.
-   * @param timestamp New current timestamp
+   * Set timeline position for current playback position.
+   * @param timeMs New current position, milliseconds since the epoch (UTC)
    */
-  void SetCurrentTimestamp(const wxDateTime& timestamp) {
-    m_currentTimestamp = timestamp;
-  }
+  void SetCurrentTimeMs(VDRTimeMs timeMs) { m_currentTimestamp = timeMs; }
   /**
    * Get path of currently loaded input file.
    *
@@ -370,17 +521,81 @@ public:
   void SetSpeedThreshold(double threshold) { m_speed_threshold = threshold; }
   /** Get configured delay before stopping recording. */
   int GetStopDelay() const { return m_stop_delay; }
+  /** Get in-memory buffer settings. */
+  const VDRTimeShiftSettings& GetTimeShiftSettings() const {
+    return m_timeshift_settings;
+  }
+  /**
+   * Set in-memory buffer settings.
+   *
+   * Buffered messages are discarded if the buffer is disabled or exceed the
+   * new limits.
+   * @param settings New settings
+   */
+  void SetTimeShiftSettings(const VDRTimeShiftSettings& settings);
+  /** Get the in-memory buffer of recently received messages. */
+  const VDRMessageRing& GetMessageRing() const { return m_ring; }
+  /** Get black box recording settings. */
+  const VDRBlackBoxSettings& GetBlackBoxSettings() const {
+    return m_blackbox_settings;
+  }
+  /**
+   * Set black box recording settings.
+   * @param settings New settings
+   */
+  void SetBlackBoxSettings(const VDRBlackBoxSettings& settings);
   /**
    * Set delay before stopping recording when speed drops.
    * @param minutes Minutes to wait before stopping
    */
   void SetStopDelay(int minutes) { m_stop_delay = minutes; }
+  /** Check if files are followed while they are being written. */
+  bool IsFollowMode() const { return m_follow_mode; }
+  /**
+   * Enable or disable follow mode.
+   *
+   * When enabled, data appended to the playback file after it was loaded is
+   * played as it arrives instead of stopping at the end of the file. The
+   * setting applies to files loaded after the change.
+   * @param enable True to follow files
+   */
+  void SetFollowMode(bool enable) { m_follow_mode = enable; }
+  /** Get protocol recording settings. */
+  const VDRProtocolSettings& GetProtocolSettings() const { return m_protocols; }
+  /**
+   * Set protocol recording settings.
+   *
+   * The event listeners of the protocols that were enabled or disabled are
+   * updated.
+   * @param settings New settings
+   */
+  void SetProtocolSettings(const VDRProtocolSettings& settings);
+  /** Get the outbound queue settings of the TCP playback clients. */
+  const VDRClientQueueSettings& GetClientQueueSettings() const {
+    return m_client_queue_settings;
+  }
+  /** Set the outbound queue settings of the TCP playback clients. */
+  void SetClientQueueSettings(const VDRClientQueueSettings& settings);
+  /** Check if sentences with a bad checksum are skipped during playback. */
+  bool IsSkipCorruptSentences() const { return m_skip_corrupt_sentences; }
+  /**
+   * Enable or disable skipping of corrupt sentences.
+   *
+   * When enabled, NMEA 0183 and AIS sentences whose checksum does not match
+   * are neither played nor used as time source. The setting applies to files
+   * loaded after the change.
+   * @param enable True to skip corrupt sentences
+   */
+  void SetSkipCorruptSentences(bool enable) {
+    m_skip_corrupt_sentences = enable;
+  }
   /**
    * Check if auto-recording should be started or stopped based on speed over
    * ground.
    *
    * Starts recording when speed over ground exceeds threshold and stops
    * recording after configured delay when speed drops below threshold.
+   * In black box mode, exceeding the threshold fires a trigger instead.
    * @param speed Current speed over ground in knots
    */
   void CheckAutoRecording(double speed);
@@ -393,11 +608,54 @@ public:
    */
   bool HasValidTimestamps() const;
 
-  /** Helper function to extract NMEA sentence components. */
+  /**
+   * Helper function to extract NMEA sentence components.
+   *
+   * @param status Optional output validation status, sentences with a bad
+   * checksum are still parsed.
+   * @return False if the sentence is malformed.
+   */
   bool ParseNMEAComponents(const wxString nmea, wxString& talkerId,
-                           wxString& sentenceId, bool& hasTimestamp) const;
+                           wxString& sentenceId, bool& hasTimestamp,
+                           NMEASentenceStatus* status = nullptr) const;
+
+  /**
+   * Check if a message is an NMEA 0183 or AIS sentence with a bad checksum.
+   * Other messages are never corrupt.
+   */
+  static bool IsCorruptSentence(const wxString& message);
+
+  /** Get the number of sentences with a bad checksum found by the scan. */
+  int GetCorruptSentenceCount() const { return m_corrupt_sentences; }
+
+  /**
+   * Format a NMEA 0183 or AIS sentence as a line of a CSV VDR file.
+   *
+   * @param nmea Sentence to format.
+   * @param timestamp Reception time of the sentence.
+   * @return CSV line, terminated by a newline.
+   */
+  wxString FormatNMEA0183AsCSV(const wxString& nmea,
+                               const wxDateTime& timestamp);
+
+  /**
+   * Format a NMEA 2000 payload as uppercase hexadecimal, as recorded in
+   * VDR files.
+   */
+  static wxString FormatN2KPayload(const std::vector<uint8_t>& payload);
+
+  /**
+   * Record an NMEA 2000 message received from OpenCPN.
+   *
+   * @param payload Message as returned by GetN2000Payload(), with the
+   * header bytes.
+   */
+  void ProcessN2KPayload(const std::vector<uint8_t>& payload);
 
-  /** Helper to flush the sentence buffer to NMEA stream. */
+  /**
+   * Flush the sentence buffer to NMEA stream, and send the sentences queued
+   * for the network servers.
+   */
   void FlushSentenceBuffer();
 
   /**
@@ -458,12 +716,44 @@ private:
     TimerHandler(vdr_pi* plugin) : m_plugin(plugin) {}
     void Notify() { m_plugin->Notify(); }
 
+  private:
+    vdr_pi* m_plugin;
+  };
+  class InstantReplayTimer : public wxTimer {
+  public:
+    InstantReplayTimer(vdr_pi* plugin) : m_plugin(plugin) {}
+    void Notify() { m_plugin->OnInstantReplayTimer(); }
+
+  private:
+    vdr_pi* m_plugin;
+  };
+  class NetworkInputTimer : public wxTimer {
+  public:
+    NetworkInputTimer(vdr_pi* plugin) : m_plugin(plugin) {}
+    void Notify() { m_plugin->OnNetworkInputTimer(); }
+
   private:
     vdr_pi* m_plugin;
   };
   bool LoadConfig(void);
   bool SaveConfig(void);
-  wxString FormatNMEA0183AsCSV(const wxString& nmea);
+  /** Write a NMEA 0183 or AIS sentence to the VDR file. */
+  void WriteNMEA0183(const wxString& sentence, const wxDateTime& timestamp);
+  /** Write a NMEA 2000 message to the VDR file. */
+  void WriteNMEA2000(unsigned int pgn, const wxString& payload,
+                     const wxDateTime& timestamp);
+  /** Write a message from the in-memory buffer to the VDR file. */
+  void WriteBufferedMessage(const RingMessage& message);
+  /** Add a replayed Signal K value to the delta sent to the server. */
+  void AddSignalKPlaybackValue(const SignalKValue& value, int64_t timeMs);
+  /** Return true if received messages are kept in memory. */
+  bool IsBuffering() const {
+    return m_timeshift_settings.enabled || m_blackbox_settings.enabled;
+  }
+  /** Apply the time-shift and black box settings to the in-memory buffer. */
+  void UpdateRingLimits();
+  /** Stop recording when the black box post-trigger window has elapsed. */
+  void CheckBlackBoxWindow();
   bool ParseCSVHeader(const wxString& header);
   /** Parse timestamp from a CSV line or raw NMEA sentence. */
   bool ParseCSVLineTimestamp(const wxString& line, wxString* messages,
@@ -479,10 +769,43 @@ private:
   /** Process incoming SignalK message from OpenCPN. */
   void OnSignalKEvent(wxCommandEvent& ev);
   double GetSpeedMultiplier() const;
+  /**
+   * Set the playback speed used when the control panel is not shown.
+   *
+   * @param multiplier Playback speed, 1.0 for real time.
+   */
+  void SetSpeedMultiplier(double multiplier);
 
   /** Helper to select the best primary time source. */
   void SelectPrimaryTimeSource();
 
+  /**
+   * Start following the loaded file for appended data.
+   *
+   * The last line of the file is discarded if it is incomplete, it will be
+   * read again once the recorder has finished writing it.
+   */
+  void StartFollowing();
+
+  /**
+   * Append the lines written to the followed file since the last call.
+   *
+   * The input stream is positioned so that the next read returns the first
+   * appended line.
+   *
+   * @return Number of lines appended to the input stream.
+   */
+  size_t ReadAppendedLines();
+
+  /**
+   * Update the timeline and keyframe index with a line appended to the
+   * followed file.
+   *
+   * @param line Appended line.
+   * @param index Index of the line in the input stream.
+   */
+  void ExtendTimeline(const wxString& line, int index);
+
   /**
    * Get or create network server for a protocol.
    *
@@ -493,12 +816,13 @@ private:
 
   /**
    * Parse a PCDIN message into its components
-   * Format: $PCDIN,<pgn>,<timestamp>,<src>,<data>
+   * Format: $PCDIN,<pgn>,<timestamp>,<src>,<data> (SeaSmart) or
+   * $PCDIN,<pgn>,<payload> (VDR recording), see ParsePCDIN()
    *
    * @param message PCDIN message to parse
    * @param pgn [out] PGN number
    * @param source [out] Source address
-   * @param payload [out] Message payload
+   * @param payload [out] Message data, in hexadecimal
    * @return True if parsing successful
    */
   bool ParsePCDINMessage(const wxString& message, int& pgn, wxString& source,
@@ -548,6 +872,14 @@ private:
    * @note: This function is safe to call even if servers are not running
    */
   void StopNetworkServers();
+  /**
+   * Start or stop receiving from the network source, according to the
+   * network input settings.
+   *
+   * Lines are received on the I/O thread of the network client and recorded
+   * on the GUI thread by OnNetworkInputTimer().
+   */
+  void UpdateNetworkInput();
   /**
    * Process and send data through appropriate network servers during playback.
    *
@@ -555,7 +887,7 @@ private:
    * network server based on message type and protocol settings. It supports:
    *
    * NMEA0183:
-   * - Messages starting with '$' or '!'
+   * - Messages starting with '$' or '!', other than the NMEA2000 ones
    * - Only sends if NMEA0183 networking is enabled
    *
    * NMEA2000:
@@ -564,13 +896,44 @@ private:
    * - MiniPlex format ($MXPGN)
    * - YD RAW format ($YDRAW)
    * - Only sends if NMEA2000 networking is enabled
+   * - $PCDIN messages are encoded as Actisense N2K or YD RAW binary frames
+   *   when selected by VDRProtocolSettings::n2kNetFormat
+   *
+   * The messages are queued by the servers and sent together by
+   * FlushSentenceBuffer(), once per playback notification.
    *
-   * @param data The NMEA message to send
+   * @param message The NMEA message to send, shared with the other outputs
    *        Each message should be a complete NMEA sentence including any line
    * endings
    *
    */
-  void HandleNetworkPlayback(const wxString& data);
+  void HandleNetworkPlayback(const VDRMessagePtr& message);
+
+  /**
+   * Replay a Signal K record to the Signal K server.
+   *
+   * Dictionary entries are remembered, values are added to the delta being
+   * written, which is queued when it is complete or by FlushSentenceBuffer().
+   * The deltas are timestamped with the recording time of the file when it
+   * is known.
+   *
+   * @param record $PVDSK record, see SignalKDeltaEncoder.
+   */
+  void HandleSignalKPlayback(const std::string& record);
+
+  /** Queue the delta being written to the Signal K server. */
+  void QueueSignalKDelta();
+
+  /**
+   * Send all messages of a state snapshot to the playback outputs.
+   *
+   * Called after a seek so that OpenCPN displays the vessel and AIS target
+   * state at the new position without waiting for each sentence type to be
+   * played again.
+   *
+   * @param state Snapshot of the latest message for each data item.
+   */
+  void EmitStateSnapshot(const StateSnapshot& state);
 
   int m_tb_item_id_record;
   int m_tb_item_id_play;
@@ -579,6 +942,8 @@ private:
   wxFileConfig* m_pconfig;
   wxAuiManager* m_pauimgr;
   VDRControl* m_pvdrcontrol;
+  /** Playback speed when the control panel is not shown. */
+  double m_speed_multiplier;
   /** Input filename for playback. */
   wxString m_ifilename;
   /** Output filename for recording. */
@@ -611,9 +976,23 @@ private:
 
   /** Network servers for each protocol */
   std::map<wxString, std::unique_ptr<VDRNetworkServer>> m_networkServers;
+  /** Outbound queue settings of the TCP playback clients. */
+  VDRClientQueueSettings m_client_queue_settings;
 
   /** Input file stream for playback. */
   wxTextFile m_istream;
+  /** Whether to follow the playback file while it is being written. */
+  bool m_follow_mode;
+  /** Whether to skip sentences with a bad checksum during playback. */
+  bool m_skip_corrupt_sentences;
+  /** Number of sentences with a bad checksum in the playback file. */
+  int m_corrupt_sentences;
+  /** Reader for data appended to the playback file in follow mode. */
+  VDRFileFollower m_follower;
+  /** Milliseconds between two checks for appended data in follow mode. */
+  static const int FOLLOW_POLL_INTERVAL_MS = 250;
+  /** Lines of a raw file whose timestamps are parsed in one batch. */
+  static const size_t SCAN_BATCH_LINES = 4096;
   /** Output file stream for recording. */
   wxFile m_ostream;
   /** Plugin toolbar icon. */
@@ -656,21 +1035,21 @@ private:
   /** When current recording started. */
   wxDateTime m_recording_start;
   /**
-   * System time when VDR playback was started.
+   * System time (ms since the epoch) when VDR playback was started.
    *
    * Used as the reference point for calculating when each message should be
    * played. All playback times are calculated as an offset from this timestamp.
    */
-  wxDateTime m_playback_base_time;
+  VDRTimeMs m_playback_base_time;
   /**
    * The first (earliest) timestamp from the primary time source in the VDR
    * file.
    */
-  wxDateTime m_firstTimestamp;
+  VDRTimeMs m_firstTimestamp;
   /** The last timestamp from the primary time source in the VDR file. */
-  wxDateTime m_lastTimestamp;
+  VDRTimeMs m_lastTimestamp;
   /** The current timestamp during VDR playback. */
-  wxDateTime m_currentTimestamp;
+  VDRTimeMs m_currentTimestamp;
   /** Track whether file has valid timestamps. */
   bool m_has_timestamps;
 
@@ -722,14 +1101,72 @@ private:
    * Used to store incoming NMEA sentences for playback, especially
    * at high speeds where sentences may arrive faster than they can be played.
    * At high replay speeds, some sentences may be skipped to maintain timing.
+   * The sentences are shared with the network servers.
    */
-  std::deque<wxString> m_sentence_buffer;
+  std::deque<VDRMessagePtr> m_sentence_buffer;
   /** Flag indicating if messages have been dropped from the buffer. */
   bool m_messages_dropped;
 
   wxEvtHandler* m_eventHandler;
   TimerHandler* m_timer;
+
+  /** In-memory buffer settings. */
+  VDRTimeShiftSettings m_timeshift_settings;
+  /** Black box recording settings. */
+  VDRBlackBoxSettings m_blackbox_settings;
+  /** Recently received messages, kept for instant replay and black box. */
+  VDRMessageRing m_ring;
+  /** Sequence number of the last buffered message written to disk. */
+  uint64_t m_blackbox_written_sequence;
+  /** End of the black box post-trigger window, invalid if not triggered. */
+  wxDateTime m_blackbox_until;
+  /** Speed was above threshold, a new trigger requires a crossing. */
+  bool m_blackbox_above_threshold;
+  /** Sentences sent by instant replay that OpenCPN may send back to us. */
+  VDREchoFilter m_echo_filter;
+  /** Encoder of the NMEA 2000 messages replayed as YD RAW frames. */
+  YDRawEncoder m_ydraw_encoder;
+  /** Dictionary and last values of the Signal K data of the VDR file. */
+  SignalKDeltaEncoder m_signalk_encoder;
+  /** Dictionary and last values of the Signal K data of the buffer. */
+  SignalKDeltaEncoder m_signalk_ring_encoder;
+  /**
+   * Dictionary of the buffered Signal K records. It is kept apart from the
+   * buffer so that values stay decodable once their entries are dropped.
+   */
+  SignalKDeltaDecoder m_signalk_ring_decoder;
+  /** Dictionary of the Signal K records of the replayed file. */
+  SignalKDeltaDecoder m_signalk_decoder;
+  /** Delta being written for the Signal K replay server. */
+  SignalKDeltaWriter m_signalk_writer;
+  /** Lines received from the network source, waiting to be recorded. */
+  VDRSpscQueue<std::string> m_input_queue{MAX_INPUT_LINES};
+  /** Lines dropped because the GUI thread could not keep up. */
+  std::atomic<uint64_t> m_input_dropped;
+  /**
+   * Client receiving the network source to record. Declared after the
+   * queue so its I/O thread is stopped before the queue is destroyed.
+   */
+  VDRNetworkClient m_network_input;
+  /** Decoder of the YD RAW frames received from the network source. */
+  YDRawDecoder m_ydraw_decoder;
+  NetworkInputTimer* m_input_timer;
+  /** Milliseconds between two recordings of the network input. */
+  static const int NETWORK_INPUT_INTERVAL_MS = 100;
+  /** Lines received from the network source beyond which they are dropped. */
+  static const size_t MAX_INPUT_LINES = 16384;
+  /** Flag indicating whether instant replay is active. */
+  bool m_instant_replay;
+  /** Messages remaining to be sent by instant replay. */
+  std::deque<RingMessage> m_replay_queue;
+  /** System time when instant replay started, in milliseconds. */
+  int64_t m_replay_start_ms;
+  /** Reception time of the first replayed message, in milliseconds. */
+  int64_t m_replay_first_ms;
+  InstantReplayTimer* m_replay_timer;
   TimestampParser m_timestampParser;  //!< Helper for timestamp parsing
+  /** Keyframes captured while scanning the input file, used for seeking. */
+  KeyframeIndex m_keyframes;
   /**
    * The set of time sources in the VDR recording.
    * Each time source is identified by its NMEA sentence type, talker ID and
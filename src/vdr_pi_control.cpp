@@ -21,6 +21,8 @@
 #include "vdr_pi.h"
 #include "icons.h"
 
+#include <cmath>
+
 enum {
   ID_VDR_LOAD = wxID_HIGHEST + 1,
   ID_VDR_PLAY_PAUSE,
@@ -260,15 +262,13 @@ void VDRControl::OnProgressSliderUpdated(wxScrollEvent& event) {
       PausePlayback();
     }
   }
-  if (m_pvdr->GetFirstTimestamp().IsValid() &&
-      m_pvdr->GetLastTimestamp().IsValid()) {
+  if (m_pvdr->GetFirstTimeMs() != INVALID_TIME_MS &&
+      m_pvdr->GetLastTimeMs() != INVALID_TIME_MS) {
     // Update time display while dragging but don't seek yet
     double fraction = m_progressSlider->GetValue() / 1000.0;
-    wxTimeSpan totalSpan =
-        m_pvdr->GetLastTimestamp() - m_pvdr->GetFirstTimestamp();
-    wxTimeSpan currentSpan =
-        wxTimeSpan::Seconds((totalSpan.GetSeconds().ToDouble() * fraction));
-    m_pvdr->SetCurrentTimestamp(m_pvdr->GetFirstTimestamp() + currentSpan);
+    VDRTimeMs totalMs = m_pvdr->GetLastTimeMs() - m_pvdr->GetFirstTimeMs();
+    m_pvdr->SetCurrentTimeMs(m_pvdr->GetFirstTimeMs() +
+                             std::llround(totalMs * fraction));
     UpdateTimeLabel();
   }
   event.Skip();
@@ -393,14 +393,12 @@ void VDRControl::SetProgress(double fraction) {
   int sliderPos = wxRound(fraction * 1000);
   m_progressSlider->SetValue(sliderPos);
 
-  if (m_pvdr->GetFirstTimestamp().IsValid() &&
-      m_pvdr->GetLastTimestamp().IsValid()) {
+  if (m_pvdr->GetFirstTimeMs() != INVALID_TIME_MS &&
+      m_pvdr->GetLastTimeMs() != INVALID_TIME_MS) {
     // Calculate and set current timestamp based on the fraction
-    wxTimeSpan totalSpan =
-        m_pvdr->GetLastTimestamp() - m_pvdr->GetFirstTimestamp();
-    wxTimeSpan currentSpan =
-        wxTimeSpan::Seconds((totalSpan.GetSeconds().ToDouble() * fraction));
-    m_pvdr->SetCurrentTimestamp(m_pvdr->GetFirstTimestamp() + currentSpan);
+    VDRTimeMs totalMs = m_pvdr->GetLastTimeMs() - m_pvdr->GetFirstTimeMs();
+    m_pvdr->SetCurrentTimeMs(m_pvdr->GetFirstTimeMs() +
+                             std::llround(totalMs * fraction));
 
     // Update time display
     UpdateTimeLabel();
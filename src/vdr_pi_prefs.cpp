@@ -34,7 +34,9 @@ enum {
   ID_NMEA2000_CHECK,
   ID_SIGNALK_CHECK,
   ID_NMEA0183_NETWORK_RADIO,
-  ID_NMEA0183_INTERNAL_RADIO
+  ID_NMEA0183_INTERNAL_RADIO,
+  ID_TIMESHIFT_CHECK,
+  ID_BLACKBOX_CHECK
 };
 
 BEGIN_EVENT_TABLE(VDRPrefsDialog, wxDialog)
@@ -44,8 +46,11 @@ EVT_CHECKBOX(ID_VDR_LOG_ROTATE_CHECK, VDRPrefsDialog::OnLogRotateCheck)
 EVT_CHECKBOX(ID_VDR_AUTO_RECORD_CHECK, VDRPrefsDialog::OnAutoRecordCheck)
 EVT_CHECKBOX(ID_USE_SPEED_THRESHOLD_CHECK,
              VDRPrefsDialog::OnUseSpeedThresholdCheck)
+EVT_CHECKBOX(ID_TIMESHIFT_CHECK, VDRPrefsDialog::OnTimeShiftCheck)
+EVT_CHECKBOX(ID_BLACKBOX_CHECK, VDRPrefsDialog::OnBlackBoxCheck)
 EVT_CHECKBOX(ID_NMEA0183_CHECK, VDRPrefsDialog::OnProtocolCheck)
 EVT_CHECKBOX(ID_NMEA2000_CHECK, VDRPrefsDialog::OnProtocolCheck)
+EVT_CHECKBOX(ID_SIGNALK_CHECK, VDRPrefsDialog::OnProtocolCheck)
 EVT_RADIOBUTTON(ID_NMEA0183_NETWORK_RADIO,
                 VDRPrefsDialog::OnNMEA0183ReplayModeChanged)
 EVT_RADIOBUTTON(ID_NMEA0183_INTERNAL_RADIO,
@@ -58,6 +63,9 @@ VDRPrefsDialog::VDRPrefsDialog(wxWindow* parent, wxWindowID id,
                                int logRotateInterval, bool autoStartRecording,
                                bool useSpeedThreshold, double speedThreshold,
                                int stopDelay,
+                               const VDRTimeShiftSettings& timeShift,
+                               const VDRBlackBoxSettings& blackBox,
+                               bool followMode, bool skipCorrupt,
                                const VDRProtocolSettings& protocols)
     : wxDialog(parent, id, _("VDR Preferences"), wxDefaultPosition,
                wxDefaultSize, wxDEFAULT_DIALOG_STYLE | wxRESIZE_BORDER),
@@ -69,6 +77,10 @@ VDRPrefsDialog::VDRPrefsDialog(wxWindow* parent, wxWindowID id,
       m_use_speed_threshold(useSpeedThreshold),
       m_speed_threshold(speedThreshold),
       m_stop_delay(stopDelay),
+      m_timeshift(timeShift),
+      m_blackbox(blackBox),
+      m_follow_mode(followMode),
+      m_skip_corrupt(skipCorrupt),
       m_protocols(protocols) {
   CreateControls();
   GetSizer()->Fit(this);
@@ -93,6 +105,19 @@ void VDRPrefsDialog::UpdateControlStates() {
   bool speedEnabled = autoRecordEnabled && m_useSpeedThresholdCheck->GetValue();
   m_speedThresholdCtrl->Enable(speedEnabled);
   m_stopDelayCtrl->Enable(speedEnabled);
+
+  // In-memory buffer controls
+  bool timeShiftEnabled = m_timeShiftCheck->GetValue();
+  bool blackBoxEnabled = m_blackBoxCheck->GetValue();
+  m_timeShiftMinutesCtrl->Enable(timeShiftEnabled);
+  // The memory cap also applies to the black box buffer.
+  m_timeShiftMaxMBCtrl->Enable(timeShiftEnabled || blackBoxEnabled);
+
+  // Black box controls
+  m_blackBoxPreTriggerCtrl->Enable(blackBoxEnabled);
+  m_blackBoxPostTriggerCtrl->Enable(blackBoxEnabled);
+
+  m_signalKHeartbeatCtrl->Enable(m_signalKCheck->GetValue());
 }
 
 void VDRPrefsDialog::CreateControls() {
@@ -142,14 +167,59 @@ wxPanel* VDRPrefsDialog::CreateRecordingTab(wxWindow* parent) {
   m_nmea2000Check->SetValue(m_protocols.nmea2000);
   protocolSizer->Add(m_nmea2000Check, 0, wxALL, 5);
 
-#if 0
   m_signalKCheck = new wxCheckBox(panel, ID_SIGNALK_CHECK, _("Signal K"));
   m_signalKCheck->SetValue(m_protocols.signalK);
   protocolSizer->Add(m_signalKCheck, 0, wxALL, 5);
-#endif
+
+  // Unchanged Signal K values are only recorded at this interval.
+  wxBoxSizer* heartbeatSizer = new wxBoxSizer(wxHORIZONTAL);
+  heartbeatSizer->Add(
+      new wxStaticText(panel, wxID_ANY, _("Record unchanged values every")),
+      0, wxALIGN_CENTER_VERTICAL | wxRIGHT, 5);
+  m_signalKHeartbeatCtrl = new wxSpinCtrl(
+      panel, wxID_ANY, wxEmptyString, wxDefaultPosition, wxDefaultSize,
+      wxSP_ARROW_KEYS, 0, 3600, m_protocols.signalKHeartbeatSec);
+  m_signalKHeartbeatCtrl->SetToolTip(
+      _("0 records every Signal K value, even when it has not changed"));
+  heartbeatSizer->Add(m_signalKHeartbeatCtrl, 0,
+                      wxALIGN_CENTER_VERTICAL | wxRIGHT, 5);
+  heartbeatSizer->Add(new wxStaticText(panel, wxID_ANY, _("seconds")), 0,
+                      wxALIGN_CENTER_VERTICAL);
+  protocolSizer->Add(heartbeatSizer, 0, wxLEFT | wxRIGHT | wxBOTTOM, 5);
 
   mainSizer->Add(protocolSizer, 0, wxEXPAND | wxALL, 5);
 
+  // Network input section
+  wxStaticBox* inputBox = new wxStaticBox(panel, wxID_ANY, _("Network Input"));
+  wxStaticBoxSizer* inputSizer = new wxStaticBoxSizer(inputBox, wxVERTICAL);
+
+  m_inputCheck = new wxCheckBox(
+      panel, wxID_ANY, _("Also record NMEA 0183 or YD RAW from the network"));
+  m_inputCheck->SetValue(m_protocols.input.enabled);
+  inputSizer->Add(m_inputCheck, 0, wxALL, 5);
+
+  wxBoxSizer* sourceSizer = new wxBoxSizer(wxHORIZONTAL);
+  wxArrayString inputProtocols;
+  inputProtocols.Add(_("TCP"));
+  inputProtocols.Add(_("UDP"));
+  m_inputProtocolChoice = new wxChoice(panel, wxID_ANY, wxDefaultPosition,
+                                       wxDefaultSize, inputProtocols);
+  m_inputProtocolChoice->SetSelection(m_protocols.input.useTCP ? 0 : 1);
+  sourceSizer->Add(m_inputProtocolChoice, 0,
+                   wxALIGN_CENTER_VERTICAL | wxRIGHT, 5);
+  m_inputHostCtrl = new wxTextCtrl(panel, wxID_ANY, m_protocols.input.host);
+  m_inputHostCtrl->SetToolTip(_("Host of the TCP server, unused for UDP"));
+  sourceSizer->Add(m_inputHostCtrl, 1, wxALIGN_CENTER_VERTICAL | wxRIGHT, 5);
+  sourceSizer->Add(new wxStaticText(panel, wxID_ANY, _("Port:")), 0,
+                   wxALIGN_CENTER_VERTICAL | wxRIGHT, 5);
+  m_inputPortCtrl = new wxSpinCtrl(
+      panel, wxID_ANY, wxEmptyString, wxDefaultPosition, wxDefaultSize,
+      wxSP_ARROW_KEYS, 1, 65535, m_protocols.input.port);
+  sourceSizer->Add(m_inputPortCtrl, 0, wxALIGN_CENTER_VERTICAL);
+  inputSizer->Add(sourceSizer, 0, wxEXPAND | wxLEFT | wxRIGHT | wxBOTTOM, 5);
+
+  mainSizer->Add(inputSizer, 0, wxEXPAND | wxALL, 5);
+
   // Add format choice
   wxStaticBox* formatBox =
       new wxStaticBox(panel, wxID_ANY, _("Recording Format"));
@@ -253,6 +323,70 @@ wxPanel* VDRPrefsDialog::CreateRecordingTab(wxWindow* parent) {
   autoSizer->Add(delaySizer, 0, wxLEFT | wxRIGHT | wxBOTTOM, 5);
   mainSizer->Add(autoSizer, 0, wxEXPAND | wxALL, 5);
 
+  // In-memory buffer section
+  wxStaticBox* timeShiftBox =
+      new wxStaticBox(panel, wxID_ANY, _("Instant Replay"));
+  wxStaticBoxSizer* timeShiftSizer =
+      new wxStaticBoxSizer(timeShiftBox, wxVERTICAL);
+
+  m_timeShiftCheck =
+      new wxCheckBox(panel, ID_TIMESHIFT_CHECK,
+                     _("Keep recent data in memory for instant replay"));
+  m_timeShiftCheck->SetValue(m_timeshift.enabled);
+  timeShiftSizer->Add(m_timeShiftCheck, 0, wxALL, 5);
+
+  wxBoxSizer* horizonSizer = new wxBoxSizer(wxHORIZONTAL);
+  horizonSizer->Add(new wxStaticText(panel, wxID_ANY, _("Keep the last")), 0,
+                    wxALIGN_CENTER_VERTICAL | wxRIGHT, 5);
+  m_timeShiftMinutesCtrl = new wxSpinCtrl(
+      panel, wxID_ANY, wxEmptyString, wxDefaultPosition, wxDefaultSize,
+      wxSP_ARROW_KEYS, 1, 240, m_timeshift.minutes);
+  horizonSizer->Add(m_timeShiftMinutesCtrl, 0,
+                    wxALIGN_CENTER_VERTICAL | wxRIGHT, 5);
+  horizonSizer->Add(new wxStaticText(panel, wxID_ANY, _("minutes, up to")), 0,
+                    wxALIGN_CENTER_VERTICAL | wxRIGHT, 5);
+  m_timeShiftMaxMBCtrl = new wxSpinCtrl(
+      panel, wxID_ANY, wxEmptyString, wxDefaultPosition, wxDefaultSize,
+      wxSP_ARROW_KEYS, 1, 1024, m_timeshift.maxMegabytes);
+  horizonSizer->Add(m_timeShiftMaxMBCtrl, 0,
+                    wxALIGN_CENTER_VERTICAL | wxRIGHT, 5);
+  horizonSizer->Add(new wxStaticText(panel, wxID_ANY, _("MB")), 0,
+                    wxALIGN_CENTER_VERTICAL);
+  timeShiftSizer->Add(horizonSizer, 0, wxLEFT | wxRIGHT | wxBOTTOM, 5);
+  mainSizer->Add(timeShiftSizer, 0, wxEXPAND | wxALL, 5);
+
+  // Black box section
+  wxStaticBox* blackBoxBox = new wxStaticBox(panel, wxID_ANY, _("Black Box"));
+  wxStaticBoxSizer* blackBoxSizer =
+      new wxStaticBoxSizer(blackBoxBox, wxVERTICAL);
+
+  m_blackBoxCheck = new wxCheckBox(
+      panel, ID_BLACKBOX_CHECK,
+      _("Only write to disk when triggered (record button, MOB, speed)"));
+  m_blackBoxCheck->SetValue(m_blackbox.enabled);
+  blackBoxSizer->Add(m_blackBoxCheck, 0, wxALL, 5);
+
+  wxBoxSizer* triggerSizer = new wxBoxSizer(wxHORIZONTAL);
+  triggerSizer->Add(new wxStaticText(panel, wxID_ANY, _("Write the last")), 0,
+                    wxALIGN_CENTER_VERTICAL | wxRIGHT, 5);
+  m_blackBoxPreTriggerCtrl = new wxSpinCtrl(
+      panel, wxID_ANY, wxEmptyString, wxDefaultPosition, wxDefaultSize,
+      wxSP_ARROW_KEYS, 1, 240, m_blackbox.preTriggerMinutes);
+  triggerSizer->Add(m_blackBoxPreTriggerCtrl, 0,
+                    wxALIGN_CENTER_VERTICAL | wxRIGHT, 5);
+  triggerSizer->Add(
+      new wxStaticText(panel, wxID_ANY, _("minutes and record for")), 0,
+      wxALIGN_CENTER_VERTICAL | wxRIGHT, 5);
+  m_blackBoxPostTriggerCtrl = new wxSpinCtrl(
+      panel, wxID_ANY, wxEmptyString, wxDefaultPosition, wxDefaultSize,
+      wxSP_ARROW_KEYS, 1, 240, m_blackbox.postTriggerMinutes);
+  triggerSizer->Add(m_blackBoxPostTriggerCtrl, 0,
+                    wxALIGN_CENTER_VERTICAL | wxRIGHT, 5);
+  triggerSizer->Add(new wxStaticText(panel, wxID_ANY, _("minutes")), 0,
+                    wxALIGN_CENTER_VERTICAL);
+  blackBoxSizer->Add(triggerSizer, 0, wxLEFT | wxRIGHT | wxBOTTOM, 5);
+  mainSizer->Add(blackBoxSizer, 0, wxEXPAND | wxALL, 5);
+
   panel->SetSizer(mainSizer);
   return panel;
 }
@@ -283,6 +417,25 @@ wxPanel* VDRPrefsDialog::CreateReplayTab(wxWindow* parent) {
   nmea0183Sizer->Add(m_nmea0183NetworkRadio, 0, wxALL, 5);
   mainSizer->Add(nmea0183Sizer, 0, wxEXPAND | wxALL, 5);
 
+  // Playback file options
+  wxStaticBox* fileBox = new wxStaticBox(panel, wxID_ANY, _("Playback File"));
+  wxStaticBoxSizer* fileSizer = new wxStaticBoxSizer(fileBox, wxVERTICAL);
+  m_followModeCheck = new wxCheckBox(
+      panel, wxID_ANY, _("Follow file while it is being recorded"));
+  m_followModeCheck->SetValue(m_follow_mode);
+  m_followModeCheck->SetToolTip(
+      _("Keep playing data appended to the file by another recorder instead "
+        "of stopping at the end of the file"));
+  fileSizer->Add(m_followModeCheck, 0, wxALL, 5);
+  m_skipCorruptCheck = new wxCheckBox(
+      panel, wxID_ANY, _("Skip sentences with an invalid checksum"));
+  m_skipCorruptCheck->SetValue(m_skip_corrupt);
+  m_skipCorruptCheck->SetToolTip(
+      _("Do not replay NMEA 0183 and AIS sentences whose checksum does not "
+        "match their content"));
+  fileSizer->Add(m_skipCorruptCheck, 0, wxALL, 5);
+  mainSizer->Add(fileSizer, 0, wxEXPAND | wxALL, 5);
+
   // Network settings
 
   // Add network panels for each protocol
@@ -297,11 +450,28 @@ wxPanel* VDRPrefsDialog::CreateReplayTab(wxWindow* parent) {
       new ConnectionSettingsPanel(panel, _("NMEA 2000"), m_protocols.n2kNet);
   mainSizer->Add(m_nmea2000NetPanel, 0, wxEXPAND | wxALL, 5);
 
-#if 0  // Signal K support disabled for now
+  // NMEA 2000 output format, in the order of N2KNetworkFormat.
+  wxBoxSizer* n2kFormatSizer = new wxBoxSizer(wxHORIZONTAL);
+  n2kFormatSizer->Add(
+      new wxStaticText(panel, wxID_ANY, _("NMEA 2000 network format:")), 0,
+      wxALIGN_CENTER_VERTICAL | wxRIGHT, 5);
+  wxArrayString n2kFormats;
+  n2kFormats.Add(_("SeaSmart text ($PCDIN)"));
+  n2kFormats.Add(_("Actisense N2K binary"));
+  n2kFormats.Add(_("YD RAW"));
+  m_n2kNetFormatChoice = new wxChoice(panel, wxID_ANY, wxDefaultPosition,
+                                      wxDefaultSize, n2kFormats);
+  m_n2kNetFormatChoice->SetSelection(
+      static_cast<int>(m_protocols.n2kNetFormat));
+  m_n2kNetFormatChoice->SetToolTip(
+      _("Format of the recorded NMEA 2000 messages sent over the network"));
+  n2kFormatSizer->Add(m_n2kNetFormatChoice, 0, wxALIGN_CENTER_VERTICAL);
+  mainSizer->Add(n2kFormatSizer, 0, wxALL, 10);
+
+  // Recorded Signal K values are replayed as a stream of deltas.
   m_signalKNetPanel = new ConnectionSettingsPanel(panel, _("Signal K"),
-                                              m_protocols.signalKNet);
+                                                  m_protocols.signalKNet);
   mainSizer->Add(m_signalKNetPanel, 0, wxEXPAND | wxALL, 5);
-#endif
 
   panel->SetSizer(mainSizer);
 
@@ -317,23 +487,38 @@ void VDRPrefsDialog::OnOK(wxCommandEvent& event) {
   m_use_speed_threshold = m_useSpeedThresholdCheck->GetValue();
   m_speed_threshold = m_speedThresholdCtrl->GetValue();
   m_stop_delay = m_stopDelayCtrl->GetValue();
+  m_timeshift.enabled = m_timeShiftCheck->GetValue();
+  m_timeshift.minutes = m_timeShiftMinutesCtrl->GetValue();
+  m_timeshift.maxMegabytes = m_timeShiftMaxMBCtrl->GetValue();
+  m_blackbox.enabled = m_blackBoxCheck->GetValue();
+  m_blackbox.preTriggerMinutes = m_blackBoxPreTriggerCtrl->GetValue();
+  m_blackbox.postTriggerMinutes = m_blackBoxPostTriggerCtrl->GetValue();
 
   // Protocol settings
   m_protocols.nmea0183 = m_nmea0183Check->GetValue();
   m_protocols.nmea2000 = m_nmea2000Check->GetValue();
-#if 0
   m_protocols.signalK = m_signalKCheck->GetValue();
-#endif
+  m_protocols.signalKHeartbeatSec = m_signalKHeartbeatCtrl->GetValue();
+
+  // Network input
+  m_protocols.input.enabled = m_inputCheck->GetValue();
+  m_protocols.input.useTCP = m_inputProtocolChoice->GetSelection() != 1;
+  m_protocols.input.host = m_inputHostCtrl->GetValue().Trim().Trim(false);
+  m_protocols.input.port = m_inputPortCtrl->GetValue();
 
   // Network settings
   m_protocols.nmea0183Net = m_nmea0183NetPanel->GetSettings();
   m_protocols.n2kNet = m_nmea2000NetPanel->GetSettings();
-#if 0
+  if (m_n2kNetFormatChoice->GetSelection() != wxNOT_FOUND) {
+    m_protocols.n2kNetFormat =
+        static_cast<N2KNetworkFormat>(m_n2kNetFormatChoice->GetSelection());
+  }
   m_protocols.signalKNet = m_signalKNetPanel->GetSettings();
-#endif
   m_protocols.nmea0183ReplayMode = m_nmea0183InternalRadio->GetValue()
                                        ? NMEA0183ReplayMode::INTERNAL_API
                                        : NMEA0183ReplayMode::NETWORK;
+  m_follow_mode = m_followModeCheck->GetValue();
+  m_skip_corrupt = m_skipCorruptCheck->GetValue();
 
   event.Skip();
 }
@@ -361,6 +546,14 @@ void VDRPrefsDialog::OnUseSpeedThresholdCheck(wxCommandEvent& event) {
   UpdateControlStates();
 }
 
+void VDRPrefsDialog::OnTimeShiftCheck(wxCommandEvent& event) {
+  UpdateControlStates();
+}
+
+void VDRPrefsDialog::OnBlackBoxCheck(wxCommandEvent& event) {
+  UpdateControlStates();
+}
+
 void VDRPrefsDialog::OnNMEA0183ReplayModeChanged(wxCommandEvent& event) {
   m_nmea0183NetPanel->Enable(event.GetId() == ID_NMEA0183_NETWORK_RADIO);
 }
\ No newline at end of file
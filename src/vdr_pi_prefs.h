@@ -58,13 +58,19 @@ public:
    * @param useSpeedThreshold Enable speed-based recording control
    * @param speedThreshold Speed threshold in knots
    * @param stopDelay Minutes to wait before stopping
+   * @param timeShift In-memory buffer settings
+   * @param blackBox Black box recording settings
+   * @param followMode Follow playback files while they are being written
+   * @param skipCorrupt Skip sentences with a bad checksum during playback
    * @param protocols Active protocol settings
    */
   VDRPrefsDialog(wxWindow* parent, wxWindowID id, VDRDataFormat format,
                  const wxString& recordingDir, bool logRotate,
                  int logRotateInterval, bool autoStartRecording,
                  bool useSpeedThreshold, double speedThreshold, int stopDelay,
-                 const VDRProtocolSettings& protocols);
+                 const VDRTimeShiftSettings& timeShift,
+                 const VDRBlackBoxSettings& blackBox, bool followMode,
+                 bool skipCorrupt, const VDRProtocolSettings& protocols);
 
   /** Get selected data format setting. */
   VDRDataFormat GetDataFormat() const { return m_format; }
@@ -90,6 +96,18 @@ public:
   /** Get recording stop delay in minutes. */
   int GetStopDelay() const { return m_stop_delay; }
 
+  /** Get in-memory buffer settings. */
+  VDRTimeShiftSettings GetTimeShiftSettings() const { return m_timeshift; }
+
+  /** Get black box recording settings. */
+  VDRBlackBoxSettings GetBlackBoxSettings() const { return m_blackbox; }
+
+  /** Check if playback files are followed while they are being written. */
+  bool GetFollowMode() const { return m_follow_mode; }
+
+  /** Check if sentences with a bad checksum are skipped during playback. */
+  bool GetSkipCorruptSentences() const { return m_skip_corrupt; }
+
   /** Get protocol recording settings. */
   VDRProtocolSettings GetProtocolSettings() const { return m_protocols; }
 
@@ -109,6 +127,12 @@ private:
   /** Handle speed threshold checkbox changes. */
   void OnUseSpeedThresholdCheck(wxCommandEvent& event);
 
+  /** Handle in-memory buffer checkbox changes. */
+  void OnTimeShiftCheck(wxCommandEvent& event);
+
+  /** Handle black box checkbox changes. */
+  void OnBlackBoxCheck(wxCommandEvent& event);
+
   /** Handle protocol checkbox changes. */
   void OnProtocolCheck(wxCommandEvent& event);
 
@@ -140,24 +164,42 @@ private:
   wxSpinCtrlDouble* m_speedThresholdCtrl;  //!< Speed threshold value
   wxSpinCtrl* m_stopDelayCtrl;             //!< Minutes before stop
 
+  // In-memory buffer settings
+  wxCheckBox* m_timeShiftCheck;        //!< Keep recent messages in memory
+  wxSpinCtrl* m_timeShiftMinutesCtrl;  //!< Buffer time horizon
+  wxSpinCtrl* m_timeShiftMaxMBCtrl;    //!< Buffer memory cap
+
+  // Black box settings
+  wxCheckBox* m_blackBoxCheck;           //!< Only write to disk on trigger
+  wxSpinCtrl* m_blackBoxPreTriggerCtrl;  //!< Minutes before trigger
+  wxSpinCtrl* m_blackBoxPostTriggerCtrl;  //!< Minutes after trigger
+
   // Protocol selection
-  wxCheckBox* m_nmea0183Check;  //!< Enable NMEA 0183 recording
-  wxCheckBox* m_nmea2000Check;  //!< Enable NMEA 2000 recording
-#if 0
-   wxCheckBox* m_signalKCheck;      //!< Enable Signal K recording
-#endif
+  wxCheckBox* m_nmea0183Check;         //!< Enable NMEA 0183 recording
+  wxCheckBox* m_nmea2000Check;         //!< Enable NMEA 2000 recording
+  wxCheckBox* m_signalKCheck;          //!< Enable Signal K recording
+  wxSpinCtrl* m_signalKHeartbeatCtrl;  //!< Seconds between unchanged values
+
+  // Network input
+  wxCheckBox* m_inputCheck;         //!< Record a network source
+  wxChoice* m_inputProtocolChoice;  //!< TCP or UDP
+  wxTextCtrl* m_inputHostCtrl;      //!< TCP server host
+  wxSpinCtrl* m_inputPortCtrl;      //!< Port of the network source
 
   // Replay tab controls
   // NMEA 0183 replay mode
   wxRadioButton* m_nmea0183NetworkRadio;
   wxRadioButton* m_nmea0183InternalRadio;
 
+  // Playback file
+  wxCheckBox* m_followModeCheck;   //!< Follow file while it is being written
+  wxCheckBox* m_skipCorruptCheck;  //!< Skip sentences with a bad checksum
+
   // Network selection
   ConnectionSettingsPanel* m_nmea0183NetPanel;
   ConnectionSettingsPanel* m_nmea2000NetPanel;
-#if 0
+  wxChoice* m_n2kNetFormatChoice;  //!< NMEA 2000 network output format
   ConnectionSettingsPanel* m_signalKNetPanel;
-#endif
 
   VDRDataFormat m_format;       //!< Selected data format
   wxString m_recording_dir;     //!< Selected recording directory
@@ -167,6 +209,10 @@ private:
   bool m_use_speed_threshold;   //!< Speed threshold enabled
   double m_speed_threshold;     //!< Speed threshold in knots
   int m_stop_delay;             //!< Minutes before stopping
+  VDRTimeShiftSettings m_timeshift;  //!< In-memory buffer settings
+  VDRBlackBoxSettings m_blackbox;    //!< Black box recording settings
+  bool m_follow_mode;                //!< Follow playback file being written
+  bool m_skip_corrupt;               //!< Skip sentences with a bad checksum
 
   VDRProtocolSettings m_protocols;  //!< Protocol selection settings
 
@@ -62,6 +62,58 @@ ConnectionSettingsPanel::ConnectionSettingsPanel(
   portSizer->Add(m_portCtrl, 0, wxALIGN_CENTER_VERTICAL);
   sizer->Add(portSizer, 0, wxALL, 5);
 
+  // UDP destinations, in the order of VDRUdpMode.
+  wxFlexGridSizer* udpSizer = new wxFlexGridSizer(2, 5, 5);
+  udpSizer->AddGrowableCol(1);
+  udpSizer->Add(new wxStaticText(this, wxID_ANY, _("UDP Destination:")), 0,
+                wxALIGN_CENTER_VERTICAL);
+  wxArrayString modes;
+  modes.Add(_("Localhost"));
+  modes.Add(_("Unicast"));
+  modes.Add(_("Broadcast"));
+  modes.Add(_("Multicast"));
+  m_udpModeChoice =
+      new wxChoice(this, wxID_ANY, wxDefaultPosition, wxDefaultSize, modes);
+  m_udpModeChoice->SetSelection(static_cast<int>(settings.udp.mode));
+  udpSizer->Add(m_udpModeChoice, 0, wxALIGN_CENTER_VERTICAL);
+
+  udpSizer->Add(new wxStaticText(this, wxID_ANY, _("Addresses:")), 0,
+                wxALIGN_CENTER_VERTICAL);
+  m_addressCtrl = new wxTextCtrl(this, wxID_ANY, settings.udp.addresses);
+  m_addressCtrl->SetToolTip(
+      _("Unicast: hosts separated by commas, each with an optional :port\n"
+        "Broadcast: broadcast address, 255.255.255.255 if empty\n"
+        "Multicast: group address, e.g. 239.192.0.1"));
+  udpSizer->Add(m_addressCtrl, 1, wxEXPAND);
+
+  udpSizer->Add(new wxStaticText(this, wxID_ANY, _("Multicast TTL:")), 0,
+                wxALIGN_CENTER_VERTICAL);
+  m_ttlCtrl = new wxSpinCtrl(this, wxID_ANY, wxEmptyString, wxDefaultPosition,
+                             wxDefaultSize, wxSP_ARROW_KEYS, 1, 255,
+                             settings.udp.multicastTtl);
+  udpSizer->Add(m_ttlCtrl, 0, wxALIGN_CENTER_VERTICAL);
+  sizer->Add(udpSizer, 0, wxALL | wxEXPAND, 5);
+
+  // Messages sent, TCP clients can also subscribe on their own.
+  wxBoxSizer* filterSizer = new wxBoxSizer(wxHORIZONTAL);
+  filterSizer->Add(new wxStaticText(this, wxID_ANY, _("Filter:")), 0,
+                   wxALIGN_CENTER_VERTICAL | wxRIGHT, 5);
+  m_filterCtrl = new wxTextCtrl(this, wxID_ANY, settings.filter);
+  m_filterCtrl->SetToolTip(
+      _("Messages sent, all if empty. Sentences such as GPRMC, ??GGA or "
+        "AI*, and NMEA 2000 PGNs such as 129025, separated by commas.\n"
+        "TCP clients can send \"SUBSCRIBE <patterns>\" to choose their "
+        "own."));
+  filterSizer->Add(m_filterCtrl, 1, wxEXPAND);
+  sizer->Add(filterSizer, 0, wxALL | wxEXPAND, 5);
+
+  m_tcpRadio->Bind(wxEVT_RADIOBUTTON,
+                   &ConnectionSettingsPanel::OnProtocolChange, this);
+  m_udpRadio->Bind(wxEVT_RADIOBUTTON,
+                   &ConnectionSettingsPanel::OnProtocolChange, this);
+  m_udpModeChoice->Bind(wxEVT_CHOICE,
+                        &ConnectionSettingsPanel::OnProtocolChange, this);
+
   SetSizer(sizer);
   UpdateControlStates();
 }
@@ -71,6 +123,11 @@ ConnectionSettings ConnectionSettingsPanel::GetSettings() const {
   settings.enabled = m_enableCheck->GetValue();
   settings.useTCP = m_tcpRadio->GetValue();
   settings.port = m_portCtrl->GetValue();
+  settings.udp.mode =
+      static_cast<VDRUdpMode>(std::max(m_udpModeChoice->GetSelection(), 0));
+  settings.udp.addresses = m_addressCtrl->GetValue().Strip(wxString::both);
+  settings.udp.multicastTtl = m_ttlCtrl->GetValue();
+  settings.filter = m_filterCtrl->GetValue().Strip(wxString::both);
   return settings;
 }
 
@@ -79,6 +136,10 @@ void ConnectionSettingsPanel::SetSettings(const ConnectionSettings& settings) {
   m_tcpRadio->SetValue(settings.useTCP);
   m_udpRadio->SetValue(!settings.useTCP);
   m_portCtrl->SetValue(settings.port);
+  m_udpModeChoice->SetSelection(static_cast<int>(settings.udp.mode));
+  m_addressCtrl->SetValue(settings.udp.addresses);
+  m_ttlCtrl->SetValue(settings.udp.multicastTtl);
+  m_filterCtrl->SetValue(settings.filter);
   UpdateControlStates();
 }
 
@@ -86,9 +147,22 @@ void ConnectionSettingsPanel::OnEnableNetwork(wxCommandEvent& event) {
   UpdateControlStates();
 }
 
+void ConnectionSettingsPanel::OnProtocolChange(wxCommandEvent& event) {
+  UpdateControlStates();
+}
+
 void ConnectionSettingsPanel::UpdateControlStates() {
   bool enabled = m_enableCheck->GetValue();
   m_tcpRadio->Enable(enabled);
   m_udpRadio->Enable(enabled);
   m_portCtrl->Enable(enabled);
+  m_filterCtrl->Enable(enabled);
+
+  // The destinations only apply to UDP, the TTL only to multicast.
+  bool udp = enabled && m_udpRadio->GetValue();
+  int mode = m_udpModeChoice->GetSelection();
+  m_udpModeChoice->Enable(udp);
+  m_addressCtrl->Enable(
+      udp && mode != static_cast<int>(VDRUdpMode::LOCALHOST));
+  m_ttlCtrl->Enable(udp && mode == static_cast<int>(VDRUdpMode::MULTICAST));
 }
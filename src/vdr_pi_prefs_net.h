@@ -53,6 +53,9 @@ private:
   /** Handle network enable checkbox */
   void OnEnableNetwork(wxCommandEvent& event);
 
+  /** Handle protocol or UDP destination change */
+  void OnProtocolChange(wxCommandEvent& event);
+
   /** Update enabled state of controls */
   void UpdateControlStates();
 
@@ -60,6 +63,10 @@ private:
   wxRadioButton* m_tcpRadio;  //!< Use TCP protocol
   wxRadioButton* m_udpRadio;  //!< Use UDP protocol
   wxSpinCtrl* m_portCtrl;     //!< Port number control
+  wxChoice* m_udpModeChoice;  //!< Kind of UDP destination
+  wxTextCtrl* m_addressCtrl;  //!< UDP destination addresses
+  wxSpinCtrl* m_ttlCtrl;      //!< Multicast time to live
+  wxTextCtrl* m_filterCtrl;   //!< Patterns of the messages sent
 
   DECLARE_EVENT_TABLE()
 };
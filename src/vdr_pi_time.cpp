@@ -26,8 +26,213 @@
 #include "wx/tokenzr.h"
 
 #include <time.h>
+#include <algorithm>
+#include <limits>
+#include <string>
 
 #include "vdr_pi_time.h"
+#include "vdr_csv.h"
+
+namespace {
+
+typedef wxStringCharType CharT;
+
+/** Characters of a sentence, not null-terminated. */
+struct CharSpan {
+  const CharT* data;
+  size_t length;
+};
+
+inline bool IsDigit(CharT c) { return c >= '0' && c <= '9'; }
+
+/**
+ * Iterate over the fields of a NMEA 0183 sentence.
+ *
+ * Fields are separated by ',' or '*'. Like wxStringTokenizer, empty fields
+ * are returned except at the end of the sentence.
+ */
+class FieldScanner {
+public:
+  FieldScanner(const CharT* begin, const CharT* end)
+      : m_pos(begin), m_end(end) {}
+
+  bool HasMoreFields() const {
+    for (const CharT* p = m_pos; p < m_end; ++p) {
+      if (*p != ',' && *p != '*') return true;
+    }
+    return false;
+  }
+
+  CharSpan NextField() {
+    const CharT* begin = m_pos;
+    while (m_pos < m_end && *m_pos != ',' && *m_pos != '*') ++m_pos;
+    CharSpan field{begin, static_cast<size_t>(m_pos - begin)};
+    if (m_pos < m_end) ++m_pos;
+    return field;
+  }
+
+private:
+  const CharT* m_pos;
+  const CharT* m_end;
+};
+
+bool SpanEquals(const CharT* data, size_t length, const char* text) {
+  size_t i = 0;
+  for (; i < length; i++) {
+    if (text[i] == '\0' || data[i] != static_cast<CharT>(text[i])) {
+      return false;
+    }
+  }
+  return text[i] == '\0';
+}
+
+/** Parse count digits, return false if one of them is not a digit. */
+bool ParseDigits(const CharT* data, size_t count, int64_t& value) {
+  value = 0;
+  for (size_t i = 0; i < count; i++) {
+    if (!IsDigit(data[i])) return false;
+    value = value * 10 + (data[i] - '0');
+  }
+  return true;
+}
+
+inline int ParseTwoDigits(const CharT* data) {
+  return (data[0] - '0') * 10 + (data[1] - '0');
+}
+
+/**
+ * Parse a numeric field like wxAtoi() does.
+ *
+ * @return False if the field contains anything else than digits.
+ */
+bool ParseIntField(const CharT* data, size_t length, int& value) {
+  // Longer fields may overflow, let wxAtoi() handle them.
+  int64_t digits;
+  if (length > 9 || !ParseDigits(data, length, digits)) return false;
+  value = static_cast<int>(digits);
+  return true;
+}
+
+/** Number of days from 1970-01-01 to a date of the proleptic Gregorian
+ * calendar. */
+inline int64_t DaysFromCivil(int year, int month, int day) {
+  year -= month <= 2;
+  const int era = (year >= 0 ? year : year - 399) / 400;
+  const int yoe = year - era * 400;
+  const int doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+  const int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return static_cast<int64_t>(era) * 146097 + doe - 719468;
+}
+
+int DaysInMonth(int year, int month) {
+  static const int days[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+  bool leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+  return month == 2 && leap ? 29 : days[month - 1];
+}
+
+/**
+ * Key of the time source of a sentence, with the identifier split like
+ * ParseTimestampWx() does.
+ */
+uint64_t GetSourceKey(const CharT* sentence, size_t length, int precision) {
+  FieldScanner fields(sentence, sentence + length);
+  CharSpan id = fields.NextField();
+  size_t talkerLength = id.length < 3 ? id.length - 1 : 2;
+  return TimeSource::MakeKey(id.data + 1, talkerLength,
+                             id.data + 1 + talkerLength,
+                             id.length - 1 - talkerLength, precision);
+}
+
+/** Milliseconds since epoch of a date and time of day. */
+inline int64_t ToEpochMs(int year, int month, int day, int msOfDay) {
+  return DaysFromCivil(year, month, day) * 86400000 + msOfDay;
+}
+
+/**
+ * Decode the UTC date and time of an AIS base station report (message 4).
+ *
+ * @param payload Six-bit armored payload (field 5 of a VDM/VDO sentence).
+ * @param length Number of characters of the payload.
+ * @param info Output date and time, not validated.
+ * @return False if the payload is not a base station report or the time is
+ * not available.
+ */
+bool DecodeAISBaseStationTime(const CharT* payload, size_t length,
+                              NMEATimeInfo& info) {
+  // The first 78 bits (13 characters) hold the type, repeat indicator, MMSI,
+  // date and time.
+  if (length < 13) return false;
+  int values[13];
+  for (size_t i = 0; i < 13; i++) {
+    int value = static_cast<int>(payload[i]) - 48;
+    if (value < 0 || value > 71 || (value > 39 && value < 48)) return false;
+    if (value > 40) value -= 8;
+    values[i] = value;
+  }
+  // The type is in the first character.
+  if (values[0] != 4) return false;
+  // Bits 36 to 77, from character 6, hold the date and time.
+  uint64_t bits = 0;
+  for (size_t i = 6; i < 13; i++) {
+    bits = (bits << 6) | static_cast<uint64_t>(values[i]);
+  }
+  auto field = [bits](int start, int width) {
+    return static_cast<int>((bits >> (78 - start - width)) &
+                            ((1u << width) - 1));
+  };
+  info.tm.tm_year = field(38, 14) - 1900;
+  info.tm.tm_mon = field(52, 4);
+  info.tm.tm_mday = field(56, 5);
+  info.tm.tm_hour = field(61, 5);
+  info.tm.tm_min = field(66, 6);
+  info.tm.tm_sec = field(72, 6);
+  info.millisecond = 0;
+  // Hour 24, minute 60 and second 60 mean not available.
+  if (info.tm.tm_hour > 23 || info.tm.tm_min > 59 || info.tm.tm_sec > 59) {
+    return false;
+  }
+  info.hasTime = true;
+  return true;
+}
+
+/**
+ * Parse a timestamp in the YYYY-MM-DDThh:mm:ssZ or YYYY-MM-DDThh:mm:ss.sssZ
+ * layout.
+ *
+ * @param text Characters of the timestamp, not necessarily null-terminated.
+ * @param length Number of characters.
+ * @return False if the text has another layout or an invalid date or time.
+ */
+bool ParseIso8601Fast(const CharT* text, size_t length, int64_t& epochMs) {
+  if ((length != 20 && length != 24) || text[length - 1] != 'Z') return false;
+  if (text[4] != '-' || text[7] != '-' || text[10] != 'T' || text[13] != ':' ||
+      text[16] != ':') {
+    return false;
+  }
+  int64_t year, month, day, hour, minute, second, millisecond = 0;
+  if (!ParseDigits(text, 4, year) || !ParseDigits(text + 5, 2, month) ||
+      !ParseDigits(text + 8, 2, day) || !ParseDigits(text + 11, 2, hour) ||
+      !ParseDigits(text + 14, 2, minute) ||
+      !ParseDigits(text + 17, 2, second)) {
+    return false;
+  }
+  if (length == 24 &&
+      (text[19] != '.' || !ParseDigits(text + 20, 3, millisecond))) {
+    return false;
+  }
+  if (year < 1 || month < 1 || month > 12 || day < 1 ||
+      day > DaysInMonth(static_cast<int>(year), static_cast<int>(month)) ||
+      hour > 23 || minute > 59 || second > 59) {
+    return false;
+  }
+  int64_t days = DaysFromCivil(static_cast<int>(year), static_cast<int>(month),
+                               static_cast<int>(day));
+  epochMs = ((days * 24 + hour) * 60 + minute) * 60000 + second * 1000 +
+            millisecond;
+  return true;
+}
+
+}  // namespace
 
 bool TimestampParser::ParseTimeField(const wxString& timeStr,
                                      NMEATimeInfo& info, int& precision) const {
@@ -109,6 +314,20 @@ void TimestampParser::ApplyCachedDate(NMEATimeInfo& info) const {
 
 bool TimestampParser::ParseIso8601Timestamp(const wxString& timeStr,
                                             wxDateTime* timestamp) const {
+  const CharT* text = timeStr.wx_str();
+  int64_t epochMs;
+  if (ParseIso8601Fast(text, std::char_traits<CharT>::length(text), epochMs)) {
+    *timestamp = wxDateTime(wxLongLong(epochMs));
+    // Same adjustment as the reference implementation.
+    timestamp->MakeUTC();
+    return true;
+  }
+  // Other layouts, time zone offsets and invalid values.
+  return ParseIso8601TimestampWx(timeStr, timestamp);
+}
+
+bool TimestampParser::ParseIso8601TimestampWx(const wxString& timeStr,
+                                              wxDateTime* timestamp) const {
   // Expected format: YYYY-MM-DDThh:mm:ss.sssZ
 
   // Parse the main date/time part using ISO format
@@ -124,8 +343,268 @@ bool TimestampParser::ParseIso8601Timestamp(const wxString& timeStr,
 
 bool TimestampParser::ParseTimestamp(const wxString& sentence,
                                      wxDateTime& timestamp, int& precision) {
+  const CharT* text = sentence.wx_str();
+  FastTimestamp fast;
+  switch (ParseTimestampFast(text, std::char_traits<CharT>::length(text),
+                             fast)) {
+    case FastParseResult::OK:
+      precision = fast.precision;
+      timestamp = wxDateTime(wxLongLong(
+          ToEpochMs(fast.year, fast.month, fast.day, fast.msOfDay)));
+      // Same adjustment as the reference implementation.
+      timestamp.MakeUTC();
+      return true;
+    case FastParseResult::INVALID:
+      return false;
+    case FastParseResult::UNSUPPORTED:
+    default:
+      return ParseTimestampWx(sentence, timestamp, precision);
+  }
+}
+
+size_t TimestampParser::ParseTimestamps(const wxStringCharType* buffer,
+                                        size_t length, TimestampBatch& batch) {
+  const CharT* end = buffer + length;
+  size_t count = std::count(buffer, end, '\n');
+  if (length > 0 && buffer[length - 1] != '\n') count++;
+  batch.epochMs.resize(count);
+  batch.precision.resize(count);
+  batch.sourceKey.resize(count);
+  batch.valid.resize(count);
+  batch.m_year.resize(count);
+  batch.m_month.resize(count);
+  batch.m_day.resize(count);
+  batch.m_msOfDay.resize(count);
+  batch.m_fallback.clear();
+
+  // Scan the sentences in order, the date of RMC and ZDA sentences is used
+  // for the following sentences that only have a time.
+  const CharT* line = buffer;
+  for (size_t i = 0; i < count; i++) {
+    const CharT* next = std::find(line, end, '\n');
+    size_t lineLength = next - line;
+    if (lineLength > 0 && line[lineLength - 1] == '\r') lineLength--;
+    FastTimestamp fast;
+    FastParseResult result = ParseTimestampFast(line, lineLength, fast);
+    if (result == FastParseResult::UNSUPPORTED) {
+      wxDateTime timestamp;
+      int precision;
+      if (ParseTimestampWx(wxString(line, lineLength), timestamp, precision)) {
+        batch.m_fallback.emplace_back(i, timestamp.GetValue().GetValue());
+        fast.precision = precision;
+        fast.sourceKey = GetSourceKey(line, lineLength, precision);
+        result = FastParseResult::OK;
+      } else {
+        result = FastParseResult::INVALID;
+      }
+      // The time of the line is replaced after the loop below.
+      fast.year = 1970;
+      fast.month = 1;
+      fast.day = 1;
+      fast.msOfDay = 0;
+    }
+    if (result == FastParseResult::OK) {
+      batch.m_year[i] = fast.year;
+      batch.m_month[i] = fast.month;
+      batch.m_day[i] = fast.day;
+      batch.m_msOfDay[i] = fast.msOfDay;
+      batch.precision[i] = static_cast<int8_t>(fast.precision);
+      batch.sourceKey[i] = fast.sourceKey;
+      batch.valid[i] = 1;
+    } else {
+      batch.m_year[i] = 1970;
+      batch.m_month[i] = 1;
+      batch.m_day[i] = 1;
+      batch.m_msOfDay[i] = 0;
+      batch.precision[i] = 0;
+      batch.sourceKey[i] = 0;
+      batch.valid[i] = 0;
+    }
+    if (next != end) line = next + 1;
+  }
+
+  // Lines do not depend on each other here.
+  const int32_t* year = batch.m_year.data();
+  const int32_t* month = batch.m_month.data();
+  const int32_t* day = batch.m_day.data();
+  const int32_t* msOfDay = batch.m_msOfDay.data();
+  int64_t* epochMs = batch.epochMs.data();
+  for (size_t i = 0; i < count; i++) {
+    epochMs[i] = ToEpochMs(year[i], month[i], day[i], msOfDay[i]);
+  }
+
+  // Same adjustment as ParseTimestamp(). It depends on daylight saving time,
+  // which only changes on quarter hours.
+  const int64_t QUARTER_HOUR_MS = 15 * 60 * 1000;
+  int64_t quarter = std::numeric_limits<int64_t>::min();
+  int64_t offset = 0;
+  for (size_t i = 0; i < count; i++) {
+    if (!batch.valid[i]) continue;
+    int64_t q = epochMs[i] / QUARTER_HOUR_MS;
+    if (epochMs[i] % QUARTER_HOUR_MS < 0) q--;
+    if (q != quarter) {
+      quarter = q;
+      int64_t start = q * QUARTER_HOUR_MS;
+      offset =
+          wxDateTime(wxLongLong(start)).MakeUTC().GetValue().GetValue() - start;
+    }
+    epochMs[i] += offset;
+  }
+  for (const auto& fallback : batch.m_fallback) {
+    epochMs[fallback.first] = fallback.second;
+  }
+  return count;
+}
+
+TimestampParser::FastParseResult TimestampParser::ParseTimestampFast(
+    const wxStringCharType* sentence, size_t length, FastTimestamp& out) {
+  if (length == 0 || (sentence[0] != '$' && sentence[0] != '!')) {
+    return FastParseResult::INVALID;
+  }
+  FieldScanner fields(sentence, sentence + length);
+  int precision = 0;
+
+  // Sentence identifier, e.g. "$GPRMC" or "!AIVDM".
+  CharSpan id = fields.NextField();
+  size_t talkerLength = id.length < 3 ? id.length - 1 : 2;
+  const CharT* type = id.data + 1 + talkerLength;
+  size_t typeLength = id.length - 1 - talkerLength;
+  if (m_useOnlyPrimarySource &&
+      TimeSource::MakeKey(id.data + 1, talkerLength, type, typeLength, 0) !=
+          m_primarySource.GetIdKey()) {
+    return FastParseResult::INVALID;
+  }
+
+  // Parse a HHMMSS or HHMMSS.sss time field, like ParseTimeField().
+  NMEATimeInfo timeInfo;
+  auto parseTime = [&](const CharSpan& field) {
+    if (field.length < 6) return FastParseResult::INVALID;
+    int64_t hhmmss;
+    if (!ParseDigits(field.data, 6, hhmmss)) {
+      return FastParseResult::UNSUPPORTED;
+    }
+    timeInfo.tm.tm_hour = static_cast<int>(hhmmss / 10000);
+    timeInfo.tm.tm_min = static_cast<int>(hhmmss / 100 % 100);
+    timeInfo.tm.tm_sec = static_cast<int>(hhmmss % 100);
+    timeInfo.millisecond = 0;
+    precision = 0;
+    if (field.length > 7) {
+      if (field.data[6] != '.') return FastParseResult::INVALID;
+      // Up to 15 digits, the division gives the same double as parsing
+      // "0.<digits>" with wxAtof().
+      size_t digits = field.length - 7;
+      int64_t subseconds;
+      if (digits > 15 || !ParseDigits(field.data + 7, digits, subseconds)) {
+        return FastParseResult::UNSUPPORTED;
+      }
+      precision = static_cast<int>(digits);
+      double scale = 1.0;
+      for (size_t i = 0; i < digits; i++) scale *= 10.0;
+      timeInfo.millisecond =
+          static_cast<int>(static_cast<double>(subseconds) / scale * 1000);
+    }
+    if (timeInfo.tm.tm_hour > 23 || timeInfo.tm.tm_min > 59 ||
+        timeInfo.tm.tm_sec > 59 || timeInfo.millisecond >= 1000) {
+      return FastParseResult::INVALID;
+    }
+    timeInfo.hasTime = true;
+    return FastParseResult::OK;
+  };
+  auto skipFields = [&](int count) {
+    for (int i = 0; i < count && fields.HasMoreFields(); i++) {
+      fields.NextField();
+    }
+  };
+
+  uint32_t sentenceId = PackSentenceId(type, typeLength);
+  const SentenceTimeFields* layout = FindSentenceTimeFields(sentenceId);
+  if (sentence[0] == '!') {
+    // AIS base station report.
+    if (sentenceId != PackSentenceId("VDM", 3) &&
+        sentenceId != PackSentenceId("VDO", 3)) {
+      return FastParseResult::INVALID;
+    }
+    // Single fragment message, payload in field 5.
+    if (!fields.HasMoreFields()) return FastParseResult::INVALID;
+    CharSpan fragments = fields.NextField();
+    if (!SpanEquals(fragments.data, fragments.length, "1")) {
+      return FastParseResult::INVALID;
+    }
+    skipFields(3);
+    if (!fields.HasMoreFields()) return FastParseResult::INVALID;
+    CharSpan payload = fields.NextField();
+    if (!DecodeAISBaseStationTime(payload.data, payload.length, timeInfo) ||
+        !ValidateAndSetDate(timeInfo)) {
+      return FastParseResult::INVALID;
+    }
+  } else if (layout) {
+    skipFields(layout->timeField - 1);
+    if (!fields.HasMoreFields()) return FastParseResult::INVALID;
+    FastParseResult result = parseTime(fields.NextField());
+    if (result != FastParseResult::OK) return result;
+    skipFields(layout->dateField - layout->timeField - 1);
+    if (layout->date == SentenceDate::DDMMYY) {
+      if (!fields.HasMoreFields()) return FastParseResult::INVALID;
+      CharSpan date = fields.NextField();
+      if (date.length < 6) return FastParseResult::INVALID;
+      int64_t ddmmyy;
+      if (!ParseDigits(date.data, 6, ddmmyy)) {
+        return FastParseResult::UNSUPPORTED;
+      }
+      timeInfo.tm.tm_mday = ParseTwoDigits(date.data);
+      timeInfo.tm.tm_mon = ParseTwoDigits(date.data + 2);
+      int twoDigitYear = ParseTwoDigits(date.data + 4);
+      timeInfo.tm.tm_year =
+          (twoDigitYear >= 70 ? 1900 : 2000) + twoDigitYear - 1900;
+      if (!ValidateAndSetDate(timeInfo)) return FastParseResult::INVALID;
+    } else if (layout->date == SentenceDate::DAY_MONTH_YEAR) {
+      int* components[] = {&timeInfo.tm.tm_mday, &timeInfo.tm.tm_mon,
+                           &timeInfo.tm.tm_year};
+      for (int* component : components) {
+        if (!fields.HasMoreFields()) return FastParseResult::INVALID;
+        CharSpan field = fields.NextField();
+        if (!ParseIntField(field.data, field.length, *component)) {
+          return FastParseResult::UNSUPPORTED;
+        }
+      }
+      timeInfo.tm.tm_year -= 1900;
+      if (!ValidateAndSetDate(timeInfo)) return FastParseResult::INVALID;
+    } else {
+      ApplyCachedDate(timeInfo);
+    }
+  } else {
+    return FastParseResult::INVALID;
+  }
+  if (m_useOnlyPrimarySource && precision != m_primarySource.GetPrecision()) {
+    return FastParseResult::INVALID;
+  }
+  if (!timeInfo.IsComplete()) return FastParseResult::INVALID;
+
+  int year = timeInfo.tm.tm_year + 1900;
+  if (year > 9999) {
+    // Years with more than 4 digits are left to wxDateTime.
+    return FastParseResult::UNSUPPORTED;
+  }
+  if (timeInfo.tm.tm_mday > DaysInMonth(year, timeInfo.tm.tm_mon)) {
+    return FastParseResult::INVALID;
+  }
+  out.year = year;
+  out.month = timeInfo.tm.tm_mon;
+  out.day = timeInfo.tm.tm_mday;
+  int seconds = (timeInfo.tm.tm_hour * 60 + timeInfo.tm.tm_min) * 60 +
+                timeInfo.tm.tm_sec;
+  out.msOfDay = seconds * 1000 + timeInfo.millisecond;
+  out.precision = precision;
+  out.sourceKey = TimeSource::MakeKey(id.data + 1, talkerLength, type,
+                                      typeLength, precision);
+  return FastParseResult::OK;
+}
+
+bool TimestampParser::ParseTimestampWx(const wxString& sentence,
+                                       wxDateTime& timestamp,
+                                       int& precision) {
   // Check for valid NMEA sentence
-  if (sentence.IsEmpty() || sentence[0] != '$') {
+  if (sentence.IsEmpty() || (sentence[0] != '$' && sentence[0] != '!')) {
     return false;
   }
 
@@ -137,66 +616,69 @@ bool TimestampParser::ParseTimestamp(const wxString& sentence,
   wxString talkerId = sentenceId.Mid(1, 2);
   wxString sentenceType = sentenceId.Mid(3);
 
-  if (m_useOnlyPrimarySource && (m_primarySource.talkerId != talkerId ||
-                                 m_primarySource.sentenceId != sentenceType)) {
+  if (m_useOnlyPrimarySource &&
+      TimeSource(talkerId, sentenceType, 0).GetIdKey() !=
+          m_primarySource.GetIdKey()) {
     return false;
   }
   NMEATimeInfo timeInfo;
 
   // Handle different sentence types
-  if (sentenceType == "RMC") {  // GPRMC, GNRMC, etc
+  const SentenceTimeFields* layout = FindSentenceTimeFields(
+      PackSentenceId(sentenceType.wx_str(), sentenceType.length()));
+  if (sentence[0] == '!') {
+    // AIS base station report, e.g.
+    // !AIVDM,1,1,,A,402R361uur9F;0mgM0Q;B`100000,0*4E
+    if (sentenceType != "VDM" && sentenceType != "VDO") return false;
+    if (!tok.HasMoreTokens() || tok.GetNextToken() != "1") return false;
+    // Skip fragment number, message id and channel.
+    for (int i = 0; i < 3 && tok.HasMoreTokens(); i++) {
+      tok.GetNextToken();
+    }
+    if (!tok.HasMoreTokens()) return false;
+    wxString payload = tok.GetNextToken();
+    precision = 0;
+    if (!DecodeAISBaseStationTime(payload.wx_str(), payload.length(),
+                                  timeInfo) ||
+        !ValidateAndSetDate(timeInfo)) {
+      return false;
+    }
+  } else if (layout) {
     // Example:
     // $GPRMC,092211.00,A,5759.09700,N,01144.34344,E,5.257,28.27,200715,,,A*58
-    // Time field
-    if (!tok.HasMoreTokens()) return false;
-    wxString timeStr = tok.GetNextToken();
-    if (!ParseTimeField(timeStr, timeInfo, precision)) return false;
-    // Skip to date field (field 9)
-    for (int i = 0; i < 7 && tok.HasMoreTokens(); i++) {
+    for (int i = 1; i < layout->timeField && tok.HasMoreTokens(); i++) {
       tok.GetNextToken();
     }
-
-    // Parse date
-    if (!tok.HasMoreTokens()) return false;
-    wxString dateStr = tok.GetNextToken();
-    if (!ParseRMCDate(dateStr, timeInfo)) return false;
-  } else if (sentenceType == "ZDA") {  // GPZDA, GNZDA, etc
-    // Parse time
     if (!tok.HasMoreTokens()) return false;
     wxString timeStr = tok.GetNextToken();
     if (!ParseTimeField(timeStr, timeInfo, precision)) return false;
-
-    // Parse date components
-    if (!tok.HasMoreTokens()) return false;
-    timeInfo.tm.tm_mday = wxAtoi(tok.GetNextToken());
-    if (!tok.HasMoreTokens()) return false;
-    timeInfo.tm.tm_mon = wxAtoi(tok.GetNextToken());
-    if (!tok.HasMoreTokens()) return false;
-    // ZDA uses 4-digit year, tm_year is years since 1900.
-    timeInfo.tm.tm_year = wxAtoi(tok.GetNextToken()) - 1900;
-
-    if (!ValidateAndSetDate(timeInfo)) return false;
-  } else if (sentenceType == "GLL") {
-    // For GLL, time is in field 5
-    for (int i = 0; i < 4 && tok.HasMoreTokens(); i++) {
-      tok.GetNextToken();  // Skip lat/lon fields
+    // Skip to the date field
+    for (int i = layout->timeField + 1;
+         i < layout->dateField && tok.HasMoreTokens(); i++) {
+      tok.GetNextToken();
     }
-    if (!tok.HasMoreTokens()) return false;
-    wxString timeStr = tok.GetNextToken();
-    if (!ParseTimeField(timeStr, timeInfo, precision)) return false;
-
-    // Try to use cached date information
-    ApplyCachedDate(timeInfo);
-  } else if (sentenceType == "GGA" || sentenceType == "GBS") {
-    // These sentences have time in field 1
-    if (!tok.HasMoreTokens()) return false;
-    wxString timeStr = tok.GetNextToken();
-    if (!ParseTimeField(timeStr, timeInfo, precision)) return false;
 
-    // Try to use cached date information
-    ApplyCachedDate(timeInfo);
+    if (layout->date == SentenceDate::DDMMYY) {
+      if (!tok.HasMoreTokens()) return false;
+      wxString dateStr = tok.GetNextToken();
+      if (!ParseRMCDate(dateStr, timeInfo)) return false;
+    } else if (layout->date == SentenceDate::DAY_MONTH_YEAR) {
+      // Parse date components
+      if (!tok.HasMoreTokens()) return false;
+      timeInfo.tm.tm_mday = wxAtoi(tok.GetNextToken());
+      if (!tok.HasMoreTokens()) return false;
+      timeInfo.tm.tm_mon = wxAtoi(tok.GetNextToken());
+      if (!tok.HasMoreTokens()) return false;
+      // 4-digit year, tm_year is years since 1900.
+      timeInfo.tm.tm_year = wxAtoi(tok.GetNextToken()) - 1900;
+
+      if (!ValidateAndSetDate(timeInfo)) return false;
+    } else {
+      // Try to use cached date information
+      ApplyCachedDate(timeInfo);
+    }
   }
-  if (m_useOnlyPrimarySource && precision != m_primarySource.precision) {
+  if (m_useOnlyPrimarySource && precision != m_primarySource.GetPrecision()) {
     return false;
   }
 
@@ -217,11 +699,15 @@ bool TimestampParser::ParseTimestamp(const wxString& sentence,
   return true;
 }
 
+void TimestampParser::SetPrimaryTimeSource(const TimeSource& source) {
+  m_primarySource = source;
+  m_useOnlyPrimarySource = true;
+}
+
 void TimestampParser::SetPrimaryTimeSource(const wxString& talkerId,
                                            const wxString& msgType,
                                            int precision) {
-  m_primarySource = TimeSource{talkerId, msgType, precision};
-  m_useOnlyPrimarySource = true;
+  SetPrimaryTimeSource(TimeSource(talkerId, msgType, precision));
 }
 
 void TimestampParser::DisablePrimaryTimeSource() {
@@ -240,49 +726,34 @@ bool TimestampParser::ParseCSVLineTimestamp(const wxString& line,
                                             unsigned int message_idx,
                                             wxString* message,
                                             wxDateTime* timestamp) {
-  wxArrayString fields;
-  wxString currentField;
-  bool inQuotes = false;
-
-  for (size_t i = 0; i < line.Length(); i++) {
-    wxChar ch = line[i];
-
-    if (ch == '"') {
-      if (inQuotes && i + 1 < line.Length() && line[i + 1] == '"') {
-        // Double quotes inside quoted field = escaped quote
-        currentField += '"';
-        i++;  // Skip next quote
-      } else {
-        // Toggle quote state
-        inQuotes = !inQuotes;
-      }
-    } else if (ch == ',' && !inQuotes) {
-      // End of field
-      fields.Add(currentField);
-      currentField.Clear();
-    } else {
-      currentField += ch;
-    }
-  }
-
-  // Add the last field
-  fields.Add(currentField);
+  // Only the message and timestamp fields are extracted.
+  const unsigned int columns[] = {message_idx, timestamp_idx};
+  CSVFieldView fields[2];
+  size_t count =
+      timestamp && timestamp_idx != static_cast<unsigned int>(-1) ? 2 : 1;
+  const CharT* text = line.wx_str();
+  ProjectCSVFields(text, std::char_traits<CharT>::length(text), columns,
+                   fields, count);
 
   // Parse timestamp if requested and available
-  if (timestamp && timestamp_idx != static_cast<unsigned int>(-1) &&
-      timestamp_idx < fields.GetCount()) {
-    if (!ParseIso8601Timestamp(fields[timestamp_idx], timestamp)) {
+  const CSVFieldView& timeField = fields[1];
+  if (timeField.IsFound()) {
+    int64_t epochMs;
+    if (!timeField.IsEscaped() &&
+        ParseIso8601Fast(timeField.GetData(), timeField.GetLength(),
+                         epochMs)) {
+      *timestamp = wxDateTime(wxLongLong(epochMs));
+      // Same adjustment as the reference implementation.
+      timestamp->MakeUTC();
+    } else if (!ParseIso8601TimestampWx(timeField.ToString(), timestamp)) {
       return false;
     }
   }
 
   // Get message field
-  if (message_idx == static_cast<unsigned int>(-1) ||
-      message_idx >= fields.GetCount()) {
+  if (!fields[0].IsFound()) {
     return false;
   }
-
-  // No need to unescape quotes here as we handled them during parsing
-  *message = fields[message_idx];
+  *message = fields[0].ToString();
   return true;
 }
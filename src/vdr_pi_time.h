@@ -26,8 +26,12 @@
 #endif
 
 #include <wx/datetime.h>
+#include <cstdint>
+#include <limits>
 #include <unordered_map>
 #include <functional>
+#include <utility>
+#include <vector>
 
 struct NMEATimeInfo {
   bool hasDate;  // Whether date information is available
@@ -40,21 +44,184 @@ struct NMEATimeInfo {
   bool IsComplete() const { return hasDate && hasTime; }
 };
 
+/**
+ * Point on the playback timeline, in milliseconds since the Unix epoch (UTC).
+ *
+ * Playback scheduling works on this plain integer, wxDateTime is only
+ * produced where a time is shown to the user.
+ */
+typedef int64_t VDRTimeMs;
+
+/** Timeline value that has not been set, same as an invalid wxDateTime. */
+constexpr VDRTimeMs INVALID_TIME_MS = std::numeric_limits<int64_t>::min();
+
+/** Convert a wxDateTime to a timeline value. */
+inline VDRTimeMs ToTimeMs(const wxDateTime& timestamp) {
+  return timestamp.IsValid() ? timestamp.GetValue().GetValue()
+                             : INVALID_TIME_MS;
+}
+
+/** Convert a timeline value to a wxDateTime, invalid if not set. */
+inline wxDateTime FromTimeMs(VDRTimeMs timeMs) {
+  return timeMs == INVALID_TIME_MS ? wxDateTime()
+                                   : wxDateTime(wxLongLong(timeMs));
+}
+
 /**
  * Represents a unique source of time information from NMEA sentences or CSV
  * entry. This is used to track the time source for each NMEA sentence type.
+ *
+ * The talker id (GP, GN...), sentence id (RMC, ZDA...) and millisecond
+ * precision (0, 1, 2, or 3 digits) are packed in a 64-bit key, so comparing
+ * and hashing sources are integer operations:
+ *
+ *   bits 0-7: precision, bits 8-23: talker id, bits 24-63: sentence id
+ *
+ * One byte is kept per character, talker ids are truncated to 2 characters
+ * and sentence ids to 5 characters. Sentences carrying a timestamp have
+ * 3-character ids.
  */
 struct TimeSource {
-  wxString talkerId;    // GP, GN, etc.
-  wxString sentenceId;  // RMC, ZDA, etc.
-  int precision;        // Millisecond precision (0, 1, 2, or 3 digits)
+  uint64_t key;
+
+  TimeSource() : key(0) {}
+  TimeSource(const wxString& talkerId, const wxString& sentenceId,
+             int precision)
+      : key(MakeKey(talkerId.wx_str(), talkerId.length(),
+                    sentenceId.wx_str(), sentenceId.length(), precision)) {}
+
+  /** Pack the characters of the ids and the precision in a key. */
+  template <typename CharT>
+  static uint64_t MakeKey(const CharT* talkerId, size_t talkerLength,
+                          const CharT* sentenceId, size_t sentenceLength,
+                          int precision) {
+    uint64_t key = static_cast<uint8_t>(precision);
+    for (size_t i = 0; i < talkerLength && i < 2; i++) {
+      key |= static_cast<uint64_t>(static_cast<uint8_t>(talkerId[i]))
+             << (8 + 8 * i);
+    }
+    for (size_t i = 0; i < sentenceLength && i < 5; i++) {
+      key |= static_cast<uint64_t>(static_cast<uint8_t>(sentenceId[i]))
+             << (24 + 8 * i);
+    }
+    return key;
+  }
+
+  /** Key of the talker and sentence ids, without the precision. */
+  uint64_t GetIdKey() const { return key & ~static_cast<uint64_t>(0xFF); }
+
+  int GetPrecision() const { return static_cast<int>(key & 0xFF); }
+  wxString GetTalkerId() const { return UnpackChars(8, 2); }
+  wxString GetSentenceId() const { return UnpackChars(24, 5); }
+
+  bool operator==(const TimeSource& other) const { return key == other.key; }
 
-  bool operator==(const TimeSource& other) const {
-    return talkerId == other.talkerId && sentenceId == other.sentenceId &&
-           precision == other.precision;
+private:
+  wxString UnpackChars(int shift, int count) const {
+    wxString text;
+    for (int i = 0; i < count; i++) {
+      char c = static_cast<char>((key >> (shift + 8 * i)) & 0xFF);
+      if (c == '\0') break;
+      text += c;
+    }
+    return text;
   }
 };
 
+/**
+ * Pack a 3-character NMEA 0183 sentence identifier ("RMC"...) into an integer.
+ *
+ * @return 0 if the identifier does not have 3 ASCII characters.
+ */
+template <typename CharT>
+constexpr uint32_t PackSentenceId(const CharT* id, size_t length) {
+  if (length != 3) return 0;
+  uint32_t packed = 0;
+  for (size_t i = 0; i < 3; i++) {
+    // Negative characters become large values.
+    uint32_t c = static_cast<uint32_t>(id[i]);
+    if (c == 0 || c > 127) return 0;
+    packed = (packed << 8) | c;
+  }
+  return packed;
+}
+
+/** Layout of the date in a sentence. */
+enum class SentenceDate {
+  NONE,            //!< No date, the date of a previous sentence is used.
+  DDMMYY,          //!< One field, e.g. RMC.
+  DAY_MONTH_YEAR,  //!< Three fields with a 4-digit year, e.g. ZDA.
+};
+
+/** Position of the time and date fields of a sentence type. */
+struct SentenceTimeFields {
+  uint32_t sentenceId;  //!< See PackSentenceId().
+  /** Index of the hhmmss[.sss] field, 1 is the first field after the id. */
+  int timeField;
+  SentenceDate date;
+  /** Index of the (first) date field, after the time field. */
+  int dateField;
+};
+
+/** NMEA 0183 sentence types carrying a UTC time. */
+constexpr SentenceTimeFields SENTENCE_TIME_FIELDS[] = {
+    {PackSentenceId("RMC", 3), 1, SentenceDate::DDMMYY, 9},
+    {PackSentenceId("ZDA", 3), 1, SentenceDate::DAY_MONTH_YEAR, 2},
+    {PackSentenceId("GGA", 3), 1, SentenceDate::NONE, 0},
+    {PackSentenceId("GLL", 3), 5, SentenceDate::NONE, 0},
+    {PackSentenceId("GBS", 3), 1, SentenceDate::NONE, 0},
+    {PackSentenceId("GNS", 3), 1, SentenceDate::NONE, 0},
+    {PackSentenceId("GST", 3), 1, SentenceDate::NONE, 0},
+    {PackSentenceId("GRS", 3), 1, SentenceDate::NONE, 0},
+};
+
+/**
+ * Find the time and date fields of a sentence type.
+ *
+ * @param sentenceId Packed sentence identifier, see PackSentenceId().
+ * @return nullptr if the sentence type carries no time.
+ */
+constexpr const SentenceTimeFields* FindSentenceTimeFields(
+    uint32_t sentenceId) {
+  for (const auto& fields : SENTENCE_TIME_FIELDS) {
+    if (sentenceId != 0 && fields.sentenceId == sentenceId) return &fields;
+  }
+  return nullptr;
+}
+
+/**
+ * Timestamps of a batch of sentences, one entry per line in parallel arrays.
+ */
+class TimestampBatch {
+public:
+  /**
+   * Time in milliseconds since epoch, the value of the wxDateTime returned by
+   * TimestampParser::ParseTimestamp(). Undefined when not valid.
+   */
+  std::vector<int64_t> epochMs;
+  /** Millisecond precision (0, 1, 2, or 3 digits). */
+  std::vector<int8_t> precision;
+  /** TimeSource key of the sentence, 0 when not valid. */
+  std::vector<uint64_t> sourceKey;
+  /** 1 if the line has a timestamp that was successfully parsed. */
+  std::vector<uint8_t> valid;
+
+  /** Get the number of lines in the batch. */
+  size_t GetCount() const { return valid.size(); }
+
+private:
+  friend class TimestampParser;
+
+  // Date and time of day of each line, combined into epochMs in a single
+  // loop once all the lines are parsed.
+  std::vector<int32_t> m_year;
+  std::vector<int32_t> m_month;
+  std::vector<int32_t> m_day;
+  std::vector<int32_t> m_msOfDay;
+  /** Lines parsed by ParseTimestampWx(), with their time. */
+  std::vector<std::pair<size_t, int64_t>> m_fallback;
+};
+
 /**
  * Parses NMEA 0183 timestamps from various sentence types.
  */
@@ -68,6 +235,10 @@ public:
    * This method supports parsing timestamps from RMC, ZDA, and other sentence
    * types.
    *
+   * The characters of the sentence are scanned once and the time is computed
+   * arithmetically, without temporary strings. Unusual field contents are
+   * handed over to ParseTimestampWx(), which gives the same results.
+   *
    * @param sentence NMEA 0183 sentence to parse.
    * @param timestamp Output timestamp.
    * @param precision Output millisecond precision.
@@ -77,9 +248,39 @@ public:
   bool ParseTimestamp(const wxString& sentence, wxDateTime& timestamp,
                       int& precision);
 
+  /**
+   * Parse the timestamps of a buffer of sentences.
+   *
+   * Gives the same results as calling ParseTimestamp() for each line in turn,
+   * including the date cached from previous lines. The sentences are scanned
+   * first, then the times of all lines are computed in a single loop over the
+   * date and time arrays, which the compiler can vectorize.
+   *
+   * @param buffer Sentences separated by '\n', a '\r' before it is ignored.
+   * @param length Number of characters in the buffer.
+   * @param batch Output timestamps, one entry per line. An empty last line
+   * is not counted.
+   * @return Number of lines in the batch.
+   */
+  size_t ParseTimestamps(const wxStringCharType* buffer, size_t length,
+                         TimestampBatch& batch);
+
+  /**
+   * Parse a timestamp from a NMEA 0183 sentence using wxWidgets string
+   * functions.
+   *
+   * Reference implementation of ParseTimestamp(), used for field contents the
+   * fast parser does not handle.
+   */
+  bool ParseTimestampWx(const wxString& sentence, wxDateTime& timestamp,
+                        int& precision);
+
   /**
    * Parse a timestamp from an ISO 8601 formatted string in UTC format.
    *
+   * The YYYY-MM-DDThh:mm:ss[.sss]Z layout written by the plugin is parsed
+   * directly, other strings are handed over to ParseIso8601TimestampWx().
+   *
    * @param timeStr ISO 8601 timestamp string.
    * @param timestamp Output timestamp in UTC.
    * @return True if the timestamp was successfully parsed.
@@ -87,6 +288,16 @@ public:
   bool ParseIso8601Timestamp(const wxString& timeStr,
                              wxDateTime* timestamp) const;
 
+  /**
+   * Parse a timestamp from an ISO 8601 formatted string using
+   * wxDateTime::ParseFormat().
+   *
+   * Reference implementation of ParseIso8601Timestamp(), which also accepts
+   * time zone offsets.
+   */
+  bool ParseIso8601TimestampWx(const wxString& timeStr,
+                               wxDateTime* timestamp) const;
+
   // Reset the cached date state
   void Reset();
 
@@ -94,6 +305,8 @@ public:
   bool ParseTimeField(const wxString& timeStr, NMEATimeInfo& info,
                       int& precision) const;
 
+  /** Set the desired primary time source. */
+  void SetPrimaryTimeSource(const TimeSource& source);
   /** Set the desired primary time source. */
   void SetPrimaryTimeSource(const wxString& talkerId, const wxString& msgType,
                             int precision);
@@ -104,6 +317,9 @@ public:
   /**
    * Parse a timestamp from a CSV line.
    *
+   * Only the timestamp and message fields are extracted, see
+   * ProjectCSVFields().
+   *
    * @param line CSV line to parse.
    * @param timestamp_idx Index of the timestamp field.
    * @param message_idx Index of the message field.
@@ -137,30 +353,57 @@ private:
 
   // Applies cached date if available
   void ApplyCachedDate(NMEATimeInfo& info) const;
+
+  /** Outcome of the fast timestamp parser. */
+  enum class FastParseResult {
+    OK,          //!< Timestamp parsed
+    INVALID,     //!< Sentence has no valid timestamp
+    UNSUPPORTED  //!< Field contents require ParseTimestampWx()
+  };
+
+  /** Date, time of day and source of a sentence. */
+  struct FastTimestamp {
+    int year;
+    int month;
+    int day;
+    int msOfDay;
+    int precision;
+    uint64_t sourceKey;
+  };
+
+  /**
+   * Parse a timestamp by scanning the characters of a sentence once.
+   *
+   * @param sentence Sentence in the wxString storage format, not necessarily
+   * null-terminated.
+   * @param length Number of characters of the sentence.
+   * @param out Output date and time (UTC), precision and time source.
+   */
+  FastParseResult ParseTimestampFast(const wxStringCharType* sentence,
+                                     size_t length, FastTimestamp& out);
 };
 
 /**
  * Represents the details of a time source, including start and end times.
  */
 struct TimeSourceDetails {
-  wxDateTime startTime;
-  wxDateTime currentTime;
-  wxDateTime endTime;
+  VDRTimeMs startTime;
+  VDRTimeMs currentTime;
+  VDRTimeMs endTime;
   /** Whether the time source is chronological or not. */
   bool isChronological;
 
-  TimeSourceDetails() : isChronological(true) {}
+  TimeSourceDetails()
+      : startTime(INVALID_TIME_MS),
+        currentTime(INVALID_TIME_MS),
+        endTime(INVALID_TIME_MS),
+        isChronological(true) {}
 };
 
 /** Custom hash function for TimeSource to use in unordered_map. */
 struct TimeSourceHash {
   size_t operator()(const TimeSource& ts) const {
-    std::string talkerId(ts.talkerId.ToStdString());
-    std::string sentenceId(ts.sentenceId.ToStdString());
-    size_t h1 = std::hash<std::string>{}(talkerId);
-    size_t h2 = std::hash<std::string>{}(sentenceId);
-    size_t h3 = std::hash<int>{}(ts.precision);
-    return h1 ^ (h2 << 1) ^ (h3 << 2);
+    return std::hash<uint64_t>{}(ts.key);
   }
 };
 
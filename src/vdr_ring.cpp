@@ -0,0 +1,121 @@
+/***************************************************************************
+ *   Copyright (C) 2024 by OpenCPN development team                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ **************************************************************************/
+
+#include "vdr_ring.h"
+
+#include <iterator>
+
+VDRMessageRing::VDRMessageRing()
+    : m_bytes(0),
+      m_maxBytes(32 * 1024 * 1024),
+      m_horizonMs(10 * 60 * 1000),
+      m_sequence(0) {}
+
+void VDRMessageRing::SetLimits(size_t maxBytes, int64_t horizonMs) {
+  m_maxBytes = maxBytes;
+  m_horizonMs = horizonMs;
+  Trim();
+}
+
+void VDRMessageRing::Add(int64_t timeMs, const std::string& message) {
+  size_t size = message.size() + MESSAGE_OVERHEAD;
+  if (size > m_maxBytes) return;
+  m_messages.push_back({++m_sequence, timeMs, message});
+  m_bytes += size;
+  Trim();
+}
+
+void VDRMessageRing::Clear() {
+  m_messages.clear();
+  m_bytes = 0;
+}
+
+void VDRMessageRing::Trim() {
+  if (m_messages.empty()) return;
+  int64_t oldest = m_messages.back().timeMs - m_horizonMs;
+  while (!m_messages.empty() &&
+         (m_bytes > m_maxBytes || m_messages.front().timeMs < oldest)) {
+    m_bytes -= m_messages.front().message.size() + MESSAGE_OVERHEAD;
+    m_messages.pop_front();
+  }
+}
+
+std::vector<RingMessage> VDRMessageRing::GetMessagesSince(
+    int64_t timeMs) const {
+  // Reception times may go backwards if the system clock is adjusted, so
+  // the buffer is scanned from the newest message.
+  auto first = m_messages.end();
+  while (first != m_messages.begin() && std::prev(first)->timeMs >= timeMs) {
+    --first;
+  }
+  return std::vector<RingMessage>(first, m_messages.end());
+}
+
+std::vector<RingMessage> VDRMessageRing::GetMessagesAfter(
+    uint64_t sequence) const {
+  if (m_messages.empty() || sequence >= m_sequence) {
+    return std::vector<RingMessage>();
+  }
+  // Sequence numbers are contiguous.
+  uint64_t oldest = m_messages.front().sequence;
+  size_t skip =
+      sequence < oldest ? 0 : static_cast<size_t>(sequence - oldest + 1);
+  return std::vector<RingMessage>(m_messages.begin() + skip, m_messages.end());
+}
+
+VDREchoFilter::VDREchoFilter(int64_t lifetimeMs)
+    : m_lifetimeMs(lifetimeMs), m_firstSequence(0) {}
+
+void VDREchoFilter::Add(int64_t timeMs, const std::string& message) {
+  Expire(timeMs);
+  m_pending[message].push_back(m_firstSequence + m_sent.size());
+  m_sent.push_back({timeMs, message, false});
+}
+
+bool VDREchoFilter::Consume(int64_t timeMs, const std::string& message) {
+  Expire(timeMs);
+  auto it = m_pending.find(message);
+  if (it == m_pending.end()) return false;
+  // Echoes come back in order, the oldest copy is the one received. It is
+  // marked so that it is not counted down again when it expires.
+  m_sent[it->second.front() - m_firstSequence].consumed = true;
+  it->second.pop_front();
+  if (it->second.empty()) m_pending.erase(it);
+  return true;
+}
+
+void VDREchoFilter::Clear() {
+  m_firstSequence += m_sent.size();
+  m_sent.clear();
+  m_pending.clear();
+}
+
+void VDREchoFilter::Expire(int64_t timeMs) {
+  while (!m_sent.empty() && m_sent.front().timeMs < timeMs - m_lifetimeMs) {
+    const SentMessage& sent = m_sent.front();
+    if (!sent.consumed) {
+      // The oldest copy of the message, it never came back.
+      auto it = m_pending.find(sent.message);
+      it->second.pop_front();
+      if (it->second.empty()) m_pending.erase(it);
+    }
+    m_sent.pop_front();
+    m_firstSequence++;
+  }
+}
@@ -0,0 +1,163 @@
+/***************************************************************************
+ *   Copyright (C) 2024 by OpenCPN development team                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ **************************************************************************/
+
+#ifndef _VDR_RING_H_
+#define _VDR_RING_H_
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Message kept in the in-memory buffer.
+ */
+struct RingMessage {
+  uint64_t sequence;  //!< Position of the message, starting at 1.
+  int64_t timeMs;     //!< Reception time in milliseconds since epoch (UTC).
+  /**
+   * NMEA 0183 or AIS sentence without line terminator, or NMEA 2000 message
+   * in the "$PCDIN,<pgn>,<payload>" recording format.
+   */
+  std::string message;
+};
+
+/**
+ * Bounded in-memory buffer of the most recently received messages.
+ *
+ * Messages older than the time horizon are discarded, as are the oldest
+ * messages when the memory used by the buffer exceeds its cap.
+ */
+class VDRMessageRing {
+public:
+  /** Estimated memory used by a message in addition to its text. */
+  static const size_t MESSAGE_OVERHEAD = sizeof(RingMessage) + 16;
+
+  VDRMessageRing();
+
+  /**
+   * Set the limits of the buffer, discarding messages if needed.
+   *
+   * @param maxBytes Maximum memory used by the messages.
+   * @param horizonMs Maximum age of a message relative to the newest one.
+   */
+  void SetLimits(size_t maxBytes, int64_t horizonMs);
+
+  /** Get the maximum memory used by the messages. */
+  size_t GetMaxBytes() const { return m_maxBytes; }
+
+  /** Get the maximum age of messages in milliseconds. */
+  int64_t GetHorizon() const { return m_horizonMs; }
+
+  /**
+   * Add a message to the buffer.
+   *
+   * @param timeMs Reception time in milliseconds since epoch.
+   * @param message Message to add.
+   */
+  void Add(int64_t timeMs, const std::string& message);
+
+  /** Remove all messages. */
+  void Clear();
+
+  /** Get the number of messages in the buffer. */
+  size_t GetCount() const { return m_messages.size(); }
+
+  /** Get the estimated memory used by the messages. */
+  size_t GetBytes() const { return m_bytes; }
+
+  /** Get the sequence number of the newest message, 0 if none was added. */
+  uint64_t GetLastSequence() const { return m_sequence; }
+
+  /**
+   * Get a copy of the messages received at or after a given time.
+   *
+   * @param timeMs Time in milliseconds since epoch.
+   */
+  std::vector<RingMessage> GetMessagesSince(int64_t timeMs) const;
+
+  /**
+   * Get a copy of the messages added after a given message.
+   *
+   * @param sequence Sequence number of the last message not to return.
+   */
+  std::vector<RingMessage> GetMessagesAfter(uint64_t sequence) const;
+
+private:
+  /** Discard messages exceeding the limits of the buffer. */
+  void Trim();
+
+  std::deque<RingMessage> m_messages;
+  size_t m_bytes;
+  size_t m_maxBytes;
+  int64_t m_horizonMs;
+  uint64_t m_sequence;
+};
+
+/**
+ * Recognize messages that come back from OpenCPN after the plugin sent them.
+ *
+ * Sentences sent with PushNMEABuffer() are delivered again to the plugin by
+ * OpenCPN. When replaying while recording, they must not be recorded a second
+ * time.
+ */
+class VDREchoFilter {
+public:
+  /**
+   * @param lifetimeMs Time after which a sent message that has not come back
+   * is forgotten.
+   */
+  explicit VDREchoFilter(int64_t lifetimeMs = 5000);
+
+  /** Remember a message sent at the given time. */
+  void Add(int64_t timeMs, const std::string& message);
+
+  /**
+   * Check whether a received message is the echo of a sent message.
+   *
+   * @return True if the message was sent recently. The message is forgotten.
+   */
+  bool Consume(int64_t timeMs, const std::string& message);
+
+  /** Forget all sent messages. */
+  void Clear();
+
+  /** Check if no sent message is waiting to come back. */
+  bool IsEmpty() const { return m_pending.empty(); }
+
+private:
+  void Expire(int64_t timeMs);
+
+  /** A sent message. */
+  struct SentMessage {
+    int64_t timeMs;
+    std::string message;
+    bool consumed;  //!< Its echo was received
+  };
+
+  int64_t m_lifetimeMs;
+  std::deque<SentMessage> m_sent;
+  /** Sequence number of the first message of m_sent. */
+  uint64_t m_firstSequence;
+  /** Sequence numbers of the copies of each message not received yet. */
+  std::unordered_map<std::string, std::deque<uint64_t>> m_pending;
+};
+
+#endif  // _VDR_RING_H_
@@ -0,0 +1,523 @@
+/***************************************************************************
+ *   Copyright (C) 2024 by OpenCPN development team                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ **************************************************************************/
+
+#include "vdr_signalk.h"
+
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <utility>
+
+const char SIGNALK_RECORD_PREFIX[] = "$PVDSK,";
+
+namespace {
+
+/** Deepest nesting of the JSON values accepted. */
+const int MAX_JSON_DEPTH = 32;
+
+/** Minimal JSON reader, for the structure of the Signal K deltas. */
+class JsonReader {
+public:
+  explicit JsonReader(const std::string& json) : m_json(json), m_pos(0) {}
+
+  /** Return the next character after whitespace, 0 at the end. */
+  char Peek() {
+    while (m_pos < m_json.size() &&
+           (m_json[m_pos] == ' ' || m_json[m_pos] == '\t' ||
+            m_json[m_pos] == '\r' || m_json[m_pos] == '\n')) {
+      m_pos++;
+    }
+    return m_pos < m_json.size() ? m_json[m_pos] : 0;
+  }
+
+  /** Skip the next character if it is c. */
+  bool Consume(char c) {
+    if (Peek() != c) return false;
+    m_pos++;
+    return true;
+  }
+
+  /** Read a string. Escapes are decoded, except \u sequences. */
+  bool ReadString(std::string* text) {
+    if (!Consume('"')) return false;
+    text->clear();
+    while (m_pos < m_json.size()) {
+      char c = m_json[m_pos++];
+      if (c == '"') return true;
+      if (c != '\\') {
+        *text += c;
+        continue;
+      }
+      if (m_pos >= m_json.size()) return false;
+      c = m_json[m_pos++];
+      switch (c) {
+        case 'n':
+          *text += '\n';
+          break;
+        case 't':
+          *text += '\t';
+          break;
+        case 'r':
+          *text += '\r';
+          break;
+        case 'b':
+          *text += '\b';
+          break;
+        case 'f':
+          *text += '\f';
+          break;
+        case 'u':
+          *text += "\\u";
+          break;
+        default:
+          *text += c;
+          break;
+      }
+    }
+    return false;
+  }
+
+  /**
+   * Read any value as compact JSON, without whitespace outside of strings.
+   */
+  bool ReadValue(std::string* text, int depth = 0) {
+    if (depth > MAX_JSON_DEPTH) return false;
+    char c = Peek();
+    if (c == '"') return CopyString(text);
+    if (c == '{' || c == '[') {
+      char close = c == '{' ? '}' : ']';
+      *text += c;
+      m_pos++;
+      if (Consume(close)) {
+        *text += close;
+        return true;
+      }
+      do {
+        if (c == '{') {
+          if (!CopyString(text) || !Consume(':')) return false;
+          *text += ':';
+        }
+        if (!ReadValue(text, depth + 1)) return false;
+        if (Peek() == ',') *text += ',';
+      } while (Consume(','));
+      if (!Consume(close)) return false;
+      *text += close;
+      return true;
+    }
+    // Number, true, false or null.
+    size_t start = m_pos;
+    while (m_pos < m_json.size() &&
+           (isalnum(static_cast<unsigned char>(m_json[m_pos])) ||
+            m_json[m_pos] == '-' || m_json[m_pos] == '+' ||
+            m_json[m_pos] == '.')) {
+      m_pos++;
+    }
+    if (m_pos == start) return false;
+    text->append(m_json, start, m_pos - start);
+    return true;
+  }
+
+  /** Skip any value. */
+  bool SkipValue() {
+    std::string ignored;
+    return ReadValue(&ignored);
+  }
+
+  bool AtEnd() { return Peek() == 0; }
+
+private:
+  /** Copy a string as is, quotes and escapes included. */
+  bool CopyString(std::string* text) {
+    if (!Consume('"')) return false;
+    size_t start = m_pos - 1;
+    while (m_pos < m_json.size()) {
+      char c = m_json[m_pos++];
+      if (c == '"') {
+        text->append(m_json, start, m_pos - start);
+        return true;
+      }
+      if (c == '\\') m_pos++;
+    }
+    return false;
+  }
+
+  const std::string& m_json;
+  size_t m_pos;
+};
+
+/** Read the members of an object, calling onMember with each name. */
+template <typename F>
+bool ReadObject(JsonReader& reader, F onMember) {
+  if (!reader.Consume('{')) return false;
+  if (reader.Consume('}')) return true;
+  do {
+    std::string name;
+    if (!reader.ReadString(&name) || !reader.Consume(':') || !onMember(name)) {
+      return false;
+    }
+  } while (reader.Consume(','));
+  return reader.Consume('}');
+}
+
+/** Read the items of an array, calling onItem for each one. */
+template <typename F>
+bool ReadArray(JsonReader& reader, F onItem) {
+  if (!reader.Consume('[')) return false;
+  if (reader.Consume(']')) return true;
+  do {
+    if (!onItem()) return false;
+  } while (reader.Consume(','));
+  return reader.Consume(']');
+}
+
+/** Read the "values" of an update. */
+bool ReadValues(JsonReader& reader, std::vector<SignalKValue>* values) {
+  return ReadArray(reader, [&reader, values]() {
+    SignalKValue value;
+    bool valid = ReadObject(reader, [&reader, &value](const std::string& name) {
+      if (name == "path") return reader.ReadString(&value.path);
+      if (name == "value") return reader.ReadValue(&value.value);
+      return reader.SkipValue();
+    });
+    if (!valid) return false;
+    // Values without path, such as the vessel name, are not recorded.
+    if (!value.path.empty() && !value.value.empty()) {
+      values->push_back(value);
+    }
+    return true;
+  });
+}
+
+bool ParseId(const std::string& text, uint32_t* id) {
+  if (text.empty() || text.size() > 9) return false;
+  char* end;
+  unsigned long value = strtoul(text.c_str(), &end, 10);
+  if (*end != 0 || !isdigit(static_cast<unsigned char>(text[0]))) {
+    return false;
+  }
+  *id = static_cast<uint32_t>(value);
+  return true;
+}
+
+/** Append a JSON string, with the characters that need it escaped. */
+void AppendJsonString(const std::string& text, std::string* json) {
+  static const char HEX[] = "0123456789abcdef";
+  json->push_back('"');
+  for (char c : text) {
+    unsigned char u = static_cast<unsigned char>(c);
+    if (c == '"' || c == '\\') {
+      json->push_back('\\');
+      json->push_back(c);
+    } else if (u < 0x20) {
+      json->append("\\u00");
+      json->push_back(HEX[u >> 4]);
+      json->push_back(HEX[u & 0xf]);
+    } else {
+      json->push_back(c);
+    }
+  }
+  json->push_back('"');
+}
+
+/** Return the value of a hexadecimal digit, -1 if it is not one. */
+int HexValue(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  return -1;
+}
+
+/** Checksum of a record, the XOR of the characters after the $. */
+uint8_t ComputeChecksum(const std::string& record, size_t end) {
+  uint8_t checksum = 0;
+  for (size_t i = 1; i < end; i++) {
+    checksum ^= static_cast<uint8_t>(record[i]);
+  }
+  return checksum;
+}
+
+/**
+ * Make a record from its fields, with a *hh checksum as in NMEA 0183 so that
+ * it is well formed for the sentence validation of the player.
+ */
+std::string MakeRecord(const std::string& fields) {
+  static const char HEX[] = "0123456789ABCDEF";
+  std::string record = SIGNALK_RECORD_PREFIX + fields;
+  uint8_t checksum = ComputeChecksum(record, record.size());
+  record.push_back('*');
+  record.push_back(HEX[checksum >> 4]);
+  record.push_back(HEX[checksum & 0xf]);
+  return record;
+}
+
+/**
+ * Escape the characters of a JSON value outside 7-bit ASCII as \u
+ * sequences. They can only appear in strings, and the checksum of a record
+ * is only meaningful for ASCII text. Invalid UTF-8 becomes U+FFFD.
+ */
+std::string EscapeNonAscii(const std::string& json) {
+  static const char HEX[] = "0123456789abcdef";
+  auto appendUnit = [](uint32_t unit, std::string* text) {
+    text->append("\\u");
+    for (int shift = 12; shift >= 0; shift -= 4) {
+      text->push_back(HEX[(unit >> shift) & 0xf]);
+    }
+  };
+
+  std::string text;
+  text.reserve(json.size());
+  for (size_t i = 0; i < json.size();) {
+    unsigned char u = static_cast<unsigned char>(json[i]);
+    if (u < 0x80) {
+      text.push_back(json[i++]);
+      continue;
+    }
+    size_t length = u >= 0xF0 ? 4 : u >= 0xE0 ? 3 : u >= 0xC0 ? 2 : 0;
+    uint32_t codePoint = u & (0x3F >> (length > 0 ? length - 1 : 0));
+    bool valid = length > 0 && length <= 4 && i + length <= json.size();
+    for (size_t j = 1; valid && j < length; j++) {
+      unsigned char next = static_cast<unsigned char>(json[i + j]);
+      valid = (next & 0xC0) == 0x80;
+      codePoint = codePoint << 6 | (next & 0x3F);
+    }
+    // Overlong forms, surrogates and values past U+10FFFF are invalid.
+    static const uint32_t MIN_CODE_POINT[] = {0, 0, 0x80, 0x800, 0x10000};
+    if (!valid || codePoint < MIN_CODE_POINT[length] || codePoint > 0x10FFFF ||
+        (codePoint >= 0xD800 && codePoint <= 0xDFFF)) {
+      codePoint = 0xFFFD;
+      length = 1;
+    }
+    if (codePoint > 0xFFFF) {
+      codePoint -= 0x10000;
+      appendUnit(0xD800 | (codePoint >> 10), &text);
+      appendUnit(0xDC00 | (codePoint & 0x3FF), &text);
+    } else {
+      appendUnit(codePoint, &text);
+    }
+    i += length;
+  }
+  return text;
+}
+
+/** Append a time as an ISO 8601 UTC timestamp with milliseconds. */
+void AppendIsoTime(int64_t timeMs, std::string* json) {
+  int64_t days = timeMs / 86400000;
+  int64_t msOfDay = timeMs % 86400000;
+  // Civil date from the days since 1970-01-01, see
+  // http://howardhinnant.github.io/date_algorithms.html#civil_from_days
+  days += 719468;
+  int64_t era = days / 146097;
+  int64_t dayOfEra = days - era * 146097;
+  int64_t yearOfEra =
+      (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) /
+      365;
+  int64_t dayOfYear =
+      dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+  int64_t mp = (5 * dayOfYear + 2) / 153;
+  int day = static_cast<int>(dayOfYear - (153 * mp + 2) / 5 + 1);
+  int month = static_cast<int>(mp < 10 ? mp + 3 : mp - 9);
+  int year = static_cast<int>(yearOfEra + era * 400 + (month <= 2));
+
+  char text[64];
+  snprintf(text, sizeof(text), "%04d-%02d-%02dT%02d:%02d:%02d.%03dZ", year,
+           month, day, static_cast<int>(msOfDay / 3600000),
+           static_cast<int>(msOfDay / 60000 % 60),
+           static_cast<int>(msOfDay / 1000 % 60),
+           static_cast<int>(msOfDay % 1000));
+  json->append(text);
+}
+
+}  // namespace
+
+bool ParseSignalKDelta(const std::string& json,
+                       const std::string& defaultContext,
+                       std::vector<SignalKValue>* values) {
+  values->clear();
+  JsonReader reader(json);
+  std::string context = defaultContext;
+  bool hasUpdates = false;
+  bool valid = ReadObject(reader, [&](const std::string& name) {
+    if (name == "context") return reader.ReadString(&context);
+    if (name == "updates") {
+      hasUpdates = true;
+      return ReadArray(reader, [&reader, values]() {
+        return ReadObject(reader, [&reader, values](const std::string& name) {
+          if (name == "values") return ReadValues(reader, values);
+          return reader.SkipValue();
+        });
+      });
+    }
+    return reader.SkipValue();
+  });
+  if (!valid || !hasUpdates || !reader.AtEnd()) {
+    values->clear();
+    return false;
+  }
+  // The context may follow the updates.
+  for (SignalKValue& value : *values) {
+    value.context = context;
+  }
+  return true;
+}
+
+bool IsSignalKRecord(const std::string& line) {
+  return line.compare(0, sizeof(SIGNALK_RECORD_PREFIX) - 1,
+                      SIGNALK_RECORD_PREFIX) == 0;
+}
+
+SignalKDeltaEncoder::SignalKDeltaEncoder(int64_t heartbeatMs)
+    : m_heartbeatMs(heartbeatMs) {}
+
+void SignalKDeltaEncoder::Reset() {
+  m_ids.clear();
+  m_values.clear();
+}
+
+uint32_t SignalKDeltaEncoder::Intern(const std::string& text,
+                                     std::vector<std::string>* records) {
+  auto it = m_ids.find(text);
+  if (it != m_ids.end()) return it->second;
+  uint32_t id = static_cast<uint32_t>(m_ids.size());
+  m_ids.emplace(text, id);
+  records->push_back(MakeRecord("D," + std::to_string(id) + "," + text));
+  return id;
+}
+
+void SignalKDeltaEncoder::Encode(const SignalKValue& value, int64_t timeMs,
+                                 std::vector<std::string>* records) {
+  // Records are single lines of ASCII text.
+  auto isPlainText = [](const std::string& text) {
+    for (char c : text) {
+      if (c == '\r' || c == '\n' || static_cast<unsigned char>(c) >= 0x80) {
+        return false;
+      }
+    }
+    return true;
+  };
+  if (!isPlainText(value.context) || !isPlainText(value.path)) return;
+  uint32_t contextId = Intern(value.context, records);
+  uint32_t pathId = Intern(value.path, records);
+  uint64_t key = (static_cast<uint64_t>(contextId) << 32) | pathId;
+  auto it = m_values.find(key);
+  if (it != m_values.end() && m_heartbeatMs > 0 &&
+      it->second.value == value.value &&
+      timeMs - it->second.timeMs < m_heartbeatMs) {
+    return;  // Unchanged, and written recently.
+  }
+  m_values[key] = {value.value, timeMs};
+  records->push_back(MakeRecord("V," + std::to_string(contextId) + "," +
+                                std::to_string(pathId) + "," +
+                                EscapeNonAscii(value.value)));
+}
+
+SignalKDeltaWriter::SignalKDeltaWriter() : m_timeMs(0), m_count(0) {}
+
+bool SignalKDeltaWriter::Add(const SignalKValue& value, int64_t timeMs) {
+  // Characters added for the value besides its path and JSON text.
+  static const size_t VALUE_OVERHEAD = 32;
+  if (m_count > 0 &&
+      (value.context != m_context || timeMs != m_timeMs ||
+       m_delta.size() + value.path.size() + value.value.size() +
+               VALUE_OVERHEAD >
+           MAX_DELTA_SIZE)) {
+    return false;
+  }
+  if (m_count == 0) {
+    m_context = value.context;
+    m_timeMs = timeMs;
+    m_delta.append("{\"context\":");
+    AppendJsonString(value.context, &m_delta);
+    m_delta.append(",\"updates\":[{");
+    if (timeMs >= 0) {
+      m_delta.append("\"timestamp\":\"");
+      AppendIsoTime(timeMs, &m_delta);
+      m_delta.append("\",");
+    }
+    m_delta.append("\"values\":[");
+  } else {
+    m_delta.push_back(',');
+  }
+  m_delta.append("{\"path\":");
+  AppendJsonString(value.path, &m_delta);
+  m_delta.append(",\"value\":");
+  m_delta.append(value.value);
+  m_delta.push_back('}');
+  m_count++;
+  return true;
+}
+
+std::string SignalKDeltaWriter::Finish() {
+  std::string delta;
+  if (m_count == 0) return delta;
+  m_delta.append("]}]}\r\n");
+  delta.swap(m_delta);
+  m_count = 0;
+  return delta;
+}
+
+bool SignalKDeltaDecoder::Decode(const std::string& line,
+                                 SignalKValue* value) {
+  if (!IsSignalKRecord(line)) return false;
+  size_t end = line.find_first_of("\r\n");
+  if (end == std::string::npos) end = line.size();
+  // Check and strip the checksum.
+  if (end < 3 || line[end - 3] != '*') return false;
+  int high = HexValue(line[end - 2]);
+  int low = HexValue(line[end - 1]);
+  end -= 3;
+  if (high < 0 || low < 0 || ComputeChecksum(line, end) != (high << 4 | low)) {
+    return false;
+  }
+  size_t start = sizeof(SIGNALK_RECORD_PREFIX) - 1;
+  if (end < start + 2 || line[start + 1] != ',') return false;
+  char kind = line[start];
+  size_t pos = start + 2;
+
+  // Read the next id field.
+  auto readId = [&line, &pos, end](uint32_t* id) {
+    size_t comma = line.find(',', pos);
+    if (comma == std::string::npos || comma >= end ||
+        !ParseId(line.substr(pos, comma - pos), id)) {
+      return false;
+    }
+    pos = comma + 1;
+    return true;
+  };
+
+  if (kind == 'D') {
+    uint32_t id;
+    if (readId(&id)) m_strings[id] = line.substr(pos, end - pos);
+    return false;
+  }
+  uint32_t contextId, pathId;
+  if (kind != 'V' || !readId(&contextId) || !readId(&pathId) || pos >= end) {
+    return false;
+  }
+  auto context = m_strings.find(contextId);
+  auto path = m_strings.find(pathId);
+  if (context == m_strings.end() || path == m_strings.end()) return false;
+  // A damaged value would corrupt the replayed deltas.
+  std::string text = line.substr(pos, end - pos);
+  JsonReader reader(text);
+  if (!reader.SkipValue() || !reader.AtEnd()) return false;
+  value->context = context->second;
+  value->path = path->second;
+  value->value = std::move(text);
+  return true;
+}
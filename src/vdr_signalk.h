@@ -0,0 +1,181 @@
+/***************************************************************************
+ *   Copyright (C) 2024 by OpenCPN development team                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ **************************************************************************/
+
+#ifndef _VDR_SIGNALK_H_
+#define _VDR_SIGNALK_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Prefix of the Signal K records in VDR files.
+ *
+ * A record is either a dictionary entry "$PVDSK,D,<id>,<text>" defining the
+ * id of a context or path, or a value "$PVDSK,V,<context id>,<path id>,
+ * <value>" where the value is compact JSON, both followed by a "*hh"
+ * checksum as in NMEA 0183. Records are ASCII, characters of the values
+ * outside it are escaped. Ids are only valid in the file that defines them.
+ */
+extern const char SIGNALK_RECORD_PREFIX[];
+
+/** A value of a Signal K delta. */
+struct SignalKValue {
+  std::string context;  //!< e.g. "vessels.urn:mrn:imo:mmsi:227006760"
+  std::string path;     //!< e.g. "navigation.speedOverGround"
+  std::string value;    //!< Compact JSON, e.g. "3.85" or "{...}"
+};
+
+/**
+ * Extract the values of a Signal K delta message.
+ *
+ * @param json Delta, "{"context": ..., "updates": [{"values": [...]}]}".
+ * @param defaultContext Context of a delta without context.
+ * @param values Receives the values, in order.
+ * @return False if the message is not valid JSON or not a delta.
+ */
+bool ParseSignalKDelta(const std::string& json,
+                       const std::string& defaultContext,
+                       std::vector<SignalKValue>* values);
+
+/** Check if a line is a Signal K record. */
+bool IsSignalKRecord(const std::string& line);
+
+/**
+ * Encoder of Signal K values as compact VDR records.
+ *
+ * Context and path strings are interned in a dictionary written to the file
+ * the first time they are used, the values then refer to them by id. A value
+ * is only written when it changes, or when it has not been written for the
+ * heartbeat interval, so the file still samples slowly changing data.
+ */
+class SignalKDeltaEncoder {
+public:
+  /** @param heartbeatMs Interval after which unchanged values are written */
+  explicit SignalKDeltaEncoder(int64_t heartbeatMs = DEFAULT_HEARTBEAT_MS);
+
+  /**
+   * Set the heartbeat interval.
+   *
+   * @param heartbeatMs Interval in milliseconds, 0 to write every value.
+   */
+  void SetHeartbeat(int64_t heartbeatMs) { m_heartbeatMs = heartbeatMs; }
+  int64_t GetHeartbeat() const { return m_heartbeatMs; }
+
+  /** Forget the dictionary and the written values, for a new file. */
+  void Reset();
+
+  /**
+   * Encode a value.
+   *
+   * @param value Value to record.
+   * @param timeMs Reception time, in milliseconds.
+   * @param records Receives the dictionary entries of new strings followed
+   * by the value, nothing if the value is not due.
+   */
+  void Encode(const SignalKValue& value, int64_t timeMs,
+              std::vector<std::string>* records);
+
+  /** Get the number of interned strings. */
+  size_t GetDictionarySize() const { return m_ids.size(); }
+
+  static const int64_t DEFAULT_HEARTBEAT_MS = 60 * 1000;
+
+private:
+  /** Get the id of a string, adding a dictionary entry if it is new. */
+  uint32_t Intern(const std::string& text, std::vector<std::string>* records);
+
+  /** Last written value of a path. */
+  struct WrittenValue {
+    std::string value;
+    int64_t timeMs;
+  };
+
+  int64_t m_heartbeatMs;
+  std::unordered_map<std::string, uint32_t> m_ids;
+  /** Written values, by context id and path id. */
+  std::unordered_map<uint64_t, WrittenValue> m_values;
+};
+
+/**
+ * Writer of Signal K delta messages, as sent by the Signal K TCP stream.
+ *
+ * The JSON text is appended to a buffer as the values are added, without
+ * building a document. Consecutive values of the same context and time are
+ * grouped in one delta, kept small enough to fit in a UDP datagram.
+ */
+class SignalKDeltaWriter {
+public:
+  SignalKDeltaWriter();
+
+  /**
+   * Add a value to the delta being written.
+   *
+   * @param value Value to add, a valid JSON value.
+   * @param timeMs Time of the value in milliseconds since epoch, negative for
+   * an update without timestamp.
+   * @return False if the value does not belong in the delta being written,
+   * which must then be finished before adding the value again.
+   */
+  bool Add(const SignalKValue& value, int64_t timeMs);
+
+  /** Whether no value was added since the last delta was finished. */
+  bool IsEmpty() const { return m_count == 0; }
+
+  /**
+   * Close the delta being written.
+   *
+   * @return The delta, a single line of JSON ending with CR LF, or an empty
+   * string if no value was added.
+   */
+  std::string Finish();
+
+  /** Size above which a delta is not extended, a single value may exceed it. */
+  static const size_t MAX_DELTA_SIZE = 1400;
+
+private:
+  std::string m_delta;    //!< JSON text of the delta being written
+  std::string m_context;  //!< Context of the delta being written
+  int64_t m_timeMs;       //!< Time of the delta being written
+  size_t m_count;         //!< Values in the delta being written
+};
+
+/** Decoder of the Signal K records of a VDR file. */
+class SignalKDeltaDecoder {
+public:
+  /**
+   * Decode a record. Dictionary entries are remembered for the next ones.
+   *
+   * @param line Record, line ending optional.
+   * @param value Set to the value when the record is a value.
+   * @return True if the record is a valid value with known ids and a
+   * matching checksum.
+   */
+  bool Decode(const std::string& line, SignalKValue* value);
+
+  /** Forget the dictionary, for a new file. */
+  void Reset() { m_strings.clear(); }
+
+private:
+  std::unordered_map<uint32_t, std::string> m_strings;
+};
+
+#endif  // _VDR_SIGNALK_H_
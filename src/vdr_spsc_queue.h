@@ -0,0 +1,84 @@
+/***************************************************************************
+ *   Copyright (C) 2024 by OpenCPN development team                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ **************************************************************************/
+
+#ifndef _VDR_SPSC_QUEUE_H_
+#define _VDR_SPSC_QUEUE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+/**
+ * Bounded lock-free queue between one producer and one consumer thread.
+ *
+ * The playback engine pushes the messages to send from the GUI thread, the
+ * network I/O thread pops them.
+ */
+template <typename T>
+class VDRSpscQueue {
+public:
+  /** @param capacity Maximum number of queued items. */
+  explicit VDRSpscQueue(size_t capacity)
+      : m_slots(capacity + 1), m_head(0), m_tail(0) {}
+
+  /**
+   * Queue an item, from the producer thread.
+   *
+   * @return False if the queue is full, the item is left unchanged.
+   */
+  bool Push(T&& item) {
+    size_t tail = m_tail.load(std::memory_order_relaxed);
+    size_t next = Next(tail);
+    if (next == m_head.load(std::memory_order_acquire)) return false;
+    m_slots[tail] = std::move(item);
+    m_tail.store(next, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * Take the oldest item, from the consumer thread.
+   *
+   * @return False if the queue is empty.
+   */
+  bool Pop(T& item) {
+    size_t head = m_head.load(std::memory_order_relaxed);
+    if (head == m_tail.load(std::memory_order_acquire)) return false;
+    item = std::move(m_slots[head]);
+    m_head.store(Next(head), std::memory_order_release);
+    return true;
+  }
+
+  bool IsEmpty() const {
+    return m_head.load(std::memory_order_acquire) ==
+           m_tail.load(std::memory_order_acquire);
+  }
+
+private:
+  size_t Next(size_t index) const {
+    return index + 1 == m_slots.size() ? 0 : index + 1;
+  }
+
+  std::vector<T> m_slots;
+  // Written by different threads, kept on separate cache lines.
+  alignas(64) std::atomic<size_t> m_head;  //!< Next item to pop
+  alignas(64) std::atomic<size_t> m_tail;  //!< Next slot to push to
+};
+
+#endif  // _VDR_SPSC_QUEUE_H_
@@ -0,0 +1,116 @@
+/***************************************************************************
+ *   Copyright (C) 2024 by OpenCPN development team                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ **************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include "wx/wxprec.h"
+
+#ifndef WX_PRECOMP
+#include "wx/wx.h"
+#endif  // precompiled headers
+
+#include "wx/textfile.h"
+
+#include "vdr_csv.h"
+
+namespace {
+
+/** Get a field of a line, empty with the not found marker "-" if missing. */
+wxString GetField(const wxString& line, unsigned int column,
+                  bool* escaped = nullptr) {
+  const wxStringCharType* text = line.wx_str();
+  CSVFieldView field;
+  ProjectCSVFields(text, std::char_traits<wxStringCharType>::length(text),
+                   &column, &field, 1);
+  if (escaped) *escaped = field.IsEscaped();
+  return field.IsFound() ? field.ToString() : wxString("-");
+}
+
+}  // namespace
+
+/** Fields of the recorded file are viewed in place. */
+TEST(VDRCSVTests, RecordingFile) {
+  wxTextFile file;
+  ASSERT_TRUE(file.Open(wxString(TESTDATA) + "/test_recording.csv"));
+  int lineCount = 0;
+  // Skip the header.
+  for (size_t i = 1; i < file.GetLineCount(); i++) {
+    wxString line = file.GetLine(i);
+    if (line.IsEmpty()) continue;
+    const wxStringCharType* text = line.wx_str();
+    const unsigned int columns[] = {3, 0};
+    CSVFieldView fields[2];
+    EXPECT_EQ(ProjectCSVFields(text,
+                               std::char_traits<wxStringCharType>::length(text),
+                               columns, fields, 2),
+              2u);
+    EXPECT_FALSE(fields[0].IsEscaped());
+    EXPECT_FALSE(fields[1].IsEscaped());
+    EXPECT_EQ(fields[0].ToString(), line.AfterFirst('"').BeforeLast('"'));
+    EXPECT_EQ(fields[1].ToString(), line.BeforeFirst(','));
+    // The view points into the line.
+    EXPECT_EQ(fields[1].GetData(), text);
+    lineCount++;
+  }
+  EXPECT_EQ(lineCount, 6);
+}
+
+/** Quoted fields are split and unescaped like a full CSV parser does. */
+TEST(VDRCSVTests, Quoting) {
+  struct TestCase {
+    const char* line;
+    unsigned int column;
+    const char* expected;
+    bool escaped;
+  };
+  const TestCase tests[] = {
+      {"a,b,c", 1, "b", false},
+      {"a,b,c", 2, "c", false},
+      {"a,,c", 1, "", false},
+      {"a,b,", 2, "", false},
+      {"a,b,c", 3, "-", false},
+      {"\"$IIMTW,16.8,C*1C\",x", 0, "$IIMTW,16.8,C*1C", false},
+      {"\"$IIMTW,16.8,C*1C\",x", 1, "x", false},
+      {"a,\"\",c", 1, "", false},
+      {"a,\"say \"\"hi\"\"\",c", 1, "say \"hi\"", true},
+      {"a,\"say \"\"hi\"\"\",c", 2, "c", false},
+      {"a,\"\"\"\",c", 1, "\"", true},
+      {"a,b\"c,d\"e,f", 1, "bc,de", true},
+      {"a,b\"c,d\"e,f", 2, "f", false},
+      {"a,\"unterminated,c", 1, "unterminated,c", true},
+      {"a,\"unterminated,c", 2, "-", false},
+  };
+  for (const auto& test : tests) {
+    bool escaped;
+    EXPECT_EQ(GetField(test.line, test.column, &escaped), test.expected)
+        << test.line << " column " << test.column;
+    EXPECT_EQ(escaped, test.escaped) << test.line << " column " << test.column;
+  }
+}
+
+/** Fields past the end of the line are not found. */
+TEST(VDRCSVTests, MissingField) {
+  wxString line("x,y");
+  const wxStringCharType* text = line.wx_str();
+  const unsigned int columns[] = {1, 5};
+  CSVFieldView fields[2];
+  EXPECT_EQ(ProjectCSVFields(text, line.length(), columns, fields, 2), 1u);
+  EXPECT_EQ(fields[0].ToString(), "y");
+  EXPECT_FALSE(fields[1].IsFound());
+}
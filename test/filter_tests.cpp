@@ -0,0 +1,79 @@
+/***************************************************************************
+ *   Copyright (C) 2024 by OpenCPN development team                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ **************************************************************************/
+
+#include <gtest/gtest.h>
+#include "vdr_filter.h"
+
+/** Sentence patterns match the address field. */
+TEST(VDRFilterTests, Sentences) {
+  VDRMessageFilter filter;
+  EXPECT_TRUE(filter.MatchesAll());
+  EXPECT_TRUE(filter.Matches("$GPRMC,,V,,,,,,,,,,N*53"));
+
+  ASSERT_TRUE(filter.Parse("gprmc, ??GGA AI*"));
+  EXPECT_FALSE(filter.MatchesAll());
+  EXPECT_EQ(filter.ToString(), "GPRMC,??GGA,AI*");
+  EXPECT_TRUE(filter.Matches("$GPRMC,,V,,,,,,,,,,N*53\r\n"));
+  EXPECT_TRUE(filter.Matches("$IIGGA,1*00"));
+  EXPECT_TRUE(filter.Matches("!AIVDM,1,1,,A,13aEOK?P00PD2wVMdL,0*26"));
+  EXPECT_TRUE(filter.Matches("!AIVDO,1,1,,A,13aEOK?P00PD2wVMdL,0*24"));
+  EXPECT_FALSE(filter.Matches("$GPGLL,1*00"));
+  EXPECT_FALSE(filter.Matches("$GPRMCA,1*00"));
+  EXPECT_FALSE(filter.Matches("GPRMC,1*00"));
+
+  // A sentence formatter alone is not a talker wildcard.
+  ASSERT_TRUE(filter.Parse("RMC"));
+  EXPECT_FALSE(filter.Matches("$GPRMC,,V,,,,,,,,,,N*53"));
+}
+
+/** PGNs match the NMEA 2000 messages. */
+TEST(VDRFilterTests, PGNs) {
+  VDRMessageFilter filter;
+  ASSERT_TRUE(filter.Parse("129025,127250"));
+  EXPECT_EQ(filter.ToString(), "127250,129025");
+  EXPECT_TRUE(filter.Matches("$PCDIN,01F801,000C72EA,09,28C36A0000B40AFD*56"));
+  EXPECT_TRUE(filter.Matches("$MXPGN,01f801,2801,C1F0E91CD72C0F50"));
+  // The PGN of the VDR recording format is decimal.
+  EXPECT_TRUE(filter.Matches("$PCDIN,129025,93130201F801FF01E803000008"));
+  EXPECT_FALSE(filter.Matches("$PCDIN,129026,93130201F901FF01E803000008"));
+  EXPECT_FALSE(filter.Matches("$PCDIN,01F802,000C72EA,09,28C36A0000B4*56"));
+  EXPECT_FALSE(filter.Matches("$GPRMC,,V,,,,,,,,,,N*53"));
+
+  ASSERT_TRUE(filter.Parse("PCDIN"));
+  EXPECT_TRUE(filter.Matches("$PCDIN,01F802,000C72EA,09,28C36A0000B4*56"));
+}
+
+/** Invalid patterns leave the filter unchanged. */
+TEST(VDRFilterTests, InvalidPatterns) {
+  VDRMessageFilter filter;
+  ASSERT_TRUE(filter.Parse("GPRMC"));
+  std::string error;
+  EXPECT_FALSE(filter.Parse("GP*RMC", &error));
+  EXPECT_EQ(error, "GP*RMC");
+  EXPECT_FALSE(filter.Parse("GPGLL,GP-RMC", &error));
+  EXPECT_EQ(error, "GP-RMC");
+  EXPECT_FALSE(filter.Parse("999999", &error));
+  EXPECT_EQ(filter.ToString(), "GPRMC");
+
+  // Empty filters and "*" match everything.
+  ASSERT_TRUE(filter.Parse(" , "));
+  EXPECT_TRUE(filter.MatchesAll());
+  ASSERT_TRUE(filter.Parse("GPRMC,*"));
+  EXPECT_TRUE(filter.Matches("$IIMTW,16.8,C*1C"));
+}
@@ -0,0 +1,112 @@
+/***************************************************************************
+ *   Copyright (C) 2024 by OpenCPN development team                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ **************************************************************************/
+
+#include <gtest/gtest.h>
+#include "vdr_follow.h"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+class VDRFollowTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    m_path = ::testing::TempDir() + "vdr_follow_test_" +
+             std::to_string(rand()) + ".txt";
+  }
+  void TearDown() override { std::remove(m_path.c_str()); }
+
+  void Write(const std::string& data, bool append = true) {
+    std::ofstream file(m_path, std::ios::binary |
+                                   (append ? std::ios::app : std::ios::trunc));
+    file << data;
+  }
+
+  /** Read appended lines, giving the follower several chances to notice. */
+  std::vector<std::string> ReadLines(VDRFileFollower& follower) {
+    std::vector<std::string> lines;
+    for (int i = 0; i < 10 && lines.empty(); i++) {
+      follower.ReadLines(lines);
+    }
+    return lines;
+  }
+
+  std::string m_path;
+};
+
+/** Existing content is never returned, only appended lines. */
+TEST_F(VDRFollowTest, ReadsAppendedLinesOnly) {
+  Write("$IIMTW,16.8,C*1C\n$IIHDG,25.0,0,E,0.0,E*60\n", false);
+
+  VDRFileFollower follower;
+  ASSERT_TRUE(follower.Start(m_path));
+  EXPECT_FALSE(follower.HasPartialLine());
+
+  std::vector<std::string> lines;
+  EXPECT_EQ(follower.ReadLines(lines), 0u);
+
+  Write("$IIVLW,2354.92,N,2338.533,N*79\r\n");
+  lines = ReadLines(follower);
+  ASSERT_EQ(lines.size(), 1u);
+  EXPECT_EQ(lines[0], "$IIVLW,2354.92,N,2338.533,N*79");
+}
+
+/** A line being written is only returned once complete. */
+TEST_F(VDRFollowTest, CompletesPartialLine) {
+  Write("$IIMTW,16.8,C*1C\n$IIHDG,25.0", false);
+
+  VDRFileFollower follower;
+  ASSERT_TRUE(follower.Start(m_path));
+  EXPECT_TRUE(follower.HasPartialLine());
+
+  Write(",0,E,0.0");
+  std::vector<std::string> lines;
+  for (int i = 0; i < 10; i++) follower.ReadLines(lines);
+  EXPECT_TRUE(lines.empty()) << "Incomplete line returned";
+
+  Write(",E*60\n$IIMTW,16.8,C*1C\n");
+  lines = ReadLines(follower);
+  ASSERT_EQ(lines.size(), 2u);
+  EXPECT_EQ(lines[0], "$IIHDG,25.0,0,E,0.0,E*60");
+  EXPECT_EQ(lines[1], "$IIMTW,16.8,C*1C");
+}
+
+/** Truncating the file does not replay the content written afterwards. */
+TEST_F(VDRFollowTest, TruncatedFile) {
+  Write("$IIMTW,16.8,C*1C\n$IIMTW,16.8,C*1C\n", false);
+
+  VDRFileFollower follower;
+  ASSERT_TRUE(follower.Start(m_path));
+
+  Write("$IIMTW,16.8,C*1C\n", false);
+  EXPECT_TRUE(ReadLines(follower).empty());
+  EXPECT_EQ(follower.GetOffset(), 17u);
+
+  Write("$IIHDG,25.0,0,E,0.0,E*60\n");
+  std::vector<std::string> lines = ReadLines(follower);
+  ASSERT_EQ(lines.size(), 1u);
+  EXPECT_EQ(lines[0], "$IIHDG,25.0,0,E,0.0,E*60");
+}
+
+TEST_F(VDRFollowTest, MissingFile) {
+  VDRFileFollower follower;
+  EXPECT_FALSE(follower.Start(m_path + ".missing"));
+  EXPECT_FALSE(follower.IsActive());
+}
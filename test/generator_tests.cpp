@@ -0,0 +1,145 @@
+/***************************************************************************
+ *   Copyright (C) 2024 by OpenCPN development team                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ **************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include "wx/wxprec.h"
+
+#ifndef WX_PRECOMP
+#include "wx/wx.h"
+#endif  // precompiled headers
+
+#include "vdr_load_generator.h"
+#include "vdr_nmea.h"
+#include "vdr_pi_time.h"
+
+namespace {
+
+VDRLoadSettings MakeSettings() {
+  VDRLoadSettings settings;
+  settings.durationMs = 10 * 1000;
+  settings.navigationRate = 10;
+  settings.aisTargets = 20;
+  settings.aisInterval = 2;
+  settings.n2kRate = 5;
+  return settings;
+}
+
+}  // namespace
+
+/** The same seed gives the same data. */
+TEST(LoadGeneratorTests, Deterministic) {
+  VDRLoadSettings settings = MakeSettings();
+  VDRLoadGenerator first(settings);
+  VDRLoadGenerator second(settings);
+  settings.seed = 2;
+  VDRLoadGenerator other(settings);
+  VDRLoadMessage a, b, c;
+  bool differs = false;
+  while (first.Next(a)) {
+    ASSERT_TRUE(second.Next(b));
+    ASSERT_TRUE(other.Next(c));
+    EXPECT_EQ(a.timeMs, b.timeMs);
+    EXPECT_EQ(a.sentence, b.sentence);
+    differs |= a.sentence != c.sentence;
+  }
+  EXPECT_FALSE(second.Next(b));
+  EXPECT_TRUE(differs);
+}
+
+/** Messages are emitted in order at the configured rates. */
+TEST(LoadGeneratorTests, Rates) {
+  VDRLoadSettings settings = MakeSettings();
+  VDRLoadGenerator generator(settings);
+  VDRLoadMessage message;
+  size_t nmea = 0, ais = 0, n2k = 0;
+  int64_t previousMs = settings.startTimeMs;
+  while (generator.Next(message)) {
+    EXPECT_GE(message.timeMs, previousMs);
+    EXPECT_LT(message.timeMs, settings.startTimeMs + settings.durationMs);
+    previousMs = message.timeMs;
+    switch (message.type) {
+      case VDRLoadMessage::Type::NMEA0183:
+        nmea++;
+        break;
+      case VDRLoadMessage::Type::AIS:
+        ais++;
+        break;
+      case VDRLoadMessage::Type::NMEA2000:
+        n2k++;
+        EXPECT_EQ(message.payload[3] | message.payload[4] << 8 |
+                      message.payload[5] << 16,
+                  static_cast<int>(message.pgn));
+        break;
+    }
+  }
+  EXPECT_EQ(nmea, 4u * 10 * 10);
+  EXPECT_EQ(ais, 20u * 5);
+  EXPECT_EQ(n2k, 4u * 5 * 10);
+}
+
+/** Sentences have valid checksums and timestamps. */
+TEST(LoadGeneratorTests, ValidSentences) {
+  VDRLoadGenerator generator(MakeSettings());
+  VDRLoadMessage message;
+  TimestampParser parser;
+  size_t timestamps = 0;
+  // Compare times relative to the first one, the parser returns the UTC
+  // fields in local time.
+  wxDateTime first;
+  while (generator.Next(message)) {
+    if (message.type == VDRLoadMessage::Type::NMEA2000) {
+      EXPECT_EQ(message.sentence.rfind("$PCDIN,", 0), 0u);
+      continue;
+    }
+    wxString sentence(message.sentence);
+    const wxStringCharType* text = sentence.wx_str();
+    EXPECT_EQ(ValidateNMEASentence(
+                  text, std::char_traits<wxStringCharType>::length(text),
+                  nullptr),
+              NMEASentenceStatus::VALID)
+        << message.sentence;
+    wxDateTime timestamp;
+    int precision;
+    if (sentence.StartsWith("$GPRMC") || sentence.StartsWith("$GPGGA")) {
+      ASSERT_TRUE(parser.ParseTimestamp(sentence, timestamp, precision));
+      if (!first.IsValid()) first = timestamp;
+      EXPECT_EQ((timestamp - first).GetMilliseconds().GetValue(),
+                message.timeMs - MakeSettings().startTimeMs);
+      EXPECT_EQ(precision, 2);
+      timestamps++;
+    }
+  }
+  EXPECT_EQ(timestamps, 2u * 10 * 10);
+}
+
+TEST(LoadGeneratorTests, CSVLine) {
+  VDRLoadMessage message;
+  message.type = VDRLoadMessage::Type::NMEA2000;
+  message.timeMs = 1437384131123LL;
+  message.pgn = 129025;
+  message.sentence = "$PCDIN,129025,0102";
+  EXPECT_EQ(VDRLoadGenerator::FormatCSVLine(message),
+            "2015-07-20T09:22:11.123Z,NMEA2000,129025,0102\n");
+  message.type = VDRLoadMessage::Type::AIS;
+  message.sentence = "!AIVDM,1,1,,A,13Hj5J7000Od<fdKQJ3Iw`S>28FK,0*27";
+  EXPECT_EQ(VDRLoadGenerator::FormatCSVLine(message),
+            "2015-07-20T09:22:11.123Z,AIS,,\"!AIVDM,1,1,,A,13Hj5J7000Od<"
+            "fdKQJ3Iw`S>28FK,0*27\"\n");
+}
@@ -0,0 +1,167 @@
+/***************************************************************************
+ *   Copyright (C) 2024 by OpenCPN development team                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ **************************************************************************/
+
+#include <gtest/gtest.h>
+#include "vdr_keyframes.h"
+
+/** Test decoding of the AIS message type and MMSI. */
+TEST(KeyframeTests, DecodeAISHeader) {
+  int type;
+  uint32_t mmsi;
+  int part;
+
+  ASSERT_TRUE(StateSnapshot::DecodeAISHeader("13u=gHP3CWPlvs2Q8sHW:5fD0h6a",
+                                             type, mmsi, part));
+  EXPECT_EQ(type, 1);
+  EXPECT_EQ(mmsi, 265514850u);
+  EXPECT_EQ(part, 0);
+
+  ASSERT_TRUE(StateSnapshot::DecodeAISHeader("53bvpB02;CK10@lf220", type,
+                                             mmsi, part));
+  EXPECT_EQ(type, 5);
+  EXPECT_EQ(mmsi, 246397000u);
+
+  // Type 24 static data report, part B.
+  ASSERT_TRUE(StateSnapshot::DecodeAISHeader("H3bvpB4", type, mmsi, part));
+  EXPECT_EQ(type, 24);
+  EXPECT_EQ(mmsi, 246397000u);
+  EXPECT_EQ(part, 1);
+
+  EXPECT_FALSE(StateSnapshot::DecodeAISHeader("13bvp", type, mmsi, part));
+  EXPECT_FALSE(StateSnapshot::DecodeAISHeader("13bv{B0", type, mmsi, part));
+}
+
+/** Test the key assigned to each kind of message. */
+TEST(KeyframeTests, MessageKeys) {
+  std::string key;
+
+  ASSERT_TRUE(StateSnapshot::GetMessageKey(
+      "$GPRMC,092211.00,A,5759.0,N,01146.0,E,5.0,90.0,200715,,,A*6E", key));
+  EXPECT_EQ(key, "$GPRMC");
+
+  // Each page of satellites in view is kept.
+  ASSERT_TRUE(StateSnapshot::GetMessageKey(
+      "$GPGSV,2,2,08,17,13,044,00,24,45,150,46,25,49,259,48,32,10,328,47*76",
+      key));
+  EXPECT_EQ(key, "$GPGSV,2");
+
+  ASSERT_TRUE(StateSnapshot::GetMessageKey(
+      "!AIVDM,1,1,,A,13bvpB001f0lPAFQ7HKptoBF00Sa,0*66", key));
+  EXPECT_EQ(key, "VDM,246397000,1");
+
+  ASSERT_TRUE(StateSnapshot::GetMessageKey("$PCDIN,130306,0102*00", key));
+  EXPECT_EQ(key, "$PCDIN,130306");
+
+  // Signal K values are kept per context and path.
+  ASSERT_TRUE(StateSnapshot::GetMessageKey("$PVDSK,V,0,1,{\"a\":1}", key));
+  EXPECT_EQ(key, "$PVDSK,V,0,1");
+  ASSERT_TRUE(StateSnapshot::GetMessageKey("$PVDSK,D,1,navigation.log", key));
+  EXPECT_EQ(key, "$PVDSK,D,1");
+
+  EXPECT_FALSE(StateSnapshot::GetMessageKey("", key));
+  EXPECT_FALSE(StateSnapshot::GetMessageKey("garbage", key));
+}
+
+/** Test that the snapshot keeps the latest message of each data item. */
+TEST(KeyframeTests, SnapshotKeepsLatestMessage) {
+  StateSnapshot state;
+  state.Update("$GPRMC,092211.00,A*00");
+  state.Update("$SDDPT,12.3,0.0*00");
+  state.Update("$GPRMC,092212.00,A*00");
+  // Position reports of type 1, 2 and 3 replace each other.
+  state.Update("!AIVDM,1,1,,B,13u=gHP3CWPlvs2Q8sHW:5fD0h6a,0*1B");
+  state.Update("!AIVDM,1,1,,B,33u=gHP3CWPlvs2Q8sHW:5fD0h6a,0*1B");
+
+  std::vector<std::string> messages = state.GetMessages();
+  ASSERT_EQ(messages.size(), 3u);
+  EXPECT_EQ(messages[0], "$SDDPT,12.3,0.0*00");
+  EXPECT_EQ(messages[1], "$GPRMC,092212.00,A*00");
+  EXPECT_EQ(messages[2], "!AIVDM,1,1,,B,33u=gHP3CWPlvs2Q8sHW:5fD0h6a,0*1B");
+}
+
+/** Test that multi-sentence AIS messages are kept together. */
+TEST(KeyframeTests, SnapshotMultiSentenceAIS) {
+  StateSnapshot state;
+  state.Update(
+      "!AIVDM,2,1,8,A,53bvpB02;CK10@lf220<u84j0lThhE0u8622221@:`?<35sC0>l3lUSkp8"
+      "1R,0*3B");
+  EXPECT_EQ(state.Size(), 0u) << "Incomplete message added to snapshot";
+  state.Update("!AIVDM,2,2,8,A,C`888888882,2*0D");
+  ASSERT_EQ(state.Size(), 1u);
+  EXPECT_EQ(state.GetMessages().size(), 2u);
+
+  // A fragment with a different sequence identifier is dropped.
+  state.Update(
+      "!AIVDM,2,1,9,A,53u=gHP00001<aUB2210ThuB3OCN1<F22222220j1@73240Ht3h0000"
+      "00000,0*1A");
+  state.Update("!AIVDM,2,2,1,A,00000000002,2*2F");
+  EXPECT_EQ(state.Size(), 1u);
+}
+
+/** Test lookup of keyframes by timestamp and by line. */
+TEST(KeyframeTests, FindKeyframe) {
+  KeyframeIndex index(10);
+  for (int line = 0; line < 100; line++) {
+    index.AddTimestamp("GPRMC/0", 1000 * line);
+    index.AddLine(line, "$GPRMC," + std::to_string(line) + "*00");
+  }
+  EXPECT_EQ(index.GetCount(), 10u);
+
+  const Keyframe* keyframe = index.FindKeyframe("GPRMC/0", 55000);
+  ASSERT_NE(keyframe, nullptr);
+  EXPECT_EQ(keyframe->line, 49);
+  ASSERT_EQ(keyframe->state.GetMessages().size(), 1u);
+  EXPECT_EQ(keyframe->state.GetMessages()[0], "$GPRMC,49*00");
+
+  // Keyframes must be strictly before the requested time.
+  keyframe = index.FindKeyframe("GPRMC/0", 49000);
+  ASSERT_NE(keyframe, nullptr);
+  EXPECT_EQ(keyframe->line, 39);
+
+  EXPECT_EQ(index.FindKeyframe("GPRMC/0", 5000), nullptr);
+  EXPECT_EQ(index.FindKeyframe("GPZDA/0", 55000), nullptr);
+
+  keyframe = index.FindKeyframeBeforeLine(20);
+  ASSERT_NE(keyframe, nullptr);
+  EXPECT_EQ(keyframe->line, 19);
+  EXPECT_EQ(index.FindKeyframeBeforeLine(9), nullptr);
+}
+
+// Long recordings thin the index instead of growing it without bound.
+TEST(KeyframeTests, IndexIsBounded) {
+  KeyframeIndex index(10, 8);
+  for (int line = 0; line < 1000; line++) {
+    index.AddLine(line, "$GPRMC," + std::to_string(line) + "*00");
+  }
+  EXPECT_LE(index.GetCount(), 8u);
+  EXPECT_EQ(index.GetIntervalLines(), 160);
+
+  // The remaining keyframes stay aligned with the current interval.
+  const Keyframe* keyframe = index.FindKeyframeBeforeLine(999);
+  ASSERT_NE(keyframe, nullptr);
+  EXPECT_EQ(keyframe->line, 959);
+  EXPECT_EQ(keyframe->state.GetMessages()[0], "$GPRMC,959*00");
+  keyframe = index.FindKeyframeBeforeLine(500);
+  ASSERT_NE(keyframe, nullptr);
+  EXPECT_EQ(keyframe->line, 479);
+
+  index.Clear();
+  EXPECT_EQ(index.GetCount(), 0u);
+  EXPECT_EQ(index.GetIntervalLines(), 10);
+}
@@ -29,6 +29,7 @@
 #include <wx/string.h>
 #include <wx/window.h>
 #include <wx/event.h>
+#include <wx/jsonval.h>
 
 #include <vector>
 #include <memory>
@@ -39,12 +40,21 @@
 
 // Global counter to track NMEA sentences pushed to buffer
 static std::vector<wxString> g_nmea_sentences;
+static std::vector<std::chrono::steady_clock::time_point> g_nmea_receive_times;
 
 // Helper functions to access mock state
-void ClearNMEASentences() { g_nmea_sentences.clear(); }
+void ClearNMEASentences() {
+  g_nmea_sentences.clear();
+  g_nmea_receive_times.clear();
+}
 
 const std::vector<wxString> &GetNMEASentences() { return g_nmea_sentences; }
 
+const std::vector<std::chrono::steady_clock::time_point>
+    &GetNMEAReceiveTimes() {
+  return g_nmea_receive_times;
+}
+
 // Plugin API mock implementations
 extern "C" {
 
@@ -58,6 +68,7 @@ wxWindow *GetOCPNCanvasWindow() { return 0; }
 
 DECL_EXP void PushNMEABuffer(wxString str) {
   g_nmea_sentences.push_back(str.Strip(wxString::both));
+  g_nmea_receive_times.push_back(std::chrono::steady_clock::now());
 }
 
 }  // extern "C"
@@ -124,6 +135,16 @@ std::shared_ptr<ObservableListener> DECL_EXP GetListener(NMEA2000Id id,
   return std::make_shared<ObservableListener>(id.id, eh, et);
 }
 
+std::shared_ptr<ObservableListener> DECL_EXP GetListener(SignalkId id,
+                                                         wxEventType et,
+                                                         wxEvtHandler *eh) {
+  return std::make_shared<ObservableListener>(0, eh, et);
+}
+
+std::shared_ptr<void> DECL_EXP GetSignalkPayload(ObservedEvt /* evt */) {
+  return std::make_shared<wxJSONValue>();  // Mock data, without delta
+}
+
 std::string DECL_EXP GetN2000Source(NMEA2000Id /* id */,
                                     ObservedEvt /* evt */) {
   return std::string("MockSource");
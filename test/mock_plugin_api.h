@@ -21,12 +21,16 @@
 #define _VDR_MOCK_PLUGIN_API_H_
 
 #include "ocpn_plugin.h"
+#include <chrono>
 #include <vector>
 #include <wx/string.h>
 
 // Functions to access mock state for NMEA sentence tracking
 void ClearNMEASentences();
 const std::vector<wxString>& GetNMEASentences();
+// Monotonic time at which each sentence was pushed to the buffer
+const std::vector<std::chrono::steady_clock::time_point>&
+GetNMEAReceiveTimes();
 
 // Base mock plugin class implementing all virtual functions with empty
 // implementations
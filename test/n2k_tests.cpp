@@ -0,0 +1,150 @@
+/***************************************************************************
+ *   Copyright (C) 2024 by OpenCPN development team                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ **************************************************************************/
+
+#include <cstdio>
+
+#include <gtest/gtest.h>
+#include "vdr_n2k.h"
+
+namespace {
+
+/** A position, rapid update with the OpenCPN payload as recorded by VDR. */
+const char* kRecordedPCDIN =
+    "$PCDIN,129025,93130201F801FF01E8030000080102030405060708";
+
+N2KMessage MakeMessage(uint32_t pgn, size_t length) {
+  N2KMessage message;
+  message.pgn = pgn;
+  message.priority = 3;
+  message.source = 0x10;
+  message.timestamp = 123456;
+  for (size_t i = 0; i < length; i++) {
+    message.data.push_back(static_cast<uint8_t>(i * 7 + 0x0A));
+  }
+  return message;
+}
+
+}  // namespace
+
+/** Both the VDR and the SeaSmart $PCDIN variants are parsed. */
+TEST(N2KTests, ParsePCDIN) {
+  N2KMessage message;
+  ASSERT_TRUE(ParsePCDIN(kRecordedPCDIN, &message));
+  EXPECT_EQ(message.pgn, 129025u);
+  EXPECT_EQ(message.priority, 2);
+  EXPECT_EQ(message.source, 1);
+  EXPECT_EQ(message.destination, 255);
+  EXPECT_EQ(message.timestamp, 1000u);
+  ASSERT_EQ(message.data.size(), 8u);
+  EXPECT_EQ(message.data[0], 0x01);
+  EXPECT_EQ(message.data[7], 0x08);
+
+  ASSERT_TRUE(ParsePCDIN("$PCDIN,01F801,000C72EA,09,28C36A0F1E0A3D0E*56\r\n",
+                         &message));
+  EXPECT_EQ(message.pgn, 129025u);
+  EXPECT_EQ(message.source, 9);
+  ASSERT_EQ(message.data.size(), 8u);
+  EXPECT_EQ(message.data[0], 0x28);
+
+  // The payload is rebuilt as recorded.
+  ASSERT_TRUE(ParsePCDIN(kRecordedPCDIN, &message));
+  std::vector<uint8_t> payload = MakeN2KPayload(message);
+  std::string hex;
+  char byte[3];
+  for (uint8_t value : payload) {
+    snprintf(byte, sizeof(byte), "%02X", value);
+    hex += byte;
+  }
+  EXPECT_EQ("$PCDIN,129025," + hex, kRecordedPCDIN);
+
+  EXPECT_FALSE(ParsePCDIN("$IIMTW,16.8,C*1C", &message));
+  EXPECT_FALSE(ParsePCDIN("$PCDIN,129025,93130201F8", &message));
+}
+
+/** Actisense messages decode to what was encoded, escaped DLE included. */
+TEST(N2KTests, ActisenseRoundTrip) {
+  N2KMessage message = MakeMessage(129029, 43);
+  message.data[5] = 0x10;
+  std::string encoded = EncodeActisenseN2K(message);
+  EXPECT_EQ(encoded.substr(0, 2), std::string("\x10\x02"));
+  EXPECT_EQ(encoded.substr(encoded.size() - 2), std::string("\x10\x03"));
+
+  uint32_t pgn = 0;
+  ASSERT_TRUE(GetN2KMessagePGN(encoded.data(), encoded.size(), &pgn));
+  EXPECT_EQ(pgn, 129029u);
+
+  N2KMessage decoded;
+  size_t consumed = 0;
+  ASSERT_TRUE(DecodeActisenseN2K(
+      reinterpret_cast<const uint8_t*>(encoded.data()), encoded.size(),
+      &decoded, &consumed));
+  EXPECT_EQ(consumed, encoded.size());
+  EXPECT_EQ(decoded.pgn, message.pgn);
+  EXPECT_EQ(decoded.priority, message.priority);
+  EXPECT_EQ(decoded.source, message.source);
+  EXPECT_EQ(decoded.timestamp, message.timestamp);
+  EXPECT_EQ(decoded.data, message.data);
+
+  // A truncated message is rejected.
+  EXPECT_FALSE(DecodeActisenseN2K(
+      reinterpret_cast<const uint8_t*>(encoded.data()), encoded.size() - 1,
+      &decoded, &consumed));
+}
+
+/** Fast packet messages are split in YD RAW frames and reassembled. */
+TEST(N2KTests, YDRawRoundTrip) {
+  N2KMessage message = MakeMessage(129029, 43);
+  YDRawEncoder encoder;
+  std::string frames = encoder.Encode(message, 0);
+  // 6 bytes in the first frame, 7 in the next ones.
+  std::vector<std::string> lines;
+  size_t start = 0;
+  for (size_t end; (end = frames.find("\r\n", start)) != std::string::npos;
+       start = end + 2) {
+    lines.push_back(frames.substr(start, end - start));
+  }
+  ASSERT_EQ(lines.size(), 7u);
+  EXPECT_EQ(lines[0].substr(0, 24), "00:00:00.000 R 0DF80510 ");
+
+  uint32_t pgn = 0;
+  ASSERT_TRUE(GetN2KMessagePGN(lines[0].data(), lines[0].size(), &pgn));
+  EXPECT_EQ(pgn, 129029u);
+
+  YDRawDecoder decoder;
+  N2KMessage decoded;
+  for (size_t i = 0; i + 1 < lines.size(); i++) {
+    EXPECT_FALSE(decoder.Decode(lines[i], &decoded));
+  }
+  ASSERT_TRUE(decoder.Decode(lines.back(), &decoded));
+  EXPECT_EQ(decoded.pgn, message.pgn);
+  EXPECT_EQ(decoded.priority, message.priority);
+  EXPECT_EQ(decoded.source, message.source);
+  EXPECT_EQ(decoded.data, message.data);
+
+  // Addressed single frame message.
+  N2KMessage request = MakeMessage(59904, 3);
+  request.priority = 6;
+  request.destination = 0x23;
+  std::string frame = encoder.Encode(request, 0);
+  EXPECT_EQ(frame, "00:00:00.000 R 18EA2310 0A 11 18\r\n");
+  ASSERT_TRUE(decoder.Decode(frame, &decoded));
+  EXPECT_EQ(decoded.pgn, 59904u);
+  EXPECT_EQ(decoded.destination, 0x23);
+  EXPECT_EQ(decoded.data, request.data);
+}
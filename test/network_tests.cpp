@@ -0,0 +1,565 @@
+/***************************************************************************
+ *   Copyright (C) 2024 by OpenCPN development team                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ **************************************************************************/
+
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "wx/wxprec.h"
+
+#ifndef WX_PRECOMP
+#include "wx/wx.h"
+#endif  // precompiled headers
+#include "wx/init.h"
+#include "wx/socket.h"
+#include "wx/tokenzr.h"
+
+#include "vdr_network.h"
+#include "vdr_spsc_queue.h"
+
+/** The oldest messages are dropped when the queue is full. */
+TEST(VDRSendQueueTests, DropOldest) {
+  const std::string message = "$IIMTW,16.8,C*1C\r\n";
+  VDRSendQueue queue(3 * message.size());
+  for (int i = 0; i < 5; i++) {
+    EXPECT_TRUE(queue.Push(message.data(), message.size(), i));
+    EXPECT_LE(queue.GetBytes(), 3 * message.size());
+  }
+  EXPECT_EQ(queue.GetMessagesDropped(), 2u);
+  EXPECT_EQ(queue.GetBytesDropped(), 2 * message.size());
+  // The messages queued at 0 and 1 ms were dropped.
+  EXPECT_EQ(queue.GetLagMs(10), 8);
+
+  // Lowering the limit drops messages immediately.
+  queue.SetMaxBytes(message.size());
+  EXPECT_EQ(queue.GetBytes(), message.size());
+  EXPECT_EQ(queue.GetMessagesDropped(), 4u);
+}
+
+/** A partially sent message is never dropped. */
+TEST(VDRSendQueueTests, PartialWrite) {
+  VDRSendQueue queue(10);
+  ASSERT_TRUE(queue.Push("abcd", 4, 0));
+  ASSERT_TRUE(queue.Push("efgh", 4, 1));
+  queue.Consume(2);
+  EXPECT_EQ(queue.GetBytes(), 6u);
+  EXPECT_EQ(queue.GetBytesSent(), 2u);
+
+  // Room is made by dropping the second message, not the one being sent.
+  ASSERT_TRUE(queue.Push("ijklm", 5, 2));
+  EXPECT_EQ(queue.GetMessagesDropped(), 1u);
+  EXPECT_EQ(std::string(queue.GetFrontData(), queue.GetFrontLength()), "cd");
+  queue.Consume(2);
+  EXPECT_EQ(std::string(queue.GetFrontData(), queue.GetFrontLength()),
+            "ijklm");
+  queue.Consume(5);
+  EXPECT_TRUE(queue.IsEmpty());
+  EXPECT_EQ(queue.GetBytes(), 0u);
+  EXPECT_EQ(queue.GetBytesSent(), 9u);
+  EXPECT_EQ(queue.GetLagMs(10), 0);
+}
+
+/** A message larger than the queue is dropped without flushing the queue. */
+TEST(VDRSendQueueTests, OversizedMessage) {
+  VDRSendQueue queue(10);
+  ASSERT_TRUE(queue.Push("abcd", 4, 0));
+  EXPECT_FALSE(queue.Push("0123456789a", 11, 1));
+  EXPECT_EQ(queue.GetMessagesDropped(), 1u);
+  EXPECT_EQ(queue.GetBytesDropped(), 11u);
+  EXPECT_EQ(queue.GetBytes(), 4u);
+}
+
+/** Queues share the messages, and write several of them at once. */
+TEST(VDRSendQueueTests, SharedMessages) {
+  VDRMessagePtr first = MakeVDRMessage("$IIMTW,16.8,C*1C");
+  VDRMessagePtr second = MakeVDRMessage("$IIHDG,25.0,0,E,0.0,E*60\r\n");
+  EXPECT_EQ(*first, "$IIMTW,16.8,C*1C\r\n");
+  EXPECT_EQ(*second, "$IIHDG,25.0,0,E,0.0,E*60\r\n");
+
+  VDRSendQueue queue1(1024);
+  VDRSendQueue queue2(1024);
+  for (VDRSendQueue* queue : {&queue1, &queue2}) {
+    ASSERT_TRUE(queue->Push(first, 0));
+    ASSERT_TRUE(queue->Push(second, 0));
+  }
+  // The queues reference the messages, they do not copy them.
+  EXPECT_EQ(queue1.GetFrontData(), first->data());
+  EXPECT_EQ(queue2.GetFrontData(), first->data());
+  EXPECT_EQ(first.use_count(), 3);
+
+  // A gathered write may end in the middle of a message.
+  std::vector<std::pair<const char*, size_t>> buffers;
+  queue1.GetPending(buffers, 64);
+  ASSERT_EQ(buffers.size(), 2u);
+  EXPECT_EQ(buffers[1].first, second->data());
+  queue1.Consume(first->size() + 3);
+  EXPECT_EQ(queue1.GetFrontData(), second->data() + 3);
+  EXPECT_EQ(queue1.GetBytes(), second->size() - 3);
+  EXPECT_EQ(first.use_count(), 2);
+  queue1.GetPending(buffers, 64);
+  ASSERT_EQ(buffers.size(), 1u);
+  EXPECT_EQ(buffers[0].second, second->size() - 3);
+  queue1.Consume(buffers[0].second);
+  EXPECT_TRUE(queue1.IsEmpty());
+  EXPECT_EQ(queue1.GetBytesSent(), first->size() + second->size());
+}
+
+/** Queued UDP messages are packed in as few datagrams as possible. */
+TEST(VDRNetworkTests, UDPBatch) {
+  wxInitializer initializer;
+  ASSERT_TRUE(initializer.IsOk());
+  const int port = 39111;
+  wxIPV4address addr;
+  addr.Hostname("127.0.0.1");
+  addr.Service(port);
+  wxDatagramSocket receiver(addr, wxSOCKET_BLOCK);
+  ASSERT_TRUE(receiver.IsOk());
+
+  VDRNetworkServer server;
+  wxString error;
+  ASSERT_TRUE(server.Start(false, port, error)) << error;
+  const wxString sentence = "$IIVHW,,T,25.0,M,5.9,N,10.9,K*78";
+  const int count = 200;
+  for (int i = 0; i < count; i++) {
+    server.QueueText(sentence);
+  }
+  EXPECT_TRUE(server.Flush());
+
+  int datagrams = 0;
+  int sentences = 0;
+  char buffer[2048];
+  wxIPV4address from;
+  while (sentences < count && receiver.WaitForRead(1)) {
+    receiver.RecvFrom(from, buffer, sizeof(buffer));
+    ASSERT_FALSE(receiver.Error());
+    wxString data(buffer, receiver.LastCount());
+    EXPECT_LE(data.length(), 1472u);
+    // Only whole sentences are sent.
+    EXPECT_TRUE(data.EndsWith("\r\n"));
+    wxStringTokenizer tokenizer(data, "\r\n", wxTOKEN_STRTOK);
+    while (tokenizer.HasMoreTokens()) {
+      EXPECT_EQ(tokenizer.GetNextToken(), sentence);
+      sentences++;
+    }
+    datagrams++;
+  }
+  EXPECT_EQ(sentences, count);
+  // 43 sentences of 34 bytes fit in a datagram.
+  EXPECT_EQ(datagrams, 5);
+  server.Stop();
+}
+
+/** Count the sentences received by a datagram socket. */
+static int ReceiveSentences(wxDatagramSocket& receiver, int expected) {
+  int sentences = 0;
+  char buffer[2048];
+  wxIPV4address from;
+  while (sentences < expected && receiver.WaitForRead(1)) {
+    receiver.RecvFrom(from, buffer, sizeof(buffer));
+    if (receiver.Error()) break;
+    wxString data(buffer, receiver.LastCount());
+    wxStringTokenizer tokenizer(data, "\r\n", wxTOKEN_STRTOK);
+    while (tokenizer.HasMoreTokens()) {
+      tokenizer.GetNextToken();
+      sentences++;
+    }
+  }
+  return sentences;
+}
+
+/** Every unicast destination receives every sentence. */
+TEST(VDRNetworkTests, UDPUnicast) {
+  wxInitializer initializer;
+  ASSERT_TRUE(initializer.IsOk());
+  const int port = 39113;
+  wxIPV4address addr1;
+  addr1.Hostname("127.0.0.1");
+  addr1.Service(port);
+  wxDatagramSocket receiver1(addr1, wxSOCKET_BLOCK);
+  ASSERT_TRUE(receiver1.IsOk());
+  wxIPV4address addr2;
+  addr2.Hostname("127.0.0.1");
+  addr2.Service(port + 1);
+  wxDatagramSocket receiver2(addr2, wxSOCKET_BLOCK);
+  ASSERT_TRUE(receiver2.IsOk());
+
+  VDRNetworkServer server;
+  VDRUdpDestinations destinations;
+  destinations.mode = VDRUdpMode::UNICAST;
+  // The first destination uses the server port.
+  destinations.addresses = "127.0.0.1, localhost:39114";
+  server.SetUDPDestinations(destinations);
+  wxString error;
+  ASSERT_TRUE(server.Start(false, port, error)) << error;
+  const int count = 200;
+  for (int i = 0; i < count; i++) {
+    server.QueueText("$IIVHW,,T,25.0,M,5.9,N,10.9,K*78");
+  }
+  EXPECT_TRUE(server.Flush());
+  EXPECT_EQ(ReceiveSentences(receiver1, count), count);
+  EXPECT_EQ(ReceiveSentences(receiver2, count), count);
+  server.Stop();
+}
+
+/** A destination that fails on every send does not hold up the others. */
+TEST(VDRNetworkTests, UDPUnreachableDestination) {
+  wxInitializer initializer;
+  ASSERT_TRUE(initializer.IsOk());
+  const int port = 39119;
+  wxIPV4address addr;
+  addr.Hostname("127.0.0.1");
+  addr.Service(port);
+  wxDatagramSocket receiver(addr, wxSOCKET_BLOCK);
+  ASSERT_TRUE(receiver.IsOk());
+
+  VDRNetworkServer server;
+  VDRUdpDestinations destinations;
+  destinations.mode = VDRUdpMode::UNICAST;
+  // Sending to the broadcast address fails, broadcast is not enabled in
+  // unicast mode.
+  destinations.addresses = "255.255.255.255, 127.0.0.1";
+  server.SetUDPDestinations(destinations);
+  wxString error;
+  ASSERT_TRUE(server.Start(false, port, error)) << error;
+  const int count = 200;
+  for (int batch = 0; batch < 2; batch++) {
+    for (int i = 0; i < count; i++) {
+      server.QueueText("$IIVHW,,T,25.0,M,5.9,N,10.9,K*78");
+    }
+    EXPECT_TRUE(server.Flush());
+    EXPECT_EQ(ReceiveSentences(receiver, count), count);
+  }
+  server.Stop();
+}
+
+/** Invalid UDP destinations are reported when the server starts. */
+TEST(VDRNetworkTests, UDPInvalidDestinations) {
+  wxInitializer initializer;
+  ASSERT_TRUE(initializer.IsOk());
+  VDRNetworkServer server;
+  VDRUdpDestinations destinations;
+  wxString error;
+
+  destinations.mode = VDRUdpMode::UNICAST;
+  destinations.addresses = "127.0.0.1:0";
+  server.SetUDPDestinations(destinations);
+  EXPECT_FALSE(server.Start(false, 39113, error));
+  EXPECT_FALSE(error.IsEmpty());
+
+  destinations.addresses = "";
+  server.SetUDPDestinations(destinations);
+  EXPECT_FALSE(server.Start(false, 39113, error));
+
+  // Not a class D address.
+  destinations.mode = VDRUdpMode::MULTICAST;
+  destinations.addresses = "10.0.0.1";
+  server.SetUDPDestinations(destinations);
+  EXPECT_FALSE(server.Start(false, 39113, error));
+  EXPECT_FALSE(server.IsRunning());
+
+  destinations.addresses = "239.192.0.1";
+  destinations.multicastTtl = 2;
+  server.SetUDPDestinations(destinations);
+  EXPECT_TRUE(server.Start(false, 39113, error)) << error;
+  server.Stop();
+}
+
+/** Items cross from the producer to the consumer thread in order. */
+TEST(VDRNetworkTests, SpscQueue) {
+  VDRSpscQueue<std::string> queue(16);
+  const int count = 100000;
+  std::thread consumer([&queue]() {
+    std::string item;
+    for (int i = 0; i < count;) {
+      if (queue.Pop(item)) {
+        EXPECT_EQ(item, std::to_string(i));
+        i++;
+      }
+    }
+  });
+  for (int i = 0; i < count;) {
+    std::string item = std::to_string(i);
+    if (queue.Push(std::move(item))) i++;
+  }
+  consumer.join();
+  EXPECT_TRUE(queue.IsEmpty());
+}
+
+/** TCP clients receive the data, slow clients are disconnected. */
+TEST(VDRNetworkTests, TCPClients) {
+  wxInitializer initializer;
+  ASSERT_TRUE(initializer.IsOk());
+  const int port = 39112;
+  VDRNetworkServer server;
+  VDRClientQueueSettings settings;
+  settings.maxBytes = 4096;
+  settings.policy = VDRSlowClientPolicy::DISCONNECT;
+  settings.maxLagMs = 200;
+  server.SetClientQueueSettings(settings);
+  wxString error;
+  ASSERT_TRUE(server.Start(true, port, error)) << error;
+
+  wxIPV4address addr;
+  addr.Hostname("127.0.0.1");
+  addr.Service(port);
+  wxSocketClient client(wxSOCKET_BLOCK);
+  ASSERT_TRUE(client.Connect(addr, true));
+  for (int i = 0; i < 100 && server.GetClientStats().empty(); i++) {
+    wxMilliSleep(10);
+  }
+  ASSERT_EQ(server.GetClientStats().size(), 1u);
+
+  // The whole batch is received.
+  const std::string sentence = "$IIVHW,,T,25.0,M,5.9,N,10.9,K*78\r\n";
+  for (int i = 0; i < 100; i++) {
+    server.QueueText(sentence);
+  }
+  EXPECT_TRUE(server.Flush());
+  std::string received;
+  char buffer[4096];
+  while (received.size() < 100 * sentence.size() && client.WaitForRead(1)) {
+    client.Read(buffer, sizeof(buffer));
+    received.append(buffer, client.LastCount());
+  }
+  EXPECT_EQ(received.size(), 100 * sentence.size());
+  EXPECT_EQ(received.substr(0, sentence.size()), sentence);
+
+  // Stop reading until the server gives up on the client.
+  for (int i = 0; i < 2000 && !server.GetClientStats().empty(); i++) {
+    for (int j = 0; j < 1000; j++) {
+      server.QueueText(sentence);
+    }
+    server.Flush();
+    wxMilliSleep(1);
+  }
+  EXPECT_TRUE(server.GetClientStats().empty());
+  server.Stop();
+}
+
+/** A TCP client only receives the messages it subscribed to. */
+TEST(VDRNetworkTests, TCPSubscription) {
+  wxInitializer initializer;
+  ASSERT_TRUE(initializer.IsOk());
+  const int port = 39115;
+  VDRNetworkServer server;
+  wxString error;
+  EXPECT_FALSE(server.SetFilter("GP-RMC", error));
+  EXPECT_FALSE(error.IsEmpty());
+  ASSERT_TRUE(server.SetFilter("GPRMC, ??GGA", error)) << error;
+  EXPECT_EQ(server.GetFilter(), "GPRMC,??GGA");
+  ASSERT_TRUE(server.Start(true, port, error)) << error;
+
+  wxIPV4address addr;
+  addr.Hostname("127.0.0.1");
+  addr.Service(port);
+  wxSocketClient client(wxSOCKET_BLOCK);
+  ASSERT_TRUE(client.Connect(addr, true));
+  for (int i = 0; i < 100 && server.GetClientStats().empty(); i++) {
+    wxMilliSleep(10);
+  }
+  ASSERT_EQ(server.GetClientStats().size(), 1u);
+
+  auto exchange = [&]() {
+    server.QueueText("$GPRMC,,V,,,,,,,,,,N*53");
+    server.QueueText("!AIVDM,1,1,,A,13aEOK?P00PD2wVMdLDRhgvL289?,0*26");
+    server.QueueText("$IIMTW,16.8,C*1C");
+    server.QueueText("$PCDIN,01F801,000C72EA,09,28C36A0000B40AFD*56");
+    server.Flush();
+    // Read until the server has nothing more to send.
+    std::string received;
+    char buffer[1024];
+    while (client.WaitForRead(0, 300)) {
+      client.Read(buffer, sizeof(buffer));
+      if (client.LastCount() == 0) break;
+      received.append(buffer, client.LastCount());
+    }
+    return received;
+  };
+  auto subscribe = [&](const std::string& command) {
+    client.Write(command.data(), command.size());
+    // Sent as a distinct exchange so the server handles it first.
+    wxMilliSleep(200);
+  };
+
+  // Without a subscription, the port filter applies.
+  EXPECT_EQ(exchange(), "$GPRMC,,V,,,,,,,,,,N*53\r\n");
+
+  subscribe("subscribe AI*, 129025\r\n");
+  EXPECT_EQ(exchange(),
+            "!AIVDM,1,1,,A,13aEOK?P00PD2wVMdLDRhgvL289?,0*26\r\n"
+            "$PCDIN,01F801,000C72EA,09,28C36A0000B40AFD*56\r\n");
+
+  // An invalid subscription is ignored.
+  subscribe("SUBSCRIBE AI-VDM\n");
+  EXPECT_EQ(exchange(),
+            "!AIVDM,1,1,,A,13aEOK?P00PD2wVMdLDRhgvL289?,0*26\r\n"
+            "$PCDIN,01F801,000C72EA,09,28C36A0000B40AFD*56\r\n");
+
+  subscribe("SUBSCRIBE *\n");
+  EXPECT_EQ(exchange().size(), 139u);
+
+  // An empty subscription reverts to the port filter.
+  subscribe("SUBSCRIBE\n");
+  EXPECT_EQ(exchange(), "$GPRMC,,V,,,,,,,,,,N*53\r\n");
+  server.Stop();
+}
+
+/** Lines are returned in place, across reads and line ending styles. */
+TEST(VDRLineReaderTests, SplitLines) {
+  VDRLineReader reader(32);
+  char* buffer = nullptr;
+  auto receive = [&](const std::string& data) {
+    size_t space;
+    buffer = reader.GetWriteBuffer(&space);
+    ASSERT_GE(space, data.size());
+    std::memcpy(buffer, data.data(), data.size());
+    reader.Commit(data.size());
+  };
+  const char* line;
+  size_t length;
+
+  receive("$IIMTW,16.8,C*1C\r\n$IIHDG,2");
+  ASSERT_TRUE(reader.NextLine(&line, &length));
+  EXPECT_EQ(std::string(line, length), "$IIMTW,16.8,C*1C");
+  // The line is not copied out of the receive buffer.
+  EXPECT_EQ(line, buffer);
+  EXPECT_FALSE(reader.NextLine(&line, &length));
+
+  // The incomplete line is completed by the next read.
+  receive("5.0,0,E,0.0,E*60\n\n");
+  ASSERT_TRUE(reader.NextLine(&line, &length));
+  EXPECT_EQ(std::string(line, length), "$IIHDG,25.0,0,E,0.0,E*60");
+  EXPECT_FALSE(reader.NextLine(&line, &length));
+
+  // A line longer than the buffer is skipped.
+  receive(std::string(32, 'x'));
+  EXPECT_FALSE(reader.NextLine(&line, &length));
+  receive("xx\r\n$IIMTW,16.8,C*1C\r\n");
+  ASSERT_TRUE(reader.NextLine(&line, &length));
+  EXPECT_EQ(std::string(line, length), "$IIMTW,16.8,C*1C");
+  EXPECT_EQ(reader.GetLinesDiscarded(), 1u);
+
+  // A datagram may end without line ending.
+  receive("$IIMTW,16.8,C*1C");
+  EXPECT_FALSE(reader.NextLine(&line, &length));
+  ASSERT_TRUE(reader.TakeRest(&line, &length));
+  EXPECT_EQ(std::string(line, length), "$IIMTW,16.8,C*1C");
+  EXPECT_FALSE(reader.TakeRest(&line, &length));
+}
+
+/** Collects the lines received by a network client. */
+class LineCollector {
+public:
+  VDRNetworkClient::LineHandler GetHandler() {
+    return [this](const char* line, size_t length) {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_lines.emplace_back(line, length);
+    };
+  }
+
+  /** Wait for lines, and return the lines received so far. */
+  std::vector<std::string> Wait(size_t expected) {
+    for (int i = 0; i < 200; i++) {
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_lines.size() >= expected) break;
+      }
+      wxMilliSleep(10);
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_lines;
+  }
+
+private:
+  std::mutex m_mutex;
+  std::vector<std::string> m_lines;
+};
+
+/** A TCP network source is received line by line. */
+TEST(VDRNetworkTests, TCPInput) {
+  wxInitializer initializer;
+  ASSERT_TRUE(initializer.IsOk());
+  const int port = 39116;
+  VDRNetworkServer server;
+  wxString error;
+  ASSERT_TRUE(server.Start(true, port, error)) << error;
+
+  LineCollector collector;
+  VDRNetworkClient client;
+  ASSERT_TRUE(
+      client.Start(true, "127.0.0.1", port, collector.GetHandler(), error))
+      << error;
+  for (int i = 0; i < 200 && server.GetClientStats().empty(); i++) {
+    wxMilliSleep(10);
+  }
+  ASSERT_EQ(server.GetClientStats().size(), 1u);
+  EXPECT_TRUE(client.IsConnected());
+
+  const char* frames[] = {"$IIMTW,16.8,C*1C",
+                          "00:00:00.000 R 09F80110 01 02 03 04 05 06 07 08",
+                          "$PCDIN,129025,93130201F801FF01E80300000801020304"
+                          "05060708"};
+  for (const char* frame : frames) {
+    server.QueueText(frame);
+  }
+  server.Flush();
+  std::vector<std::string> lines = collector.Wait(3);
+  ASSERT_EQ(lines.size(), 3u);
+  for (size_t i = 0; i < lines.size(); i++) {
+    EXPECT_EQ(lines[i], frames[i]);
+  }
+  EXPECT_EQ(client.GetLinesReceived(), 3u);
+
+  // The client notices when the source goes away.
+  server.Stop();
+  for (int i = 0; i < 200 && client.IsConnected(); i++) {
+    wxMilliSleep(10);
+  }
+  EXPECT_FALSE(client.IsConnected());
+  client.Stop();
+}
+
+/** UDP datagrams are received line by line. */
+TEST(VDRNetworkTests, UDPInput) {
+  wxInitializer initializer;
+  ASSERT_TRUE(initializer.IsOk());
+  const int port = 39117;
+  LineCollector collector;
+  VDRNetworkClient client;
+  wxString error;
+  ASSERT_TRUE(client.Start(false, wxEmptyString, port, collector.GetHandler(),
+                           error))
+      << error;
+
+  VDRNetworkServer server;
+  ASSERT_TRUE(server.Start(false, port, error)) << error;
+  const int count = 100;
+  for (int i = 0; i < count; i++) {
+    server.QueueText("$IIVHW,,T,25.0,M,5.9,N,10.9,K*78");
+  }
+  server.Flush();
+  std::vector<std::string> lines = collector.Wait(count);
+  ASSERT_EQ(lines.size(), static_cast<size_t>(count));
+  EXPECT_EQ(lines.back(), "$IIVHW,,T,25.0,M,5.9,N,10.9,K*78");
+  server.Stop();
+  client.Stop();
+  EXPECT_FALSE(client.IsRunning());
+}
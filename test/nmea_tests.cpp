@@ -0,0 +1,116 @@
+/***************************************************************************
+ *   Copyright (C) 2024 by OpenCPN development team                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ **************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include "wx/wxprec.h"
+
+#ifndef WX_PRECOMP
+#include "wx/wx.h"
+#endif  // precompiled headers
+
+#include "wx/textfile.h"
+
+#include "vdr_nmea.h"
+
+namespace {
+
+NMEASentenceStatus Validate(const wxString& sentence,
+                            NMEASentenceHeader* header = nullptr) {
+  const wxStringCharType* text = sentence.wx_str();
+  return ValidateNMEASentence(
+      text, std::char_traits<wxStringCharType>::length(text), header);
+}
+
+}  // namespace
+
+/** Well formed sentences are classified in the same pass. */
+TEST(NMEAValidatorTests, ValidSentences) {
+  NMEASentenceHeader header;
+  EXPECT_EQ(Validate("$IIMTW,16.8,C*1C", &header), NMEASentenceStatus::VALID);
+  EXPECT_EQ(wxString(header.talkerId, 2), "II");
+  EXPECT_EQ(wxString(header.sentenceId, 3), "MTW");
+  EXPECT_FALSE(header.isAIS);
+
+  EXPECT_EQ(Validate("!AIVDM,1,1,,B,13u=gHP3CWPlvs2Q8sHW:5fD0h6a,0*1B\r\n",
+                     &header),
+            NMEASentenceStatus::VALID);
+  EXPECT_EQ(wxString(header.talkerId, 2), "AI");
+  EXPECT_EQ(wxString(header.sentenceId, 3), "VDM");
+  EXPECT_TRUE(header.isAIS);
+
+  // Lowercase checksum.
+  EXPECT_EQ(Validate("$IIDPT,14.8,0.4,100.0*7a"), NMEASentenceStatus::VALID);
+}
+
+/** Sentences with a bad checksum still have a valid header. */
+TEST(NMEAValidatorTests, BadChecksum) {
+  NMEASentenceHeader header;
+  EXPECT_EQ(Validate("$IIMTW,16.9,C*1C", &header),
+            NMEASentenceStatus::BAD_CHECKSUM);
+  EXPECT_EQ(wxString(header.sentenceId, 3), "MTW");
+  EXPECT_EQ(Validate("$IIMTW,16.8,C*1G"), NMEASentenceStatus::BAD_CHECKSUM);
+  EXPECT_EQ(Validate("$IIMTW,16.8,C*1C7"), NMEASentenceStatus::BAD_CHECKSUM);
+  EXPECT_EQ(Validate("$IIMTW,16.8*,C"), NMEASentenceStatus::BAD_CHECKSUM);
+  EXPECT_EQ(Validate(wxString::FromUTF8("$IIMTW,16.8,\xC2\xB0*1C")),
+            NMEASentenceStatus::BAD_CHECKSUM);
+}
+
+TEST(NMEAValidatorTests, Malformed) {
+  EXPECT_EQ(Validate(""), NMEASentenceStatus::MALFORMED);
+  EXPECT_EQ(Validate("# Comment"), NMEASentenceStatus::MALFORMED);
+  EXPECT_EQ(Validate("$IIMTW,16.8,C"), NMEASentenceStatus::MALFORMED);
+  EXPECT_EQ(Validate("$IiMTW,16.8,C*1C"), NMEASentenceStatus::MALFORMED);
+  EXPECT_EQ(Validate("$IIMT1,16.8,C*1C"), NMEASentenceStatus::MALFORMED);
+  EXPECT_EQ(Validate("$IIMTWX,16.8,C*1C"), NMEASentenceStatus::MALFORMED);
+  // AIS sentences from other talkers.
+  EXPECT_EQ(Validate("!GPVDM,1,1,,B,13u=gHP3CWPlvs2Q8sHW:5fD0h6a,0*1B"),
+            NMEASentenceStatus::MALFORMED);
+}
+
+/** The vectorized checksum matches a plain XOR whatever the length. */
+TEST(NMEAValidatorTests, ChecksumAllLengths) {
+  wxString data("GPRMC,092211.00,A,5759.09700,N,01144.34344,E,5.257,28.27,"
+                "200715,,,A");
+  const wxStringCharType* text = data.wx_str();
+  for (size_t length = 0; length <= data.length(); length++) {
+    uint8_t expected = 0;
+    for (size_t i = 0; i < length; i++) {
+      expected ^= static_cast<uint8_t>(text[i]);
+    }
+    bool isAscii = false;
+    EXPECT_EQ(ComputeNMEAChecksum(text, length, &isAscii), expected)
+        << "length " << length;
+    EXPECT_TRUE(isAscii);
+  }
+}
+
+/** The test recordings are free of corrupt sentences. */
+TEST(NMEAValidatorTests, Recording) {
+  wxTextFile file(wxString(TESTDATA) + "/hakan.txt");
+  ASSERT_TRUE(file.Open());
+  size_t valid = 0;
+  for (size_t i = 0; i < file.GetLineCount(); i++) {
+    NMEASentenceStatus status = Validate(file[i]);
+    EXPECT_NE(status, NMEASentenceStatus::BAD_CHECKSUM) << file[i];
+    if (status == NMEASentenceStatus::VALID) valid++;
+  }
+  // All but the empty last line.
+  EXPECT_EQ(valid, file.GetLineCount() - 1);
+}
@@ -23,6 +23,11 @@
 #include "wx/wx.h"
 #endif  // precompiled headers
 #include "wx/tokenzr.h"
+#include "wx/file.h"
+#include "wx/filename.h"
+#include "wx/dir.h"
+
+#include <mutex>
 
 #include <gtest/gtest.h>
 #include "vdr_pi_time.h"
@@ -102,6 +107,74 @@ TEST(VDRPluginTests, ProgressFractionNoPlayback) {
       << "Expected progress fraction to be near 0.5";
 }
 
+/** Playback is scheduled on the millisecond timeline of the file. */
+TEST(VDRPluginTests, PlaybackSchedule) {
+  vdr_pi plugin(nullptr);
+  wxString testfile = wxString(TESTDATA) + wxString("/hakan.txt");
+  ASSERT_TRUE(plugin.LoadFile(testfile)) << "Failed to load test file";
+  bool hasValidTimestamps;
+  wxString error;
+  ASSERT_TRUE(plugin.ScanFileTimestamps(hasValidTimestamps, error));
+  ASSERT_TRUE(hasValidTimestamps);
+
+  VDRTimeMs first = plugin.GetFirstTimeMs();
+  EXPECT_EQ(plugin.GetFirstTimestamp(), FromTimeMs(first));
+  EXPECT_EQ(ToTimeMs(plugin.GetLastTimestamp()), plugin.GetLastTimeMs());
+
+  // Not scheduled before playback starts.
+  EXPECT_EQ(plugin.GetNextPlaybackTime(), INVALID_TIME_MS);
+
+  // The current position is played now.
+  plugin.SetCurrentTimeMs(first + 10000);
+  VDRTimeMs before = wxGetUTCTimeMillis().GetValue();
+  plugin.AdjustPlaybackBaseTime();
+  VDRTimeMs after = wxGetUTCTimeMillis().GetValue();
+  VDRTimeMs base = plugin.GetNextPlaybackTime();
+  EXPECT_GE(base, before);
+  EXPECT_LE(base, after);
+
+  // Later messages are played at the same pace as they were recorded.
+  plugin.SetCurrentTimeMs(first + 12345);
+  EXPECT_EQ(plugin.GetNextPlaybackTime(), base + 2345);
+}
+
+/** Seeking should restore the vessel and AIS target state immediately. */
+TEST(VDRPluginTests, SeekEmitsStateSnapshot) {
+  vdr_pi plugin(nullptr);
+
+  wxString testfile = wxString(TESTDATA) + wxString("/hakan.txt");
+  ASSERT_TRUE(plugin.LoadFile(testfile)) << "Failed to load test file";
+  bool hasValidTimestamps;
+  wxString error;
+  ASSERT_TRUE(plugin.ScanFileTimestamps(hasValidTimestamps, error))
+      << wxString::Format("Failed to scan timestamps: %s", error);
+
+  ClearNMEASentences();
+  ASSERT_TRUE(plugin.SeekToFraction(0.5)) << "Failed to seek to fraction 0.5";
+
+  const auto& sentences = GetNMEASentences();
+  int rmcCount = 0;
+  int aisCount = 0;
+  for (const auto& sentence : sentences) {
+    if (sentence.StartsWith("$GPRMC")) rmcCount++;
+    if (sentence.StartsWith("!AIVDM")) aisCount++;
+  }
+  EXPECT_EQ(rmcCount, 1) << "Expected the latest RMC sentence in the snapshot";
+  EXPECT_GT(aisCount, 1) << "Expected AIS targets in the snapshot";
+
+  // The snapshot is emitted in the order the messages were recorded, the
+  // last RMC sentence holds the seek position.
+  wxDateTime timestamp;
+  int precision;
+  TimestampParser parser;
+  for (const auto& sentence : sentences) {
+    if (sentence.StartsWith("$GPRMC")) {
+      ASSERT_TRUE(parser.ParseTimestamp(sentence, timestamp, precision));
+    }
+  }
+  EXPECT_EQ(timestamp, plugin.GetCurrentTimestamp());
+}
+
 TEST(VDRPluginTests, LoadFileErrors) {
   vdr_pi plugin(nullptr);
 
@@ -429,6 +502,143 @@ TEST(VDRPluginTests, PlaybackCsvFile) {
   plugin.DeInit();
 }
 
+/** Replay a file while lines are appended to it. */
+TEST(VDRPluginTests, PlaybackFollowMode) {
+  wxString testfile = wxFileName::CreateTempFileName("vdr_follow");
+  {
+    wxFile file(testfile, wxFile::write);
+    ASSERT_TRUE(file.IsOpened()) << "Failed to create " << testfile;
+    // The last line is still being written.
+    file.Write(
+        "$IIMTW,16.8,C*1C\n$IIVLW,2354.92,N,2338.533,N*79\n$IIHDG,25.0,0,E");
+  }
+
+  vdr_pi plugin(nullptr);
+  plugin.Init();
+  plugin.SetFollowMode(true);
+  ClearNMEASentences();
+
+  ASSERT_TRUE(plugin.LoadFile(testfile)) << "Failed to load test file";
+  bool hasValidTimestamps;
+  wxString error;
+  ASSERT_TRUE(plugin.ScanFileTimestamps(hasValidTimestamps, error))
+      << wxString::Format("Failed to scan timestamps: %s", error);
+
+  plugin.StartPlayback();
+  EXPECT_FALSE(plugin.IsAtFileEnd()) << "Playback should wait for more data";
+  EXPECT_TRUE(plugin.IsPlaying());
+  ASSERT_EQ(GetNMEASentences().size(), 2u);
+
+  {
+    wxFile file(testfile, wxFile::write_append);
+    file.Write(",0.0,E*60\n$IIMTW,16.8,C*1C\n");
+  }
+  // Let the follower notice the change, as the timer would do.
+  for (int i = 0; i < 10 && GetNMEASentences().size() == 2; i++) {
+    plugin.Notify();
+  }
+
+  const auto& sentences = GetNMEASentences();
+  ASSERT_EQ(sentences.size(), 4u);
+  EXPECT_EQ(sentences[2], "$IIHDG,25.0,0,E,0.0,E*60");
+  EXPECT_EQ(sentences[3], "$IIMTW,16.8,C*1C");
+
+  plugin.StopPlayback();
+  plugin.DeInit();
+  wxRemoveFile(testfile);
+}
+
+TEST(VDRPluginTests, InstantReplay) {
+  vdr_pi plugin(nullptr);
+  plugin.Init();
+  VDRTimeShiftSettings settings;
+  settings.enabled = true;
+  plugin.SetTimeShiftSettings(settings);
+
+  std::vector<wxString> received = {"$IIMTW,16.8,C*1C",
+                                    "$IIVLW,2354.92,N,2338.533,N*79",
+                                    "$IIHDG,25.0,0,E,0.0,E*60"};
+  for (wxString sentence : received) {
+    sentence += "\r\n";
+    plugin.SetNMEASentence(sentence);
+  }
+  EXPECT_EQ(plugin.GetMessageRing().GetCount(), received.size());
+
+  ClearNMEASentences();
+  ASSERT_TRUE(plugin.StartInstantReplay(10));
+  // Let the replay complete, as the timer would do.
+  for (int i = 0; i < 100 && plugin.IsInstantReplayActive(); i++) {
+    wxMilliSleep(10);
+    plugin.OnInstantReplayTimer();
+  }
+  EXPECT_FALSE(plugin.IsInstantReplayActive());
+
+  const auto sentences = GetNMEASentences();
+  ASSERT_EQ(sentences.size(), received.size());
+  for (size_t i = 0; i < received.size(); i++) {
+    EXPECT_EQ(sentences[i], received[i]);
+  }
+
+  // Replayed sentences come back from OpenCPN and must not be buffered again.
+  for (const auto& echo : sentences) {
+    wxString sentence = wxString(echo) + "\r\n";
+    plugin.SetNMEASentence(sentence);
+  }
+  EXPECT_EQ(plugin.GetMessageRing().GetCount(), received.size());
+
+  plugin.DeInit();
+}
+
+TEST(VDRPluginTests, BlackBoxTrigger) {
+  wxString dir = wxFileName::GetTempDir() + wxFileName::GetPathSeparator() +
+                 wxString::Format("vdr_blackbox_%lu", wxGetProcessId());
+  ASSERT_TRUE(wxFileName::Mkdir(dir, wxS_DIR_DEFAULT, wxPATH_MKDIR_FULL));
+
+  vdr_pi plugin(nullptr);
+  plugin.Init();
+  plugin.SetRecordingDir(dir);
+  plugin.SetDataFormat(VDRDataFormat::RawNMEA);
+  plugin.SetLogRotate(false);
+  plugin.SetAutoStartRecording(false);
+  VDRBlackBoxSettings settings;
+  settings.enabled = true;
+  plugin.SetBlackBoxSettings(settings);
+
+  std::vector<wxString> received = {"$IIMTW,16.8,C*1C",
+                                    "$IIVLW,2354.92,N,2338.533,N*79"};
+  for (wxString sentence : received) {
+    sentence += "\r\n";
+    plugin.SetNMEASentence(sentence);
+  }
+  EXPECT_FALSE(plugin.IsRecording()) << "Nothing written before a trigger";
+
+  wxString id("VDR_BLACKBOX_TRIGGER");
+  wxString body("Test trigger");
+  plugin.SetPluginMessage(id, body);
+  ASSERT_TRUE(plugin.IsRecording());
+
+  wxString sentence("$IIHDG,25.0,0,E,0.0,E*60\r\n");
+  plugin.SetNMEASentence(sentence);
+  // A trigger while recording only extends the post-trigger window.
+  EXPECT_TRUE(plugin.TriggerBlackBox("Second trigger"));
+  plugin.StopRecording("Test done");
+
+  wxArrayString files;
+  ASSERT_EQ(wxDir::GetAllFiles(dir, &files), 1u);
+  wxString content;
+  {
+    wxFile file(files[0]);
+    ASSERT_TRUE(file.ReadAll(&content));
+  }
+  EXPECT_EQ(content,
+            "$IIMTW,16.8,C*1C\r\n$IIVLW,2354.92,N,2338.533,N*79\r\n"
+            "$IIHDG,25.0,0,E,0.0,E*60\r\n");
+
+  plugin.DeInit();
+  wxRemoveFile(files[0]);
+  wxRmdir(dir);
+}
+
 TEST(VDRPluginTests, CommentLineHandling) {
   vdr_pi plugin(nullptr);
 
@@ -473,6 +683,51 @@ TEST(VDRPluginTests, PlaybackNonChronologicalTimestamps) {
   plugin.DeInit();
 }
 
+/** Sentences with a bad checksum are counted, and optionally skipped. */
+TEST(VDRPluginTests, CorruptSentences) {
+  vdr_pi plugin(nullptr);
+  plugin.Init();
+
+  wxString testfile = wxString(TESTDATA) + wxString("/not_chronological.txt");
+  ASSERT_TRUE(plugin.LoadFile(testfile)) << "Failed to load test file";
+  bool hasValidTimestamps;
+  wxString error;
+  ASSERT_TRUE(plugin.ScanFileTimestamps(hasValidTimestamps, error));
+  EXPECT_EQ(plugin.GetCorruptSentenceCount(), 2);
+  EXPECT_FALSE(plugin.HasValidTimestamps());
+
+  // The state restored by a seek has no corrupt sentence, here from the
+  // line position since the file has no usable time source yet.
+  plugin.SetSkipCorruptSentences(true);
+  ClearNMEASentences();
+  ASSERT_TRUE(plugin.SeekToFraction(1.0));
+  bool foundGBS = false;
+  for (const wxString& sentence : GetNMEASentences()) {
+    EXPECT_FALSE(vdr_pi::IsCorruptSentence(sentence)) << sentence;
+    foundGBS |= sentence == "$GPGBS,092211.00,1.9,1.5,3.2,,,,*45";
+  }
+  EXPECT_TRUE(foundGBS);
+
+  // The GBS sentence going back in time is corrupt, without it GBS becomes a
+  // usable time source.
+  ASSERT_TRUE(plugin.ScanFileTimestamps(hasValidTimestamps, error));
+  EXPECT_EQ(plugin.GetCorruptSentenceCount(), 2);
+  EXPECT_TRUE(plugin.HasValidTimestamps());
+  ClearNMEASentences();
+  ASSERT_TRUE(plugin.SeekToFraction(1.0));
+  EXPECT_FALSE(GetNMEASentences().empty());
+  for (const wxString& sentence : GetNMEASentences()) {
+    EXPECT_FALSE(vdr_pi::IsCorruptSentence(sentence)) << sentence;
+  }
+
+  EXPECT_TRUE(vdr_pi::IsCorruptSentence("$GPGBS,092210.00,1.9,1.5,3.2,,,,*45"));
+  EXPECT_FALSE(
+      vdr_pi::IsCorruptSentence("$GPGBS,092210.00,1.9,1.5,3.2,,,,*44"));
+  EXPECT_FALSE(vdr_pi::IsCorruptSentence("# Comment"));
+
+  plugin.DeInit();
+}
+
 TEST(VDRPluginTests, TestRealRecordings) {
   vdr_pi plugin(nullptr);
   plugin.Init();
@@ -569,16 +824,13 @@ TEST(VDRPluginTests, TestRealRecordings) {
     ASSERT_EQ(timeSources.size(), test.expectedSources.size());
 
     for (const auto& expected : test.expectedSources) {
-      TimeSource ts;
-      ts.talkerId = expected.talker;
-      ts.sentenceId = expected.sentence;
-      ts.precision = expected.precision;
+      TimeSource ts(expected.talker, expected.sentence, expected.precision);
 
       auto it = timeSources.find(ts);
       ASSERT_NE(it, timeSources.end())
           << "Missing time source: " << expected.talker << expected.sentence;
 
-      EXPECT_EQ(it->first.precision, expected.precision)
+      EXPECT_EQ(it->first.GetPrecision(), expected.precision)
           << "Incorrect precision for " << expected.talker << expected.sentence;
       EXPECT_EQ(it->second.isChronological, expected.chronological)
           << "Incorrect chronological flag for " << expected.talker
@@ -586,4 +838,244 @@ TEST(VDRPluginTests, TestRealRecordings) {
     }
   }
   plugin.DeInit();
-}
\ No newline at end of file
+}
+
+/** Recorded Signal K values are replayed as deltas to a TCP client. */
+TEST(VDRPluginTests, PlaybackSignalKServer) {
+  const int port = 39118;
+  const int count = 2000;
+  wxString testfile = wxFileName::CreateTempFileName("vdr_signalk");
+  {
+    wxFile file(testfile, wxFile::write);
+    ASSERT_TRUE(file.IsOpened()) << "Failed to create " << testfile;
+    // The values start one second after the first line, to let the client
+    // connect once the server is started by the playback.
+    file.Write("timestamp,type,id,message\n");
+    file.Write("2025-02-04T12:00:00.000Z,NMEA0183,,\"$IIMTW,16.8,C*1C\"\n");
+    SignalKDeltaEncoder encoder(0);  // Every value is written.
+    for (int i = 0; i < count; i++) {
+      // One value every 10 ms, every tenth one is a JSON object.
+      SignalKValue value = {"vessels.self", "navigation.speedOverGround",
+                            std::to_string(i % 10) + ".5"};
+      if (i % 10 == 0) {
+        value.path = "navigation.position";
+        value.value = R"({"latitude":57.98,"longitude":11.77})";
+      }
+      std::vector<std::string> records;
+      encoder.Encode(value, i * 10, &records);
+      for (const std::string& record : records) {
+        wxString message(record);
+        message.Replace("\"", "\"\"");
+        file.Write(wxString::Format("2025-02-04T12:00:%02d.%03dZ,SignalK,,"
+                                    "\"%s\"\n",
+                                    1 + i / 100, i % 100 * 10, message));
+      }
+    }
+  }
+
+  vdr_pi plugin(nullptr);
+  plugin.Init();
+  VDRProtocolSettings protocols = plugin.GetProtocolSettings();
+  protocols.signalKNet.enabled = true;
+  protocols.signalKNet.useTCP = true;
+  protocols.signalKNet.port = port;
+  plugin.SetProtocolSettings(protocols);
+
+  ASSERT_TRUE(plugin.LoadFile(testfile)) << "Failed to load test file";
+  bool hasValidTimestamps;
+  wxString error;
+  ASSERT_TRUE(plugin.ScanFileTimestamps(hasValidTimestamps, error))
+      << wxString::Format("Failed to scan timestamps: %s", error);
+  ASSERT_TRUE(hasValidTimestamps);
+  plugin.StartPlayback();
+
+  // A stand-in for a Signal K consumer, reading the deltas line by line.
+  std::mutex mutex;
+  std::vector<std::string> deltas;
+  VDRNetworkClient client;
+  ASSERT_TRUE(client.Start(
+      true, "127.0.0.1", port,
+      [&mutex, &deltas](const char* line, size_t length) {
+        std::lock_guard<std::mutex> lock(mutex);
+        deltas.emplace_back(line, length);
+      },
+      error))
+      << error;
+  for (int i = 0; i < 200 && !client.IsConnected(); i++) {
+    wxMilliSleep(10);
+  }
+  ASSERT_TRUE(client.IsConnected());
+  wxMilliSleep(100);  // Let the server accept the client.
+
+  // 20 seconds of data at 1000x, 100000 values per second.
+  plugin.SetSpeedMultiplier(1000);
+  while (!plugin.IsAtFileEnd()) {
+    VDRTimeMs due = plugin.GetNextPlaybackTime();
+    ASSERT_NE(due, INVALID_TIME_MS);
+    VDRTimeMs delay = due - wxGetUTCTimeMillis().GetValue();
+    if (delay > 0) wxMilliSleep(delay);
+    plugin.Notify();
+  }
+
+  std::vector<SignalKValue> values;
+  for (int i = 0; i < 200; i++) {
+    values.clear();
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      for (const std::string& delta : deltas) {
+        std::vector<SignalKValue> deltaValues;
+        ASSERT_TRUE(ParseSignalKDelta(delta, "", &deltaValues)) << delta;
+        values.insert(values.end(), deltaValues.begin(), deltaValues.end());
+      }
+    }
+    if (values.size() >= static_cast<size_t>(count)) break;
+    wxMilliSleep(10);
+  }
+  client.Stop();
+  plugin.StopPlayback();
+  plugin.DeInit();
+  wxRemoveFile(testfile);
+
+  // Every value is received once, in order, with its recording time.
+  ASSERT_EQ(values.size(), static_cast<size_t>(count));
+  EXPECT_EQ(values[0].context, "vessels.self");
+  EXPECT_EQ(values[0].path, "navigation.position");
+  EXPECT_EQ(values[0].value, R"({"latitude":57.98,"longitude":11.77})");
+  EXPECT_EQ(values[1].path, "navigation.speedOverGround");
+  EXPECT_EQ(values[1].value, "1.5");
+  EXPECT_EQ(values.back().value, "9.5");
+  EXPECT_NE(deltas[0].find("\"timestamp\":\"2025-02-04T12:00:01.000Z\""),
+            std::string::npos);
+}
+
+/** Signal K values of a raw recording are replayed after a seek. */
+TEST(VDRPluginTests, PlaybackSignalKRawSeek) {
+  const int port = 39119;
+  const int count = 600;
+  wxString testfile =
+      wxFileName::GetTempDir() + wxFileName::GetPathSeparator() +
+      wxString::Format("vdr_signalk_raw_%lu.txt", wxGetProcessId());
+  {
+    wxFile file(testfile, wxFile::write);
+    ASSERT_TRUE(file.IsOpened()) << "Failed to create " << testfile;
+    // One position per second followed by a value, the dictionary entries
+    // are only written at the start, before the first keyframe.
+    SignalKDeltaEncoder encoder(0);
+    for (int i = 0; i < count; i++) {
+      wxString rmc = wxString::Format(
+          "GPRMC,%02d%02d%02d.00,A,5758.800,N,01146.200,E,5.0,90.0,040225,,,A",
+          12 + i / 3600, i / 60 % 60, i % 60);
+      file.Write(wxString::Format(
+          "$%s*%02X\r\n", rmc,
+          ComputeNMEAChecksum(rmc.wx_str(), rmc.length())));
+      // The '*' of the value is not mistaken for a checksum.
+      SignalKValue value = {"vessels.self", "navigation.state",
+                            "\"*" + std::to_string(i) + "\""};
+      std::vector<std::string> records;
+      encoder.Encode(value, i * 1000, &records);
+      for (const std::string& record : records) {
+        file.Write(wxString(record) + "\r\n");
+      }
+    }
+  }
+
+  vdr_pi plugin(nullptr);
+  plugin.Init();
+  plugin.SetSkipCorruptSentences(true);
+  VDRProtocolSettings protocols = plugin.GetProtocolSettings();
+  protocols.signalKNet.enabled = true;
+  protocols.signalKNet.useTCP = true;
+  protocols.signalKNet.port = port;
+  plugin.SetProtocolSettings(protocols);
+
+  ASSERT_TRUE(plugin.LoadFile(testfile)) << "Failed to load test file";
+  bool hasValidTimestamps;
+  wxString error;
+  ASSERT_TRUE(plugin.ScanFileTimestamps(hasValidTimestamps, error))
+      << wxString::Format("Failed to scan timestamps: %s", error);
+  ASSERT_TRUE(hasValidTimestamps);
+  EXPECT_EQ(plugin.GetCorruptSentenceCount(), 0);
+  plugin.StartPlayback();
+
+  std::mutex mutex;
+  std::vector<std::string> deltas;
+  VDRNetworkClient client;
+  ASSERT_TRUE(client.Start(
+      true, "127.0.0.1", port,
+      [&mutex, &deltas](const char* line, size_t length) {
+        std::lock_guard<std::mutex> lock(mutex);
+        deltas.emplace_back(line, length);
+      },
+      error))
+      << error;
+  for (int i = 0; i < 200 && !client.IsConnected(); i++) {
+    wxMilliSleep(10);
+  }
+  ASSERT_TRUE(client.IsConnected());
+  wxMilliSleep(100);  // Let the server accept the client.
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    deltas.clear();
+  }
+
+  // The position at 539.1 seconds is after the first keyframe, the state
+  // restored by the seek sends the value received at 539 seconds.
+  ASSERT_TRUE(plugin.SeekToFraction(0.9));
+  plugin.SetSpeedMultiplier(1000);
+  while (!plugin.IsAtFileEnd()) {
+    VDRTimeMs due = plugin.GetNextPlaybackTime();
+    ASSERT_NE(due, INVALID_TIME_MS);
+    VDRTimeMs delay = due - wxGetUTCTimeMillis().GetValue();
+    if (delay > 0) wxMilliSleep(delay);
+    plugin.Notify();
+  }
+
+  const size_t expectedCount = count - 539;
+  std::vector<SignalKValue> values;
+  for (int i = 0; i < 200; i++) {
+    values.clear();
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      for (const std::string& delta : deltas) {
+        std::vector<SignalKValue> deltaValues;
+        ASSERT_TRUE(ParseSignalKDelta(delta, "", &deltaValues)) << delta;
+        values.insert(values.end(), deltaValues.begin(), deltaValues.end());
+      }
+    }
+    if (values.size() >= expectedCount) break;
+    wxMilliSleep(10);
+  }
+  // Stopping the playback closes the connection of the client.
+  plugin.StopPlayback();
+  for (int i = 0; i < 200 && client.IsConnected(); i++) {
+    wxMilliSleep(10);
+  }
+  EXPECT_FALSE(client.IsConnected());
+  client.Stop();
+
+  ASSERT_EQ(values.size(), expectedCount);
+  for (size_t i = 0; i < values.size(); i++) {
+    EXPECT_EQ(values[i].path, "navigation.state");
+    EXPECT_EQ(values[i].value, "\"*" + std::to_string(539 + i) + "\"");
+  }
+
+  // A recording of Signal K data only is a valid file without timestamps.
+  {
+    wxFile file(testfile, wxFile::write);
+    ASSERT_TRUE(file.IsOpened());
+    SignalKDeltaEncoder encoder(0);
+    std::vector<std::string> records;
+    encoder.Encode({"vessels.self", "navigation.state", "\"moored\""}, 0,
+                   &records);
+    for (const std::string& record : records) {
+      file.Write(wxString(record) + "\r\n");
+    }
+  }
+  ASSERT_TRUE(plugin.LoadFile(testfile)) << "Failed to load test file";
+  EXPECT_TRUE(plugin.ScanFileTimestamps(hasValidTimestamps, error))
+      << wxString::Format("Failed to scan timestamps: %s", error);
+  EXPECT_FALSE(hasValidTimestamps);
+
+  plugin.DeInit();
+  wxRemoveFile(testfile);
+}
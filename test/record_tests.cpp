@@ -30,6 +30,7 @@
 #include "vdr_pi_time.h"
 #include "vdr_pi.h"
 #include "mock_plugin_api.h"
+#include "vdr_load_generator.h"
 
 #include <wx/dir.h>
 #include <wx/file.h>
@@ -272,3 +273,185 @@ TEST(VDRRecordTests, RecordNMEAWithCSV) {
 }
 
 /** Test recording NMEA0183 with pause. */
+
+/** Record a generated stream of NMEA 0183, AIS and NMEA 2000 messages. */
+TEST(VDRRecordTests, RecordGeneratedLoad) {
+  wxString tempDir = wxFileName::GetTempDir();
+  wxString uniqueId =
+      wxDateTime::Now().Format("%Y%m%d%H%M%S") + wxString::Format("%d", rand());
+  wxString testDir = tempDir + "/vdr_test_" + uniqueId;
+  ASSERT_TRUE(wxFileName::Mkdir(testDir))
+      << "Failed to create directory: " << testDir;
+
+  vdr_pi plugin(nullptr);
+  plugin.Init();
+  plugin.SetRecordingDir(testDir);
+  plugin.SetDataFormat(VDRDataFormat::CSV);
+  plugin.SetLogRotate(false);
+  VDRProtocolSettings protocols = plugin.GetProtocolSettings();
+  protocols.nmea2000 = true;
+  plugin.SetProtocolSettings(protocols);
+
+  plugin.StartRecording();
+  ASSERT_TRUE(plugin.IsRecording()) << "Recording should be active";
+
+  VDRLoadSettings settings;
+  settings.durationMs = 10 * 1000;
+  settings.navigationRate = 100;
+  settings.aisTargets = 50;
+  settings.aisInterval = 1;
+  settings.n2kRate = 50;
+  VDRLoadGenerator generator(settings);
+  VDRLoadMessage message;
+  std::map<wxString, size_t> sent;
+  while (generator.Next(message)) {
+    wxString sentence(message.sentence);
+    switch (message.type) {
+      case VDRLoadMessage::Type::NMEA0183:
+        plugin.SetNMEASentence(sentence);
+        sent["NMEA0183"]++;
+        break;
+      case VDRLoadMessage::Type::AIS:
+        plugin.SetAISSentence(sentence);
+        sent["AIS"]++;
+        break;
+      case VDRLoadMessage::Type::NMEA2000:
+        plugin.ProcessN2KPayload(message.payload);
+        sent["NMEA2000"]++;
+        break;
+    }
+  }
+  plugin.StopRecording("Test complete");
+
+  wxArrayString files;
+  wxDir::GetAllFiles(testDir, &files, "vdr_*.csv");
+  ASSERT_EQ(files.size(), 1u) << "Expected one recording file";
+  wxTextFile file;
+  ASSERT_TRUE(file.Open(files[0])) << "Failed to open file: " << files[0];
+
+  // Every message is recorded once, after the header line.
+  std::map<wxString, size_t> recorded;
+  for (size_t i = 1; i < file.GetLineCount(); i++) {
+    recorded[file[i].AfterFirst(',').BeforeFirst(',')]++;
+  }
+  EXPECT_EQ(sent["NMEA0183"], 4000u);
+  EXPECT_EQ(sent["AIS"], 500u);
+  EXPECT_EQ(sent["NMEA2000"], 2000u);
+  EXPECT_EQ(recorded, sent);
+
+  file.Close();
+  plugin.DeInit();
+  wxDir::Remove(testDir, wxPATH_RMDIR_RECURSIVE);
+}
+
+/** Signal K deltas are recorded compactly, without repeated values. */
+TEST(VDRRecordTests, RecordSignalK) {
+  wxString testDir = wxFileName::GetTempDir() + "/vdr_test_signalk_" +
+                     wxDateTime::Now().Format("%Y%m%d%H%M%S") +
+                     wxString::Format("%d", rand());
+  ASSERT_TRUE(wxFileName::Mkdir(testDir));
+
+  vdr_pi plugin(nullptr);
+  plugin.Init();
+  plugin.SetRecordingDir(testDir);
+  plugin.SetDataFormat(VDRDataFormat::RawNMEA);
+  plugin.SetLogRotate(false);
+  VDRProtocolSettings protocols = plugin.GetProtocolSettings();
+  protocols.signalK = true;
+  plugin.SetProtocolSettings(protocols);
+  plugin.StartRecording();
+  ASSERT_TRUE(plugin.IsRecording());
+
+  const std::string delta =
+      R"({"updates":[{"values":[)"
+      R"({"path":"navigation.speedOverGround","value":3.85},)"
+      R"({"path":"environment.depth.belowTransducer","value":12.1}]}]})";
+  for (int i = 0; i < 10; i++) {
+    plugin.RecordSignalKDelta(delta, "vessels.self");
+  }
+  plugin.RecordSignalKDelta(
+      R"({"context":"vessels.self","updates":[{"values":[)"
+      R"({"path":"navigation.speedOverGround","value":3.9}]}]})",
+      "vessels.self");
+  plugin.StopRecording("Test complete");
+
+  wxArrayString files;
+  wxDir::GetAllFiles(testDir, &files, "vdr_*.txt");
+  ASSERT_EQ(files.size(), 1u);
+  wxTextFile file;
+  ASSERT_TRUE(file.Open(files[0]));
+  const char* expected[] = {
+      "$PVDSK,D,0,vessels.self*59",
+      "$PVDSK,D,1,navigation.speedOverGround*4B",
+      "$PVDSK,V,0,1,3.85*1D",
+      "$PVDSK,D,2,environment.depth.belowTransducer*54",
+      "$PVDSK,V,0,2,12.1*12",
+      "$PVDSK,V,0,1,3.9*29"};
+  ASSERT_EQ(file.GetLineCount(), sizeof(expected) / sizeof(expected[0]));
+  for (size_t i = 0; i < file.GetLineCount(); i++) {
+    EXPECT_EQ(file[i], expected[i]) << "Mismatch at line " << i;
+    EXPECT_FALSE(vdr_pi::IsCorruptSentence(file[i]));
+  }
+
+  file.Close();
+  plugin.DeInit();
+  wxDir::Remove(testDir, wxPATH_RMDIR_RECURSIVE);
+}
+
+/** Signal K values of the pre-trigger window are written by the black box. */
+TEST(VDRRecordTests, RecordSignalKBlackBox) {
+  wxString testDir = wxFileName::GetTempDir() + "/vdr_test_signalk_bb_" +
+                     wxDateTime::Now().Format("%Y%m%d%H%M%S") +
+                     wxString::Format("%d", rand());
+  ASSERT_TRUE(wxFileName::Mkdir(testDir));
+
+  vdr_pi plugin(nullptr);
+  plugin.Init();
+  plugin.SetRecordingDir(testDir);
+  plugin.SetDataFormat(VDRDataFormat::RawNMEA);
+  plugin.SetLogRotate(false);
+  plugin.SetAutoStartRecording(false);
+  VDRProtocolSettings protocols = plugin.GetProtocolSettings();
+  protocols.signalK = true;
+  plugin.SetProtocolSettings(protocols);
+  VDRBlackBoxSettings settings;
+  settings.enabled = true;
+  plugin.SetBlackBoxSettings(settings);
+
+  for (int i = 0; i < 3; i++) {
+    plugin.RecordSignalKDelta(
+        R"({"updates":[{"values":[)"
+        R"({"path":"navigation.speedOverGround","value":3.85},)"
+        R"({"path":"environment.depth.belowTransducer","value":12.1}]}]})",
+        "vessels.self");
+  }
+  EXPECT_FALSE(plugin.IsRecording()) << "Nothing written before a trigger";
+  ASSERT_TRUE(plugin.TriggerBlackBox("Test trigger"));
+  plugin.RecordSignalKDelta(
+      R"({"updates":[{"values":[)"
+      R"({"path":"navigation.speedOverGround","value":3.9}]}]})",
+      "vessels.self");
+  plugin.StopRecording("Test complete");
+
+  wxArrayString files;
+  wxDir::GetAllFiles(testDir, &files, "vdr_*.txt");
+  ASSERT_EQ(files.size(), 1u);
+  wxTextFile file;
+  ASSERT_TRUE(file.Open(files[0]));
+  // The buffered values are written with the dictionary of the file.
+  const char* expected[] = {
+      "$PVDSK,D,0,vessels.self*59",
+      "$PVDSK,D,1,navigation.speedOverGround*4B",
+      "$PVDSK,V,0,1,3.85*1D",
+      "$PVDSK,D,2,environment.depth.belowTransducer*54",
+      "$PVDSK,V,0,2,12.1*12",
+      "$PVDSK,V,0,1,3.9*29"};
+  ASSERT_EQ(file.GetLineCount(), sizeof(expected) / sizeof(expected[0]));
+  for (size_t i = 0; i < file.GetLineCount(); i++) {
+    EXPECT_EQ(file[i], expected[i]) << "Mismatch at line " << i;
+  }
+
+  file.Close();
+  plugin.DeInit();
+  wxDir::Remove(testDir, wxPATH_RMDIR_RECURSIVE);
+}
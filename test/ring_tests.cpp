@@ -0,0 +1,108 @@
+/***************************************************************************
+ *   Copyright (C) 2024 by OpenCPN development team                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ **************************************************************************/
+
+#include <gtest/gtest.h>
+#include "vdr_ring.h"
+
+/** Messages older than the time horizon are discarded. */
+TEST(VDRRingTests, TimeHorizon) {
+  VDRMessageRing ring;
+  ring.SetLimits(1024 * 1024, 60 * 1000);
+  for (int i = 0; i <= 120; i++) {
+    ring.Add(i * 1000, "$IIMTW,16.8,C*1C");
+  }
+  EXPECT_EQ(ring.GetCount(), 61u);
+  EXPECT_EQ(ring.GetLastSequence(), 121u);
+
+  std::vector<RingMessage> messages = ring.GetMessagesSince(110 * 1000);
+  ASSERT_EQ(messages.size(), 11u);
+  EXPECT_EQ(messages.front().timeMs, 110 * 1000);
+  EXPECT_EQ(messages.back().timeMs, 120 * 1000);
+}
+
+/** Memory used by the buffer never exceeds the cap. */
+TEST(VDRRingTests, MemoryCap) {
+  const std::string message = "$IIVLW,2354.92,N,2338.533,N*79";
+  const size_t messageBytes = message.size() + VDRMessageRing::MESSAGE_OVERHEAD;
+  VDRMessageRing ring;
+  ring.SetLimits(10 * messageBytes, 60 * 60 * 1000);
+  for (int i = 0; i < 100; i++) {
+    ring.Add(i, message);
+    EXPECT_LE(ring.GetBytes(), ring.GetMaxBytes());
+  }
+  EXPECT_EQ(ring.GetCount(), 10u);
+
+  // Lowering the limits discards messages immediately.
+  ring.SetLimits(5 * messageBytes, 60 * 60 * 1000);
+  EXPECT_EQ(ring.GetCount(), 5u);
+  ring.SetLimits(5 * messageBytes, 2);
+  EXPECT_EQ(ring.GetCount(), 3u);
+}
+
+/** Messages can be retrieved after a given sequence number. */
+TEST(VDRRingTests, MessagesAfter) {
+  VDRMessageRing ring;
+  ring.SetLimits(1024 * 1024, 3);
+  for (int i = 0; i < 10; i++) {
+    ring.Add(i, "$PCDIN,130306," + std::to_string(i));
+  }
+  // Only the messages of the last 3 ms are left, sequence 7 to 10.
+  std::vector<RingMessage> messages = ring.GetMessagesAfter(8);
+  ASSERT_EQ(messages.size(), 2u);
+  EXPECT_EQ(messages[0].sequence, 9u);
+  EXPECT_EQ(messages[0].message, "$PCDIN,130306,8");
+  EXPECT_EQ(ring.GetMessagesAfter(0).size(), 4u);
+  EXPECT_TRUE(ring.GetMessagesAfter(10).empty());
+}
+
+/** Sent messages are recognized once when they come back. */
+TEST(VDRRingTests, EchoFilter) {
+  VDREchoFilter filter(1000);
+  EXPECT_TRUE(filter.IsEmpty());
+  filter.Add(0, "$IIMTW,16.8,C*1C");
+  filter.Add(0, "$IIMTW,16.8,C*1C");
+  EXPECT_FALSE(filter.Consume(10, "$IIHDG,25.0,0,E,0.0,E*60"));
+  EXPECT_TRUE(filter.Consume(10, "$IIMTW,16.8,C*1C"));
+  EXPECT_TRUE(filter.Consume(20, "$IIMTW,16.8,C*1C"));
+  EXPECT_FALSE(filter.Consume(30, "$IIMTW,16.8,C*1C"));
+  EXPECT_TRUE(filter.IsEmpty());
+
+  // Messages that never come back are forgotten.
+  filter.Add(100, "$IIMTW,16.8,C*1C");
+  EXPECT_FALSE(filter.Consume(2000, "$IIMTW,16.8,C*1C"));
+  EXPECT_TRUE(filter.IsEmpty());
+}
+
+/** A sent message that came back is not counted down again when it expires. */
+TEST(VDRRingTests, EchoFilterRepeatedMessage) {
+  VDREchoFilter filter(1000);
+  filter.Add(0, "$IIMTW,16.8,C*1C");
+  EXPECT_TRUE(filter.Consume(10, "$IIMTW,16.8,C*1C"));
+  filter.Add(900, "$IIMTW,16.8,C*1C");
+  // The first copy expires before the echo of the second one arrives.
+  EXPECT_TRUE(filter.Consume(1500, "$IIMTW,16.8,C*1C"));
+  EXPECT_TRUE(filter.IsEmpty());
+
+  // Only the copies that did not come back expire.
+  filter.Add(2000, "$IIMTW,16.8,C*1C");
+  filter.Add(2500, "$IIMTW,16.8,C*1C");
+  EXPECT_TRUE(filter.Consume(2600, "$IIMTW,16.8,C*1C"));
+  EXPECT_TRUE(filter.Consume(3200, "$IIMTW,16.8,C*1C"));
+  EXPECT_FALSE(filter.Consume(3300, "$IIMTW,16.8,C*1C"));
+}
@@ -0,0 +1,210 @@
+/***************************************************************************
+ *   Copyright (C) 2024 by OpenCPN development team                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ **************************************************************************/
+
+#include <gtest/gtest.h>
+#include "vdr_signalk.h"
+
+namespace {
+
+const char* kDelta = R"({
+  "updates": [
+    {
+      "source": {"label": "N2K", "src": "3"},
+      "timestamp": "2024-05-04T10:00:00.000Z",
+      "values": [
+        {"path": "navigation.speedOverGround", "value": 3.85},
+        {"path": "navigation.position",
+         "value": {"longitude": -122.4, "latitude": 37.8}},
+        {"path": "", "value": {"name": "Hilda"}}
+      ]
+    },
+    {"meta": [{"path": "navigation.speedOverGround", "value": {}}]}
+  ],
+  "context": "vessels.urn:mrn:imo:mmsi:227006760"
+})";
+
+}  // namespace
+
+/** The values of a delta are extracted as compact JSON. */
+TEST(SignalKTests, ParseDelta) {
+  std::vector<SignalKValue> values;
+  ASSERT_TRUE(ParseSignalKDelta(kDelta, "vessels.self", &values));
+  ASSERT_EQ(values.size(), 2u);
+  EXPECT_EQ(values[0].context, "vessels.urn:mrn:imo:mmsi:227006760");
+  EXPECT_EQ(values[0].path, "navigation.speedOverGround");
+  EXPECT_EQ(values[0].value, "3.85");
+  EXPECT_EQ(values[1].path, "navigation.position");
+  EXPECT_EQ(values[1].value, R"({"longitude":-122.4,"latitude":37.8})");
+
+  ASSERT_TRUE(ParseSignalKDelta(
+      R"({"updates":[{"values":[{"path":"a.b","value":"x, y"}]}]})",
+      "vessels.self", &values));
+  ASSERT_EQ(values.size(), 1u);
+  EXPECT_EQ(values[0].context, "vessels.self");
+  EXPECT_EQ(values[0].value, "\"x, y\"");
+
+  EXPECT_FALSE(ParseSignalKDelta("{\"updates\":[", "vessels.self", &values));
+  EXPECT_FALSE(ParseSignalKDelta("{\"name\":\"Hilda\"}", "", &values));
+  EXPECT_TRUE(values.empty());
+}
+
+/** Strings are written once, values when they change or are due. */
+TEST(SignalKTests, Deduplication) {
+  SignalKDeltaEncoder encoder(10000);
+  SignalKValue sog = {"vessels.self", "navigation.speedOverGround", "3.85"};
+  std::vector<std::string> records;
+  encoder.Encode(sog, 0, &records);
+  ASSERT_EQ(records.size(), 3u);
+  EXPECT_EQ(records[0], "$PVDSK,D,0,vessels.self*59");
+  EXPECT_EQ(records[1], "$PVDSK,D,1,navigation.speedOverGround*4B");
+  EXPECT_EQ(records[2], "$PVDSK,V,0,1,3.85*1D");
+
+  // Unchanged values are only written after the heartbeat.
+  records.clear();
+  encoder.Encode(sog, 1000, &records);
+  encoder.Encode(sog, 9999, &records);
+  EXPECT_TRUE(records.empty());
+  encoder.Encode(sog, 10000, &records);
+  ASSERT_EQ(records.size(), 1u);
+  EXPECT_EQ(records[0], "$PVDSK,V,0,1,3.85*1D");
+
+  records.clear();
+  sog.value = "3.9";
+  encoder.Encode(sog, 10001, &records);
+  SignalKValue cog = {"vessels.self", "navigation.courseOverGroundTrue",
+                      "1.2"};
+  encoder.Encode(cog, 10001, &records);
+  ASSERT_EQ(records.size(), 3u);
+  EXPECT_EQ(records[0], "$PVDSK,V,0,1,3.9*29");
+  EXPECT_EQ(records[1], "$PVDSK,D,2,navigation.courseOverGroundTrue*04");
+  EXPECT_EQ(records[2], "$PVDSK,V,0,2,1.2*23");
+  EXPECT_EQ(encoder.GetDictionarySize(), 3u);
+
+  // A new file starts with a new dictionary.
+  encoder.Reset();
+  records.clear();
+  encoder.Encode(cog, 10002, &records);
+  ASSERT_EQ(records.size(), 3u);
+  EXPECT_EQ(records[2], "$PVDSK,V,0,1,1.2*20");
+}
+
+/** Recorded values are decoded with the dictionary of the file. */
+TEST(SignalKTests, RoundTrip) {
+  std::vector<SignalKValue> values;
+  ASSERT_TRUE(ParseSignalKDelta(kDelta, "vessels.self", &values));
+  SignalKDeltaEncoder encoder;
+  std::vector<std::string> records;
+  for (const SignalKValue& value : values) {
+    encoder.Encode(value, 0, &records);
+  }
+
+  SignalKDeltaDecoder decoder;
+  std::vector<SignalKValue> decoded;
+  for (const std::string& record : records) {
+    EXPECT_TRUE(IsSignalKRecord(record));
+    SignalKValue value;
+    if (decoder.Decode(record + "\r\n", &value)) decoded.push_back(value);
+  }
+  ASSERT_EQ(decoded.size(), values.size());
+  for (size_t i = 0; i < values.size(); i++) {
+    EXPECT_EQ(decoded[i].context, values[i].context);
+    EXPECT_EQ(decoded[i].path, values[i].path);
+    EXPECT_EQ(decoded[i].value, values[i].value);
+  }
+
+  // Values with unknown ids are ignored.
+  SignalKValue value;
+  EXPECT_FALSE(decoder.Decode("$PVDSK,V,0,7,1.0*24", &value));
+  // Damaged values are ignored.
+  EXPECT_FALSE(decoder.Decode("$PVDSK,V,0,1,{\"latitude\":57.9*49", &value));
+  // Records with a missing or mismatched checksum are ignored.
+  EXPECT_FALSE(decoder.Decode("$PVDSK,V,0,1,3.85", &value));
+  EXPECT_FALSE(decoder.Decode("$PVDSK,V,0,1,3.86*1D", &value));
+  EXPECT_FALSE(decoder.Decode("$IIMTW,16.8,C*1C", &value));
+}
+
+/** Records are ASCII with a checksum, whatever the characters of a value. */
+TEST(SignalKTests, RecordChecksum) {
+  SignalKDeltaEncoder encoder;
+  std::vector<std::string> records;
+  SignalKValue value = {"vessels.self", "notifications.mob",
+                        "{\"message\":\"*MOB* \xc3\xa9\xf0\x9f\x9a\xa2\xff\"}"};
+  encoder.Encode(value, 0, &records);
+  ASSERT_EQ(records.size(), 3u);
+  EXPECT_EQ(records[2],
+            "$PVDSK,V,0,1,{\"message\":\"*MOB* "
+            "\\u00e9\\ud83d\\udea2\\ufffd\"}*3D");
+
+  SignalKDeltaDecoder decoder;
+  SignalKValue decoded;
+  EXPECT_FALSE(decoder.Decode(records[0], &decoded));
+  EXPECT_FALSE(decoder.Decode(records[1], &decoded));
+  ASSERT_TRUE(decoder.Decode(records[2] + "\r\n", &decoded));
+  EXPECT_EQ(decoded.path, "notifications.mob");
+  EXPECT_EQ(decoded.value,
+            "{\"message\":\"*MOB* \\u00e9\\ud83d\\udea2\\ufffd\"}");
+}
+
+/** Values are written as deltas grouped by context and time. */
+TEST(SignalKTests, DeltaWriter) {
+  SignalKDeltaWriter writer;
+  EXPECT_TRUE(writer.IsEmpty());
+  EXPECT_EQ(writer.Finish(), "");
+
+  const int64_t time = 1738670736748;  // 2025-02-04T12:05:36.748Z
+  ASSERT_TRUE(writer.Add({"vessels.self", "navigation.speedOverGround", "3.85"},
+                         time));
+  ASSERT_TRUE(writer.Add(
+      {"vessels.self", "navigation.position",
+       R"({"latitude":57.98,"longitude":11.77})"},
+      time));
+  // Another time or context starts a new delta.
+  EXPECT_FALSE(
+      writer.Add({"vessels.self", "navigation.log", "1200"}, time + 1));
+  EXPECT_FALSE(writer.Add({"vessels.other", "navigation.log", "1200"}, time));
+  EXPECT_EQ(writer.Finish(),
+            R"({"context":"vessels.self","updates":[{"timestamp":)"
+            R"("2025-02-04T12:05:36.748Z","values":[)"
+            R"({"path":"navigation.speedOverGround","value":3.85},)"
+            R"({"path":"navigation.position","value":)"
+            R"({"latitude":57.98,"longitude":11.77}}]}]})"
+            "\r\n");
+  EXPECT_TRUE(writer.IsEmpty());
+
+  // Strings are escaped, and the timestamp is optional.
+  ASSERT_TRUE(writer.Add({"vessels.\"a\"", "name", "\"x\""}, -1));
+  std::string delta = writer.Finish();
+  EXPECT_EQ(delta, R"({"context":"vessels.\"a\"","updates":[{"values":[)"
+                   R"({"path":"name","value":"x"}]}]})"
+                   "\r\n");
+  std::vector<SignalKValue> values;
+  ASSERT_TRUE(ParseSignalKDelta(delta, "", &values));
+  ASSERT_EQ(values.size(), 1u);
+  EXPECT_EQ(values[0].context, "vessels.\"a\"");
+
+  // Deltas are split before they grow too large.
+  size_t count = 0;
+  std::string path = "environment.wind.speedApparent";
+  while (writer.Add({"vessels.self", path, "10.5"}, time)) count++;
+  delta = writer.Finish();
+  EXPECT_GT(count, 1u);
+  EXPECT_LE(delta.size(), SignalKDeltaWriter::MAX_DELTA_SIZE);
+  ASSERT_TRUE(ParseSignalKDelta(delta, "", &values));
+  EXPECT_EQ(values.size(), count);
+}
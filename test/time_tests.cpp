@@ -20,15 +20,33 @@
 #include <gtest/gtest.h>
 #include "vdr_pi_time.h"
 
-class VDRTimeTest : public ::testing::Test {
+#include <fstream>
+#include <string>
+
+/**
+ * The sentence parsing tests run against both the fast parser and the
+ * wxWidgets based reference implementation.
+ */
+class VDRTimeTest : public ::testing::TestWithParam<bool> {
 protected:
   void SetUp() override { parser.Reset(); }
 
+  bool ParseTimestamp(const wxString& sentence, wxDateTime& timestamp,
+                      int& precision) {
+    return GetParam() ? parser.ParseTimestampWx(sentence, timestamp, precision)
+                      : parser.ParseTimestamp(sentence, timestamp, precision);
+  }
+
   TimestampParser parser;
 };
 
+INSTANTIATE_TEST_SUITE_P(Parsers, VDRTimeTest, ::testing::Values(false, true),
+                         [](const ::testing::TestParamInfo<bool>& info) {
+                           return info.param ? "Reference" : "Fast";
+                         });
+
 /** Test parsing of time field. */
-TEST_F(VDRTimeTest, TimeFieldParsing) {
+TEST_P(VDRTimeTest, TimeFieldParsing) {
   NMEATimeInfo timeInfo;
   int precision;
 
@@ -42,7 +60,7 @@ TEST_F(VDRTimeTest, TimeFieldParsing) {
 }
 
 /** Test parsing of time field with milliseconds. */
-TEST_F(VDRTimeTest, TimeFieldParsingWithMs) {
+TEST_P(VDRTimeTest, TimeFieldParsingWithMs) {
   NMEATimeInfo timeInfo;
   int precision;
 
@@ -56,12 +74,12 @@ TEST_F(VDRTimeTest, TimeFieldParsingWithMs) {
 }
 
 /** Test RMC sentences with different years. */
-TEST_F(VDRTimeTest, RMCSentenceParsing) {
+TEST_P(VDRTimeTest, RMCSentenceParsing) {
   wxDateTime timestamp;
   int precision;
 
   // Test a 1994 date
-  EXPECT_TRUE(parser.ParseTimestamp(
+  EXPECT_TRUE(ParseTimestamp(
       "$GPRMC,123519,A,4807.038,N,01131.000,E,022.4,084.4,230394,003.1,W*6A",
       timestamp, precision));
   EXPECT_EQ(timestamp.GetYear(), 1994);
@@ -69,43 +87,43 @@ TEST_F(VDRTimeTest, RMCSentenceParsing) {
   EXPECT_EQ(timestamp.GetDay(), 23);
 
   // Test a valid 2015 date
-  EXPECT_TRUE(parser.ParseTimestamp(
+  EXPECT_TRUE(ParseTimestamp(
       "$GPRMC,123519,A,4807.038,N,01131.000,E,022.4,084.4,230315,003.1,W*6A",
       timestamp, precision));
   EXPECT_EQ(timestamp.GetYear(), 2015);
 
   // Test a date with invalid month 0.
-  EXPECT_FALSE(parser.ParseTimestamp(
+  EXPECT_FALSE(ParseTimestamp(
       "$GPRMC,123519,A,4807.038,N,01131.000,E,022.4,084.4,230015,003.1,W*6A",
       timestamp, precision));
 
   // Test a date with invalid month 13.
-  EXPECT_FALSE(parser.ParseTimestamp(
+  EXPECT_FALSE(ParseTimestamp(
       "$GPRMC,123519,A,4807.038,N,01131.000,E,022.4,084.4,231315,003.1,W*6A",
       timestamp, precision));
 
   // Test a date with invalid day-of-month 0.
-  EXPECT_FALSE(parser.ParseTimestamp(
+  EXPECT_FALSE(ParseTimestamp(
       "$GPRMC,123519,A,4807.038,N,01131.000,E,022.4,084.4,000015,003.1,W*6A",
       timestamp, precision));
 
   // Test a date with invalid day-of-month 32.
-  EXPECT_FALSE(parser.ParseTimestamp(
+  EXPECT_FALSE(ParseTimestamp(
       "$GPRMC,123519,A,4807.038,N,01131.000,E,022.4,084.4,320015,003.1,W*6A",
       timestamp, precision));
 
   // Test a date with invalid February 29 2015.
-  EXPECT_FALSE(parser.ParseTimestamp(
+  EXPECT_FALSE(ParseTimestamp(
       "$GPRMC,123519,A,4807.038,N,01131.000,E,022.4,084.4,290215,003.1,W*6A",
       timestamp, precision));
 
   // Test year at the boundary (1969/2069)
-  EXPECT_TRUE(parser.ParseTimestamp(
+  EXPECT_TRUE(ParseTimestamp(
       "$GPRMC,123519,A,4807.038,N,01131.000,E,022.4,084.4,230369,003.1,W*6A",
       timestamp, precision));
   EXPECT_EQ(timestamp.GetYear(), 2069);
 
-  EXPECT_TRUE(parser.ParseTimestamp(
+  EXPECT_TRUE(ParseTimestamp(
       "$GPRMC,123519,A,4807.038,N,01131.000,E,022.4,084.4,230370,003.1,W*6A",
       timestamp, precision));
   EXPECT_EQ(timestamp.GetYear(), 1970);
@@ -117,10 +135,10 @@ TEST_F(VDRTimeTest, RMCSentenceParsing) {
   EXPECT_EQ(timestamp.GetMillisecond(), 0);
   EXPECT_EQ(precision, 0);
 
-  EXPECT_TRUE(
-      parser.ParseTimestamp("$GPRMC,123519.234,A,4807.038,N,01131.000,E,022.4,"
-                            "084.4,230370,003.1,W*6A",
-                            timestamp, precision));
+  EXPECT_TRUE(ParseTimestamp(
+      "$GPRMC,123519.234,A,4807.038,N,01131.000,E,022.4,084.4,230370,003.1,"
+      "W*6A",
+      timestamp, precision));
   EXPECT_EQ(timestamp.GetYear(), 1970);
   EXPECT_EQ(timestamp.GetMonth(), wxDateTime::Mar);
   EXPECT_EQ(timestamp.GetDay(), 23);
@@ -132,7 +150,7 @@ TEST_F(VDRTimeTest, RMCSentenceParsing) {
 }
 
 /** Test invalid inputs. */
-TEST_F(VDRTimeTest, InvalidInputs) {
+TEST_P(VDRTimeTest, InvalidInputs) {
   NMEATimeInfo timeInfo;
   int precision;
 
@@ -147,13 +165,13 @@ TEST_F(VDRTimeTest, InvalidInputs) {
 }
 
 /** Test ZDA sentence parsing. */
-TEST_F(VDRTimeTest, ZDAParsing) {
+TEST_P(VDRTimeTest, ZDAParsing) {
   wxDateTime timestamp;
   int precision;
 
   // Test ZDA with full date/time
-  EXPECT_TRUE(parser.ParseTimestamp("$GPZDA,123519,23,03,1994,00,00*6A",
-                                    timestamp, precision));
+  EXPECT_TRUE(ParseTimestamp("$GPZDA,123519,23,03,1994,00,00*6A", timestamp,
+                             precision));
   EXPECT_EQ(timestamp.GetHour(), 12);
   EXPECT_EQ(timestamp.GetMinute(), 35);
   EXPECT_EQ(timestamp.GetSecond(), 19);
@@ -162,22 +180,21 @@ TEST_F(VDRTimeTest, ZDAParsing) {
   EXPECT_EQ(timestamp.GetYear(), 1994);
 
   // Test ZDA with missing fields
-  EXPECT_FALSE(
-      parser.ParseTimestamp("$GPZDA,123519,23,03*6A", timestamp, precision));
+  EXPECT_FALSE(ParseTimestamp("$GPZDA,123519,23,03*6A", timestamp, precision));
 }
 
 /** Test GGA/GBS/GLL sentence parsing (time only). */
-TEST_F(VDRTimeTest, GxxParsing) {
+TEST_P(VDRTimeTest, GxxParsing) {
   wxDateTime timestamp;
   int precision;
 
   // First set cached date with RMC
-  EXPECT_TRUE(parser.ParseTimestamp(
+  EXPECT_TRUE(ParseTimestamp(
       "$GPRMC,123519,A,4807.038,N,01131.000,E,022.4,084.4,230394,003.1,W*6A",
       timestamp, precision));
 
   // Test GGA (time in field 1)
-  EXPECT_TRUE(parser.ParseTimestamp(
+  EXPECT_TRUE(ParseTimestamp(
       "$GPGGA,123520,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,*47",
       timestamp, precision));
   EXPECT_EQ(timestamp.GetHour(), 12);
@@ -188,21 +205,21 @@ TEST_F(VDRTimeTest, GxxParsing) {
   EXPECT_EQ(timestamp.GetYear(), 1994);
 
   // Test GLL (time in field 5)
-  EXPECT_TRUE(parser.ParseTimestamp("$GPGLL,4916.45,N,12311.12,W,123521,A*31",
-                                    timestamp, precision));
+  EXPECT_TRUE(ParseTimestamp("$GPGLL,4916.45,N,12311.12,W,123521,A*31",
+                             timestamp, precision));
   EXPECT_EQ(timestamp.GetHour(), 12);
   EXPECT_EQ(timestamp.GetMinute(), 35);
   EXPECT_EQ(timestamp.GetSecond(), 21);
 
   // Without cached date, GGA should fail
   parser.Reset();  // Clear cached date
-  EXPECT_FALSE(parser.ParseTimestamp(
+  EXPECT_FALSE(ParseTimestamp(
       "$GPGGA,123520,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,*47",
       timestamp, precision));
 }
 
 /** Parse sentence that does not match the desired primary time source. */
-TEST_F(VDRTimeTest, ParseSecondaryTime) {
+TEST_P(VDRTimeTest, ParseSecondaryTime) {
   wxDateTime timestamp;
   int precision;
 
@@ -210,25 +227,25 @@ TEST_F(VDRTimeTest, ParseSecondaryTime) {
   parser.SetPrimaryTimeSource("GP", "RMC", 3);
 
   // Test sentence with different talker ID.
-  EXPECT_FALSE(parser.ParseTimestamp(
+  EXPECT_FALSE(ParseTimestamp(
       "$GNRMC,123519,A,4807.038,N,01131.000,E,022.4,084.4,230394,003.1,W*6A",
       timestamp, precision));
 
   // Test sentence with expected talker ID but different message type.
-  EXPECT_FALSE(parser.ParseTimestamp(
+  EXPECT_FALSE(ParseTimestamp(
       "$GPGSA,A,3,04,05,,09,12,,,24,,,,,2.5,1.3,2.1*39", timestamp, precision));
 
   // Test sentence with expected talker ID and message type, but different
   // precision. Expected precision is 3, but actual precision is 0.
-  EXPECT_FALSE(parser.ParseTimestamp(
+  EXPECT_FALSE(ParseTimestamp(
       "$GPRMC,123519,A,4807.038,N,01131.000,E,022.4,084.4,230394,003.1,W*6A",
       timestamp, precision));
 
   // Test sentence with expected talker ID, message type, and precision.
-  EXPECT_TRUE(
-      parser.ParseTimestamp("$GPRMC,123519.789,A,4807.038,N,01131.000,E,022.4,"
-                            "084.4,230394,003.1,W*6A7",
-                            timestamp, precision));
+  EXPECT_TRUE(ParseTimestamp(
+      "$GPRMC,123519.789,A,4807.038,N,01131.000,E,022.4,084.4,230394,003.1,"
+      "W*6A7",
+      timestamp, precision));
   EXPECT_EQ(timestamp.GetHour(), 12);
   EXPECT_EQ(timestamp.GetMinute(), 35);
   EXPECT_EQ(timestamp.GetSecond(), 19);
@@ -240,25 +257,25 @@ TEST_F(VDRTimeTest, ParseSecondaryTime) {
 }
 
 /** Test GGA/GBS/GLL sentence parsing with different date scenarios. */
-TEST_F(VDRTimeTest, GxxParsingDateScenarios) {
+TEST_P(VDRTimeTest, GxxParsingDateScenarios) {
   wxDateTime timestamp;
   int precision;
 
   // Scenario 1: No prior RMC or ZDA
-  EXPECT_FALSE(parser.ParseTimestamp(
+  EXPECT_FALSE(ParseTimestamp(
       "$GPGGA,123520,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,*47",
       timestamp, precision));
-  EXPECT_FALSE(parser.ParseTimestamp("$GPGBS,123520,3.0,2.9,5.3,11,,,*6B",
-                                     timestamp, precision));
-  EXPECT_FALSE(parser.ParseTimestamp("$GPGLL,4916.45,N,12311.12,W,123520,A*31",
-                                     timestamp, precision));
+  EXPECT_FALSE(ParseTimestamp("$GPGBS,123520,3.0,2.9,5.3,11,,,*6B", timestamp,
+                              precision));
+  EXPECT_FALSE(ParseTimestamp("$GPGLL,4916.45,N,12311.12,W,123520,A*31",
+                              timestamp, precision));
 
   // Scenario 2: Prior ZDA
-  EXPECT_TRUE(parser.ParseTimestamp("$GPZDA,123519,23,03,1994,00,00*6A",
-                                    timestamp, precision));
+  EXPECT_TRUE(ParseTimestamp("$GPZDA,123519,23,03,1994,00,00*6A", timestamp,
+                             precision));
 
   // Test GGA after ZDA
-  EXPECT_TRUE(parser.ParseTimestamp(
+  EXPECT_TRUE(ParseTimestamp(
       "$GPGGA,123520,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,*47",
       timestamp, precision));
   EXPECT_EQ(timestamp.GetHour(), 12);
@@ -269,22 +286,108 @@ TEST_F(VDRTimeTest, GxxParsingDateScenarios) {
   EXPECT_EQ(timestamp.GetYear(), 1994);
 
   // Test GBS after ZDA
-  EXPECT_TRUE(parser.ParseTimestamp("$GPGBS,123521,3.0,2.9,5.3,11,,,*6B",
-                                    timestamp, precision));
+  EXPECT_TRUE(ParseTimestamp("$GPGBS,123521,3.0,2.9,5.3,11,,,*6B", timestamp,
+                             precision));
   EXPECT_EQ(timestamp.GetHour(), 12);
   EXPECT_EQ(timestamp.GetMinute(), 35);
   EXPECT_EQ(timestamp.GetSecond(), 21);
 
   // Test GLL after ZDA
-  EXPECT_TRUE(parser.ParseTimestamp("$GPGLL,4916.45,N,12311.12,W,123522,A*31",
-                                    timestamp, precision));
+  EXPECT_TRUE(ParseTimestamp("$GPGLL,4916.45,N,12311.12,W,123522,A*31",
+                             timestamp, precision));
   EXPECT_EQ(timestamp.GetHour(), 12);
   EXPECT_EQ(timestamp.GetMinute(), 35);
   EXPECT_EQ(timestamp.GetSecond(), 22);
 }
 
+/** Test GNS/GST/GRS sentence parsing (time only). */
+TEST_P(VDRTimeTest, GnssTimeParsing) {
+  wxDateTime timestamp;
+  int precision;
+
+  EXPECT_FALSE(ParseTimestamp(
+      "$GNGNS,092212.00,5759.097,N,01144.345,E,AA,14,0.8,22.1,39.5,,*5F",
+      timestamp, precision));
+
+  EXPECT_TRUE(ParseTimestamp(
+      "$GPRMC,092211.00,A,5759.097,N,01144.345,E,0.0,0.0,200715,,,A*6E",
+      timestamp, precision));
+
+  EXPECT_TRUE(ParseTimestamp(
+      "$GNGNS,092212.00,5759.097,N,01144.345,E,AA,14,0.8,22.1,39.5,,*5F",
+      timestamp, precision));
+  EXPECT_EQ(timestamp.GetSecond(), 12);
+  EXPECT_EQ(timestamp.GetDay(), 20);
+  EXPECT_EQ(timestamp.GetMonth(), wxDateTime::Jul);
+  EXPECT_EQ(timestamp.GetYear(), 2015);
+  EXPECT_EQ(precision, 2);
+
+  EXPECT_TRUE(ParseTimestamp("$GPGST,092213.00,1.8,,,,1.7,1.3,2.2*7E",
+                             timestamp, precision));
+  EXPECT_EQ(timestamp.GetSecond(), 13);
+
+  EXPECT_TRUE(ParseTimestamp(
+      "$GPGRS,092214.0,1,-0.2,0.1,0.3,,,,,,,,,*7B", timestamp, precision));
+  EXPECT_EQ(timestamp.GetSecond(), 14);
+  EXPECT_EQ(timestamp.GetDay(), 20);
+  EXPECT_EQ(precision, 1);
+}
+
+/** Test AIS base station report (type 4) parsing. */
+TEST_P(VDRTimeTest, AISBaseStationParsing) {
+  wxDateTime timestamp;
+  int precision;
+
+  EXPECT_TRUE(ParseTimestamp("!AIVDM,1,1,,A,402R361uur9F;0mgM0Q;B`100000,0*4E",
+                             timestamp, precision));
+  EXPECT_EQ(timestamp.GetHour(), 9);
+  EXPECT_EQ(timestamp.GetMinute(), 22);
+  EXPECT_EQ(timestamp.GetSecond(), 11);
+  EXPECT_EQ(timestamp.GetDay(), 20);
+  EXPECT_EQ(timestamp.GetMonth(), wxDateTime::Jul);
+  EXPECT_EQ(timestamp.GetYear(), 2015);
+  EXPECT_EQ(precision, 0);
+
+  // The base station date is cached for sentences with time only.
+  EXPECT_TRUE(ParseTimestamp(
+      "$GPGGA,092212,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,*47",
+      timestamp, precision));
+  EXPECT_EQ(timestamp.GetDay(), 20);
+  EXPECT_EQ(timestamp.GetYear(), 2015);
+
+  // Date and time not available.
+  EXPECT_FALSE(ParseTimestamp(
+      "!AIVDM,1,1,,A,402R360000Htt0mgM0Q;B`100000,0*01", timestamp, precision));
+  // Position report, no time.
+  EXPECT_FALSE(ParseTimestamp("!AIVDM,1,1,,A,13u=gHP3CWPlvs2Q8sHW:5fD0h6a,0*0F",
+                              timestamp, precision));
+  // Multi-fragment messages are not decoded.
+  EXPECT_FALSE(ParseTimestamp(
+      "!AIVDM,2,1,3,B,402R361uur9F;0mgM0Q;B`100000,0*4E", timestamp, precision));
+}
+
+/** Sentences are looked up by their packed id. */
+TEST(TimestampParserTests, SentenceTimeFields) {
+  static_assert(FindSentenceTimeFields(PackSentenceId("RMC", 3)) != nullptr,
+                "RMC has a time field");
+  static_assert(FindSentenceTimeFields(PackSentenceId("VLW", 3)) == nullptr,
+                "VLW has no time field");
+  EXPECT_EQ(PackSentenceId("RMCX", 4), 0u);
+  const SentenceTimeFields* zda =
+      FindSentenceTimeFields(PackSentenceId(wxString("ZDA").wx_str(), 3));
+  ASSERT_NE(zda, nullptr);
+  EXPECT_EQ(zda->timeField, 1);
+  EXPECT_EQ(zda->date, SentenceDate::DAY_MONTH_YEAR);
+  EXPECT_EQ(zda->dateField, 2);
+  const SentenceTimeFields* gll =
+      FindSentenceTimeFields(PackSentenceId("GLL", 3));
+  ASSERT_NE(gll, nullptr);
+  EXPECT_EQ(gll->timeField, 5);
+  EXPECT_EQ(gll->date, SentenceDate::NONE);
+}
+
 /** Test CSV line parsing. */
-TEST_F(VDRTimeTest, CSVParsingISO8601) {
+TEST_P(VDRTimeTest, CSVParsingISO8601) {
   wxDateTime timestamp;
   wxString msg =
       "$GPRMC,123519,A,4807.038,N,01131.000,E,022.4,084.4,230394,003.1,W*6A";
@@ -357,4 +460,177 @@ TEST(TimestampParserTests, ParseISO8601) {
     EXPECT_FALSE(parser.ParseIso8601Timestamp("2024-02-03T09:22:11.1234Z",
                                               &dt));  // Too many ms digits
   }
-}
\ No newline at end of file
+}
+
+/** Unusual field contents give the same result with both parsers. */
+TEST_P(VDRTimeTest, UnusualFields) {
+  wxDateTime timestamp;
+  int precision;
+
+  // Time with a trailing character but no subseconds.
+  EXPECT_TRUE(ParseTimestamp("$GPZDA,123519x,23,03,1994,00,00*6A", timestamp,
+                             precision));
+  EXPECT_EQ(timestamp.GetSecond(), 19);
+  EXPECT_EQ(precision, 0);
+  // Date with extra characters.
+  EXPECT_TRUE(ParseTimestamp(
+      "$GPRMC,123519.5,A,4807.038,N,01131.000,E,022.4,084.4,2303945,003.1,"
+      "W*6A",
+      timestamp, precision));
+  EXPECT_EQ(timestamp.GetMillisecond(), 500);
+  EXPECT_EQ(precision, 1);
+  // Non numeric time and day, handled by the reference implementation.
+  EXPECT_FALSE(ParseTimestamp("$GPZDA,12:35:19,23,03,1994,00,00*6A",
+                              timestamp, precision));
+  EXPECT_TRUE(ParseTimestamp("$GPZDA,123519, 23,03,1994,00,00*6A", timestamp,
+                             precision));
+  EXPECT_EQ(timestamp.GetDay(), 23);
+  // Invalid subseconds separator.
+  EXPECT_FALSE(ParseTimestamp("$GPZDA,123519:12,23,03,1994,00,00*6A",
+                              timestamp, precision));
+  // Leap years.
+  EXPECT_TRUE(ParseTimestamp("$GPZDA,123519,29,02,2000,00,00*6A", timestamp,
+                             precision));
+  EXPECT_FALSE(ParseTimestamp("$GPZDA,123519,29,02,1900,00,00*6A", timestamp,
+                              precision));
+  EXPECT_FALSE(ParseTimestamp("$GPZDA,123519,31,04,2024,00,00*6A", timestamp,
+                              precision));
+}
+
+/** ISO 8601 timestamps give the same results with both parsers. */
+TEST(TimestampParserTests, ParseISO8601MatchesReference) {
+  TimestampParser parser;
+  for (const char* text :
+       {"2024-02-03T09:22:11.123Z", "2024-02-03T09:22:11Z",
+        "2024-02-29T23:59:59.999Z", "1994-03-23T12:35:19.000Z",
+        "2015-07-20T09:22:11.000+02:00", "2023-02-29T09:22:11Z",
+        "2024-13-03T09:22:11Z", "2024-02-03T09:60:11Z", "2024-02-03 09:22:11Z",
+        "2024-02-03T09:22:11.12Z", "2024-02-03T09:22:1xZ"}) {
+    wxDateTime fast, reference;
+    bool fastOk = parser.ParseIso8601Timestamp(text, &fast);
+    bool referenceOk = parser.ParseIso8601TimestampWx(text, &reference);
+    EXPECT_EQ(fastOk, referenceOk) << text;
+    if (fastOk && referenceOk) {
+      EXPECT_EQ(fast.GetValue(), reference.GetValue()) << text;
+    }
+  }
+}
+
+/** The fast parser gives the same results as the reference implementation. */
+TEST(TimestampParserTests, FastParserMatchesReference) {
+  for (const char* filename :
+       {"hakan.txt", "PacCupStart.txt", "Hakefjord-Sweden-1m.txt",
+        "with_timestamps.txt", "not_chronological.txt"}) {
+    std::ifstream file(std::string(TESTDATA) + "/" + filename);
+    ASSERT_TRUE(file.is_open()) << "Failed to open " << filename;
+    TimestampParser fast;
+    TimestampParser reference;
+    std::string line;
+    int parsed = 0;
+    while (std::getline(file, line)) {
+      wxString sentence(line);
+      wxDateTime fastTime, referenceTime;
+      int fastPrecision = -1, referencePrecision = -1;
+      bool fastOk = fast.ParseTimestamp(sentence, fastTime, fastPrecision);
+      bool referenceOk = reference.ParseTimestampWx(sentence, referenceTime,
+                                                    referencePrecision);
+      ASSERT_EQ(fastOk, referenceOk) << filename << ": " << line;
+      if (!fastOk) continue;
+      parsed++;
+      EXPECT_EQ(fastTime.GetValue(), referenceTime.GetValue())
+          << filename << ": " << line;
+      EXPECT_EQ(fastPrecision, referencePrecision) << filename << ": " << line;
+    }
+    EXPECT_GT(parsed, 0) << "No timestamp in " << filename;
+  }
+}
+
+/** Time sources are identified by their packed key. */
+TEST(TimestampParserTests, TimeSourceKey) {
+  TimeSource source("GP", "RMC", 3);
+  EXPECT_EQ(source.GetTalkerId(), "GP");
+  EXPECT_EQ(source.GetSentenceId(), "RMC");
+  EXPECT_EQ(source.GetPrecision(), 3);
+  EXPECT_EQ(source, TimeSource("GP", "RMC", 3));
+  EXPECT_FALSE(source == TimeSource("GP", "RMC", 2));
+  EXPECT_FALSE(source == TimeSource("GN", "RMC", 3));
+  EXPECT_FALSE(source == TimeSource("GP", "RM", 3));
+  EXPECT_EQ(source.GetIdKey(), TimeSource("GP", "RMC", 0).key);
+  EXPECT_EQ(TimeSourceHash{}(source),
+            TimeSourceHash{}(TimeSource("GP", "RMC", 3)));
+
+  // Ids shorter than 2 and 3 characters.
+  TimeSource shortSource("P", "", 0);
+  EXPECT_EQ(shortSource.GetTalkerId(), "P");
+  EXPECT_EQ(shortSource.GetSentenceId(), "");
+
+  // Only the primary time source is parsed.
+  TimestampParser parser;
+  parser.SetPrimaryTimeSource(TimeSource("GP", "ZDA", 2));
+  wxDateTime timestamp;
+  int precision;
+  EXPECT_FALSE(parser.ParseTimestamp(
+      "$GPRMC,123519.00,A,4807.038,N,01131.000,E,022.4,084.4,230394,003.1,W*"
+      "6A",
+      timestamp, precision));
+  EXPECT_TRUE(parser.ParseTimestamp("$GPZDA,201530.00,04,07,2002,00,00*60",
+                                    timestamp, precision));
+  EXPECT_FALSE(parser.ParseTimestampWx("$GNZDA,201530.00,04,07,2002,00,00*60",
+                                       timestamp, precision));
+}
+
+/** Parsing a batch gives the same results as parsing each line in turn. */
+TEST(TimestampParserTests, BatchMatchesSingle) {
+  for (const char* filename :
+       {"hakan.txt", "PacCupStart.txt", "with_timestamps.txt",
+        "not_chronological.txt"}) {
+    std::ifstream file(std::string(TESTDATA) + "/" + filename);
+    ASSERT_TRUE(file.is_open()) << "Failed to open " << filename;
+    std::vector<std::string> lines;
+    wxString buffer;
+    std::string line;
+    while (std::getline(file, line)) {
+      lines.push_back(line);
+      buffer += wxString(line) + "\n";
+    }
+    // Unusual fields, the date of the RMC sentence is used for GGA.
+    lines.push_back(
+        "$GPRMC,09221 ,A,5759.097,N,01144.345,E,0.0,0.0,200715,,*00");
+    lines.push_back(
+        "$GPRMC,092211.5,A,5759.097,N,01144.345,E,0.0,0.0,0107+5,,*00");
+    lines.push_back(
+        "$GPGGA,092212.25,5759.097,N,01144.345,E,1,8,0.9,2.0,M,,*00");
+    lines.push_back("");
+    for (size_t i = lines.size() - 4; i < lines.size(); i++) {
+      buffer += wxString(lines[i]) + "\r\n";
+    }
+
+    TimestampParser single;
+    TimestampParser batchParser;
+    TimestampBatch batch;
+    const wxStringCharType* text = buffer.wx_str();
+    ASSERT_EQ(batchParser.ParseTimestamps(
+                  text, std::char_traits<wxStringCharType>::length(text),
+                  batch),
+              lines.size());
+    ASSERT_EQ(batch.GetCount(), lines.size());
+    int parsed = 0;
+    for (size_t i = 0; i < lines.size(); i++) {
+      wxDateTime timestamp;
+      int precision = -1;
+      bool ok = single.ParseTimestamp(lines[i], timestamp, precision);
+      ASSERT_EQ(batch.valid[i] != 0, ok) << filename << ": " << lines[i];
+      if (!ok) continue;
+      parsed++;
+      EXPECT_EQ(batch.epochMs[i], timestamp.GetValue().GetValue())
+          << filename << ": " << lines[i];
+      EXPECT_EQ(batch.precision[i], precision) << filename << ": " << lines[i];
+      wxString sentenceId = wxString(lines[i]).BeforeFirst(',');
+      EXPECT_EQ(batch.sourceKey[i],
+                TimeSource(sentenceId.Mid(1, 2), sentenceId.Mid(3), precision)
+                    .key)
+          << filename << ": " << lines[i];
+    }
+    EXPECT_GT(parsed, 0) << "No timestamp in " << filename;
+  }
+}
@@ -0,0 +1,323 @@
+/***************************************************************************
+ *   Copyright (C) 2024 by OpenCPN development team                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ **************************************************************************/
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "wx/wxprec.h"
+
+#ifndef WX_PRECOMP
+#include "wx/wx.h"
+#endif  // precompiled headers
+#include "wx/file.h"
+#include "wx/filename.h"
+#include "wx/init.h"
+#include "wx/socket.h"
+#include "wx/tokenzr.h"
+
+#include "vdr_nmea.h"
+#include "vdr_pi.h"
+#include "mock_plugin_api.h"
+
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+/**
+ * Number of timestamped RMC sentences in the generated file. There are
+ * enough intervals for the p99 to leave out the worst few, a single
+ * scheduling hiccup does not fail the test.
+ */
+const int TIMING_FIX_COUNT = 300;
+/** Sentences without a timestamp between two RMC sentences. */
+const int TIMING_FILLER_COUNT = 3;
+
+/**
+ * Regression thresholds, in milliseconds.
+ *
+ * They leave room for the scheduling noise of shared CI runners, while
+ * sending messages early or batched with the previous one still fails.
+ */
+const double MAX_MEAN_ERROR_MS = 5.0;
+const double MAX_P99_JITTER_MS = 25.0;
+
+/** A message captured by one of the playback outputs. */
+struct CapturedMessage {
+  wxString sentence;
+  Clock::time_point received;
+};
+
+/** Mean error and p99 jitter of the inter-arrival times of an output. */
+struct TimingStats {
+  size_t intervals = 0;
+  double meanErrorMs = 0;
+  double p99JitterMs = 0;
+};
+
+wxString WithChecksum(const wxString& body) {
+  uint8_t checksum = ComputeNMEAChecksum(body.wx_str(), body.length());
+  return wxString::Format("$%s*%02X", body, static_cast<int>(checksum));
+}
+
+/**
+ * Write a raw NMEA file with RMC sentences at irregular intervals.
+ *
+ * The intervals are picked so the file plays in about six seconds at the
+ * given speed.
+ *
+ * @param path File to write.
+ * @param speed Playback speed the file is meant for.
+ * @return Recorded interval between consecutive RMC sentences, in ms.
+ */
+std::vector<VDRTimeMs> WriteTimingFile(const wxString& path, double speed) {
+  const wxString fillers[TIMING_FILLER_COUNT] = {
+      "$IIMTW,16.8,C*1C", "$IIHDG,25.0,0,E,0.0,E*60",
+      "$IIVHW,,T,25.0,M,5.9,N,10.9,K*78"};
+  std::vector<VDRTimeMs> intervals;
+  wxString content;
+  // 09:22:11.00, as in the other test recordings.
+  VDRTimeMs timeMs = (9 * 3600 + 22 * 60 + 11) * 1000;
+  for (int i = 0; i < TIMING_FIX_COUNT; i++) {
+    if (i > 0) {
+      // 10 to 30 ms of playback time, in centiseconds of recording time.
+      VDRTimeMs played = 10 + (i * 37) % 21;
+      VDRTimeMs interval = std::llround(played * speed / 10) * 10;
+      intervals.push_back(interval);
+      timeMs += interval;
+    }
+    content += WithChecksum(wxString::Format(
+                   "GPRMC,%02d%02d%02d.%02d,A,5759.097,N,01144.345,E,5.5,"
+                   "30.5,200715,0.0,E",
+                   static_cast<int>(timeMs / 3600000),
+                   static_cast<int>(timeMs / 60000 % 60),
+                   static_cast<int>(timeMs / 1000 % 60),
+                   static_cast<int>(timeMs % 1000 / 10))) +
+               "\n";
+    for (const auto& filler : fillers) {
+      content += filler + "\n";
+    }
+  }
+  wxFile file(path, wxFile::write);
+  file.Write(content);
+  return intervals;
+}
+
+/** Receive the sentences sent by the UDP playback server. */
+class UDPCapture {
+public:
+  ~UDPCapture() { Stop(); }
+
+  /** Listen on a port picked by the system, see GetPort(). */
+  bool Start() {
+    wxIPV4address addr;
+    addr.Hostname("127.0.0.1");
+    addr.Service(0);
+    // Blocking sockets are the only ones that can be used from a thread.
+    m_socket = std::make_unique<wxDatagramSocket>(addr, wxSOCKET_BLOCK);
+    if (!m_socket->IsOk() || !m_socket->GetLocal(addr)) return false;
+    m_port = addr.Service();
+    m_stop = false;
+    m_thread = std::thread([this]() { Run(); });
+    return true;
+  }
+
+  void Stop() {
+    m_stop = true;
+    if (m_thread.joinable()) m_thread.join();
+    m_socket.reset();
+  }
+
+  int GetPort() const { return m_port; }
+
+  std::vector<CapturedMessage> GetMessages() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_messages;
+  }
+
+private:
+  void Run() {
+    char buffer[2048];
+    wxIPV4address from;
+    while (!m_stop) {
+      if (!m_socket->WaitForRead(0, 20)) continue;
+      m_socket->RecvFrom(from, buffer, sizeof(buffer));
+      Clock::time_point received = Clock::now();
+      if (m_socket->Error() || m_socket->LastCount() == 0) continue;
+      // A datagram holds several sentences.
+      wxStringTokenizer tokenizer(wxString(buffer, m_socket->LastCount()),
+                                  "\r\n", wxTOKEN_STRTOK);
+      std::lock_guard<std::mutex> lock(m_mutex);
+      while (tokenizer.HasMoreTokens()) {
+        m_messages.push_back({tokenizer.GetNextToken(), received});
+      }
+    }
+  }
+
+  std::unique_ptr<wxDatagramSocket> m_socket;
+  int m_port = 0;
+  std::thread m_thread;
+  std::atomic<bool> m_stop{true};
+  std::mutex m_mutex;
+  std::vector<CapturedMessage> m_messages;
+};
+
+/**
+ * Compare the inter-arrival times of the RMC sentences with the recording.
+ *
+ * @param messages Messages captured from one output, in arrival order.
+ * @param intervals Recorded interval between consecutive RMC sentences.
+ * @param speed Playback speed.
+ */
+TimingStats ComputeTimingStats(const std::vector<CapturedMessage>& messages,
+                               const std::vector<VDRTimeMs>& intervals,
+                               double speed) {
+  std::vector<Clock::time_point> arrivals;
+  for (const auto& message : messages) {
+    if (message.sentence.StartsWith("$GPRMC")) {
+      arrivals.push_back(message.received);
+    }
+  }
+  std::vector<double> errors;
+  for (size_t i = 1; i < arrivals.size() && i <= intervals.size(); i++) {
+    double actual = std::chrono::duration<double, std::milli>(
+                        arrivals[i] - arrivals[i - 1])
+                        .count();
+    errors.push_back(std::fabs(actual - intervals[i - 1] / speed));
+  }
+
+  TimingStats stats;
+  stats.intervals = errors.size();
+  if (errors.empty()) return stats;
+  for (double error : errors) stats.meanErrorMs += error;
+  stats.meanErrorMs /= errors.size();
+  // Nearest-rank percentile.
+  std::sort(errors.begin(), errors.end());
+  size_t rank = static_cast<size_t>(std::ceil(0.99 * errors.size()));
+  stats.p99JitterMs = errors[std::max<size_t>(rank, 1) - 1];
+  return stats;
+}
+
+}  // namespace
+
+/**
+ * Playback timing fidelity, at several speeds.
+ *
+ * The playback timer is driven the way wxWidgets would drive it, each
+ * notification is delivered when the next message is due.
+ */
+class PlaybackTimingTest : public ::testing::TestWithParam<double> {
+protected:
+  // Sockets need the wxWidgets library to be initialized.
+  static void SetUpTestSuite() { wxInitialize(); }
+  static void TearDownTestSuite() { wxUninitialize(); }
+
+  void Report(const char* output, const TimingStats& stats) {
+    double speed = GetParam();
+    std::cout << wxString::Format(
+                     "%s at %gx: %d intervals, mean error %.2f ms, "
+                     "p99 jitter %.2f ms",
+                     output, speed, static_cast<int>(stats.intervals),
+                     stats.meanErrorMs, stats.p99JitterMs)
+              << std::endl;
+    RecordProperty(std::string(output) + "_mean_error_ms",
+                   wxString::Format("%.3f", stats.meanErrorMs).ToStdString());
+    RecordProperty(std::string(output) + "_p99_jitter_ms",
+                   wxString::Format("%.3f", stats.p99JitterMs).ToStdString());
+    EXPECT_EQ(stats.intervals, static_cast<size_t>(TIMING_FIX_COUNT - 1))
+        << output;
+    EXPECT_LT(stats.meanErrorMs, MAX_MEAN_ERROR_MS) << output;
+    EXPECT_LT(stats.p99JitterMs, MAX_P99_JITTER_MS) << output;
+  }
+};
+
+TEST_P(PlaybackTimingTest, InterArrivalTimes) {
+  double speed = GetParam();
+  wxString testfile = wxFileName::CreateTempFileName("vdr_timing");
+  std::vector<VDRTimeMs> intervals = WriteTimingFile(testfile, speed);
+
+  UDPCapture capture;
+  ASSERT_TRUE(capture.Start()) << "Failed to listen on a UDP port";
+
+  vdr_pi plugin(nullptr);
+  plugin.Init();
+  VDRProtocolSettings protocols = plugin.GetProtocolSettings();
+  protocols.nmea0183ReplayMode = NMEA0183ReplayMode::INTERNAL_API;
+  protocols.nmea0183Net.enabled = true;
+  protocols.nmea0183Net.useTCP = false;
+  protocols.nmea0183Net.port = capture.GetPort();
+  plugin.SetProtocolSettings(protocols);
+  plugin.SetSpeedMultiplier(speed);
+
+  ASSERT_TRUE(plugin.LoadFile(testfile)) << "Failed to load test file";
+  bool hasValidTimestamps;
+  wxString error;
+  ASSERT_TRUE(plugin.ScanFileTimestamps(hasValidTimestamps, error))
+      << wxString::Format("Failed to scan timestamps: %s", error);
+  ASSERT_TRUE(hasValidTimestamps);
+
+  ClearNMEASentences();
+  plugin.StartPlayback();
+  while (!plugin.IsAtFileEnd()) {
+    VDRTimeMs due = plugin.GetNextPlaybackTime();
+    ASSERT_NE(due, INVALID_TIME_MS);
+    VDRTimeMs delay = due - wxGetUTCTimeMillis().GetValue();
+    if (delay > 0) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(delay));
+    }
+    plugin.Notify();
+  }
+
+  // Let the last datagrams arrive.
+  const size_t lineCount = TIMING_FIX_COUNT * (1 + TIMING_FILLER_COUNT);
+  for (int i = 0; i < 50 && capture.GetMessages().size() < lineCount; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  capture.Stop();
+  plugin.StopPlayback();
+  plugin.DeInit();
+  wxRemoveFile(testfile);
+
+  std::vector<CapturedMessage> pushed;
+  const auto& sentences = GetNMEASentences();
+  const auto& receiveTimes = GetNMEAReceiveTimes();
+  for (size_t i = 0; i < sentences.size(); i++) {
+    pushed.push_back({sentences[i], receiveTimes[i]});
+  }
+  std::vector<CapturedMessage> sent = capture.GetMessages();
+  EXPECT_EQ(pushed.size(), lineCount);
+  EXPECT_EQ(sent.size(), lineCount);
+
+  Report("PushNMEABuffer", ComputeTimingStats(pushed, intervals, speed));
+  Report("UDP", ComputeTimingStats(sent, intervals, speed));
+}
+
+INSTANTIATE_TEST_SUITE_P(Speeds, PlaybackTimingTest,
+                         ::testing::Values(1.0, 10.0, 100.0),
+                         [](const testing::TestParamInfo<double>& info) {
+                           return "Speed" + std::to_string(
+                                                static_cast<int>(info.param));
+                         });
@@ -0,0 +1,320 @@
+/***************************************************************************
+ *   Copyright (C) 2024 by OpenCPN development team                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ **************************************************************************/
+
+/**
+ * Microbenchmarks of the recording and playback hot paths.
+ *
+ * Run with --benchmark_out=<file> --benchmark_out_format=json to keep the
+ * results, the run-bench target does this.
+ */
+
+#include "wx/wxprec.h"
+
+#ifndef WX_PRECOMP
+#include "wx/wx.h"
+#endif  // precompiled headers
+
+#include "wx/file.h"
+#include "wx/filename.h"
+#include "wx/dir.h"
+
+#include <benchmark/benchmark.h>
+#include "vdr_pi_time.h"
+#include "vdr_pi.h"
+#include "vdr_load_generator.h"
+
+static void BM_ParseTimestampRMC(benchmark::State& state) {
+  TimestampParser parser;
+  wxString sentence(
+      "$GPRMC,092211.00,A,5759.097,N,01144.345,E,0.0,0.0,200715,,,A*6E");
+  wxDateTime timestamp;
+  int precision;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        parser.ParseTimestamp(sentence, timestamp, precision));
+  }
+}
+BENCHMARK(BM_ParseTimestampRMC);
+
+static void BM_ParseTimestampRMCWx(benchmark::State& state) {
+  TimestampParser parser;
+  wxString sentence(
+      "$GPRMC,092211.00,A,5759.097,N,01144.345,E,0.0,0.0,200715,,,A*6E");
+  wxDateTime timestamp;
+  int precision;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        parser.ParseTimestampWx(sentence, timestamp, precision));
+  }
+}
+BENCHMARK(BM_ParseTimestampRMCWx);
+
+static void BM_ParseTimestampNoTime(benchmark::State& state) {
+  TimestampParser parser;
+  wxString sentence("$IIVLW,2354.92,N,2338.533,N*79");
+  wxDateTime timestamp;
+  int precision;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        parser.ParseTimestamp(sentence, timestamp, precision));
+  }
+}
+BENCHMARK(BM_ParseTimestampNoTime);
+
+/** Parse the timestamps of a test data file, one line at a time. */
+static void BM_ParseTimestampLines(benchmark::State& state) {
+  wxString buffer;
+  wxFile(wxString(TESTDATA) + "/hakan.txt").ReadAll(&buffer);
+  wxArrayString lines = wxSplit(buffer, '\n', '\0');
+  wxDateTime timestamp;
+  int precision;
+  for (auto _ : state) {
+    TimestampParser parser;
+    for (const auto& line : lines) {
+      benchmark::DoNotOptimize(
+          parser.ParseTimestamp(line, timestamp, precision));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * lines.size());
+}
+BENCHMARK(BM_ParseTimestampLines);
+
+/** Parse the timestamps of a test data file as a batch. */
+static void BM_ParseTimestampBatch(benchmark::State& state) {
+  wxString buffer;
+  wxFile(wxString(TESTDATA) + "/hakan.txt").ReadAll(&buffer);
+  const wxStringCharType* text = buffer.wx_str();
+  size_t length = std::char_traits<wxStringCharType>::length(text);
+  TimestampBatch batch;
+  size_t count = 0;
+  for (auto _ : state) {
+    TimestampParser parser;
+    count = parser.ParseTimestamps(text, length, batch);
+    benchmark::DoNotOptimize(batch.epochMs.data());
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_ParseTimestampBatch);
+
+static void BM_ParseIso8601Timestamp(benchmark::State& state) {
+  TimestampParser parser;
+  wxString text("2015-07-20T09:22:11.123Z");
+  wxDateTime timestamp;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(parser.ParseIso8601Timestamp(text, &timestamp));
+  }
+}
+BENCHMARK(BM_ParseIso8601Timestamp);
+
+static void BM_ParseIso8601TimestampWx(benchmark::State& state) {
+  TimestampParser parser;
+  wxString text("2015-07-20T09:22:11.123Z");
+  wxDateTime timestamp;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(parser.ParseIso8601TimestampWx(text, &timestamp));
+  }
+}
+BENCHMARK(BM_ParseIso8601TimestampWx);
+
+static void BM_ParseCSVLineTimestamp(benchmark::State& state) {
+  TimestampParser parser;
+  wxString line(
+      "2015-07-20T09:22:11.123Z,NMEA0183,,\"$GPRMC,092211.00,A,5759.097,N,"
+      "01144.345,E,0.0,0.0,200715,,,A*6E\"");
+  wxString message;
+  wxDateTime timestamp;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        parser.ParseCSVLineTimestamp(line, 0, 3, &message, &timestamp));
+  }
+}
+BENCHMARK(BM_ParseCSVLineTimestamp);
+
+static void BM_ParseNMEAComponents(benchmark::State& state) {
+  vdr_pi plugin(nullptr);
+  wxString sentence(
+      "$GPRMC,092211.00,A,5759.097,N,01144.345,E,0.0,0.0,200715,,,A*6E");
+  wxString talkerId;
+  wxString sentenceId;
+  bool hasTimestamp;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(plugin.ParseNMEAComponents(
+        sentence, talkerId, sentenceId, hasTimestamp));
+  }
+}
+BENCHMARK(BM_ParseNMEAComponents);
+
+static void BM_ValidateNMEASentence(benchmark::State& state) {
+  wxString sentence(
+      "$GPRMC,092211.00,A,5759.09700,N,01144.34344,E,5.257,28.27,200715,,,"
+      "A*58");
+  const wxStringCharType* text = sentence.wx_str();
+  size_t length = std::char_traits<wxStringCharType>::length(text);
+  NMEASentenceHeader header;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(ValidateNMEASentence(text, length, &header));
+  }
+  state.SetBytesProcessed(state.iterations() * length);
+}
+BENCHMARK(BM_ValidateNMEASentence);
+
+static void BM_FormatNMEA0183AsCSV(benchmark::State& state) {
+  vdr_pi plugin(nullptr);
+  wxString sentence("!AIVDM,1,1,,A,13aEOK?P00PD2wVMdLDRhgvL289?,0*26\r\n");
+  wxDateTime timestamp = wxDateTime::UNow();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(plugin.FormatNMEA0183AsCSV(sentence, timestamp));
+  }
+}
+BENCHMARK(BM_FormatNMEA0183AsCSV);
+
+static void BM_FormatN2KPayload(benchmark::State& state) {
+  // COG & SOG rapid update (PGN 129026) as delivered by OpenCPN, with the
+  // 11 header bytes.
+  std::vector<uint8_t> payload = {0x93, 0x13, 0x02, 0x02, 0xF8, 0x01,
+                                  0xFF, 0x00, 0x00, 0x00, 0x08, 0xFF,
+                                  0xFC, 0x21, 0x2E, 0x9A, 0x02, 0x00,
+                                  0xFF, 0xFF, 0xFF, 0xFF};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(vdr_pi::FormatN2KPayload(payload));
+  }
+  state.SetBytesProcessed(state.iterations() * payload.size());
+}
+BENCHMARK(BM_FormatN2KPayload);
+
+/** Scan all timestamps of a test data file. */
+static void BM_ScanFileTimestamps(benchmark::State& state,
+                                  const char* filename) {
+  wxLogNull noLog;
+  vdr_pi plugin(nullptr);
+  if (!plugin.LoadFile(wxString(TESTDATA) + "/" + filename)) {
+    state.SkipWithError("Failed to load test file");
+    return;
+  }
+  bool hasValidTimestamps;
+  wxString error;
+  for (auto _ : state) {
+    if (!plugin.ScanFileTimestamps(hasValidTimestamps, error)) {
+      state.SkipWithError("Failed to scan timestamps");
+      break;
+    }
+  }
+}
+BENCHMARK_CAPTURE(BM_ScanFileTimestamps, PacCupStart, "PacCupStart.txt")
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_ScanFileTimestamps, Hakefjord,
+                  "Hakefjord-Sweden-1m.txt")
+    ->Unit(benchmark::kMillisecond);
+
+/**
+ * Scan the timestamps of a generated CSV file, one message every 100 ms.
+ * The file is written once per size.
+ */
+static void BM_ScanCSVTimestamps(benchmark::State& state) {
+  wxLogNull noLog;
+  const int lineCount = static_cast<int>(state.range(0));
+  wxString filename =
+      wxFileName(wxFileName::GetTempDir(),
+                 wxString::Format("vdr_bench_%d.csv", lineCount))
+          .GetFullPath();
+  if (!wxFileExists(filename)) {
+    wxFile file(filename, wxFile::write);
+    file.Write("timestamp,type,id,message\n");
+    wxDateTime time(wxLongLong(1437384131000LL));
+    for (int i = 0; i < lineCount; i++) {
+      file.Write(time.Format("%Y-%m-%dT%H:%M:%S.%lZ", wxDateTime::UTC) +
+                 ",NMEA0183,,\"$IIMTW,16.8,C*1C\"\n");
+      time += wxTimeSpan::Milliseconds(100);
+    }
+  }
+  vdr_pi plugin(nullptr);
+  if (!plugin.LoadFile(filename)) {
+    state.SkipWithError("Failed to load generated file");
+    return;
+  }
+  bool hasValidTimestamps;
+  wxString error;
+  for (auto _ : state) {
+    if (!plugin.ScanFileTimestamps(hasValidTimestamps, error)) {
+      state.SkipWithError("Failed to scan timestamps");
+      break;
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * lineCount);
+}
+BENCHMARK(BM_ScanCSVTimestamps)
+    ->Arg(100000)
+    ->Arg(1000000)
+    ->Unit(benchmark::kMillisecond);
+
+/**
+ * Record a generated stream of 100 NMEA 0183 sentences per second, 200 AIS
+ * targets and 100 NMEA 2000 messages per second, the rate is reported as
+ * items per second.
+ */
+static void BM_RecordGeneratedLoad(benchmark::State& state) {
+  wxLogNull noLog;
+  VDRLoadSettings settings;
+  settings.durationMs = 60 * 1000;
+  settings.navigationRate = 25;
+  settings.aisTargets = 200;
+  settings.aisInterval = 2;
+  settings.n2kRate = 25;
+  std::vector<VDRLoadMessage> messages;
+  VDRLoadGenerator generator(settings);
+  VDRLoadMessage message;
+  while (generator.Next(message)) {
+    messages.push_back(message);
+  }
+
+  wxString dir = wxFileName::CreateTempFileName("vdr_bench");
+  wxRemoveFile(dir);
+  wxFileName::Mkdir(dir);
+  vdr_pi plugin(nullptr);
+  plugin.Init();
+  plugin.SetRecordingDir(dir);
+  plugin.SetDataFormat(state.range(0) ? VDRDataFormat::CSV
+                                      : VDRDataFormat::RawNMEA);
+  plugin.SetLogRotate(false);
+  VDRProtocolSettings protocols = plugin.GetProtocolSettings();
+  protocols.nmea2000 = true;
+  plugin.SetProtocolSettings(protocols);
+  plugin.StartRecording();
+  for (auto _ : state) {
+    for (const auto& generated : messages) {
+      if (generated.type == VDRLoadMessage::Type::NMEA2000) {
+        plugin.ProcessN2KPayload(generated.payload);
+      } else {
+        wxString sentence(generated.sentence);
+        plugin.SetNMEASentence(sentence);
+      }
+    }
+  }
+  plugin.StopRecording("Benchmark complete");
+  plugin.DeInit();
+  wxDir::Remove(dir, wxPATH_RMDIR_RECURSIVE);
+  state.SetItemsProcessed(state.iterations() * messages.size());
+}
+BENCHMARK(BM_RecordGeneratedLoad)
+    ->ArgName("csv")
+    ->Arg(0)
+    ->Arg(1)
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,123 @@
+/***************************************************************************
+ *   Copyright (C) 2024 by OpenCPN development team                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ **************************************************************************/
+
+/**
+ * Command line front end of the load generator.
+ *
+ * Writes a synthetic VDR file, raw NMEA by default, to a file or the
+ * standard output. With --realtime the messages are written at their
+ * generation time, so the output can be piped to a network tool to feed a
+ * live stream.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+#include "vdr_load_generator.h"
+
+namespace {
+
+void Usage(const char* program) {
+  fprintf(stderr,
+          "Usage: %s [options]\n"
+          "  --duration <seconds>      Length of the data (default 60)\n"
+          "  --rate <hz>               RMC, GGA, HDG and MWV rate (default 1)\n"
+          "  --ais-targets <count>     Number of AIS targets (default 0)\n"
+          "  --ais-interval <seconds>  Reporting interval of a target "
+          "(default 10)\n"
+          "  --n2k-rate <hz>           Rate of each NMEA 2000 PGN (default 0)\n"
+          "  --seed <number>           Random seed (default 1)\n"
+          "  --start <ms>              Start time, ms since the epoch\n"
+          "  --csv                     Write CSV instead of raw NMEA\n"
+          "  --realtime                Write messages at their time\n"
+          "  --output <file>           Output file (default stdout)\n",
+          program);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  VDRLoadSettings settings;
+  bool csv = false;
+  bool realtime = false;
+  const char* output = nullptr;
+  for (int i = 1; i < argc; i++) {
+    const char* option = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (strcmp(option, "--csv") == 0) {
+      csv = true;
+    } else if (strcmp(option, "--realtime") == 0) {
+      realtime = true;
+    } else if (strcmp(option, "--duration") == 0 && hasValue) {
+      settings.durationMs =
+          static_cast<int64_t>(strtod(argv[++i], nullptr) * 1000);
+    } else if (strcmp(option, "--rate") == 0 && hasValue) {
+      settings.navigationRate = strtod(argv[++i], nullptr);
+    } else if (strcmp(option, "--ais-targets") == 0 && hasValue) {
+      settings.aisTargets = atoi(argv[++i]);
+    } else if (strcmp(option, "--ais-interval") == 0 && hasValue) {
+      settings.aisInterval = strtod(argv[++i], nullptr);
+    } else if (strcmp(option, "--n2k-rate") == 0 && hasValue) {
+      settings.n2kRate = strtod(argv[++i], nullptr);
+    } else if (strcmp(option, "--seed") == 0 && hasValue) {
+      settings.seed = strtoull(argv[++i], nullptr, 10);
+    } else if (strcmp(option, "--start") == 0 && hasValue) {
+      settings.startTimeMs = strtoll(argv[++i], nullptr, 10);
+    } else if (strcmp(option, "--output") == 0 && hasValue) {
+      output = argv[++i];
+    } else {
+      Usage(argv[0]);
+      return 1;
+    }
+  }
+
+  FILE* file = output ? fopen(output, "wb") : stdout;
+  if (!file) {
+    fprintf(stderr, "Cannot open %s\n", output);
+    return 1;
+  }
+  if (csv) {
+    fprintf(file, "%s\n", VDRLoadGenerator::CSV_HEADER);
+  }
+
+  VDRLoadGenerator generator(settings);
+  VDRLoadMessage message;
+  size_t count = 0;
+  auto start = std::chrono::steady_clock::now();
+  while (generator.Next(message)) {
+    if (realtime) {
+      std::this_thread::sleep_until(
+          start +
+          std::chrono::milliseconds(message.timeMs - settings.startTimeMs));
+    }
+    std::string line = csv ? VDRLoadGenerator::FormatCSVLine(message)
+                           : VDRLoadGenerator::FormatRawLine(message);
+    fwrite(line.data(), 1, line.size(), file);
+    if (realtime) fflush(file);
+    count++;
+  }
+  if (output) {
+    fclose(file);
+  }
+  fprintf(stderr, "Generated %zu messages\n", count);
+  return 0;
+}
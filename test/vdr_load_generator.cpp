@@ -0,0 +1,388 @@
+/***************************************************************************
+ *   Copyright (C) 2024 by OpenCPN development team                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ **************************************************************************/
+
+#include "vdr_load_generator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace {
+
+const double PI = 3.14159265358979323846;
+const double KNOTS_TO_MS = 1852.0 / 3600.0;
+
+/** Append the *hh checksum to a sentence starting with $ or !. */
+std::string AddChecksum(const std::string& sentence) {
+  uint8_t checksum = 0;
+  for (size_t i = 1; i < sentence.size(); i++) {
+    checksum ^= static_cast<uint8_t>(sentence[i]);
+  }
+  char suffix[4];
+  snprintf(suffix, sizeof(suffix), "*%02X", checksum);
+  return sentence + suffix;
+}
+
+/** Format a latitude or longitude as NMEA 0183 [d]ddmm.mmmm,H. */
+std::string FormatCoordinate(double value, bool isLatitude) {
+  // Work in 1/10000 of minutes so the minutes never round up to 60.
+  long long total = std::llround(std::fabs(value) * 600000.0);
+  char text[32];
+  snprintf(text, sizeof(text), isLatitude ? "%02lld%02lld.%04lld,%c"
+                                          : "%03lld%02lld.%04lld,%c",
+           total / 600000, total % 600000 / 10000, total % 10000,
+           isLatitude ? (value < 0 ? 'S' : 'N') : (value < 0 ? 'W' : 'E'));
+  return text;
+}
+
+/** Split a time into calendar fields, proleptic Gregorian calendar. */
+void CivilFromTime(int64_t timeMs, int& year, int& month, int& day,
+                   int& msOfDay) {
+  int64_t days = timeMs / 86400000;
+  msOfDay = static_cast<int>(timeMs % 86400000);
+  if (msOfDay < 0) {
+    msOfDay += 86400000;
+    days--;
+  }
+  days += 719468;
+  int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+  int64_t dayOfEra = days - era * 146097;
+  int64_t yearOfEra =
+      (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+  int64_t dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 -
+                                  yearOfEra / 100);
+  int64_t mp = (5 * dayOfYear + 2) / 153;
+  day = static_cast<int>(dayOfYear - (153 * mp + 2) / 5 + 1);
+  month = static_cast<int>(mp < 10 ? mp + 3 : mp - 9);
+  year = static_cast<int>(yearOfEra + era * 400 + (month <= 2));
+}
+
+/** Format the time of day as hhmmss.ss. */
+std::string FormatNMEATime(int64_t timeMs) {
+  int year, month, day, msOfDay;
+  CivilFromTime(timeMs, year, month, day, msOfDay);
+  char text[16];
+  snprintf(text, sizeof(text), "%02d%02d%02d.%02d", msOfDay / 3600000,
+           msOfDay / 60000 % 60, msOfDay / 1000 % 60, msOfDay % 1000 / 10);
+  return text;
+}
+
+/** Bit writer for the 6-bit armored AIS payload. */
+class AISPayload {
+public:
+  void Add(int64_t value, int width) {
+    for (int i = width - 1; i >= 0; i--) {
+      m_bits.push_back(static_cast<uint8_t>((value >> i) & 1));
+    }
+  }
+
+  std::string Armor() const {
+    std::string text;
+    for (size_t i = 0; i + 6 <= m_bits.size(); i += 6) {
+      int value = 0;
+      for (size_t j = 0; j < 6; j++) value = (value << 1) | m_bits[i + j];
+      text += static_cast<char>(value < 40 ? value + 48 : value + 56);
+    }
+    return text;
+  }
+
+private:
+  std::vector<uint8_t> m_bits;
+};
+
+void AddUInt16(std::vector<uint8_t>& data, unsigned int value) {
+  data.push_back(static_cast<uint8_t>(value & 0xFF));
+  data.push_back(static_cast<uint8_t>((value >> 8) & 0xFF));
+}
+
+void AddInt32(std::vector<uint8_t>& data, int32_t value) {
+  uint32_t bits = static_cast<uint32_t>(value);
+  for (int i = 0; i < 4; i++) {
+    data.push_back(static_cast<uint8_t>((bits >> (8 * i)) & 0xFF));
+  }
+}
+
+/** Angle in degrees as NMEA 2000 radians * 10000. */
+unsigned int ToN2KAngle(double degrees) {
+  double angle = std::fmod(degrees + 360.0, 360.0);
+  return static_cast<unsigned int>(std::lround(angle * PI / 180.0 * 10000.0));
+}
+
+}  // namespace
+
+const char* const VDRLoadGenerator::CSV_HEADER = "timestamp,type,id,message";
+
+VDRLoadGenerator::VDRLoadGenerator(const VDRLoadSettings& settings)
+    : m_settings(settings),
+      m_random_state(settings.seed),
+      m_order(0),
+      m_sid(0) {
+  int64_t startUs = settings.startTimeMs * 1000;
+  m_ownShip = {257000000, 57.98495, 11.73908, 5.5, 30.0, startUs};
+  for (int i = 0; i < settings.aisTargets; i++) {
+    Vessel target = {static_cast<uint32_t>(265000000 + i),
+                     m_ownShip.lat + (Random() - 0.5) * 0.2,
+                     m_ownShip.lon + (Random() - 0.5) * 0.4,
+                     Random() * 15.0,
+                     Random() * 360.0,
+                     startUs};
+    m_targets.push_back(target);
+  }
+
+  if (settings.navigationRate > 0) {
+    int64_t period = std::llround(1e6 / settings.navigationRate);
+    for (Stream stream :
+         {Stream::RMC, Stream::GGA, Stream::HDG, Stream::MWV}) {
+      Schedule(startUs, stream, 0, period);
+    }
+  }
+  if (settings.aisTargets > 0 && settings.aisInterval > 0) {
+    // Spread the targets over the reporting interval.
+    int64_t period = std::llround(settings.aisInterval * 1e6);
+    for (int i = 0; i < settings.aisTargets; i++) {
+      Schedule(startUs + period * i / settings.aisTargets, Stream::AIS, i,
+               period);
+    }
+  }
+  if (settings.n2kRate > 0) {
+    int64_t period = std::llround(1e6 / settings.n2kRate);
+    for (Stream stream : {Stream::N2K_COG_SOG, Stream::N2K_POSITION,
+                          Stream::N2K_HEADING, Stream::N2K_WIND}) {
+      Schedule(startUs, stream, 0, period);
+    }
+  }
+}
+
+void VDRLoadGenerator::Schedule(int64_t timeUs, Stream stream, int target,
+                                int64_t periodUs) {
+  m_events.push(
+      {timeUs, m_order++, stream, target, std::max<int64_t>(periodUs, 1)});
+}
+
+double VDRLoadGenerator::Random() {
+  // SplitMix64, the same sequence on every platform.
+  uint64_t z = (m_random_state += 0x9E3779B97F4A7C15ULL);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  z ^= z >> 31;
+  return static_cast<double>(z >> 11) / 9007199254740992.0;
+}
+
+void VDRLoadGenerator::Advance(Vessel& vessel, int64_t timeUs) {
+  double seconds = (timeUs - vessel.timeUs) / 1e6;
+  vessel.timeUs = timeUs;
+  if (seconds <= 0) return;
+  double distance = vessel.sog * seconds / 3600.0;  // Nautical miles.
+  double cog = vessel.cog * PI / 180.0;
+  vessel.lat += distance * std::cos(cog) / 60.0;
+  vessel.lon +=
+      distance * std::sin(cog) / (60.0 * std::cos(vessel.lat * PI / 180.0));
+  vessel.cog = std::fmod(vessel.cog + (Random() - 0.5) * 0.2 + 360.0, 360.0);
+}
+
+bool VDRLoadGenerator::Next(VDRLoadMessage& message) {
+  if (m_events.empty()) return false;
+  Event event = m_events.top();
+  int64_t endUs = (m_settings.startTimeMs + m_settings.durationMs) * 1000;
+  if (event.timeUs >= endUs) return false;
+  m_events.pop();
+  Schedule(event.timeUs + event.periodUs, event.stream, event.target,
+           event.periodUs);
+
+  message.timeMs = event.timeUs / 1000;
+  message.pgn = 0;
+  message.payload.clear();
+  switch (event.stream) {
+    case Stream::RMC:
+    case Stream::GGA:
+    case Stream::HDG:
+    case Stream::MWV:
+      Advance(m_ownShip, event.timeUs);
+      MakeNMEA0183(event.stream, event.timeUs, message);
+      break;
+    case Stream::AIS:
+      Advance(m_targets[event.target], event.timeUs);
+      MakeAIS(m_targets[event.target], event.timeUs, message);
+      break;
+    default:
+      Advance(m_ownShip, event.timeUs);
+      MakeNMEA2000(event.stream, event.timeUs, message);
+      break;
+  }
+  return true;
+}
+
+void VDRLoadGenerator::MakeNMEA0183(Stream stream, int64_t timeUs,
+                                    VDRLoadMessage& message) {
+  int64_t timeMs = timeUs / 1000;
+  char text[128];
+  switch (stream) {
+    case Stream::RMC: {
+      int year, month, day, msOfDay;
+      CivilFromTime(timeMs, year, month, day, msOfDay);
+      snprintf(text, sizeof(text),
+               "$GPRMC,%s,A,%s,%s,%.1f,%.1f,%02d%02d%02d,,,A",
+               FormatNMEATime(timeMs).c_str(),
+               FormatCoordinate(m_ownShip.lat, true).c_str(),
+               FormatCoordinate(m_ownShip.lon, false).c_str(), m_ownShip.sog,
+               m_ownShip.cog, day, month, year % 100);
+      break;
+    }
+    case Stream::GGA:
+      snprintf(text, sizeof(text), "$GPGGA,%s,%s,%s,1,08,0.9,12.0,M,39.5,M,,",
+               FormatNMEATime(timeMs).c_str(),
+               FormatCoordinate(m_ownShip.lat, true).c_str(),
+               FormatCoordinate(m_ownShip.lon, false).c_str());
+      break;
+    case Stream::HDG:
+      snprintf(text, sizeof(text), "$IIHDG,%.1f,,,2.5,E",
+               std::fmod(m_ownShip.cog + 2.0, 360.0));
+      break;
+    default:
+      snprintf(text, sizeof(text), "$IIMWV,%.1f,R,%.1f,N,A",
+               35.0 + Random() * 10.0, 11.0 + Random() * 2.0);
+      break;
+  }
+  message.type = VDRLoadMessage::Type::NMEA0183;
+  message.sentence = AddChecksum(text);
+}
+
+void VDRLoadGenerator::MakeAIS(const Vessel& vessel, int64_t timeUs,
+                               VDRLoadMessage& message) {
+  int year, month, day, msOfDay;
+  CivilFromTime(timeUs / 1000, year, month, day, msOfDay);
+  // Position report class A (message 1).
+  AISPayload payload;
+  payload.Add(1, 6);                                 // Message type
+  payload.Add(0, 2);                                 // Repeat indicator
+  payload.Add(vessel.mmsi, 30);                      // MMSI
+  payload.Add(0, 4);                                 // Under way using engine
+  payload.Add(-128, 8);                              // No rate of turn
+  payload.Add(std::lround(vessel.sog * 10.0), 10);   // SOG, 0.1 knots
+  payload.Add(1, 1);                                 // Position accuracy
+  payload.Add(std::llround(vessel.lon * 600000.0), 28);  // 1/10000 min
+  payload.Add(std::llround(vessel.lat * 600000.0), 27);
+  payload.Add(std::lround(vessel.cog * 10.0) % 3600, 12);  // COG, 0.1 deg
+  payload.Add(std::lround(vessel.cog) % 360, 9);           // True heading
+  payload.Add(msOfDay / 1000 % 60, 6);                     // UTC second
+  payload.Add(0, 2);                                       // Maneuver
+  payload.Add(0, 3);                                       // Spare
+  payload.Add(0, 1);                                       // RAIM
+  payload.Add(0, 19);                                      // Radio status
+  message.type = VDRLoadMessage::Type::AIS;
+  message.sentence = AddChecksum(std::string("!AIVDM,1,1,,") +
+                                 (vessel.mmsi % 2 ? 'B' : 'A') + "," +
+                                 payload.Armor() + ",0");
+}
+
+void VDRLoadGenerator::MakeNMEA2000(Stream stream, int64_t timeUs,
+                                    VDRLoadMessage& message) {
+  std::vector<uint8_t> data;
+  unsigned int pgn;
+  switch (stream) {
+    case Stream::N2K_COG_SOG:
+      pgn = 129026;
+      data.push_back(m_sid);
+      data.push_back(0xFC);  // True COG reference.
+      AddUInt16(data, ToN2KAngle(m_ownShip.cog));
+      AddUInt16(data, static_cast<unsigned int>(
+                          std::lround(m_ownShip.sog * KNOTS_TO_MS * 100.0)));
+      AddUInt16(data, 0xFFFF);
+      break;
+    case Stream::N2K_POSITION:
+      pgn = 129025;
+      AddInt32(data, static_cast<int32_t>(std::lround(m_ownShip.lat * 1e7)));
+      AddInt32(data, static_cast<int32_t>(std::lround(m_ownShip.lon * 1e7)));
+      break;
+    case Stream::N2K_HEADING:
+      pgn = 127250;
+      data.push_back(m_sid);
+      AddUInt16(data, ToN2KAngle(m_ownShip.cog + 2.0));
+      AddUInt16(data, 0x7FFF);  // Deviation not available.
+      AddUInt16(data, ToN2KAngle(2.5));
+      data.push_back(0xFC);  // True heading reference.
+      break;
+    default:
+      pgn = 130306;
+      data.push_back(m_sid);
+      AddUInt16(data, static_cast<unsigned int>(std::lround(
+                          (11.0 + Random() * 2.0) * KNOTS_TO_MS * 100.0)));
+      AddUInt16(data, ToN2KAngle(35.0 + Random() * 10.0));
+      data.push_back(0xFA);  // Apparent wind.
+      AddUInt16(data, 0xFFFF);
+      break;
+  }
+  m_sid = static_cast<uint8_t>((m_sid + 1) % 253);
+
+  // Actisense N2K layout as delivered by OpenCPN: command, length, priority,
+  // PGN, destination, source, timestamp and data length, then the data.
+  uint32_t timestamp = static_cast<uint32_t>(timeUs / 1000);
+  message.payload = {0x93,
+                     static_cast<uint8_t>(11 + data.size()),
+                     2,
+                     static_cast<uint8_t>(pgn & 0xFF),
+                     static_cast<uint8_t>((pgn >> 8) & 0xFF),
+                     static_cast<uint8_t>((pgn >> 16) & 0xFF),
+                     0xFF,
+                     0x01,
+                     static_cast<uint8_t>(timestamp & 0xFF),
+                     static_cast<uint8_t>((timestamp >> 8) & 0xFF),
+                     static_cast<uint8_t>((timestamp >> 16) & 0xFF),
+                     static_cast<uint8_t>((timestamp >> 24) & 0xFF),
+                     static_cast<uint8_t>(data.size())};
+  message.payload.insert(message.payload.end(), data.begin(), data.end());
+
+  message.type = VDRLoadMessage::Type::NMEA2000;
+  message.pgn = pgn;
+  std::string hex;
+  char byte[3];
+  for (uint8_t value : message.payload) {
+    snprintf(byte, sizeof(byte), "%02X", value);
+    hex += byte;
+  }
+  message.sentence = "$PCDIN," + std::to_string(pgn) + "," + hex;
+}
+
+std::string VDRLoadGenerator::FormatIsoTime(int64_t timeMs) {
+  int year, month, day, msOfDay;
+  CivilFromTime(timeMs, year, month, day, msOfDay);
+  char text[32];
+  snprintf(text, sizeof(text), "%04d-%02d-%02dT%02d:%02d:%02d.%03dZ", year,
+           month, day, msOfDay / 3600000, msOfDay / 60000 % 60,
+           msOfDay / 1000 % 60, msOfDay % 1000);
+  return text;
+}
+
+std::string VDRLoadGenerator::FormatRawLine(const VDRLoadMessage& message) {
+  return message.sentence + "\r\n";
+}
+
+std::string VDRLoadGenerator::FormatCSVLine(const VDRLoadMessage& message) {
+  std::string timestamp = FormatIsoTime(message.timeMs);
+  switch (message.type) {
+    case VDRLoadMessage::Type::NMEA2000:
+      // The payload is the hexadecimal after "$PCDIN,<pgn>,".
+      return timestamp + ",NMEA2000," + std::to_string(message.pgn) + "," +
+             message.sentence.substr(message.sentence.rfind(',') + 1) + "\n";
+    case VDRLoadMessage::Type::AIS:
+      return timestamp + ",AIS,,\"" + message.sentence + "\"\n";
+    default:
+      return timestamp + ",NMEA0183,,\"" + message.sentence + "\"\n";
+  }
+}
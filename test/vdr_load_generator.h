@@ -0,0 +1,150 @@
+/***************************************************************************
+ *   Copyright (C) 2024 by OpenCPN development team                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ **************************************************************************/
+
+#ifndef _VDR_LOAD_GENERATOR_H_
+#define _VDR_LOAD_GENERATOR_H_
+
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <string>
+#include <vector>
+
+/** Rates and duration of a generated data stream. */
+struct VDRLoadSettings {
+  /** Seed of the pseudo-random motion, the same seed gives the same data. */
+  uint64_t seed = 1;
+  /** Time of the first message, 2015-07-20T09:22:11Z by default. */
+  int64_t startTimeMs = 1437384131000LL;
+  /** Length of the generated data. */
+  int64_t durationMs = 60 * 1000;
+  /** RMC, GGA, HDG and MWV sentences per second, for each sentence type. */
+  double navigationRate = 1;
+  /** Number of AIS targets, each sending position reports. */
+  int aisTargets = 0;
+  /** Seconds between two position reports of an AIS target. */
+  double aisInterval = 10;
+  /** COG & SOG, position, heading and wind PGNs per second, for each PGN. */
+  double n2kRate = 0;
+};
+
+/** A generated NMEA 0183 sentence, AIS sentence or NMEA 2000 message. */
+struct VDRLoadMessage {
+  enum class Type { NMEA0183, AIS, NMEA2000 };
+
+  Type type;
+  /** Generation time, milliseconds since the epoch. */
+  int64_t timeMs;
+  /** Sentence without line ending, "$PCDIN,<pgn>,<payload>" for NMEA 2000. */
+  std::string sentence;
+  /** NMEA 2000 PGN. */
+  unsigned int pgn;
+  /** NMEA 2000 payload as delivered by OpenCPN, with the header bytes. */
+  std::vector<uint8_t> payload;
+};
+
+/**
+ * Deterministic generator of vessel data for load tests.
+ *
+ * Simulates an own ship and AIS targets moving at constant speed with a
+ * slowly wandering course, and emits their data at the configured rates in
+ * chronological order. Messages are returned one at a time so hour-long logs
+ * can be written, or live streams fed to the plugin, without holding them in
+ * memory.
+ */
+class VDRLoadGenerator {
+public:
+  explicit VDRLoadGenerator(const VDRLoadSettings& settings);
+
+  /**
+   * Generate the next message.
+   *
+   * @return False once the configured duration is reached.
+   */
+  bool Next(VDRLoadMessage& message);
+
+  /** Header line of CSV files, as written by the recorder. */
+  static const char* const CSV_HEADER;
+
+  /** Format a message as a line of a raw NMEA file, with CRLF. */
+  static std::string FormatRawLine(const VDRLoadMessage& message);
+
+  /** Format a message as a line of a CSV file, with LF. */
+  static std::string FormatCSVLine(const VDRLoadMessage& message);
+
+  /** Format a time as ISO 8601 with milliseconds, like the recorder. */
+  static std::string FormatIsoTime(int64_t timeMs);
+
+private:
+  enum class Stream {
+    RMC,
+    GGA,
+    HDG,
+    MWV,
+    AIS,
+    N2K_COG_SOG,
+    N2K_POSITION,
+    N2K_HEADING,
+    N2K_WIND
+  };
+
+  /** Scheduled emission of a stream, in microseconds. */
+  struct Event {
+    int64_t timeUs;
+    uint64_t order;  //!< Tie breaker, keeps the output deterministic.
+    Stream stream;
+    int target;
+    int64_t periodUs;
+
+    bool operator>(const Event& other) const {
+      return timeUs != other.timeUs ? timeUs > other.timeUs
+                                    : order > other.order;
+    }
+  };
+
+  /** Position and motion of a simulated vessel. */
+  struct Vessel {
+    uint32_t mmsi;
+    double lat;
+    double lon;
+    double sog;  //!< Knots.
+    double cog;  //!< Degrees true.
+    int64_t timeUs;
+  };
+
+  void Schedule(int64_t timeUs, Stream stream, int target, int64_t periodUs);
+  /** Move a vessel to the given time, the course wanders randomly. */
+  void Advance(Vessel& vessel, int64_t timeUs);
+  /** Uniform random number in [0, 1). */
+  double Random();
+
+  void MakeNMEA0183(Stream stream, int64_t timeUs, VDRLoadMessage& message);
+  void MakeAIS(const Vessel& vessel, int64_t timeUs, VDRLoadMessage& message);
+  void MakeNMEA2000(Stream stream, int64_t timeUs, VDRLoadMessage& message);
+
+  VDRLoadSettings m_settings;
+  uint64_t m_random_state;
+  uint64_t m_order;
+  uint8_t m_sid;
+  Vessel m_ownShip;
+  std::vector<Vessel> m_targets;
+  std::priority_queue<Event, std::vector<Event>, std::greater<Event>> m_events;
+};
+
+#endif  // _VDR_LOAD_GENERATOR_H_